@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Compiles the stopwords.<language code> lists into the gvdb file
+ * TrackerLanguage maps at runtime:
+ *
+ *  "languages": the language codes, the Nth code is bit N in masks
+ *  "<code>":    table with the stop words of the language, plus the
+ *               english ones, TrackerLanguage looks tokens up here
+ *  "words":     stop word -> mask of the languages having it
+ *  "trigrams":  trigram of a stop word -> mask of the languages
+ *               having it, both used by tracker_language_detect()
+ *  "n-trigrams": number of distinct trigrams of each language
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <gvdb/gvdb-builder.h>
+
+#include <libtracker-common/tracker-language.h>
+
+#define MAX_LANGUAGES 32
+
+static gchar **
+read_words (const gchar  *filename,
+            GError      **error)
+{
+	gchar *contents, **words, **p;
+	GPtrArray *array;
+
+	if (!g_file_get_contents (filename, &contents, NULL, error)) {
+		return NULL;
+	}
+
+	words = g_strsplit_set (contents, "\n", -1);
+	g_free (contents);
+
+	array = g_ptr_array_new ();
+
+	for (p = words; *p; p++) {
+		gchar *word;
+
+		word = g_utf8_strdown (g_strstrip (*p), -1);
+
+		if (word[0] == '\0') {
+			g_free (word);
+			continue;
+		}
+
+		g_ptr_array_add (array, word);
+	}
+
+	g_ptr_array_add (array, NULL);
+	g_strfreev (words);
+
+	return (gchar **) g_ptr_array_free (array, FALSE);
+}
+
+static void
+add_to_mask (GHashTable  *masks,
+             const gchar *key,
+             guint        bit)
+{
+	guint mask;
+
+	mask = GPOINTER_TO_UINT (g_hash_table_lookup (masks, key));
+	g_hash_table_insert (masks, g_strdup (key),
+	                     GUINT_TO_POINTER (mask | (1 << bit)));
+}
+
+typedef struct {
+	GHashTable *masks;
+	guint bit;
+} TrigramData;
+
+static void
+add_trigram (const gchar *trigram,
+             gpointer     user_data)
+{
+	TrigramData *data = user_data;
+
+	add_to_mask (data->masks, trigram, data->bit);
+}
+
+static void
+insert_masks (GHashTable *root,
+              const gchar *name,
+              GHashTable *masks)
+{
+	GHashTableIter iter;
+	GHashTable *table;
+	gpointer key, value;
+
+	table = gvdb_hash_table_new (root, name);
+	g_hash_table_iter_init (&iter, masks);
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		GvdbItem *item;
+
+		item = gvdb_hash_table_insert (table, key);
+		gvdb_item_set_value (item, g_variant_new_uint32 (GPOINTER_TO_UINT (value)));
+	}
+
+	g_hash_table_unref (table);
+}
+
+static void
+insert_stop_words (GHashTable  *table,
+                   gchar      **words)
+{
+	gint i;
+
+	for (i = 0; words && words[i]; i++) {
+		GvdbItem *item;
+
+		if (g_hash_table_contains (table, words[i])) {
+			continue;
+		}
+
+		item = gvdb_hash_table_insert (table, words[i]);
+		gvdb_item_set_value (item, g_variant_new_boolean (TRUE));
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	GHashTable *root, *table, *word_masks, *trigram_masks;
+	guint32 n_trigrams[MAX_LANGUAGES] = { 0 };
+	GHashTableIter iter;
+	gpointer value;
+	GPtrArray *codes, *lists;
+	gchar **english = NULL;
+	GError *error = NULL;
+	guint i, j;
+
+	if (argc < 3) {
+		g_printerr ("Usage: %s OUTPUT stopwords.<code>...\n", argv[0]);
+		return 1;
+	}
+
+	if (argc - 2 > MAX_LANGUAGES) {
+		g_printerr ("At most %d languages are supported\n", MAX_LANGUAGES);
+		return 1;
+	}
+
+	codes = g_ptr_array_new_with_free_func (g_free);
+	lists = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+	word_masks = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	trigram_masks = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (i = 2; i < (guint) argc; i++) {
+		gchar *basename, **words;
+		const gchar *code;
+
+		basename = g_path_get_basename (argv[i]);
+		code = strrchr (basename, '.');
+
+		if (!code || code[1] == '\0') {
+			g_printerr ("No language code in file name '%s'\n", argv[i]);
+			return 1;
+		}
+
+		words = read_words (argv[i], &error);
+
+		if (!words) {
+			g_printerr ("Could not read '%s': %s\n", argv[i], error->message);
+			return 1;
+		}
+
+		g_ptr_array_add (codes, g_strdup (code + 1));
+		g_ptr_array_add (lists, words);
+		g_free (basename);
+
+		if (strcmp (g_ptr_array_index (codes, codes->len - 1), "en") == 0) {
+			english = words;
+		}
+	}
+
+	root = gvdb_hash_table_new (NULL, NULL);
+
+	for (i = 0; i < codes->len; i++) {
+		gchar **words = g_ptr_array_index (lists, i);
+		TrigramData data;
+
+		data.masks = trigram_masks;
+		data.bit = i;
+
+		for (j = 0; words[j]; j++) {
+			add_to_mask (word_masks, words[j], i);
+			tracker_language_foreach_trigram (words[j], -1, add_trigram, &data);
+		}
+
+		/* English stop words are ignored for every language */
+		table = gvdb_hash_table_new (root, g_ptr_array_index (codes, i));
+		insert_stop_words (table, words);
+		insert_stop_words (table, english);
+		g_hash_table_unref (table);
+	}
+
+	insert_masks (root, "words", word_masks);
+	insert_masks (root, "trigrams", trigram_masks);
+
+	g_hash_table_iter_init (&iter, trigram_masks);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		for (i = 0; i < codes->len; i++) {
+			if (GPOINTER_TO_UINT (value) & (1 << i)) {
+				n_trigrams[i]++;
+			}
+		}
+	}
+
+	gvdb_item_set_value (gvdb_hash_table_insert (root, "n-trigrams"),
+	                     g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+	                                                n_trigrams, codes->len,
+	                                                sizeof (guint32)));
+
+	g_ptr_array_add (codes, NULL);
+	gvdb_item_set_value (gvdb_hash_table_insert (root, "languages"),
+	                     g_variant_new_strv ((const gchar * const *) codes->pdata, -1));
+
+	if (!gvdb_table_write_contents (root, argv[1], FALSE, &error)) {
+		g_printerr ("Could not write '%s': %s\n", argv[1], error->message);
+		return 1;
+	}
+
+	g_hash_table_unref (root);
+	g_hash_table_unref (word_masks);
+	g_hash_table_unref (trigram_masks);
+	g_ptr_array_unref (lists);
+	g_ptr_array_unref (codes);
+
+	return 0;
+}
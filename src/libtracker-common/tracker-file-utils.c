@@ -44,6 +44,12 @@
 
 #define TEXT_SNIFF_SIZE 4096
 
+/* Reading the whole file must stay considerably cheaper than
+ * extracting it again, files bigger than this get no fingerprint.
+ */
+#define FINGERPRINT_MAX_SIZE (64 * 1024 * 1024)
+#define FINGERPRINT_CHUNK_SIZE 65536
+
 int
 tracker_file_open_fd (const gchar *path)
 {
@@ -238,6 +244,84 @@ tracker_file_get_mime_type (GFile *file)
 	return content_type ? content_type : g_strdup ("unknown");
 }
 
+gchar *
+tracker_file_get_content_fingerprint (GFile         *file,
+                                      GCancellable  *cancellable,
+                                      GError       **error)
+{
+	GChecksum *checksum;
+	struct stat st;
+	gchar *path, *fingerprint = NULL;
+	guchar *buffer;
+	ssize_t len;
+	int fd;
+
+	g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+	path = g_file_get_path (file);
+
+	if (!path) {
+		/* Not a local file, nothing to fingerprint */
+		return NULL;
+	}
+
+	fd = tracker_file_open_fd (path);
+
+	if (fd == -1) {
+		g_set_error (error, G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Could not open '%s': %s",
+		             path, g_strerror (errno));
+		g_free (path);
+		return NULL;
+	}
+
+	if (fstat (fd, &st) == -1 ||
+	    !S_ISREG (st.st_mode) ||
+	    st.st_size > FINGERPRINT_MAX_SIZE) {
+		close (fd);
+		g_free (path);
+		return NULL;
+	}
+
+	checksum = g_checksum_new (G_CHECKSUM_MD5);
+	buffer = g_malloc (FINGERPRINT_CHUNK_SIZE);
+
+	while ((len = read (fd, buffer, FINGERPRINT_CHUNK_SIZE)) != 0) {
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+
+			g_set_error (error, G_IO_ERROR,
+			             g_io_error_from_errno (errno),
+			             "Could not read '%s': %s",
+			             path, g_strerror (errno));
+			break;
+		}
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			break;
+
+		g_checksum_update (checksum, buffer, len);
+	}
+
+	if (len == 0) {
+		/* File size is part of the fingerprint, so truncations
+		 * and appends are caught without relying on the hash.
+		 */
+		fingerprint = g_strdup_printf ("%" G_GINT64_FORMAT ":%s",
+		                               (gint64) st.st_size,
+		                               g_checksum_get_string (checksum));
+	}
+
+	g_checksum_free (checksum);
+	g_free (buffer);
+	close (fd);
+	g_free (path);
+
+	return fingerprint;
+}
+
 #ifdef __linux__
 
 #ifdef __USE_LARGEFILE64
@@ -44,6 +44,9 @@ gboolean tracker_file_is_locked                             (GFile       *file);
 gboolean tracker_file_is_hidden                             (GFile       *file);
 gint     tracker_file_cmp                                   (GFile       *file_a,
                                                              GFile       *file_b);
+gchar *  tracker_file_get_content_fingerprint               (GFile         *file,
+                                                             GCancellable  *cancellable,
+                                                             GError       **error);
 
 /* Path utils */
 gboolean tracker_path_is_in_path                            (const gchar *path,
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include <math.h>
 #include <string.h>
 
 #include <glib.h>
@@ -28,23 +29,61 @@
 #include <libstemmer.h>
 #endif /* HAVE_LIBSTEMMER */
 
+#include <gvdb/gvdb-reader.h>
+
 #include "tracker-log.h"
 #include "tracker-language.h"
 
+/* Only the first bytes of a document are looked at */
+#define DETECT_MAX_BYTES   2048
+#define DETECT_MIN_WORDS   8
+#define DETECT_MAX_WORD    64
+
+/* A stop word says more about the language than a trigram, both
+ * are split among the languages sharing them.
+ */
+#define DETECT_STOP_WORD_SCORE 24
+#define DETECT_TRIGRAM_SCORE   6
+
 #define GET_PRIV(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), TRACKER_TYPE_LANGUAGE, TrackerLanguagePriv))
 
 typedef struct _TrackerLanguagePriv TrackerLanguagePriv;
 typedef struct _Languages           Languages;
+typedef struct _StopWords           StopWords;
+typedef struct _DetectData          DetectData;
 
 struct _TrackerLanguagePriv {
-	GHashTable    *stop_words;
+	GvdbTable     *stop_words;
 	gboolean       enable_stemmer;
 	gchar         *language_code;
 
+	/* Language code -> GvdbTable, language code -> stemmer,
+	 * switching languages is frequent with detection enabled.
+	 */
+	GHashTable    *stop_word_tables;
+	GHashTable    *stemmers;
+
 	GMutex         stemmer_mutex;
 	gpointer       stemmer;
 };
 
+/* Compiled at build time into stopwords.gvdb, see
+ * stop-words/tracker-language-compile.c
+ */
+struct _StopWords {
+	GvdbTable     *root;
+	GvdbTable     *words;     /* word -> mask of languages */
+	GvdbTable     *trigrams;  /* trigram -> mask of languages */
+	gchar        **languages; /* bit -> language code */
+	guint32       *n_trigrams; /* bit -> trigrams of the language */
+	guint          n_languages;
+};
+
+struct _DetectData {
+	StopWords     *stop_words;
+	guint          scores[32];
+};
+
 struct _Languages {
 	const gchar *code;
 	const gchar *name;
@@ -72,7 +111,6 @@ enum {
 	PROP_0,
 
 	PROP_ENABLE_STEMMER,
-	PROP_STOP_WORDS,
 	PROP_LANGUAGE_CODE,
 };
 
@@ -105,14 +143,6 @@ tracker_language_class_init (TrackerLanguageClass *klass)
 	                                                       TRUE,
 	                                                       G_PARAM_WRITABLE | G_PARAM_CONSTRUCT));
 
-	g_object_class_install_property (object_class,
-	                                 PROP_STOP_WORDS,
-	                                 g_param_spec_boxed ("stop-words",
-	                                                     "Stop words",
-	                                                     "Stop words",
-	                                                     g_hash_table_get_type (),
-	                                                     G_PARAM_READABLE));
-
 	g_object_class_install_property (object_class,
 	                                 PROP_LANGUAGE_CODE,
 	                                 g_param_spec_string ("language-code",
@@ -135,15 +165,21 @@ tracker_language_init (TrackerLanguage *language)
 
 	priv = GET_PRIV (language);
 
-	priv->stop_words = g_hash_table_new_full (g_str_hash,
-	                                          g_str_equal,
-	                                          g_free,
-	                                          NULL);
+	priv->stop_word_tables = g_hash_table_new_full (g_str_hash,
+	                                                g_str_equal,
+	                                                g_free,
+	                                                (GDestroyNotify) gvdb_table_unref);
 #ifdef HAVE_LIBSTEMMER
 	g_mutex_init (&priv->stemmer_mutex);
 
+	priv->stemmers = g_hash_table_new_full (g_str_hash,
+	                                        g_str_equal,
+	                                        g_free,
+	                                        (GDestroyNotify) sb_stemmer_delete);
+
 	stem_language = tracker_language_get_name_by_code (NULL);
 	priv->stemmer = sb_stemmer_new (stem_language, NULL);
+	g_hash_table_insert (priv->stemmers, g_strdup ("en"), priv->stemmer);
 #endif /* HAVE_LIBSTEMMER */
 }
 
@@ -155,17 +191,15 @@ language_finalize (GObject *object)
 	priv = GET_PRIV (object);
 
 #ifdef HAVE_LIBSTEMMER
-	if (priv->stemmer) {
-		g_mutex_lock (&priv->stemmer_mutex);
-		sb_stemmer_delete (priv->stemmer);
-		g_mutex_unlock (&priv->stemmer_mutex);
-	}
+	/* The current stemmer is owned by the cache */
+	g_mutex_lock (&priv->stemmer_mutex);
+	g_hash_table_unref (priv->stemmers);
+	priv->stemmer = NULL;
+	g_mutex_unlock (&priv->stemmer_mutex);
 	g_mutex_clear (&priv->stemmer_mutex);
 #endif /* HAVE_LIBSTEMMER */
 
-	if (priv->stop_words) {
-		g_hash_table_unref (priv->stop_words);
-	}
+	g_hash_table_unref (priv->stop_word_tables);
 
 	g_free (priv->language_code);
 
@@ -186,9 +220,6 @@ language_get_property (GObject    *object,
 	case PROP_ENABLE_STEMMER:
 		g_value_set_boolean (value, priv->enable_stemmer);
 		break;
-	case PROP_STOP_WORDS:
-		g_value_set_boxed (value, priv->stop_words);
-		break;
 	case PROP_LANGUAGE_CODE:
 		g_value_set_string (value, priv->language_code);
 		break;
@@ -221,118 +252,146 @@ language_set_property (GObject      *object,
 }
 
 static gchar *
-language_get_stopword_filename (const gchar *language_code)
+language_get_stop_words_filename (void)
 {
-	gchar *str;
-	gchar *filename;
 	const gchar *testpath;
 
-	str = g_strconcat ("stopwords.", language_code, NULL);
-
 	/* Look if the testpath for stopwords dictionary was set
 	 *  (used during unit tests) */
 	testpath = g_getenv ("TRACKER_LANGUAGE_STOP_WORDS_DIR");
 	if (!testpath) {
-		filename = g_build_filename (SHAREDIR,
-		                             "tracker",
-		                             "stop-words",
-		                             str,
-		                             NULL);
+		return g_build_filename (SHAREDIR,
+		                         "tracker",
+		                         "stop-words",
+		                         "stopwords.gvdb",
+		                         NULL);
 	} else {
-		filename = g_build_filename (testpath,
-		                             str,
-		                             NULL);
+		return g_build_filename (testpath,
+		                         "stopwords.gvdb",
+		                         NULL);
 	}
-
-	g_free (str);
-	return filename;
 }
 
-static void
-language_add_stopwords (TrackerLanguage *language,
-                        const gchar     *filename)
+/* The file is mapped once for the whole process, lookups go
+ * straight to the mapped hash tables, nothing is parsed.
+ */
+static StopWords *
+language_get_stop_words (void)
 {
-	TrackerLanguagePriv  *priv;
-	GMappedFile          *mapped_file;
-	GError               *error = NULL;
-	gchar                *content;
-	gchar               **words, **p;
-
-	priv = GET_PRIV (language);
-
-	mapped_file = g_mapped_file_new (filename, FALSE, &error);
-	if (error) {
-		g_message ("Tracker couldn't read stopword file:'%s', %s",
-		           filename, error->message);
-		g_clear_error (&error);
-		return;
-	}
-
-	content = g_mapped_file_get_contents (mapped_file);
-	words = g_strsplit_set (content, "\n" , -1);
-
-	g_mapped_file_unref (mapped_file);
+	static gsize initialized = 0;
+	static StopWords stop_words = { 0 };
+
+	if (g_once_init_enter (&initialized)) {
+		GError *error = NULL;
+		GVariant *value;
+		gchar *filename;
+
+		filename = language_get_stop_words_filename ();
+		stop_words.root = gvdb_table_new (filename, TRUE, &error);
+
+		if (error) {
+			g_message ("Tracker couldn't read stopword file:'%s', %s",
+			           filename, error->message);
+			g_clear_error (&error);
+		} else {
+			stop_words.words = gvdb_table_get_table (stop_words.root, "words");
+			stop_words.trigrams = gvdb_table_get_table (stop_words.root, "trigrams");
+
+			value = gvdb_table_get_value (stop_words.root, "languages");
+
+			if (value) {
+				stop_words.languages = g_variant_dup_strv (value, NULL);
+				g_variant_unref (value);
+			}
+
+			value = gvdb_table_get_value (stop_words.root, "n-trigrams");
+
+			if (value && stop_words.languages) {
+				gsize n_elements;
+				gconstpointer data;
+
+				data = g_variant_get_fixed_array (value, &n_elements, sizeof (guint32));
+				stop_words.n_trigrams = g_memdup (data, n_elements * sizeof (guint32));
+				stop_words.n_languages = MIN (MIN (g_strv_length (stop_words.languages),
+				                                   n_elements), 32);
+			}
+
+			if (value) {
+				g_variant_unref (value);
+			}
+		}
 
-	/* FIXME: Shouldn't clear the hash table first? */
-	for (p = words; *p; p++) {
-		g_hash_table_insert (priv->stop_words,
-		                     g_strdup (g_strstrip (*p)),
-		                     GINT_TO_POINTER (1));
+		g_free (filename);
+		g_once_init_leave (&initialized, 1);
 	}
 
-	g_strfreev (words);
+	return &stop_words;
 }
 
 static void
 language_set_stopword_list (TrackerLanguage *language,
                             const gchar     *language_code)
 {
-#ifdef HAVE_LIBSTEMMER
 	TrackerLanguagePriv *priv;
+	StopWords *stop_words;
+	GvdbTable *table;
+
+#ifdef HAVE_LIBSTEMMER
 	gchar *stem_language_lower;
 	const gchar *stem_language;
+	gpointer stemmer;
 #endif /* HAVE_LIBSTEMMER */
 
-	gchar *stopword_filename;
-
 	g_return_if_fail (TRACKER_IS_LANGUAGE (language));
 
-	/* Set up stopwords list */
-	/* g_message ("Setting up stopword list for language code:'%s'", language_code); */
+	priv = GET_PRIV (language);
 
-	stopword_filename = language_get_stopword_filename (language_code);
-	language_add_stopwords (language, stopword_filename);
-	g_free (stopword_filename);
+	/* Set up stopwords list, each language table has the
+	 * english stop words merged in at build time.
+	 */
+	table = g_hash_table_lookup (priv->stop_word_tables, language_code);
+	stop_words = language_get_stop_words ();
 
-	if (!language_code || strcmp (language_code, "en") != 0) {
-		stopword_filename = language_get_stopword_filename ("en");
-		language_add_stopwords (language, stopword_filename);
-		g_free (stopword_filename);
-	}
+	if (!table && stop_words->root) {
+		table = gvdb_table_get_table (stop_words->root, language_code);
 
-#ifdef HAVE_LIBSTEMMER
-	priv = GET_PRIV (language);
+		if (!table) {
+			table = gvdb_table_get_table (stop_words->root, "en");
+		}
 
-	/* g_message ("Setting up stemmer for language code:'%s'", language_code); */
+		if (table) {
+			g_hash_table_insert (priv->stop_word_tables,
+			                     g_strdup (language_code),
+			                     table);
+		}
+	}
 
-	stem_language = tracker_language_get_name_by_code (language_code);
-	stem_language_lower = g_ascii_strdown (stem_language, -1);
+	priv->stop_words = table;
 
+#ifdef HAVE_LIBSTEMMER
 	g_mutex_lock (&priv->stemmer_mutex);
 
-	if (priv->stemmer) {
-		sb_stemmer_delete (priv->stemmer);
-	}
+	if (!g_hash_table_lookup_extended (priv->stemmers, language_code,
+	                                   NULL, &stemmer)) {
+		stem_language = tracker_language_get_name_by_code (language_code);
+		stem_language_lower = g_ascii_strdown (stem_language, -1);
 
-	priv->stemmer = sb_stemmer_new (stem_language_lower, NULL);
-	if (!priv->stemmer) {
-		g_message ("No stemmer could be found for language:'%s'",
-		           stem_language_lower);
+		stemmer = sb_stemmer_new (stem_language_lower, NULL);
+		if (!stemmer) {
+			g_message ("No stemmer could be found for language:'%s'",
+			           stem_language_lower);
+		}
+
+		/* Failures are cached too, so they're only reported once */
+		g_hash_table_insert (priv->stemmers,
+		                     g_strdup (language_code),
+		                     stemmer);
+		g_free (stem_language_lower);
 	}
 
-	g_mutex_unlock (&priv->stemmer_mutex);
+	priv->stemmer = stemmer;
 
-	g_free (stem_language_lower);
+	g_mutex_unlock (&priv->stemmer_mutex);
 #endif /* HAVE_LIBSTEMMER */
 }
 
@@ -376,28 +435,6 @@ tracker_language_get_enable_stemmer (TrackerLanguage *language)
 	return priv->enable_stemmer;
 }
 
-/**
- * tracker_language_get_stop_words:
- * @language: a #TrackerLanguage
- *
- * Returns the stop words for @language. Stop words are really common
- * words that are not worth to index for the language handled by @language.
- *
- * Returns: A #GHashTable with the stop words as the value, this memory
- *          is owned by @language and should not be modified nor freed.
- **/
-GHashTable *
-tracker_language_get_stop_words (TrackerLanguage *language)
-{
-	TrackerLanguagePriv *priv;
-
-	g_return_val_if_fail (TRACKER_IS_LANGUAGE (language), NULL);
-
-	priv = GET_PRIV (language);
-
-	return priv->stop_words;
-}
-
 /**
  * tracker_language_is_stop_word:
  * @language: a #TrackerLanguage
@@ -419,7 +456,11 @@ tracker_language_is_stop_word (TrackerLanguage *language,
 
 	priv = GET_PRIV (language);
 
-	return g_hash_table_lookup (priv->stop_words, word) != NULL;
+	if (!priv->stop_words) {
+		return FALSE;
+	}
+
+	return gvdb_table_has_value (priv->stop_words, word);
 }
 
 /**
@@ -482,14 +523,18 @@ tracker_language_set_language_code (TrackerLanguage *language,
 
 	priv = GET_PRIV (language);
 
-	g_free (priv->language_code);
-
-	priv->language_code = g_strdup (language_code);
+	if (!language_code) {
+		language_code = "en";
+	}
 
-	if (!priv->language_code) {
-		priv->language_code = g_strdup ("en");
+	/* Called for every document if language detection is on */
+	if (g_strcmp0 (priv->language_code, language_code) == 0) {
+		return;
 	}
 
+	g_free (priv->language_code);
+	priv->language_code = g_strdup (language_code);
+
 	language_set_stopword_list (language, priv->language_code);
 
 	g_object_notify (G_OBJECT (language), "language-code");
@@ -532,6 +577,11 @@ tracker_language_stem_word (TrackerLanguage *language,
 
 	g_mutex_lock (&priv->stemmer_mutex);
 
+	if (!priv->stemmer) {
+		g_mutex_unlock (&priv->stemmer_mutex);
+		return g_strndup (word, word_length);
+	}
+
 	stem_word = (const gchar*) sb_stemmer_stem (priv->stemmer,
 	                                            (guchar*) word,
 	                                            word_length);
@@ -570,3 +620,219 @@ tracker_language_get_name_by_code (const gchar *language_code)
 
 	return "";
 }
+
+/**
+ * tracker_language_foreach_trigram:
+ * @word: a lowercase word in UTF-8
+ * @word_length: length of @word in bytes, or -1 if nul terminated
+ * @func: function to call for each trigram
+ * @user_data: data to pass to @func
+ *
+ * Calls @func for each 3 character substring of @word, with the
+ * word padded by '_' on both ends, so "the" yields "_th", "the"
+ * and "he_". These are the n-grams used for language detection.
+ **/
+void
+tracker_language_foreach_trigram (const gchar                *word,
+                                  gint                        word_length,
+                                  TrackerLanguageTrigramFunc  func,
+                                  gpointer                    user_data)
+{
+	gchar padded[DETECT_MAX_WORD + 3];
+	gchar trigram[3 * 6 + 1];
+	gint offsets[DETECT_MAX_WORD + 3];
+	gint len, n_chars = 0, i;
+	const gchar *p;
+
+	g_return_if_fail (word != NULL);
+	g_return_if_fail (func != NULL);
+
+	if (word_length < 0) {
+		word_length = strlen (word);
+	}
+
+	if (word_length == 0 || word_length > DETECT_MAX_WORD) {
+		return;
+	}
+
+	padded[0] = '_';
+	memcpy (&padded[1], word, word_length);
+	padded[word_length + 1] = '_';
+	padded[word_length + 2] = '\0';
+	len = word_length + 2;
+
+	for (p = padded; p < padded + len; p = g_utf8_next_char (p)) {
+		offsets[n_chars++] = p - padded;
+	}
+
+	offsets[n_chars] = len;
+
+	for (i = 0; i + 3 <= n_chars; i++) {
+		gint size = offsets[i + 3] - offsets[i];
+
+		if (size >= (gint) sizeof (trigram)) {
+			continue;
+		}
+
+		memcpy (trigram, &padded[offsets[i]], size);
+		trigram[size] = '\0';
+		func (trigram, user_data);
+	}
+}
+
+static void
+detect_add_scores (DetectData  *data,
+                   GvdbTable   *table,
+                   const gchar *key,
+                   guint        score)
+{
+	GVariant *value;
+	guint32 mask;
+	guint i, n_languages;
+
+	value = gvdb_table_get_value (table, key);
+
+	if (!value) {
+		return;
+	}
+
+	mask = g_variant_get_uint32 (value);
+	g_variant_unref (value);
+
+	for (i = 0, n_languages = 0; i < 32; i++) {
+		if (mask & (1 << i)) {
+			n_languages++;
+		}
+	}
+
+	for (i = 0; i < data->stop_words->n_languages; i++) {
+		if (mask & (1 << i)) {
+			data->scores[i] += score / n_languages;
+		}
+	}
+}
+
+static void
+detect_trigram_func (const gchar *trigram,
+                     gpointer     user_data)
+{
+	DetectData *data = user_data;
+
+	detect_add_scores (data, data->stop_words->trigrams, trigram,
+	                   DETECT_TRIGRAM_SCORE);
+}
+
+/**
+ * tracker_language_detect:
+ * @text: a UTF-8 string
+ * @length: length of @text in bytes, or -1 if nul terminated
+ *
+ * Guesses the language @text is written in, scoring the stop
+ * words and the trigrams of the stop words of every supported
+ * language found in its first words. Only confident guesses are
+ * returned, short texts like search terms never are.
+ *
+ * Returns: an ISO 639-1 language code, or %NULL if unsure.
+ **/
+const gchar *
+tracker_language_detect (const gchar *text,
+                         gint         length)
+{
+	StopWords *stop_words;
+	DetectData data = { 0 };
+	gchar word[DETECT_MAX_WORD + 6];
+	const gchar *p, *end;
+	gint word_length = 0, n_words = 0;
+	gdouble best = 0, second = 0;
+	gint best_language = -1;
+	guint i;
+
+	g_return_val_if_fail (text != NULL, NULL);
+
+	stop_words = language_get_stop_words ();
+
+	if (!stop_words->words || !stop_words->trigrams ||
+	    stop_words->n_languages == 0) {
+		return NULL;
+	}
+
+	if (length < 0) {
+		length = strlen (text);
+	}
+
+	data.stop_words = stop_words;
+	end = text + MIN (length, DETECT_MAX_BYTES);
+
+	for (p = text; p <= end; ) {
+		gunichar ch = 0;
+
+		if (p < end) {
+			ch = g_utf8_get_char_validated (p, end - p);
+
+			if (ch == (gunichar) -1 || ch == (gunichar) -2) {
+				/* Invalid or cut at DETECT_MAX_BYTES */
+				ch = 0;
+				p++;
+			} else {
+				p = g_utf8_next_char (p);
+			}
+		} else {
+			p++;
+		}
+
+		if (ch != 0 && g_unichar_isalpha (ch)) {
+			if (word_length <= DETECT_MAX_WORD) {
+				word_length += g_unichar_to_utf8 (g_unichar_tolower (ch),
+				                                  &word[word_length]);
+			}
+			continue;
+		}
+
+		if (word_length == 0) {
+			continue;
+		}
+
+		if (word_length <= DETECT_MAX_WORD) {
+			word[word_length] = '\0';
+			n_words++;
+
+			detect_add_scores (&data, stop_words->words, word,
+			                   DETECT_STOP_WORD_SCORE);
+			tracker_language_foreach_trigram (word, word_length,
+			                                  detect_trigram_func,
+			                                  &data);
+		}
+
+		word_length = 0;
+	}
+
+	if (n_words < DETECT_MIN_WORDS) {
+		return NULL;
+	}
+
+	for (i = 0; i < stop_words->n_languages; i++) {
+		gdouble score;
+
+		if (data.scores[i] == 0) {
+			continue;
+		}
+
+		/* Languages with longer lists have more trigrams to hit */
+		score = data.scores[i] / sqrt (MAX (stop_words->n_trigrams[i], 1));
+
+		if (score > best) {
+			second = best;
+			best = score;
+			best_language = i;
+		} else if (score > second) {
+			second = score;
+		}
+	}
+
+	/* Ask for a 20% lead over the runner up */
+	if (best_language < 0 || best * 5 < second * 6) {
+		return NULL;
+	}
+
+	return stop_words->languages[best_language];
+}
@@ -39,6 +39,9 @@ G_BEGIN_DECLS
 typedef struct _TrackerLanguage TrackerLanguage;
 typedef struct _TrackerLanguageClass TrackerLanguageClass;
 
+typedef void (* TrackerLanguageTrigramFunc) (const gchar *trigram,
+                                             gpointer     user_data);
+
 struct _TrackerLanguage {
 	GObject parent;
 };
@@ -51,7 +54,6 @@ GType            tracker_language_get_type           (void) G_GNUC_CONST;
 TrackerLanguage *tracker_language_new                (const gchar     *language_code);
 
 gboolean         tracker_language_get_enable_stemmer (TrackerLanguage *language);
-GHashTable *     tracker_language_get_stop_words     (TrackerLanguage *language);
 gboolean         tracker_language_is_stop_word       (TrackerLanguage *language,
                                                       const gchar     *word);
 const gchar *    tracker_language_get_language_code  (TrackerLanguage *language);
@@ -67,6 +69,12 @@ gchar *          tracker_language_stem_word          (TrackerLanguage *language,
 
 /* Utility functions */
 const gchar *    tracker_language_get_name_by_code   (const gchar     *language_code);
+const gchar *    tracker_language_detect             (const gchar     *text,
+                                                      gint             length);
+void             tracker_language_foreach_trigram    (const gchar     *word,
+                                                      gint             word_length,
+                                                      TrackerLanguageTrigramFunc func,
+                                                      gpointer         user_data);
 G_END_DECLS
 
 #endif /* __LIBTRACKER_COMMON_LANGUAGE_H__ */
@@ -44,6 +44,24 @@ typedef enum {
 /* Max possible length of a UChar encoded string (just a safety limit) */
 #define WORD_BUFFER_LENGTH 512
 
+/* Each UChar may take up to 3 bytes in UTF-8 */
+#define WORD_BUFFER_UTF8_LENGTH (3 * WORD_BUFFER_LENGTH + 1)
+
+/* Word characters and separators in the ASCII range, these follow the
+ * Unicode word break rules (UAX #29) ICU implements, so the fast path
+ * splits ASCII text exactly as ICU would.
+ */
+#define IS_ASCII_ALPHA(c)      (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
+#define IS_ASCII_DIGIT(c)      ((c) >= '0' && (c) <= '9')
+#define IS_ASCII_WORD_CHAR(c)  (IS_ASCII_ALPHA (c) || IS_ASCII_DIGIT (c) || (c) == '_')
+#define IS_ASCII_SPACE(c)      ((c) == ' ' || (c) == '\t' || (c) == '\n' || \
+                                (c) == '\r' || (c) == '\f' || (c) == '\v')
+
+/* Bytes that make a chunk of text go through ICU: anything outside
+ * ASCII, and colons, which ICU versions disagree on (MidLetter).
+ */
+#define NEEDS_UNICODE_BREAK(c) ((c) >= 0x80 || (c) == ':')
+
 struct TrackerParser {
 	const gchar           *txt;
 	gint                   txt_size;
@@ -58,17 +76,35 @@ struct TrackerParser {
 	gboolean               enable_forced_wordbreaks;
 
 	/* Private members */
-	gchar                 *word;
+	const gchar           *word;
 	gint                   word_length;
 	guint                  word_position;
 
-	/* Text as UChars */
+	/* Processed words are written here, unless the
+	 * stemmer is enabled, which allocates its output.
+	 */
+	gchar                  word_buffer[WORD_BUFFER_UTF8_LENGTH];
+	gchar                 *word_stemmed;
+
+	/* Text is split at ASCII whitespace into segments,
+	 * pure ASCII segments are tokenized straight from
+	 * the UTF-8 input, the rest go through ICU. Given as
+	 * byte offsets in txt.
+	 */
+	gint                   segment_start;
+	gint                   segment_end;
+	gboolean               segment_is_ascii;
+	gint                   ascii_cursor;
+
+	/* Segment text as UChars */
 	UChar                 *utxt;
 	gint                   utxt_size;
-	/* Original offset of each UChar in the input txt string */
+	gint                   utxt_allocated;
+	/* Offset of each UChar relative to segment_start */
 	gint32                *offsets;
 
-	/* The word-break iterator */
+	/* Kept across segments and resets */
+	UConverter            *converter;
 	UBreakIterator        *bi;
 
 	/* Cursor, as index of the utxt array of bytes */
@@ -207,53 +243,65 @@ tracker_parser_unaccent_nfkd_string (gpointer  str,
 	return TRUE;
 }
 
-static gchar *
-convert_UChar_to_utf8 (const UChar *word,
-                       gsize        uchar_len,
-                       gsize       *utf8_len)
+/* Checks stop words and stems the word in parser->word_buffer,
+ * returns the word to emit.
+ */
+static const gchar *
+process_word_utf8 (TrackerParser *parser,
+                   gsize          length,
+                   gboolean      *stop_word)
 {
-	gchar *utf8_str;
-	UErrorCode icu_error = U_ZERO_ERROR;
-	UConverter *converter;
-	gsize new_utf8_len;
-
-	g_return_val_if_fail (word, NULL);
-	g_return_val_if_fail (utf8_len, NULL);
-
-	/* Open converter UChar to UTF-16BE */
-	converter = ucnv_open ("UTF-8", &icu_error);
-	if (!converter) {
-		g_warning ("Cannot open UTF-8 converter: '%s'",
-		           U_FAILURE (icu_error) ? u_errorName (icu_error) : "none");
-		return NULL;
+	/* Check if stop word */
+	if (parser->ignore_stop_words) {
+		*stop_word = tracker_language_is_stop_word (parser->language,
+		                                            parser->word_buffer);
+	}
+
+	/* Stemming needed? */
+	if (parser->enable_stemmer) {
+		/* Input for stemmer ALWAYS in UTF-8, as well as output */
+		parser->word_stemmed = tracker_language_stem_word (parser->language,
+		                                                   parser->word_buffer,
+		                                                   length);
+
+		/* If stemmed wanted and succeeded, return it */
+		if (parser->word_stemmed) {
+			/* Log after stemming */
+			tracker_parser_message_hex ("    After stemming",
+			                            parser->word_stemmed,
+			                            strlen (parser->word_stemmed));
+			return parser->word_stemmed;
+		}
 	}
 
-	/* A character encoded in 2 bytes in UTF-16 may get expanded to 3 or 4 bytes
-	 *  in UTF-8. */
-	utf8_str = g_malloc (2 * uchar_len * sizeof (UChar) + 1);
+	return parser->word_buffer;
+}
 
-	/* Convert from UChar to UTF-8 (NIL-terminated) */
-	new_utf8_len = ucnv_fromUChars (converter,
-	                                utf8_str,
-	                                2 * uchar_len * sizeof (UChar) + 1,
-	                                word,
-	                                uchar_len,
-	                                &icu_error);
-	if (U_FAILURE (icu_error)) {
-		g_warning ("Cannot convert from UChar to UTF-8: '%s'",
-		           u_errorName (icu_error));
-		g_free (utf8_str);
-		ucnv_close (converter);
-		return NULL;
+static const gchar *
+process_word_ascii (TrackerParser *parser,
+                    const gchar   *word,
+                    gsize          length,
+                    gboolean      *stop_word)
+{
+	gsize i;
+
+	/* Same outcome as ICU's lowercasing for ASCII words,
+	 * without conversions nor allocations.
+	 */
+	for (i = 0; i < length; i++) {
+		parser->word_buffer[i] = g_ascii_tolower (word[i]);
 	}
 
-	*utf8_len = new_utf8_len;
-	ucnv_close (converter);
+	parser->word_buffer[length] = '\0';
+
+	tracker_parser_message_hex (" After lowercase",
+	                            parser->word_buffer,
+	                            length);
 
-	return utf8_str;
+	return process_word_utf8 (parser, length, stop_word);
 }
 
-static gchar *
+static const gchar *
 process_word_uchar (TrackerParser         *parser,
                     const UChar           *word,
                     gint                   length,
@@ -262,8 +310,8 @@ process_word_uchar (TrackerParser         *parser,
 {
 	UErrorCode error = U_ZERO_ERROR;
 	UChar normalized_buffer[WORD_BUFFER_LENGTH];
-	gchar *utf8_str = NULL;
 	gsize new_word_length;
+	gint32 utf8_length;
 
 	/* Log original word */
 	tracker_parser_message_hex ("ORIGINAL word",
@@ -346,43 +394,24 @@ process_word_uchar (TrackerParser         *parser,
 	}
 
 	/* Finally, convert to UTF-8 */
-	utf8_str = convert_UChar_to_utf8 (normalized_buffer,
-	                                  new_word_length,
-	                                  &new_word_length);
-
-	/* Log after unaccenting */
-	tracker_parser_message_hex ("   After UTF8 conversion",
-	                            utf8_str,
-	                            new_word_length);
-
-	/* Check if stop word */
-	if (parser->ignore_stop_words) {
-		*stop_word = tracker_language_is_stop_word (parser->language,
-		                                            utf8_str);
+	u_strToUTF8 (parser->word_buffer,
+	             WORD_BUFFER_UTF8_LENGTH,
+	             &utf8_length,
+	             normalized_buffer,
+	             new_word_length,
+	             &error);
+	if (U_FAILURE (error)) {
+		g_warning ("Cannot convert from UChar to UTF-8: '%s'",
+		           u_errorName (error));
+		return NULL;
 	}
 
-	/* Stemming needed? */
-	if (utf8_str &&
-	    parser->enable_stemmer) {
-		gchar *stemmed;
-
-		/* Input for stemmer ALWAYS in UTF-8, as well as output */
-		stemmed = tracker_language_stem_word (parser->language,
-		                                      utf8_str,
-		                                      new_word_length);
-
-		/* Log after stemming */
-		tracker_parser_message_hex ("    After stemming",
-		                            stemmed, strlen (stemmed));
-
-		/* If stemmed wanted and succeeded, free previous and return it */
-		if (stemmed) {
-			g_free (utf8_str);
-			return stemmed;
-		}
-	}
+	/* Log after UTF-8 conversion */
+	tracker_parser_message_hex ("   After UTF8 conversion",
+	                            parser->word_buffer,
+	                            utf8_length);
 
-	return utf8_str;
+	return process_word_utf8 (parser, utf8_length, stop_word);
 }
 
 static gboolean
@@ -426,21 +455,309 @@ parser_check_forced_wordbreaks (const UChar *buffer,
 	return FALSE;
 }
 
+/* Returns the position of the first byte at or after @start
+ * that needs ICU, or @end if none. Checks a machine word at
+ * a time while it can.
+ */
+static gint
+find_unicode_byte (const gchar *txt,
+                   gint         start,
+                   gint         end)
+{
+	const guint64 high_bits = G_GUINT64_CONSTANT (0x8080808080808080);
+	const guint64 low_bits = G_GUINT64_CONSTANT (0x0101010101010101);
+	const guint64 colons = G_GUINT64_CONSTANT (0x3a3a3a3a3a3a3a3a);
+	gint i = start;
+
+	while (i + 8 <= end) {
+		guint64 chunk, xored;
+
+		memcpy (&chunk, &txt[i], sizeof (chunk));
+		xored = chunk ^ colons;
+
+		/* Any byte with the high bit set, or any zero byte
+		 * after XORing with ':' (i.e. any colon)?
+		 */
+		if ((chunk & high_bits) != 0 ||
+		    ((xored - low_bits) & ~xored & high_bits) != 0) {
+			break;
+		}
+
+		i += 8;
+	}
+
+	while (i < end && !NEEDS_UNICODE_BREAK ((guchar) txt[i])) {
+		i++;
+	}
+
+	return i;
+}
+
+/* Pure ASCII segments end at the whitespace preceding the
+ * first chunk of text that needs ICU. Whitespace always is
+ * a word break, so both sides can be tokenized separately.
+ */
+static gint
+find_ascii_segment_end (const gchar *txt,
+                        gint         start,
+                        gint         end)
+{
+	gint pos;
+
+	pos = find_unicode_byte (txt, start, end);
+
+	if (pos == end) {
+		return end;
+	}
+
+	while (pos > start && !IS_ASCII_SPACE (txt[pos - 1])) {
+		pos--;
+	}
+
+	return pos;
+}
+
+/* Unicode segments span consecutive whitespace-separated
+ * chunks needing ICU, and end at the next pure ASCII one.
+ */
+static gint
+find_unicode_segment_end (const gchar *txt,
+                          gint         start,
+                          gint         end)
+{
+	gint pos = start;
+
+	while (pos < end) {
+		gint chunk_start = pos;
+		gboolean needs_unicode = FALSE;
+
+		while (pos < end && !IS_ASCII_SPACE (txt[pos])) {
+			needs_unicode |= NEEDS_UNICODE_BREAK ((guchar) txt[pos]);
+			pos++;
+		}
+
+		if (!needs_unicode && chunk_start > start) {
+			return chunk_start;
+		}
+
+		while (pos < end && IS_ASCII_SPACE (txt[pos])) {
+			pos++;
+		}
+	}
+
+	return end;
+}
+
+static void
+parser_setup_unicode_segment (TrackerParser *parser)
+{
+	UErrorCode error = U_ZERO_ERROR;
+	UChar *last_uchar;
+	const gchar *last_utf8;
+	gint length;
+
+	parser->utxt_size = 0;
+	parser->cursor = 0;
+
+	if (!parser->converter) {
+		/* Open converter UTF-8 to UChar */
+		parser->converter = ucnv_open ("UTF-8", &error);
+		if (!parser->converter) {
+			g_warning ("Cannot open UTF-8 converter: '%s'",
+			           U_FAILURE (error) ? u_errorName (error) : "none");
+			return;
+		}
+	} else {
+		ucnv_reset (parser->converter);
+	}
+
+	length = parser->segment_end - parser->segment_start;
+
+	/* Grow UChars and offsets buffers if needed */
+	if (length + 1 > parser->utxt_allocated) {
+		g_free (parser->utxt);
+		g_free (parser->offsets);
+
+		parser->utxt_allocated = length + 1;
+		parser->utxt = g_malloc (parser->utxt_allocated * sizeof (UChar));
+		parser->offsets = g_malloc (parser->utxt_allocated * sizeof (gint32));
+	}
+
+	/* last_uchar and last_utf8 will be also an output parameter! */
+	last_uchar = parser->utxt;
+	last_utf8 = &parser->txt[parser->segment_start];
+
+	/* Convert to UChars storing offsets */
+	ucnv_toUnicode (parser->converter,
+	                &last_uchar,
+	                &parser->utxt[length],
+	                &last_utf8,
+	                &parser->txt[parser->segment_end],
+	                parser->offsets,
+	                FALSE,
+	                &error);
+	if (U_SUCCESS (error)) {
+		/* Proper UChar array size is now given by 'last_uchar' */
+		parser->utxt_size = last_uchar - parser->utxt;
+
+		/* Open word-break iterator, or reuse the one we have */
+		if (!parser->bi) {
+			parser->bi = ubrk_open (UBRK_WORD,
+			                        setlocale (LC_CTYPE, NULL),
+			                        parser->utxt,
+			                        parser->utxt_size,
+			                        &error);
+		} else {
+			ubrk_setText (parser->bi,
+			              parser->utxt,
+			              parser->utxt_size,
+			              &error);
+		}
+
+		if (U_SUCCESS (error)) {
+			/* Find FIRST word in the UChar array */
+			parser->cursor = ubrk_first (parser->bi);
+		}
+	}
+
+	/* If any error happened, skip the segment */
+	if (U_FAILURE (error)) {
+		g_warning ("Error initializing libicu support: '%s'",
+		           u_errorName (error));
+		parser->utxt_size = 0;
+		parser->cursor = 0;
+
+		if (parser->bi) {
+			ubrk_close (parser->bi);
+			parser->bi = NULL;
+		}
+	}
+}
+
 static gboolean
-parser_next (TrackerParser *parser,
-             gint          *byte_offset_start,
-             gint          *byte_offset_end,
-             gboolean      *stop_word)
+parser_next_segment (TrackerParser *parser)
 {
-	gsize word_length_uchar = 0;
-	gsize word_length_utf8 = 0;
-	gchar *processed_word = NULL;
-	gsize current_word_offset_utf8;
+	gint start, end;
 
-	*byte_offset_start = 0;
-	*byte_offset_end = 0;
+	start = parser->segment_end;
 
-	g_return_val_if_fail (parser, FALSE);
+	if (start >= parser->txt_size) {
+		return FALSE;
+	}
+
+	end = find_ascii_segment_end (parser->txt, start, parser->txt_size);
+
+	if (end > start) {
+		parser->segment_is_ascii = TRUE;
+		parser->ascii_cursor = start;
+	} else {
+		end = find_unicode_segment_end (parser->txt, start, parser->txt_size);
+		parser->segment_is_ascii = FALSE;
+	}
+
+	parser->segment_start = start;
+	parser->segment_end = end;
+
+	if (!parser->segment_is_ascii) {
+		parser_setup_unicode_segment (parser);
+	}
+
+	return TRUE;
+}
+
+static const gchar *
+parser_next_ascii (TrackerParser *parser,
+                   gint          *byte_offset_start,
+                   gint          *byte_offset_end,
+                   gboolean      *stop_word)
+{
+	const gchar *txt = parser->txt;
+	gint end = parser->segment_end;
+
+	while (parser->ascii_cursor < end) {
+		const gchar *processed_word;
+		gint word_start, i;
+		guint word_length;
+
+		word_start = i = parser->ascii_cursor;
+
+		/* Anything else than word characters is a single
+		 * character word ICU would ignore.
+		 */
+		if (!IS_ASCII_WORD_CHAR (txt[i])) {
+			parser->ascii_cursor++;
+			continue;
+		}
+
+		for (i++; i < end; i++) {
+			gchar c = txt[i];
+
+			if (IS_ASCII_WORD_CHAR (c)) {
+				continue;
+			}
+
+			/* Apostrophes between letters or digits, and
+			 * commas or semicolons between digits, don't
+			 * break words. Dots would neither, but are
+			 * forced word breaks.
+			 */
+			if (i + 1 < end &&
+			    (((c == '\'') &&
+			      IS_ASCII_ALPHA (txt[i - 1]) && IS_ASCII_ALPHA (txt[i + 1])) ||
+			     ((c == '\'' || c == ',' || c == ';') &&
+			      IS_ASCII_DIGIT (txt[i - 1]) && IS_ASCII_DIGIT (txt[i + 1])))) {
+				i++;
+				continue;
+			}
+
+			break;
+		}
+
+		parser->ascii_cursor = i;
+		word_length = i - word_start;
+
+		/* Ignore the word if longer than the maximum allowed */
+		if (word_length >= parser->max_word_length ||
+		    word_length >= WORD_BUFFER_LENGTH) {
+			continue;
+		}
+
+		/* Ignore numbers if requested */
+		if (parser->ignore_numbers && IS_ASCII_DIGIT (txt[word_start])) {
+			continue;
+		}
+
+		/* check if word is reserved */
+		if (parser->ignore_reserved_words &&
+		    tracker_parser_is_reserved_word_utf8 (&txt[word_start],
+		                                          word_length)) {
+			continue;
+		}
+
+		processed_word = process_word_ascii (parser,
+		                                     &txt[word_start],
+		                                     word_length,
+		                                     stop_word);
+
+		*byte_offset_start = word_start;
+		*byte_offset_end = i;
+
+		return processed_word;
+	}
+
+	return NULL;
+}
+
+static const gchar *
+parser_next_unicode (TrackerParser *parser,
+                     gint          *byte_offset_start,
+                     gint          *byte_offset_end,
+                     gboolean      *stop_word)
+{
+	gsize word_length_uchar = 0;
+	gsize word_length_utf8 = 0;
+	const gchar *processed_word = NULL;
+	gsize current_word_offset_utf8 = 0;
 
 	/* Loop to look for next valid word */
 	while (!processed_word &&
@@ -452,7 +769,7 @@ parser_next (TrackerParser *parser,
 		gsize truncated_length;
 
 		/* Set current word offset in the original UTF-8 string */
-		current_word_offset_utf8 = parser->offsets[parser->cursor];
+		current_word_offset_utf8 = parser->segment_start + parser->offsets[parser->cursor];
 
 		/* Find next word break. */
 		next_word_offset_uchar = ubrk_next (parser->bi);
@@ -472,23 +789,16 @@ parser_next (TrackerParser *parser,
 		if (next_word_offset_uchar >= parser->utxt_size) {
 			/* Last word support... */
 			next_word_offset_uchar = parser->utxt_size;
-			next_word_offset_utf8 = parser->txt_size;
+			next_word_offset_utf8 = parser->segment_end;
 		} else {
-			next_word_offset_utf8 = parser->offsets[next_word_offset_uchar];
+			next_word_offset_utf8 = parser->segment_start + parser->offsets[next_word_offset_uchar];
 		}
 
 		/* Word end is the first byte after the word, which is either the
-		 *  start of next word or the end of the string */
+		 *  start of next word or the end of the segment */
 		word_length_uchar = next_word_offset_uchar - parser->cursor;
 		word_length_utf8 = next_word_offset_utf8 - current_word_offset_utf8;
 
-		/* g_debug ("word_length_uchar: %" G_GSIZE_FORMAT, word_length_uchar); */
-		/* g_debug ("next_word_offset_uchar: %" G_GSIZE_FORMAT, next_word_offset_uchar); */
-		/* g_debug ("current_word_offset_uchar: %" G_GSIZE_FORMAT, parser->cursor); */
-		/* g_debug ("word_length_utf8: %" G_GSIZE_FORMAT, word_length_utf8); */
-		/* g_debug ("next_word_offset_utf8: %" G_GSIZE_FORMAT, next_word_offset_utf8); */
-		/* g_debug ("current_word_offset_utf8: %" G_GSIZE_FORMAT, current_word_offset_utf8); */
-
 		/* Ignore the word if longer than the maximum allowed */
 		if (word_length_utf8 >= parser->max_word_length) {
 			/* Ignore this word and keep on looping */
@@ -530,8 +840,7 @@ parser_next (TrackerParser *parser,
 		                    2 * WORD_BUFFER_LENGTH);
 
 		/* Process the word here. If it fails, we can still go
-		 *  to the next one. Returns newly allocated UTF-8
-		 *  string always.
+		 *  to the next one.
 		 * Enable UNAC stripping only if no ASCII and no CJK
 		 * Note we are passing UChar encoded string here!
 		 */
@@ -555,12 +864,44 @@ parser_next (TrackerParser *parser,
 
 		/* Update cursor */
 		parser->cursor += word_length_uchar;
+	}
 
-		parser->word_length = strlen (processed_word);
-		parser->word = processed_word;
+	return processed_word;
+}
 
-		return TRUE;
-	}
+static gboolean
+parser_next (TrackerParser *parser,
+             gint          *byte_offset_start,
+             gint          *byte_offset_end,
+             gboolean      *stop_word)
+{
+	const gchar *processed_word;
+
+	*byte_offset_start = 0;
+	*byte_offset_end = 0;
+
+	g_return_val_if_fail (parser, FALSE);
+
+	do {
+		if (parser->segment_is_ascii) {
+			processed_word = parser_next_ascii (parser,
+			                                    byte_offset_start,
+			                                    byte_offset_end,
+			                                    stop_word);
+		} else {
+			processed_word = parser_next_unicode (parser,
+			                                      byte_offset_start,
+			                                      byte_offset_end,
+			                                      stop_word);
+		}
+
+		if (processed_word) {
+			parser->word_length = strlen (processed_word);
+			parser->word = processed_word;
+
+			return TRUE;
+		}
+	} while (parser_next_segment (parser));
 
 	/* No more words... */
 	return FALSE;
@@ -593,10 +934,14 @@ tracker_parser_free (TrackerParser *parser)
 		ubrk_close (parser->bi);
 	}
 
+	if (parser->converter) {
+		ucnv_close (parser->converter);
+	}
+
 	g_free (parser->utxt);
 	g_free (parser->offsets);
 
-	g_free (parser->word);
+	g_free (parser->word_stemmed);
 
 	g_free (parser);
 }
@@ -612,11 +957,6 @@ tracker_parser_reset (TrackerParser *parser,
                       gboolean       ignore_reserved_words,
                       gboolean       ignore_numbers)
 {
-	UErrorCode error = U_ZERO_ERROR;
-	UConverter *converter;
-	UChar *last_uchar;
-	const gchar *last_utf8;
-
 	g_return_if_fail (parser != NULL);
 	g_return_if_fail (txt != NULL);
 
@@ -635,82 +975,21 @@ tracker_parser_reset (TrackerParser *parser,
 	parser->txt_size = txt_size;
 	parser->txt = txt;
 
-	g_free (parser->word);
+	g_free (parser->word_stemmed);
+	parser->word_stemmed = NULL;
 	parser->word = NULL;
 
-	if (parser->bi) {
-		ubrk_close (parser->bi);
-		parser->bi = NULL;
-	}
-	g_free (parser->utxt);
-	parser->utxt = NULL;
-	g_free (parser->offsets);
-	parser->offsets = NULL;
-
 	parser->word_position = 0;
 
+	/* Start with an empty segment, the first one
+	 * is looked up on the first parser_next() call.
+	 */
+	parser->segment_start = 0;
+	parser->segment_end = 0;
+	parser->segment_is_ascii = TRUE;
+	parser->ascii_cursor = 0;
+	parser->utxt_size = 0;
 	parser->cursor = 0;
-
-	/* Open converter UTF-8 to UChar */
-	converter = ucnv_open ("UTF-8", &error);
-	if (!converter) {
-		g_warning ("Cannot open UTF-8 converter: '%s'",
-		           U_FAILURE (error) ? u_errorName (error) : "none");
-		return;
-	}
-
-	/* Allocate UChars and offsets buffers */
-	parser->utxt_size = txt_size + 1;
-	parser->utxt = g_malloc (parser->utxt_size * sizeof (UChar));
-	parser->offsets = g_malloc (parser->utxt_size * sizeof (gint32));
-
-	/* last_uchar and last_utf8 will be also an output parameter! */
-	last_uchar = parser->utxt;
-	last_utf8 = parser->txt;
-
-	/* Convert to UChars storing offsets */
-	ucnv_toUnicode (converter,
-	                &last_uchar,
-	                &parser->utxt[txt_size],
-	                &last_utf8,
-	                &parser->txt[txt_size],
-	                parser->offsets,
-	                FALSE,
-	                &error);
-	if (U_SUCCESS (error)) {
-		/* Proper UChar array size is now given by 'last_uchar' */
-		parser->utxt_size = last_uchar - parser->utxt;
-
-		/* Open word-break iterator */
-		parser->bi = ubrk_open(UBRK_WORD,
-		                       setlocale (LC_CTYPE, NULL),
-		                       parser->utxt,
-		                       parser->utxt_size,
-		                       &error);
-		if (U_SUCCESS (error)) {
-			/* Find FIRST word in the UChar array */
-			parser->cursor = ubrk_first (parser->bi);
-		}
-	}
-
-	/* If any error happened, reset buffers */
-	if (U_FAILURE (error)) {
-		g_warning ("Error initializing libicu support: '%s'",
-		           u_errorName (error));
-		/* Reset buffers */
-		g_free (parser->utxt);
-		parser->utxt = NULL;
-		g_free (parser->offsets);
-		parser->offsets = NULL;
-		parser->utxt_size = 0;
-		if (parser->bi) {
-			ubrk_close (parser->bi);
-			parser->bi = NULL;
-		}
-	}
-
-	/* Close converter */
-	ucnv_close (converter);
 }
 
 const gchar *
@@ -726,8 +1005,10 @@ tracker_parser_next (TrackerParser *parser,
 
 	str = NULL;
 
-	g_free (parser->word);
+	g_free (parser->word_stemmed);
+	parser->word_stemmed = NULL;
 	parser->word = NULL;
+	parser->word_length = 0;
 
 	*stop_word = FALSE;
 
@@ -746,4 +1027,3 @@ tracker_parser_next (TrackerParser *parser,
 
 	return str;
 }
-
@@ -47,6 +47,8 @@ struct _TrackerClassPrivate {
 	GArray *domain_indexes;
 	GArray *last_domain_indexes;
 	GArray *last_super_classes;
+	GArray *composite_indexes;
+	GArray *partial_indexes;
 
 	struct {
 		struct {
@@ -72,6 +74,18 @@ struct _TrackerClassPrivate {
 
 static void class_finalize     (GObject      *object);
 
+static void
+free_index_declarations (GArray *declarations)
+{
+	guint i;
+
+	for (i = 0; i < declarations->len; i++) {
+		g_free (g_array_index (declarations, gchar *, i));
+	}
+
+	g_array_free (declarations, TRUE);
+}
+
 G_DEFINE_TYPE (TrackerClass, tracker_class, G_TYPE_OBJECT);
 
 static void
@@ -96,6 +110,8 @@ tracker_class_init (TrackerClass *service)
 	priv->domain_indexes = g_array_new (TRUE, TRUE, sizeof (TrackerProperty *));
 	priv->last_domain_indexes = NULL;
 	priv->last_super_classes = NULL;
+	priv->composite_indexes = g_array_new (TRUE, TRUE, sizeof (gchar *));
+	priv->partial_indexes = g_array_new (TRUE, TRUE, sizeof (gchar *));
 
 	priv->deletes.pending.sub_pred_ids = g_array_new (FALSE, FALSE, sizeof (gint64));
 	priv->deletes.pending.obj_graph_ids = g_array_new (FALSE, FALSE, sizeof (gint64));
@@ -123,6 +139,8 @@ class_finalize (GObject *object)
 
 	g_array_free (priv->super_classes, TRUE);
 	g_array_free (priv->domain_indexes, TRUE);
+	free_index_declarations (priv->composite_indexes);
+	free_index_declarations (priv->partial_indexes);
 
 	g_array_free (priv->deletes.pending.sub_pred_ids, TRUE);
 	g_array_free (priv->deletes.pending.obj_graph_ids, TRUE);
@@ -268,6 +286,30 @@ tracker_class_get_last_domain_indexes (TrackerClass *service)
 	return (TrackerProperty **) (priv->last_domain_indexes ? priv->last_domain_indexes->data : NULL);
 }
 
+const gchar **
+tracker_class_get_composite_indexes (TrackerClass *service)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_CLASS (service), NULL);
+
+	priv = GET_PRIV (service);
+
+	return (const gchar **) priv->composite_indexes->data;
+}
+
+const gchar **
+tracker_class_get_partial_indexes (TrackerClass *service)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_CLASS (service), NULL);
+
+	priv = GET_PRIV (service);
+
+	return (const gchar **) priv->partial_indexes->data;
+}
+
 TrackerClass **
 tracker_class_get_last_super_classes (TrackerClass *service)
 {
@@ -469,6 +511,53 @@ tracker_class_reset_domain_indexes (TrackerClass *service)
 	priv->domain_indexes = g_array_new (TRUE, TRUE, sizeof (TrackerProperty *));
 }
 
+void
+tracker_class_add_composite_index (TrackerClass *service,
+                                   const gchar  *value)
+{
+	TrackerClassPrivate *priv;
+	gchar *copy;
+
+	g_return_if_fail (TRACKER_IS_CLASS (service));
+	g_return_if_fail (value != NULL);
+
+	priv = GET_PRIV (service);
+
+	copy = g_strdup (value);
+	g_array_append_val (priv->composite_indexes, copy);
+}
+
+void
+tracker_class_add_partial_index (TrackerClass *service,
+                                 const gchar  *value)
+{
+	TrackerClassPrivate *priv;
+	gchar *copy;
+
+	g_return_if_fail (TRACKER_IS_CLASS (service));
+	g_return_if_fail (value != NULL);
+
+	priv = GET_PRIV (service);
+
+	copy = g_strdup (value);
+	g_array_append_val (priv->partial_indexes, copy);
+}
+
+void
+tracker_class_reset_composite_indexes (TrackerClass *service)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_CLASS (service));
+
+	priv = GET_PRIV (service);
+
+	free_index_declarations (priv->composite_indexes);
+	free_index_declarations (priv->partial_indexes);
+	priv->composite_indexes = g_array_new (TRUE, TRUE, sizeof (gchar *));
+	priv->partial_indexes = g_array_new (TRUE, TRUE, sizeof (gchar *));
+}
+
 void
 tracker_class_set_is_new (TrackerClass *service,
                           gboolean      value)
@@ -629,6 +718,110 @@ tracker_class_reset_pending_events (TrackerClass *class)
 
 }
 
+/* Events are kept sorted on subject and predicate, so the ones
+ * cancelling out each other can be found quickly. Literal objects
+ * all have object ID 0, replacing a literal value is a change even
+ * though its delete and insert events look alike, so only events on
+ * resource objects are ever found.
+ */
+static gint
+find_event (GArray *sub_pred_ids,
+            GArray *obj_graph_ids,
+            gint64  sub_pred_id,
+            gint64  obj_graph_id)
+{
+	guint i, j, k;
+
+	if ((obj_graph_id >> 32) == 0) {
+		return -1;
+	}
+
+	i = 0;
+	j = sub_pred_ids->len;
+
+	while (i < j) {
+		k = (i + j) / 2;
+		if (g_array_index (sub_pred_ids, gint64, k) < sub_pred_id)
+			i = k + 1;
+		else
+			j = k;
+	}
+
+	for (; i < sub_pred_ids->len; i++) {
+		if (g_array_index (sub_pred_ids, gint64, i) != sub_pred_id)
+			break;
+		if (g_array_index (obj_graph_ids, gint64, i) == obj_graph_id)
+			return i;
+	}
+
+	return -1;
+}
+
+/* Drops the events in the first arrays that undo one in the others,
+ * along with the undone event. An insert followed by a delete of the
+ * same statement, or the other way around, leaves nothing to notify.
+ */
+static void
+cancel_events (GArray *sub_pred_ids,
+               GArray *obj_graph_ids,
+               GArray *other_sub_pred_ids,
+               GArray *other_obj_graph_ids)
+{
+	guint i = 0;
+	gint other;
+
+	while (i < sub_pred_ids->len) {
+		other = find_event (other_sub_pred_ids, other_obj_graph_ids,
+		                    g_array_index (sub_pred_ids, gint64, i),
+		                    g_array_index (obj_graph_ids, gint64, i));
+
+		if (other < 0) {
+			i++;
+			continue;
+		}
+
+		g_array_remove_index (other_sub_pred_ids, other);
+		g_array_remove_index (other_obj_graph_ids, other);
+		g_array_remove_index (sub_pred_ids, i);
+		g_array_remove_index (obj_graph_ids, i);
+	}
+}
+
+static void
+merge_events (GArray *sub_pred_ids,
+              GArray *obj_graph_ids,
+              GArray *pending_sub_pred_ids,
+              GArray *pending_obj_graph_ids)
+{
+	guint i, j, k;
+
+	i = sub_pred_ids->len;
+	j = pending_sub_pred_ids->len;
+	k = i + j;
+
+	g_array_set_size (sub_pred_ids, k);
+	g_array_set_size (obj_graph_ids, k);
+
+	/* Merge from the end, pending events go after ready ones
+	 * with the same subject and predicate.
+	 */
+	while (j > 0) {
+		k--;
+
+		if (i > 0 &&
+		    g_array_index (sub_pred_ids, gint64, i - 1) >
+		    g_array_index (pending_sub_pred_ids, gint64, j - 1)) {
+			i--;
+			g_array_index (sub_pred_ids, gint64, k) = g_array_index (sub_pred_ids, gint64, i);
+			g_array_index (obj_graph_ids, gint64, k) = g_array_index (obj_graph_ids, gint64, i);
+		} else {
+			j--;
+			g_array_index (sub_pred_ids, gint64, k) = g_array_index (pending_sub_pred_ids, gint64, j);
+			g_array_index (obj_graph_ids, gint64, k) = g_array_index (pending_obj_graph_ids, gint64, j);
+		}
+	}
+}
+
 void
 tracker_class_transact_events (TrackerClass *class)
 {
@@ -637,16 +830,22 @@ tracker_class_transact_events (TrackerClass *class)
 	g_return_if_fail (TRACKER_IS_CLASS (class));
 	priv = GET_PRIV (class);
 
-	/* Move */
-	g_array_insert_vals (priv->deletes.ready.obj_graph_ids,
-	                     priv->deletes.ready.obj_graph_ids->len,
-	                     priv->deletes.pending.obj_graph_ids->data,
-	                     priv->deletes.pending.obj_graph_ids->len);
+	/* Coalesce with the events of earlier transactions not yet emitted */
+	cancel_events (priv->deletes.pending.sub_pred_ids,
+	               priv->deletes.pending.obj_graph_ids,
+	               priv->inserts.ready.sub_pred_ids,
+	               priv->inserts.ready.obj_graph_ids);
+
+	cancel_events (priv->inserts.pending.sub_pred_ids,
+	               priv->inserts.pending.obj_graph_ids,
+	               priv->deletes.ready.sub_pred_ids,
+	               priv->deletes.ready.obj_graph_ids);
 
-	g_array_insert_vals (priv->deletes.ready.sub_pred_ids,
-	                     priv->deletes.ready.sub_pred_ids->len,
-	                     priv->deletes.pending.sub_pred_ids->data,
-	                     priv->deletes.pending.sub_pred_ids->len);
+	/* Move */
+	merge_events (priv->deletes.ready.sub_pred_ids,
+	              priv->deletes.ready.obj_graph_ids,
+	              priv->deletes.pending.sub_pred_ids,
+	              priv->deletes.pending.obj_graph_ids);
 
 	/* Reset */
 	g_array_set_size (priv->deletes.pending.sub_pred_ids, 0);
@@ -654,15 +853,10 @@ tracker_class_transact_events (TrackerClass *class)
 
 
 	/* Move */
-	g_array_insert_vals (priv->inserts.ready.obj_graph_ids,
-	                     priv->inserts.ready.obj_graph_ids->len,
-	                     priv->inserts.pending.obj_graph_ids->data,
-	                     priv->inserts.pending.obj_graph_ids->len);
-
-	g_array_insert_vals (priv->inserts.ready.sub_pred_ids,
-	                     priv->inserts.ready.sub_pred_ids->len,
-	                     priv->inserts.pending.sub_pred_ids->data,
-	                     priv->inserts.pending.sub_pred_ids->len);
+	merge_events (priv->inserts.ready.sub_pred_ids,
+	              priv->inserts.ready.obj_graph_ids,
+	              priv->inserts.pending.sub_pred_ids,
+	              priv->inserts.pending.obj_graph_ids);
 
 	/* Reset */
 	g_array_set_size (priv->inserts.pending.sub_pred_ids, 0);
@@ -678,8 +872,7 @@ insert_vals_into_arrays (GArray *sub_pred_ids,
                          gint    pred_id,
                          gint    object_id)
 {
-	gint i, j, k;
-	gint64 tmp;
+	guint i, j, k;
 	gint64 sub_pred_id;
 	gint64 obj_graph_id;
 
@@ -688,16 +881,13 @@ insert_vals_into_arrays (GArray *sub_pred_ids,
 	obj_graph_id = (gint64) object_id;
 	obj_graph_id = obj_graph_id << 32 | graph_id;
 
+	/* Insert after the events with the same subject and predicate */
 	i = 0;
-	j = sub_pred_ids->len - 1;
+	j = sub_pred_ids->len;
 
-	while (j - i > 0) {
+	while (i < j) {
 		k = (i + j) / 2;
-		tmp = g_array_index (sub_pred_ids, gint64, k);
-		if (tmp == sub_pred_id) {
-			i = k + 1;
-			break;
-		} else if (tmp > sub_pred_id)
+		if (g_array_index (sub_pred_ids, gint64, k) > sub_pred_id)
 			j = k;
 		else
 			i = k + 1;
@@ -707,6 +897,35 @@ insert_vals_into_arrays (GArray *sub_pred_ids,
 	g_array_insert_val (obj_graph_ids, i, obj_graph_id);
 }
 
+static gboolean
+remove_vals_from_arrays (GArray *sub_pred_ids,
+                         GArray *obj_graph_ids,
+                         gint    graph_id,
+                         gint    subject_id,
+                         gint    pred_id,
+                         gint    object_id)
+{
+	gint64 sub_pred_id;
+	gint64 obj_graph_id;
+	gint i;
+
+	sub_pred_id = (gint64) subject_id;
+	sub_pred_id = sub_pred_id << 32 | pred_id;
+	obj_graph_id = (gint64) object_id;
+	obj_graph_id = obj_graph_id << 32 | graph_id;
+
+	i = find_event (sub_pred_ids, obj_graph_ids, sub_pred_id, obj_graph_id);
+
+	if (i < 0) {
+		return FALSE;
+	}
+
+	g_array_remove_index (sub_pred_ids, i);
+	g_array_remove_index (obj_graph_ids, i);
+
+	return TRUE;
+}
+
 void
 tracker_class_add_insert_event (TrackerClass *class,
                                 gint          graph_id,
@@ -746,3 +965,43 @@ tracker_class_add_delete_event (TrackerClass *class,
 	                         pred_id,
 	                         object_id);
 }
+
+gboolean
+tracker_class_remove_insert_event (TrackerClass *class,
+                                   gint          graph_id,
+                                   gint          subject_id,
+                                   gint          pred_id,
+                                   gint          object_id)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_CLASS (class), FALSE);
+	priv = GET_PRIV (class);
+
+	return remove_vals_from_arrays (priv->inserts.pending.sub_pred_ids,
+	                                priv->inserts.pending.obj_graph_ids,
+	                                graph_id,
+	                                subject_id,
+	                                pred_id,
+	                                object_id);
+}
+
+gboolean
+tracker_class_remove_delete_event (TrackerClass *class,
+                                   gint          graph_id,
+                                   gint          subject_id,
+                                   gint          pred_id,
+                                   gint          object_id)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_CLASS (class), FALSE);
+	priv = GET_PRIV (class);
+
+	return remove_vals_from_arrays (priv->deletes.pending.sub_pred_ids,
+	                                priv->deletes.pending.obj_graph_ids,
+	                                graph_id,
+	                                subject_id,
+	                                pred_id,
+	                                object_id);
+}
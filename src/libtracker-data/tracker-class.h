@@ -70,6 +70,8 @@ TrackerClass    **tracker_class_get_super_classes      (TrackerClass        *ser
 TrackerProperty **tracker_class_get_domain_indexes     (TrackerClass        *service);
 TrackerProperty **tracker_class_get_last_domain_indexes(TrackerClass        *service);
 TrackerClass    **tracker_class_get_last_super_classes (TrackerClass        *service);
+const gchar     **tracker_class_get_composite_indexes  (TrackerClass        *service);
+const gchar     **tracker_class_get_partial_indexes    (TrackerClass        *service);
 
 void              tracker_class_set_uri                (TrackerClass        *service,
                                                         const gchar         *value);
@@ -83,6 +85,11 @@ void              tracker_class_del_domain_index       (TrackerClass        *ser
                                                         TrackerProperty     *value);
 void              tracker_class_reset_domain_indexes   (TrackerClass        *service);
 void              tracker_class_reset_super_classes   (TrackerClass        *service);
+void              tracker_class_add_composite_index    (TrackerClass        *service,
+                                                        const gchar         *value);
+void              tracker_class_add_partial_index      (TrackerClass        *service,
+                                                        const gchar         *value);
+void              tracker_class_reset_composite_indexes (TrackerClass       *service);
 void              tracker_class_set_id                 (TrackerClass        *service,
                                                         gint                 id);
 void              tracker_class_set_is_new             (TrackerClass        *service,
@@ -114,6 +121,16 @@ void              tracker_class_add_insert_event       (TrackerClass        *cla
                                                         gint                 subject_id,
                                                         gint                 pred_id,
                                                         gint                 object_id);
+gboolean          tracker_class_remove_delete_event    (TrackerClass        *class,
+                                                        gint                 graph_id,
+                                                        gint                 subject_id,
+                                                        gint                 pred_id,
+                                                        gint                 object_id);
+gboolean          tracker_class_remove_insert_event    (TrackerClass        *class,
+                                                        gint                 graph_id,
+                                                        gint                 subject_id,
+                                                        gint                 pred_id,
+                                                        gint                 object_id);
 
 G_END_DECLS
 
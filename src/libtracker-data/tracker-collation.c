@@ -40,11 +40,18 @@
 #elif HAVE_LIBICU
 #include <unicode/ucol.h>
 #include <unicode/utypes.h>
+#include <unicode/uvernum.h>
 #endif
 
 /* If string lenth less than this value, allocating from the stack */
 #define MAX_STACK_STR_SIZE 8192
 
+/* Sorting and DISTINCT compare lots of identical strings, these
+ * are equal whatever the locale, no need to collate them.
+ */
+#define COLLATION_SAME_BYTES(len1, str1, len2, str2) \
+	((len1) == (len2) && memcmp ((str1), (str2), (len1)) == 0)
+
 #ifdef HAVE_LIBUNISTRING /* ---- GNU libunistring based collation ---- */
 
 gpointer
@@ -77,6 +84,9 @@ tracker_collation_utf8 (gpointer      collator,
 	gchar *aux1;
 	gchar *aux2;
 
+	if (COLLATION_SAME_BYTES (len1, str1, len2, str2))
+		return 0;
+
 	/* Note: str1 and str2 are NOT NUL-terminated */
 	aux1 = (len1 < MAX_STACK_STR_SIZE) ? g_alloca (len1+1) : g_malloc (len1+1);
 	aux2 = (len2 < MAX_STACK_STR_SIZE) ? g_alloca (len2+1) : g_malloc (len2+1);
@@ -145,21 +155,37 @@ tracker_collation_utf8 (gpointer      collator,
                         gconstpointer str2)
 {
 	UErrorCode status = U_ZERO_ERROR;
-	UCharIterator iter1;
-	UCharIterator iter2;
 	UCollationResult result;
 
 	/* Collator must be created before trying to collate */
 	g_return_val_if_fail (collator, -1);
 
-	/* Setup iterators */
-	uiter_setUTF8 (&iter1, str1, len1);
-	uiter_setUTF8 (&iter2, str2, len2);
+	if (COLLATION_SAME_BYTES (len1, str1, len2, str2))
+		return 0;
 
-	result = ucol_strcollIter ((UCollator *)collator,
-	                           &iter1,
-	                           &iter2,
+#if U_ICU_VERSION_MAJOR_NUM >= 50
+	/* Works on the UTF-8 directly, with fast paths for Latin
+	 * text, instead of decoding through iterators.
+	 */
+	result = ucol_strcollUTF8 ((UCollator *)collator,
+	                           str1, len1,
+	                           str2, len2,
 	                           &status);
+#else
+	{
+		UCharIterator iter1;
+		UCharIterator iter2;
+
+		/* Setup iterators */
+		uiter_setUTF8 (&iter1, str1, len1);
+		uiter_setUTF8 (&iter2, str2, len2);
+
+		result = ucol_strcollIter ((UCollator *)collator,
+		                           &iter1,
+		                           &iter2,
+		                           &status);
+	}
+#endif
 	if (status != U_ZERO_ERROR)
 		g_critical ("Error collating: %s", u_errorName (status));
 
@@ -224,6 +250,9 @@ tracker_collation_utf8 (gpointer      collator,
 	gchar *aux1;
 	gchar *aux2;
 
+	if (COLLATION_SAME_BYTES (len1, str1, len2, str2))
+		return 0;
+
 	/* Note: str1 and str2 are NOT NUL-terminated */
 	aux1 = (len1 < MAX_STACK_STR_SIZE) ? g_alloca (len1+1) : g_malloc (len1+1);
 	aux2 = (len2 < MAX_STACK_STR_SIZE) ? g_alloca (len2+1) : g_malloc (len2+1);
@@ -325,6 +325,208 @@ set_index_for_multi_value_property (TrackerDBInterface  *iface,
 	}
 }
 
+static gboolean
+is_class_column (TrackerClass *class,
+                 const gchar  *field_name)
+{
+	TrackerProperty **properties;
+	guint n_props, i;
+
+	properties = tracker_ontologies_get_properties (&n_props);
+
+	for (i = 0; i < n_props; i++) {
+		if (!tracker_property_get_multiple_values (properties[i]) &&
+		    tracker_property_get_domain (properties[i]) == class &&
+		    g_strcmp0 (tracker_property_get_name (properties[i]), field_name) == 0) {
+			return TRUE;
+		}
+	}
+
+	for (properties = tracker_class_get_domain_indexes (class); *properties; properties++) {
+		if (g_strcmp0 (tracker_property_get_name (*properties), field_name) == 0) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* A tracker:compositeIndex or tracker:partialIndex declaration lists
+ * single-valued columns of the class table, separated by spaces or
+ * commas. Trailing columns make the index covering for queries that
+ * only read them. Partial indexes only include the rows where the
+ * first column is set. */
+static gchar *
+get_composite_index_sql (TrackerClass  *class,
+                         const gchar   *declaration,
+                         gboolean       partial,
+                         gchar        **index_name)
+{
+	const gchar *service_name;
+	const gchar *first_field = NULL;
+	gchar **fields, *sql;
+	GString *name, *columns;
+	gint i;
+
+	service_name = tracker_class_get_name (class);
+	fields = g_strsplit_set (declaration, " \t\n,", -1);
+
+	name = g_string_new (service_name);
+	g_string_append (name, partial ? "_partial" : "_composite");
+	columns = g_string_new (NULL);
+
+	for (i = 0; fields[i]; i++) {
+		if (fields[i][0] == '\0') {
+			continue;
+		}
+
+		if (!is_class_column (class, fields[i])) {
+			g_critical ("Index '%s' of %s: %s is not a single-valued property of the class",
+			            declaration, service_name, fields[i]);
+			break;
+		}
+
+		if (!first_field) {
+			first_field = fields[i];
+		} else {
+			g_string_append (columns, ", ");
+		}
+
+		g_string_append_printf (name, "_%s", fields[i]);
+		g_string_append_printf (columns, "\"%s\"", fields[i]);
+	}
+
+	if (fields[i] || !first_field) {
+		if (!first_field) {
+			g_critical ("Index of %s lists no properties", service_name);
+		}
+
+		g_string_free (name, TRUE);
+		g_string_free (columns, TRUE);
+		g_strfreev (fields);
+		return NULL;
+	}
+
+	if (partial) {
+		sql = g_strdup_printf ("CREATE INDEX \"%s\" ON \"%s\" (%s) WHERE \"%s\" IS NOT NULL",
+		                       name->str, service_name, columns->str, first_field);
+	} else {
+		sql = g_strdup_printf ("CREATE INDEX \"%s\" ON \"%s\" (%s)",
+		                       name->str, service_name, columns->str);
+	}
+
+	*index_name = g_string_free (name, FALSE);
+	g_string_free (columns, TRUE);
+	g_strfreev (fields);
+
+	return sql;
+}
+
+static void
+add_composite_indexes (GHashTable    *indexes,
+                       TrackerClass  *class,
+                       const gchar  **declarations,
+                       gboolean       partial)
+{
+	while (*declarations) {
+		gchar *index_name, *sql;
+
+		sql = get_composite_index_sql (class, *declarations, partial, &index_name);
+
+		if (sql) {
+			g_hash_table_insert (indexes, index_name, sql);
+		}
+
+		declarations++;
+	}
+}
+
+/* Creates the declared composite and partial indexes of the class table
+ * that don't exist yet and drops the ones no longer declared, all of
+ * them get created again if recreate is set */
+static void
+set_composite_indexes_for_class (TrackerDBInterface  *iface,
+                                 TrackerClass        *class,
+                                 gboolean             recreate,
+                                 GError             **error)
+{
+	GError *internal_error = NULL;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GHashTable *declared;
+	GPtrArray *existing;
+	GHashTableIter iter;
+	gpointer key, value;
+	const gchar *service_name;
+	guint i;
+
+	service_name = tracker_class_get_name (class);
+
+	declared = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	add_composite_indexes (declared, class, tracker_class_get_composite_indexes (class), FALSE);
+	add_composite_indexes (declared, class, tracker_class_get_partial_indexes (class), TRUE);
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &internal_error,
+	                                              "SELECT name FROM sqlite_master "
+	                                              "WHERE type = 'index' AND tbl_name = ? AND "
+	                                              "(name GLOB ? || '_composite_*' OR name GLOB ? || '_partial_*')");
+
+	if (!stmt) {
+		g_hash_table_unref (declared);
+		g_propagate_error (error, internal_error);
+		return;
+	}
+
+	tracker_db_statement_bind_text (stmt, 0, service_name);
+	tracker_db_statement_bind_text (stmt, 1, service_name);
+	tracker_db_statement_bind_text (stmt, 2, service_name);
+	cursor = tracker_db_statement_start_cursor (stmt, &internal_error);
+	g_object_unref (stmt);
+
+	existing = g_ptr_array_new_with_free_func (g_free);
+
+	while (cursor && tracker_db_cursor_iter_next (cursor, NULL, &internal_error)) {
+		g_ptr_array_add (existing, g_strdup (tracker_db_cursor_get_string (cursor, 0, NULL)));
+	}
+
+	if (cursor) {
+		g_object_unref (cursor);
+	}
+
+	for (i = 0; !internal_error && i < existing->len; i++) {
+		const gchar *index_name = g_ptr_array_index (existing, i);
+
+		if (recreate || !g_hash_table_contains (declared, index_name)) {
+			g_debug ("Dropping composite index: DROP INDEX IF EXISTS \"%s\"", index_name);
+
+			tracker_db_interface_execute_query (iface, &internal_error,
+			                                    "DROP INDEX IF EXISTS \"%s\"",
+			                                    index_name);
+		}
+
+		if (!recreate) {
+			/* Kept, or not declared anymore */
+			g_hash_table_remove (declared, index_name);
+		}
+	}
+
+	g_hash_table_iter_init (&iter, declared);
+
+	while (!internal_error && g_hash_table_iter_next (&iter, &key, &value)) {
+		g_debug ("Creating composite index: %s", (const gchar *) value);
+
+		tracker_db_interface_execute_query (iface, &internal_error,
+		                                    "%s", (const gchar *) value);
+	}
+
+	if (internal_error) {
+		g_propagate_error (error, internal_error);
+	}
+
+	g_ptr_array_unref (existing);
+	g_hash_table_unref (declared);
+}
+
 static gboolean
 is_allowed_conversion (const gchar *oldv,
                        const gchar *newv,
@@ -603,6 +805,7 @@ tracker_data_ontology_load_statement (const gchar *ontology_path,
 				} else {
 					/* Reset for a correct post-check */
 					tracker_class_reset_domain_indexes (class);
+					tracker_class_reset_composite_indexes (class);
 					tracker_class_reset_super_classes (class);
 					tracker_class_set_notify (class, FALSE);
 				}
@@ -889,6 +1092,39 @@ tracker_data_ontology_load_statement (const gchar *ontology_path,
 			tracker_property_add_domain_index (property, class);
 		}
 
+	} else if (g_strcmp0 (predicate, TRACKER_PREFIX_TRACKER "compositeIndex") == 0 ||
+	           g_strcmp0 (predicate, TRACKER_PREFIX_TRACKER "partialIndex") == 0) {
+		TrackerClass *class;
+		gboolean partial;
+		const gchar **declarations;
+
+		class = tracker_ontologies_get_class_by_uri (subject);
+
+		if (class == NULL) {
+			g_critical ("%s: Unknown class %s", ontology_path, subject);
+			return;
+		}
+
+		/* The columns are checked when creating the index, their
+		 * properties might be defined later on */
+		partial = g_str_has_suffix (predicate, "partialIndex");
+		declarations = partial ? tracker_class_get_partial_indexes (class) :
+		                         tracker_class_get_composite_indexes (class);
+
+		while (*declarations) {
+			if (g_strcmp0 (*declarations, object) == 0) {
+				g_debug ("%s: Index '%s' already declared in %s",
+				         ontology_path, object, subject);
+				return;
+			}
+			declarations++;
+		}
+
+		if (partial) {
+			tracker_class_add_partial_index (class, object);
+		} else {
+			tracker_class_add_composite_index (class, object);
+		}
 	} else if (g_strcmp0 (predicate, TRACKER_PREFIX_TRACKER "writeback") == 0) {
 		TrackerProperty *property;
 
@@ -911,6 +1147,17 @@ tracker_data_ontology_load_statement (const gchar *ontology_path,
 		}
 
 		tracker_property_set_force_journal (property, (strcmp (object, "true") == 0));
+	} else if (g_strcmp0 (predicate, TRACKER_PREFIX_TRACKER "aggregated") == 0) {
+		TrackerProperty *property;
+
+		property = tracker_ontologies_get_property_by_uri (subject);
+
+		if (property == NULL) {
+			g_critical ("%s: Unknown property %s", ontology_path, subject);
+			return;
+		}
+
+		tracker_property_set_aggregated (property, (strcmp (object, "true") == 0));
 	} else if (g_strcmp0 (predicate, RDFS_SUB_PROPERTY_OF) == 0) {
 		TrackerProperty *property, *super_property;
 		gboolean is_new;
@@ -1471,6 +1718,90 @@ check_for_deleted_super_properties (TrackerProperty  *property,
 	}
 }
 
+static void
+check_for_deleted_index_declarations (TrackerClass  *class,
+                                      const gchar   *predicate,
+                                      const gchar  **declarations)
+{
+	TrackerProperty *property;
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GPtrArray *deleted;
+	GError *error = NULL;
+	guint i;
+
+	property = tracker_ontologies_get_property_by_uri (predicate);
+
+	if (!property) {
+		return;
+	}
+
+	iface = tracker_db_manager_get_db_interface ();
+
+	/* The table doesn't exist yet when the ontology that defines the
+	 * predicate is new, nothing was declared before then */
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, NULL,
+	                                              "SELECT \"%s\" FROM \"%s\" "
+	                                              "WHERE ID = (SELECT ID FROM Resource WHERE Uri = ?)",
+	                                              tracker_property_get_name (property),
+	                                              tracker_property_get_table_name (property));
+
+	if (!stmt) {
+		return;
+	}
+
+	tracker_db_statement_bind_text (stmt, 0, tracker_class_get_uri (class));
+	cursor = tracker_db_statement_start_cursor (stmt, NULL);
+	g_object_unref (stmt);
+
+	if (!cursor) {
+		return;
+	}
+
+	deleted = g_ptr_array_new_with_free_func (g_free);
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+		const gchar *last_declaration;
+		const gchar **d;
+
+		last_declaration = tracker_db_cursor_get_string (cursor, 0, NULL);
+
+		for (d = declarations; *d; d++) {
+			if (g_strcmp0 (*d, last_declaration) == 0) {
+				break;
+			}
+		}
+
+		if (!*d) {
+			g_ptr_array_add (deleted, g_strdup (last_declaration));
+		}
+	}
+
+	g_object_unref (cursor);
+
+	/* The index itself is dropped when the class table is created */
+	for (i = 0; i < deleted->len; i++) {
+		const gchar *declaration = g_ptr_array_index (deleted, i);
+
+		g_debug ("Ontology change: deleting %s: %s", predicate, declaration);
+
+		tracker_data_delete_statement (NULL, tracker_class_get_uri (class),
+		                               predicate, declaration, &error);
+
+		if (!error) {
+			tracker_data_update_buffer_flush (&error);
+		}
+
+		if (error) {
+			g_critical ("Ontology change, %s", error->message);
+			g_clear_error (&error);
+		}
+	}
+
+	g_ptr_array_unref (deleted);
+}
+
 static void
 tracker_data_ontology_process_changes_pre_db (GPtrArray  *seen_classes,
                                               GPtrArray  *seen_properties,
@@ -1483,6 +1814,12 @@ tracker_data_ontology_process_changes_pre_db (GPtrArray  *seen_classes,
 			TrackerClass *class = g_ptr_array_index (seen_classes, i);
 
 			check_for_deleted_domain_index (class);
+			check_for_deleted_index_declarations (class,
+			                                      TRACKER_PREFIX_TRACKER "compositeIndex",
+			                                      tracker_class_get_composite_indexes (class));
+			check_for_deleted_index_declarations (class,
+			                                      TRACKER_PREFIX_TRACKER "partialIndex",
+			                                      tracker_class_get_partial_indexes (class));
 			check_for_deleted_super_classes (class, &n_error);
 
 			if (n_error) {
@@ -2116,6 +2453,54 @@ class_add_domain_indexes_from_db (TrackerDBInterface *iface,
 	}
 }
 
+static void
+class_add_index_declarations_from_db (TrackerDBInterface *iface,
+                                      TrackerClass       *class,
+                                      const gchar        *predicate)
+{
+	TrackerProperty *property;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+
+	property = tracker_ontologies_get_property_by_uri (predicate);
+
+	if (!property) {
+		return;
+	}
+
+	/* Databases created before the predicate was in the ontology
+	 * don't have the table yet */
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, NULL,
+	                                              "SELECT \"%s\" FROM \"%s\" "
+	                                              "WHERE ID = ?",
+	                                              tracker_property_get_name (property),
+	                                              tracker_property_get_table_name (property));
+
+	if (!stmt) {
+		return;
+	}
+
+	tracker_db_statement_bind_int (stmt, 0, tracker_class_get_id (class));
+	cursor = tracker_db_statement_start_cursor (stmt, NULL);
+	g_object_unref (stmt);
+
+	if (cursor) {
+		while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+			const gchar *declaration;
+
+			declaration = tracker_db_cursor_get_string (cursor, 0, NULL);
+
+			if (g_str_has_suffix (predicate, "partialIndex")) {
+				tracker_class_add_partial_index (class, declaration);
+			} else {
+				tracker_class_add_composite_index (class, declaration);
+			}
+		}
+
+		g_object_unref (cursor);
+	}
+}
+
 static void
 property_add_super_properties_from_db (TrackerDBInterface *iface,
                                        TrackerProperty *property)
@@ -2459,6 +2844,10 @@ db_get_static_data (TrackerDBInterface  *iface,
 	classes = tracker_ontologies_get_classes (&n_classes);
 	for (i = 0; i < n_classes; i++) {
 		class_add_domain_indexes_from_db (iface, classes[i]);
+		class_add_index_declarations_from_db (iface, classes[i],
+		                                      TRACKER_PREFIX_TRACKER "compositeIndex");
+		class_add_index_declarations_from_db (iface, classes[i],
+		                                      TRACKER_PREFIX_TRACKER "partialIndex");
 	}
 
 	if (internal_error) {
@@ -3253,11 +3642,19 @@ create_decomposed_metadata_tables (TrackerDBInterface  *iface,
 
 			if (internal_error) {
 				g_propagate_error (error, internal_error);
-				break;
+				goto error_out;
 			}
 		}
 	}
 
+	/* After the copy, building the index once is cheaper than
+	 * updating it for every row. A recreated table lost them. */
+	set_composite_indexes_for_class (iface, service, in_change, &internal_error);
+
+	if (internal_error) {
+		g_propagate_error (error, internal_error);
+	}
+
 error_out:
 
 	if (copy_schedule) {
@@ -3488,7 +3885,8 @@ tracker_data_manager_recreate_indexes (TrackerBusyCallback    busy_callback,
 {
 	GError *internal_error = NULL;
 	TrackerProperty **properties;
-	guint n_properties;
+	TrackerClass **classes;
+	guint n_properties, n_classes;
 	guint i;
 
 	properties = tracker_ontologies_get_properties (&n_properties);
@@ -3524,6 +3922,21 @@ tracker_data_manager_recreate_indexes (TrackerBusyCallback    busy_callback,
 			               busy_user_data);
 		}
 	}
+
+	classes = tracker_ontologies_get_classes (&n_classes);
+
+	for (i = 0; i < n_classes; i++) {
+		set_composite_indexes_for_class (tracker_db_manager_get_db_interface (),
+		                                 classes[i], TRUE, &internal_error);
+
+		if (internal_error) {
+			g_critical ("Unable to create composite indexes for %s: %s",
+			            tracker_class_get_name (classes[i]),
+			            internal_error->message);
+			g_clear_error (&internal_error);
+		}
+	}
+
 	g_debug ("  Finished index re-creation...");
 }
 
@@ -4606,6 +5019,32 @@ tracker_data_manager_init (TrackerDBManagerFlags   flags,
 	}
 #endif /* DISABLE_JOURNAL */
 
+#if HAVE_TRACKER_FTS
+	/* If the FTS prefix indexes or language detection settings
+	 * changed, rebuild the FTS table */
+	if (!read_only && !is_first_time_index &&
+	    tracker_db_interface_sqlite_fts_settings_changed (iface)) {
+		GHashTable *fts_properties, *multivalued;
+
+		if (busy_callback) {
+			busy_status = g_strdup_printf ("%s - %s",
+			                               busy_operation,
+			                               "Rebuilding full-text search index");
+			busy_callback (busy_status, 0, busy_user_data);
+			g_free (busy_status);
+		}
+
+		ontology_get_fts_properties (FALSE, &fts_properties, &multivalued);
+
+		tracker_db_interface_start_transaction (iface);
+		tracker_db_interface_sqlite_fts_alter_table (iface, fts_properties, multivalued);
+		tracker_db_interface_end_db_transaction (iface, NULL);
+
+		g_hash_table_unref (fts_properties);
+		g_hash_table_unref (multivalued);
+	}
+#endif
+
 	/* If locale changed, re-create indexes */
 	if (!read_only && tracker_db_manager_locale_changed ()) {
 		/* Report OPERATION - STATUS */
@@ -4641,9 +5080,12 @@ tracker_data_manager_init (TrackerDBManagerFlags   flags,
 	}
 
 	if (!read_only) {
+		tracker_data_change_log_init (iface);
 		tracker_ontologies_sort ();
 	}
 
+	tracker_data_statistics_init (iface, read_only);
+
 	initialized = TRUE;
 
 	g_free (ontologies_dir);
@@ -147,3 +147,149 @@ tracker_data_query_sparql_cursor (const gchar  *query,
 	return cursor;
 }
 
+/**
+ * tracker_data_query_changes_since:
+ * @modseq: the last modseq seen by the caller
+ * @class_ids: (array length=n_class_ids): IDs of the classes to get
+ * changes for, or %NULL for all of them
+ * @n_class_ids: length of @class_ids
+ * @limit: about how many changes to return at most, or -1
+ * @error: return location for errors
+ *
+ * Queries the change log for changes after @modseq. The cursor has
+ * the modseq, class, subject and predicate of each change, and 1
+ * for inserts or 0 for deletes. The changes of a transaction are
+ * never split, so the last modseq can be passed on to get the next
+ * changes.
+ *
+ * If changes after @modseq were trimmed from the log already,
+ * %TRACKER_DB_CHANGES_EXPIRED is returned.
+ *
+ * Returns: a cursor on the changes, or %NULL on error.
+ **/
+TrackerDBCursor *
+tracker_data_query_changes_since (gint     modseq,
+                                  gint    *class_ids,
+                                  gint     n_class_ids,
+                                  gint     limit,
+                                  GError **error)
+{
+	static TrackerPropertyType types[] = {
+		TRACKER_PROPERTY_TYPE_INTEGER,
+		TRACKER_PROPERTY_TYPE_RESOURCE,
+		TRACKER_PROPERTY_TYPE_RESOURCE,
+		TRACKER_PROPERTY_TYPE_RESOURCE,
+		TRACKER_PROPERTY_TYPE_INTEGER
+	};
+	static const gchar *variable_names[] = {
+		"modseq", "class", "subject", "predicate", "op"
+	};
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL, *start_cursor;
+	GError *inner_error = NULL;
+	GString *filter, *sql;
+	gint i, start = 0;
+
+	iface = tracker_db_manager_get_db_interface ();
+
+	/* The statement reading the start of the log is left pending
+	 * along with the cursor, so both read the same snapshot of the
+	 * database, and the log can't be trimmed in between.
+	 */
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, error,
+	                                              "SELECT Modseq FROM ChangeLogStart");
+
+	if (!stmt) {
+		return NULL;
+	}
+
+	start_cursor = tracker_db_statement_start_cursor (stmt, error);
+	g_object_unref (stmt);
+
+	if (!start_cursor) {
+		return NULL;
+	}
+
+	if (tracker_db_cursor_iter_next (start_cursor, NULL, &inner_error)) {
+		start = tracker_db_cursor_get_int (start_cursor, 0);
+	}
+
+	if (inner_error) {
+		g_propagate_error (error, inner_error);
+		g_object_unref (start_cursor);
+		return NULL;
+	}
+
+	if (start == 0 || modseq < start - 1) {
+		g_set_error (error,
+		             TRACKER_DB_INTERFACE_ERROR,
+		             TRACKER_DB_CHANGES_EXPIRED,
+		             "Changes since modseq %d are no longer logged",
+		             modseq);
+		g_object_unref (start_cursor);
+		return NULL;
+	}
+
+	filter = g_string_new ("Modseq > ?1");
+
+	if (n_class_ids > 0) {
+		g_string_append (filter, " AND Class IN (");
+
+		for (i = 0; i < n_class_ids; i++) {
+			g_string_append_printf (filter, i > 0 ? ", %d" : "%d", class_ids[i]);
+		}
+
+		g_string_append_c (filter, ')');
+	}
+
+	sql = g_string_new ("SELECT Modseq, "
+	                    "(SELECT Uri FROM Resource WHERE ID = Class), "
+	                    "(SELECT Uri FROM Resource WHERE ID = Subject), "
+	                    "(SELECT Uri FROM Resource WHERE ID = Predicate), "
+	                    "Op FROM ChangeLog WHERE ");
+	g_string_append (sql, filter->str);
+
+	if (limit > 0) {
+		/* Stop before the transaction of the change past the
+		 * limit, unless it's the first one */
+		g_string_append_printf (sql,
+		                        " AND Modseq < MAX("
+		                        "COALESCE((SELECT Modseq FROM ChangeLog WHERE %s ORDER BY ID LIMIT 1 OFFSET ?2), %d), "
+		                        "(SELECT MIN(Modseq) FROM ChangeLog WHERE %s) + 1)",
+		                        filter->str, G_MAXINT, filter->str);
+	}
+
+	g_string_append (sql, " ORDER BY ID");
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, error,
+	                                              "%s", sql->str);
+
+	if (stmt) {
+		tracker_db_statement_bind_int (stmt, 0, modseq);
+
+		if (limit > 0) {
+			tracker_db_statement_bind_int (stmt, 1, limit);
+		}
+
+		cursor = tracker_db_statement_start_sparql_cursor (stmt,
+		                                                   types, G_N_ELEMENTS (types),
+		                                                   variable_names, G_N_ELEMENTS (variable_names),
+		                                                   FALSE,
+		                                                   error);
+		g_object_unref (stmt);
+	}
+
+	if (cursor) {
+		g_object_set_data_full (G_OBJECT (cursor), "tracker-change-log-start",
+		                        start_cursor, g_object_unref);
+	} else {
+		g_object_unref (start_cursor);
+	}
+
+	g_string_free (filter, TRUE);
+	g_string_free (sql, TRUE);
+
+	return cursor;
+}
+
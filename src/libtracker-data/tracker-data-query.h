@@ -36,6 +36,11 @@ G_BEGIN_DECLS
 gint                 tracker_data_query_resource_id   (const gchar  *uri);
 TrackerDBCursor     *tracker_data_query_sparql_cursor (const gchar  *query,
                                                        GError      **error);
+TrackerDBCursor     *tracker_data_query_changes_since (gint          modseq,
+                                                       gint         *class_ids,
+                                                       gint          n_class_ids,
+                                                       gint          limit,
+                                                       GError      **error);
 
 GPtrArray*           tracker_data_query_rdf_type      (gint          id);
 
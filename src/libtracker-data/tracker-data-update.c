@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <string.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
@@ -28,6 +29,10 @@
 #include <libtracker-common/tracker-common.h>
 #include <libtracker-sparql/tracker-sparql.h>
 
+#if HAVE_TRACKER_FTS
+#include <libtracker-fts/tracker-fts.h>
+#endif
+
 #include "tracker-class.h"
 #include "tracker-data-manager.h"
 #include "tracker-data-update.h"
@@ -59,9 +64,15 @@ struct _TrackerDataUpdateBuffer {
 	/* the following two fields are valid per sqlite transaction, not just for same subject */
 	/* TrackerClass -> integer */
 	GHashTable *class_counts;
+	/* TrackerProperty -> integer */
+	GHashTable *property_counts;
+	/* TrackerProperty -> gdouble*, change of the sum of tracker:aggregated ones */
+	GHashTable *property_sums;
 
 #if HAVE_TRACKER_FTS
 	gboolean fts_ever_updated;
+	/* resources queued for deferred FTS updates */
+	gboolean fts_queued;
 #endif
 };
 
@@ -79,6 +90,8 @@ struct _TrackerDataUpdateBufferResource {
 
 #if HAVE_TRACKER_FTS
 	gboolean fts_updated;
+	/* queued for FTS indexing before, nothing of it is indexed */
+	gboolean fts_unindexed;
 #endif
 };
 
@@ -151,6 +164,25 @@ static GPtrArray *commit_callbacks = NULL;
 static GPtrArray *rollback_callbacks = NULL;
 static gint max_service_id = 0;
 static gint max_ontology_id = 0;
+#if HAVE_TRACKER_FTS
+static gboolean fts_deferred = FALSE;
+static volatile gint fts_pending = 0;
+#endif
+
+/* The change log keeps about the last CHANGE_LOG_MAX_ROWS changes,
+ * trimmed every CHANGE_LOG_TRIM_INTERVAL logged changes.
+ */
+#define CHANGE_LOG_MAX_ROWS      100000
+#define CHANGE_LOG_TRIM_INTERVAL 10000
+
+static gint change_log_modseq = 0;
+static volatile gint change_log_start = 0;
+static guint change_log_untrimmed = 0;
+
+/* Class and property counts are saved on commit */
+static gboolean statistics_enabled = FALSE;
+/* the Statistics and Aggregates tables can be read */
+static gboolean statistics_available = FALSE;
 
 static gint         ensure_resource_id         (const gchar      *uri,
                                                 gboolean         *create);
@@ -447,15 +479,47 @@ tracker_data_update_get_next_modseq (void)
 		g_error_free (error);
 	}
 
+	/* Resources modified last may be gone, the change log still
+	 * has their modseq */
+	max_modseq = MAX (change_log_modseq, max_modseq);
+
 	return ++max_modseq;
 }
 
+static void change_log_insert_cb (gint         graph_id,
+                                  const gchar *graph,
+                                  gint         subject_id,
+                                  const gchar *subject,
+                                  gint         pred_id,
+                                  gint         object_id,
+                                  const gchar *object,
+                                  GPtrArray   *rdf_types,
+                                  gpointer     user_data);
+static void change_log_delete_cb (gint         graph_id,
+                                  const gchar *graph,
+                                  gint         subject_id,
+                                  const gchar *subject,
+                                  gint         pred_id,
+                                  gint         object_id,
+                                  const gchar *object,
+                                  GPtrArray   *rdf_types,
+                                  gpointer     user_data);
+
 void
 tracker_data_update_shutdown (void)
 {
 	max_service_id = 0;
 	max_ontology_id = 0;
 	transaction_modseq = 0;
+
+	tracker_data_remove_insert_statement_callback (change_log_insert_cb, NULL);
+	tracker_data_remove_delete_statement_callback (change_log_delete_cb, NULL);
+	change_log_modseq = 0;
+	change_log_untrimmed = 0;
+	g_atomic_int_set (&change_log_start, 0);
+
+	statistics_enabled = FALSE;
+	statistics_available = FALSE;
 }
 
 static gint
@@ -473,6 +537,238 @@ get_transaction_modseq (void)
 	return transaction_modseq;
 }
 
+static void
+change_log_add (gint       subject_id,
+                gint       pred_id,
+                GPtrArray *rdf_types,
+                gboolean   insert)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+	gint modseq;
+	guint i;
+
+	if (in_ontology_transaction || rdf_types == NULL) {
+		return;
+	}
+
+	iface = tracker_db_manager_get_db_interface ();
+	modseq = get_transaction_modseq ();
+
+	for (i = 0; i < rdf_types->len; i++) {
+		TrackerClass *class = g_ptr_array_index (rdf_types, i);
+
+		/* Same changes as GraphUpdated signals */
+		if (!tracker_class_get_notify (class)) {
+			continue;
+		}
+
+		stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &error,
+		                                              "INSERT INTO ChangeLog (Modseq, Class, Subject, Predicate, Op) VALUES (?, ?, ?, ?, ?)");
+
+		if (stmt) {
+			tracker_db_statement_bind_int (stmt, 0, modseq);
+			tracker_db_statement_bind_int (stmt, 1, tracker_class_get_id (class));
+			tracker_db_statement_bind_int (stmt, 2, subject_id);
+			tracker_db_statement_bind_int (stmt, 3, pred_id);
+			tracker_db_statement_bind_int (stmt, 4, insert ? 1 : 0);
+			tracker_db_statement_execute (stmt, &error);
+			g_object_unref (stmt);
+		}
+
+		if (error) {
+			g_warning ("Could not log change: %s", error->message);
+			g_error_free (error);
+			return;
+		}
+
+		change_log_modseq = MAX (change_log_modseq, modseq);
+		change_log_untrimmed++;
+	}
+}
+
+static void
+change_log_insert_cb (gint         graph_id,
+                      const gchar *graph,
+                      gint         subject_id,
+                      const gchar *subject,
+                      gint         pred_id,
+                      gint         object_id,
+                      const gchar *object,
+                      GPtrArray   *rdf_types,
+                      gpointer     user_data)
+{
+	change_log_add (subject_id, pred_id, rdf_types, TRUE);
+}
+
+static void
+change_log_delete_cb (gint         graph_id,
+                      const gchar *graph,
+                      gint         subject_id,
+                      const gchar *subject,
+                      gint         pred_id,
+                      gint         object_id,
+                      const gchar *object,
+                      GPtrArray   *rdf_types,
+                      gpointer     user_data)
+{
+	change_log_add (subject_id, pred_id, rdf_types, FALSE);
+}
+
+static gint
+change_log_query_int (TrackerDBInterface  *iface,
+                      const gchar         *query,
+                      GError             **error)
+{
+	TrackerDBCursor *cursor = NULL;
+	TrackerDBStatement *stmt;
+	gint value = 0;
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, error,
+	                                              "%s", query);
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, error);
+		g_object_unref (stmt);
+	}
+
+	if (cursor) {
+		if (tracker_db_cursor_iter_next (cursor, NULL, error)) {
+			value = tracker_db_cursor_get_int (cursor, 0);
+		}
+
+		g_object_unref (cursor);
+	}
+
+	return value;
+}
+
+/* Drops the oldest changes, whole transactions at a time */
+static void
+change_log_trim (TrackerDBInterface *iface)
+{
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+	gint modseq;
+
+	change_log_untrimmed = 0;
+
+	modseq = change_log_query_int (iface,
+	                               "SELECT Modseq FROM ChangeLog WHERE ID <= "
+	                               "(SELECT MAX(ID) FROM ChangeLog) - " G_STRINGIFY (CHANGE_LOG_MAX_ROWS) " "
+	                               "ORDER BY ID DESC LIMIT 1",
+	                               &error);
+
+	if (error || modseq == 0) {
+		g_clear_error (&error);
+		return;
+	}
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &error,
+	                                              "DELETE FROM ChangeLog WHERE Modseq <= ?");
+
+	if (stmt) {
+		tracker_db_statement_bind_int (stmt, 0, modseq);
+		tracker_db_statement_execute (stmt, &error);
+		g_object_unref (stmt);
+	}
+
+	if (!error) {
+		tracker_db_interface_execute_query (iface, &error,
+		                                    "UPDATE ChangeLogStart SET Modseq = %d",
+		                                    modseq + 1);
+	}
+
+	if (error) {
+		g_warning ("Could not trim the change log: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	g_atomic_int_set (&change_log_start, modseq + 1);
+}
+
+/**
+ * tracker_data_change_log_init:
+ * @iface: the database interface of the writer
+ *
+ * Creates the change log tables if needed and starts logging the
+ * changes to classes with tracker:notify set, the same ones sent
+ * in GraphUpdated signals.
+ **/
+void
+tracker_data_change_log_init (TrackerDBInterface *iface)
+{
+	GError *error = NULL;
+	gint start;
+
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "CREATE TABLE IF NOT EXISTS ChangeLog ("
+	                                    "ID INTEGER NOT NULL PRIMARY KEY, "
+	                                    "Modseq INTEGER NOT NULL, "
+	                                    "Class INTEGER NOT NULL, "
+	                                    "Subject INTEGER NOT NULL, "
+	                                    "Predicate INTEGER NOT NULL, "
+	                                    "Op INTEGER NOT NULL)");
+
+	if (!error) {
+		tracker_db_interface_execute_query (iface, &error,
+		                                    "CREATE INDEX IF NOT EXISTS ChangeLog_Modseq "
+		                                    "ON ChangeLog (Modseq)");
+	}
+
+	/* First modseq whose changes are all logged */
+	if (!error) {
+		tracker_db_interface_execute_query (iface, &error,
+		                                    "CREATE TABLE IF NOT EXISTS ChangeLogStart ("
+		                                    "Modseq INTEGER NOT NULL)");
+	}
+
+	if (!error) {
+		change_log_modseq = change_log_query_int (iface, "SELECT MAX(Modseq) FROM ChangeLog", &error);
+	}
+
+	if (!error) {
+		start = change_log_query_int (iface, "SELECT Modseq FROM ChangeLogStart", &error);
+	}
+
+	if (error) {
+		g_warning ("Could not initialize the change log: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	/* The modseq may have been picked before the log was read */
+	if (transaction_modseq != 0 && transaction_modseq <= change_log_modseq) {
+		transaction_modseq = change_log_modseq + 1;
+	}
+
+	if (start == 0) {
+		start = get_transaction_modseq ();
+		tracker_db_interface_execute_query (iface, NULL,
+		                                    "INSERT INTO ChangeLogStart (Modseq) VALUES (%d)",
+		                                    start);
+	}
+
+	g_atomic_int_set (&change_log_start, start);
+
+	tracker_data_add_insert_statement_callback (change_log_insert_cb, NULL);
+	tracker_data_add_delete_statement_callback (change_log_delete_cb, NULL);
+}
+
+/**
+ * tracker_data_get_change_log_start:
+ *
+ * Returns: the first modseq whose changes are all in the change log,
+ * or 0 if there's no change log. Can be called from any thread.
+ **/
+gint
+tracker_data_get_change_log_start (void)
+{
+	return g_atomic_int_get (&change_log_start);
+}
+
 static TrackerDataUpdateBufferTable *
 cache_table_new (gboolean multiple_values)
 {
@@ -562,6 +858,15 @@ cache_insert_value (const gchar            *table_name,
 	property.graph = graph;
 #if HAVE_TRACKER_FTS
 	property.fts = fts;
+
+	/* Big texts are tokenized on worker threads while the
+	 * rest of the update goes on, fts_view has single values
+	 * as is, so only those can be matched later on.
+	 */
+	if (fts && !fts_deferred && !multiple_values &&
+	    G_VALUE_HOLDS_STRING (value)) {
+		tracker_fts_pretokenize (g_value_get_string (value), -1);
+	}
 #endif
 	property.date_time = date_time;
 
@@ -599,121 +904,685 @@ cache_delete_value (const gchar            *table_name,
 #endif
 	property.date_time = date_time;
 
-	table = cache_ensure_table (table_name, multiple_values, transient);
-	table->delete_value = TRUE;
-	g_array_append_val (table->properties, property);
+	table = cache_ensure_table (table_name, multiple_values, transient);
+	table->delete_value = TRUE;
+	g_array_append_val (table->properties, property);
+}
+
+static gint
+query_resource_id (const gchar *uri)
+{
+	gint id;
+
+	id = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.resource_cache, uri));
+
+	if (id == 0) {
+		id = tracker_data_query_resource_id (uri);
+
+		if (id) {
+			g_hash_table_insert (update_buffer.resource_cache, g_strdup (uri), GINT_TO_POINTER (id));
+		}
+	}
+
+	return id;
+}
+
+static gint
+ensure_resource_id (const gchar *uri,
+                    gboolean    *create)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+	gint id;
+
+	id = query_resource_id (uri);
+
+	if (create) {
+		*create = (id == 0);
+	}
+
+	if (id == 0) {
+		iface = tracker_db_manager_get_db_interface ();
+
+		id = tracker_data_update_get_new_service_id ();
+		stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &error,
+		                                              "INSERT INTO Resource (ID, Uri) VALUES (?, ?)");
+
+		if (stmt) {
+			tracker_db_statement_bind_int (stmt, 0, id);
+			tracker_db_statement_bind_text (stmt, 1, uri);
+			tracker_db_statement_execute (stmt, &error);
+			g_object_unref (stmt);
+		}
+
+		if (error) {
+			g_critical ("Could not ensure resource existence: %s", error->message);
+			g_error_free (error);
+		}
+
+#ifndef DISABLE_JOURNAL
+		if (!in_journal_replay) {
+			tracker_db_journal_append_resource (id, uri);
+		}
+#endif /* DISABLE_JOURNAL */
+
+		g_hash_table_insert (update_buffer.resource_cache, g_strdup (uri), GINT_TO_POINTER (id));
+	}
+
+	return id;
+}
+
+static void
+statement_bind_gvalue (TrackerDBStatement *stmt,
+                       gint               *idx,
+                       const GValue       *value)
+{
+	GType type;
+
+	type = G_VALUE_TYPE (value);
+	switch (type) {
+	case G_TYPE_STRING:
+		tracker_db_statement_bind_text (stmt, (*idx)++, g_value_get_string (value));
+		break;
+	case G_TYPE_INT64:
+		tracker_db_statement_bind_int (stmt, (*idx)++, g_value_get_int64 (value));
+		break;
+	case G_TYPE_DOUBLE:
+		tracker_db_statement_bind_double (stmt, (*idx)++, g_value_get_double (value));
+		break;
+	default:
+		if (type == TRACKER_TYPE_DATE_TIME) {
+			tracker_db_statement_bind_double (stmt, (*idx)++, tracker_date_time_get_time (value));
+			tracker_db_statement_bind_int (stmt, (*idx)++, tracker_date_time_get_local_date (value));
+			tracker_db_statement_bind_int (stmt, (*idx)++, tracker_date_time_get_local_time (value));
+		} else {
+			g_warning ("Unknown type for binding: %s\n", G_VALUE_TYPE_NAME (value));
+		}
+		break;
+	}
+}
+
+static void
+add_class_count (TrackerClass *class,
+                 gint          count)
+{
+	gint old_count_entry;
+
+	tracker_class_set_count (class, tracker_class_get_count (class) + count);
+
+	/* update class_counts table so that the count change can be reverted in case of rollback */
+	if (!update_buffer.class_counts) {
+		update_buffer.class_counts = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+
+	old_count_entry = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.class_counts, class));
+	g_hash_table_insert (update_buffer.class_counts, class,
+	                     GINT_TO_POINTER (old_count_entry + count));
+}
+
+static gboolean
+property_has_count (TrackerProperty *property)
+{
+	/* rdf:type values are the class counts, transient
+	 * values are gone after a restart */
+	return (property != tracker_ontologies_get_rdf_type () &&
+	        !tracker_property_get_transient (property));
+}
+
+static void
+add_property_count (TrackerProperty *property,
+                    gint             count)
+{
+	gint old_count_entry;
+
+	if (count == 0 || !property_has_count (property)) {
+		return;
+	}
+
+	tracker_property_set_count (property, tracker_property_get_count (property) + count);
+
+	/* same as class_counts, reverted in case of rollback */
+	if (!update_buffer.property_counts) {
+		update_buffer.property_counts = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+
+	old_count_entry = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.property_counts, property));
+	g_hash_table_insert (update_buffer.property_counts, property,
+	                     GINT_TO_POINTER (old_count_entry + count));
+}
+
+static gboolean
+property_has_sum (TrackerProperty *property)
+{
+	TrackerPropertyType type = tracker_property_get_data_type (property);
+
+	return (tracker_property_get_aggregated (property) &&
+	        property_has_count (property) &&
+	        (type == TRACKER_PROPERTY_TYPE_INTEGER || type == TRACKER_PROPERTY_TYPE_DOUBLE));
+}
+
+/* @sign is 1 for an added value, -1 for a removed one */
+static void
+add_property_sum (TrackerProperty *property,
+                  const GValue    *value,
+                  gint             sign)
+{
+	gdouble *sum;
+
+	if (!statistics_enabled || !property_has_sum (property)) {
+		return;
+	}
+
+	if (!update_buffer.property_sums) {
+		update_buffer.property_sums = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	}
+
+	sum = g_hash_table_lookup (update_buffer.property_sums, property);
+
+	if (!sum) {
+		sum = g_new0 (gdouble, 1);
+		g_hash_table_insert (update_buffer.property_sums, property, sum);
+	}
+
+	if (G_VALUE_HOLDS_INT64 (value)) {
+		*sum += sign * g_value_get_int64 (value);
+	} else if (G_VALUE_HOLDS_DOUBLE (value)) {
+		*sum += sign * g_value_get_double (value);
+	}
+}
+
+static void
+statistics_set (TrackerDBInterface  *iface,
+                gint                 id,
+                gint                 count,
+                GError             **error)
+{
+	TrackerDBStatement *stmt;
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, error,
+	                                              "INSERT OR REPLACE INTO Statistics (ID, Count) VALUES (?, ?)");
+
+	if (stmt) {
+		tracker_db_statement_bind_int (stmt, 0, id);
+		tracker_db_statement_bind_int (stmt, 1, count);
+		tracker_db_statement_execute (stmt, error);
+		g_object_unref (stmt);
+	}
+}
+
+/* Saves the counts changed in the current transaction */
+static void
+statistics_save (TrackerDBInterface *iface)
+{
+	GHashTableIter iter;
+	gpointer key;
+	GError *error = NULL;
+
+	if (!statistics_enabled) {
+		return;
+	}
+
+	if (update_buffer.class_counts) {
+		g_hash_table_iter_init (&iter, update_buffer.class_counts);
+
+		while (!error && g_hash_table_iter_next (&iter, &key, NULL)) {
+			statistics_set (iface,
+			                tracker_class_get_id (key),
+			                tracker_class_get_count (key),
+			                &error);
+		}
+	}
+
+	if (update_buffer.property_counts) {
+		g_hash_table_iter_init (&iter, update_buffer.property_counts);
+
+		while (!error && g_hash_table_iter_next (&iter, &key, NULL)) {
+			statistics_set (iface,
+			                tracker_property_get_id (key),
+			                tracker_property_get_count (key),
+			                &error);
+		}
+	}
+
+	if (update_buffer.property_sums) {
+		gpointer value;
+
+		g_hash_table_iter_init (&iter, update_buffer.property_sums);
+
+		while (!error && g_hash_table_iter_next (&iter, &key, &value)) {
+			TrackerDBStatement *stmt;
+
+			stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &error,
+			                                              "UPDATE Aggregates SET Sum = Sum + ? WHERE ID = ?");
+
+			if (stmt) {
+				tracker_db_statement_bind_double (stmt, 0, *(gdouble *) value);
+				tracker_db_statement_bind_int (stmt, 1, tracker_property_get_id (key));
+				tracker_db_statement_execute (stmt, &error);
+				g_object_unref (stmt);
+			}
+		}
+
+		g_hash_table_remove_all (update_buffer.property_sums);
+	}
+
+	if (error) {
+		g_warning ("Could not save statistics: %s", error->message);
+		g_error_free (error);
+	}
+}
+
+static gint
+statistics_count (TrackerDBInterface  *iface,
+                  GError             **error,
+                  const gchar         *query,
+                  ...)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	gchar *sql;
+	va_list args;
+	gint count = 0;
+
+	va_start (args, query);
+	sql = g_strdup_vprintf (query, args);
+	va_end (args);
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, error,
+	                                              "%s", sql);
+	g_free (sql);
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, error);
+		g_object_unref (stmt);
+	}
+
+	if (cursor) {
+		if (tracker_db_cursor_iter_next (cursor, NULL, error)) {
+			count = tracker_db_cursor_get_int (cursor, 0);
+		}
+
+		g_object_unref (cursor);
+	}
+
+	return count;
+}
+
+/* Counts everything once, for databases created before the
+ * Statistics table */
+static void
+statistics_count_all (TrackerDBInterface  *iface,
+                      GError             **error)
+{
+	TrackerClass **classes;
+	TrackerProperty **properties;
+	guint i, n_classes, n_properties;
+
+	classes = tracker_ontologies_get_classes (&n_classes);
+	properties = tracker_ontologies_get_properties (&n_properties);
+
+	for (i = 0; i < n_classes; i++) {
+		const gchar *name = tracker_class_get_name (classes[i]);
+		gint count;
+
+		/* xsd classes do not derive from rdfs:Resource and do not use separate tables */
+		if (g_str_has_prefix (name, "xsd:")) {
+			continue;
+		}
+
+		count = statistics_count (iface, error, "SELECT COUNT(1) FROM \"%s\"", name);
+
+		if (*error) {
+			return;
+		}
+
+		tracker_class_set_count (classes[i], count);
+		statistics_set (iface, tracker_class_get_id (classes[i]), count, error);
+
+		if (*error) {
+			return;
+		}
+	}
+
+	for (i = 0; i < n_properties; i++) {
+		TrackerProperty *property = properties[i];
+		gint count;
+
+		if (!property_has_count (property)) {
+			continue;
+		}
+
+		if (tracker_property_get_multiple_values (property)) {
+			count = statistics_count (iface, error, "SELECT COUNT(1) FROM \"%s\"",
+			                          tracker_property_get_table_name (property));
+		} else {
+			count = statistics_count (iface, error, "SELECT COUNT(\"%s\") FROM \"%s\"",
+			                          tracker_property_get_name (property),
+			                          tracker_property_get_table_name (property));
+		}
+
+		if (*error) {
+			return;
+		}
+
+		tracker_property_set_count (property, count);
+		statistics_set (iface, tracker_property_get_id (property), count, error);
+
+		if (*error) {
+			return;
+		}
+	}
+}
+
+static gboolean
+statistics_load (TrackerDBInterface  *iface,
+                 GError             **error)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	TrackerClass **classes;
+	TrackerProperty **properties;
+	GHashTable *counts;
+	guint i, n_classes, n_properties;
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, error,
+	                                              "SELECT ID, Count FROM Statistics");
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, error);
+		g_object_unref (stmt);
+	}
+
+	if (!cursor) {
+		return FALSE;
+	}
+
+	counts = g_hash_table_new (NULL, NULL);
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, error)) {
+		g_hash_table_insert (counts,
+		                     GINT_TO_POINTER (tracker_db_cursor_get_int (cursor, 0)),
+		                     GINT_TO_POINTER (tracker_db_cursor_get_int (cursor, 1)));
+	}
+
+	g_object_unref (cursor);
+
+	if (*error || g_hash_table_size (counts) == 0) {
+		g_hash_table_unref (counts);
+		return FALSE;
+	}
+
+	classes = tracker_ontologies_get_classes (&n_classes);
+	properties = tracker_ontologies_get_properties (&n_properties);
+
+	/* Classes and properties without a row have no instances */
+	for (i = 0; i < n_classes; i++) {
+		tracker_class_set_count (classes[i],
+		                         GPOINTER_TO_INT (g_hash_table_lookup (counts, GINT_TO_POINTER (tracker_class_get_id (classes[i])))));
+	}
+
+	for (i = 0; i < n_properties; i++) {
+		tracker_property_set_count (properties[i],
+		                            GPOINTER_TO_INT (g_hash_table_lookup (counts, GINT_TO_POINTER (tracker_property_get_id (properties[i])))));
+	}
+
+	g_hash_table_unref (counts);
+
+	return TRUE;
+}
+
+/* tracker:aggregated is not part of the static data of properties,
+ * databases created before it was added have no column for it */
+static void
+aggregates_load_properties (TrackerDBInterface *iface)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, NULL,
+	                                              "SELECT ID FROM \"rdf:Property\" WHERE \"tracker:aggregated\" = 1");
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, NULL);
+		g_object_unref (stmt);
+	}
+
+	if (!cursor) {
+		return;
+	}
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+		const gchar *uri;
+		TrackerProperty *property;
+
+		uri = tracker_ontologies_get_uri_by_id (tracker_db_cursor_get_int (cursor, 0));
+		property = uri ? tracker_ontologies_get_property_by_uri (uri) : NULL;
+
+		if (property) {
+			tracker_property_set_aggregated (property, TRUE);
+		}
+	}
+
+	g_object_unref (cursor);
 }
 
-static gint
-query_resource_id (const gchar *uri)
+/* Sums the values of the tracker:aggregated properties without an
+ * Aggregates row yet, and drops the rows of the ones no longer
+ * aggregated, so a later tracker:aggregated doesn't find stale sums */
+static void
+aggregates_update (TrackerDBInterface  *iface,
+                   GError             **error)
 {
-	gint id;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	TrackerProperty **properties;
+	GHashTable *ids;
+	guint i, n_properties;
 
-	id = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.resource_cache, uri));
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, error,
+	                                              "SELECT ID FROM Aggregates");
 
-	if (id == 0) {
-		id = tracker_data_query_resource_id (uri);
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, error);
+		g_object_unref (stmt);
+	}
 
-		if (id) {
-			g_hash_table_insert (update_buffer.resource_cache, g_strdup (uri), GINT_TO_POINTER (id));
+	if (!cursor) {
+		return;
+	}
+
+	ids = g_hash_table_new (NULL, NULL);
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, error)) {
+		g_hash_table_add (ids, GINT_TO_POINTER (tracker_db_cursor_get_int (cursor, 0)));
+	}
+
+	g_object_unref (cursor);
+
+	properties = tracker_ontologies_get_properties (&n_properties);
+
+	for (i = 0; !*error && i < n_properties; i++) {
+		TrackerProperty *property = properties[i];
+		gint id = tracker_property_get_id (property);
+		gboolean has_row;
+
+		has_row = g_hash_table_contains (ids, GINT_TO_POINTER (id));
+
+		if (property_has_sum (property) && !has_row) {
+			tracker_db_interface_execute_query (iface, error,
+			                                    "INSERT INTO Aggregates (ID, Sum) "
+			                                    "SELECT %d, TOTAL(\"%s\") FROM \"%s\"",
+			                                    id,
+			                                    tracker_property_get_name (property),
+			                                    tracker_property_get_table_name (property));
+		} else if (!property_has_sum (property) && has_row) {
+			tracker_db_interface_execute_query (iface, error,
+			                                    "DELETE FROM Aggregates WHERE ID = %d", id);
 		}
 	}
 
-	return id;
+	g_hash_table_unref (ids);
 }
 
-static gint
-ensure_resource_id (const gchar *uri,
-                    gboolean    *create)
+/* Reads the rows per indexed value found by the last ANALYZE */
+static void
+statistics_load_analyze (TrackerDBInterface *iface)
 {
-	TrackerDBInterface *iface;
 	TrackerDBStatement *stmt;
-	GError *error = NULL;
-	gint id;
+	TrackerDBCursor *cursor = NULL;
+	TrackerProperty **properties;
+	GHashTable *indexes;
+	guint i, n_properties;
 
-	id = query_resource_id (uri);
+	/* sqlite_stat1 only exists after ANALYZE */
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, NULL,
+	                                              "SELECT idx, stat FROM sqlite_stat1");
 
-	if (create) {
-		*create = (id == 0);
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, NULL);
+		g_object_unref (stmt);
 	}
 
-	if (id == 0) {
-		iface = tracker_db_manager_get_db_interface ();
+	if (!cursor) {
+		return;
+	}
 
-		id = tracker_data_update_get_new_service_id ();
-		stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &error,
-		                                              "INSERT INTO Resource (ID, Uri) VALUES (?, ?)");
+	/* index name -> property, the indexes with the value first */
+	indexes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	properties = tracker_ontologies_get_properties (&n_properties);
 
-		if (stmt) {
-			tracker_db_statement_bind_int (stmt, 0, id);
-			tracker_db_statement_bind_text (stmt, 1, uri);
-			tracker_db_statement_execute (stmt, &error);
-			g_object_unref (stmt);
+	for (i = 0; i < n_properties; i++) {
+		TrackerProperty *property = properties[i];
+
+		if (!tracker_property_get_indexed (property)) {
+			continue;
 		}
 
-		if (error) {
-			g_critical ("Could not ensure resource existence: %s", error->message);
-			g_error_free (error);
+		if (tracker_property_get_multiple_values (property)) {
+			g_hash_table_insert (indexes,
+			                     g_strdup_printf ("%s_ID_ID", tracker_property_get_table_name (property)),
+			                     property);
+		} else {
+			g_hash_table_insert (indexes,
+			                     g_strdup_printf ("%s_%s",
+			                                      tracker_property_get_table_name (property),
+			                                      tracker_property_get_name (property)),
+			                     property);
 		}
+	}
 
-#ifndef DISABLE_JOURNAL
-		if (!in_journal_replay) {
-			tracker_db_journal_append_resource (id, uri);
+	while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+		TrackerProperty *property;
+		const gchar *idx, *stat;
+		gint n_rows, rows_per_value;
+
+		idx = tracker_db_cursor_get_string (cursor, 0, NULL);
+		stat = tracker_db_cursor_get_string (cursor, 1, NULL);
+
+		if (!idx || !stat) {
+			continue;
 		}
-#endif /* DISABLE_JOURNAL */
 
-		g_hash_table_insert (update_buffer.resource_cache, g_strdup (uri), GINT_TO_POINTER (id));
+		property = g_hash_table_lookup (indexes, idx);
+
+		/* "<rows> <rows per value of the first column> ..." */
+		if (property && sscanf (stat, "%d %d", &n_rows, &rows_per_value) == 2) {
+			tracker_property_set_rows_per_value (property, rows_per_value);
+		}
 	}
 
-	return id;
+	g_object_unref (cursor);
+	g_hash_table_unref (indexes);
 }
 
-static void
-statement_bind_gvalue (TrackerDBStatement *stmt,
-                       gint               *idx,
-                       const GValue       *value)
+/**
+ * tracker_data_statistics_init:
+ * @iface: the database interface
+ * @read_only: whether the database is opened read only
+ *
+ * Loads the number of instances of every class and the number of
+ * values of every property, so they are known without scanning the
+ * tables. Unless @read_only, they are kept up to date and saved on
+ * each commit from now on. The index statistics of the last ANALYZE,
+ * if any, are loaded too.
+ **/
+void
+tracker_data_statistics_init (TrackerDBInterface *iface,
+                              gboolean            read_only)
 {
-	GType type;
+	GError *error = NULL;
 
-	type = G_VALUE_TYPE (value);
-	switch (type) {
-	case G_TYPE_STRING:
-		tracker_db_statement_bind_text (stmt, (*idx)++, g_value_get_string (value));
-		break;
-	case G_TYPE_INT64:
-		tracker_db_statement_bind_int (stmt, (*idx)++, g_value_get_int64 (value));
-		break;
-	case G_TYPE_DOUBLE:
-		tracker_db_statement_bind_double (stmt, (*idx)++, g_value_get_double (value));
-		break;
-	default:
-		if (type == TRACKER_TYPE_DATE_TIME) {
-			tracker_db_statement_bind_double (stmt, (*idx)++, tracker_date_time_get_time (value));
-			tracker_db_statement_bind_int (stmt, (*idx)++, tracker_date_time_get_local_date (value));
-			tracker_db_statement_bind_int (stmt, (*idx)++, tracker_date_time_get_local_time (value));
-		} else {
-			g_warning ("Unknown type for binding: %s\n", G_VALUE_TYPE_NAME (value));
+	statistics_load_analyze (iface);
+	aggregates_load_properties (iface);
+
+	if (read_only) {
+		TrackerDBStatement *stmt = NULL;
+
+		/* queries use the tables if the store keeps them */
+		if (statistics_load (iface, &error)) {
+			stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, NULL,
+			                                              "SELECT ID, Sum FROM Aggregates");
 		}
-		break;
+
+		statistics_available = (stmt != NULL);
+
+		g_clear_object (&stmt);
+		g_clear_error (&error);
+
+		return;
 	}
-}
 
-static void
-add_class_count (TrackerClass *class,
-                 gint          count)
-{
-	gint old_count_entry;
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "CREATE TABLE IF NOT EXISTS Statistics ("
+	                                    "ID INTEGER NOT NULL PRIMARY KEY, "
+	                                    "Count INTEGER NOT NULL)");
 
-	tracker_class_set_count (class, tracker_class_get_count (class) + count);
+	if (!error) {
+		tracker_db_interface_execute_query (iface, &error,
+		                                    "CREATE TABLE IF NOT EXISTS Aggregates ("
+		                                    "ID INTEGER NOT NULL PRIMARY KEY, "
+		                                    "Sum REAL NOT NULL)");
+	}
 
-	/* update class_counts table so that the count change can be reverted in case of rollback */
-	if (!update_buffer.class_counts) {
-		update_buffer.class_counts = g_hash_table_new (g_direct_hash, g_direct_equal);
+	if (!error) {
+		tracker_db_interface_start_transaction (iface);
+
+		if (!statistics_load (iface, &error) && !error) {
+			statistics_count_all (iface, &error);
+		}
+
+		if (!error) {
+			aggregates_update (iface, &error);
+		}
+
+		if (error) {
+			tracker_db_interface_execute_query (iface, NULL, "ROLLBACK");
+		} else {
+			tracker_db_interface_end_db_transaction (iface, &error);
+		}
 	}
 
-	old_count_entry = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.class_counts, class));
-	g_hash_table_insert (update_buffer.class_counts, class,
-	                     GINT_TO_POINTER (old_count_entry + count));
+	if (error) {
+		g_warning ("Could not initialize statistics: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	statistics_enabled = TRUE;
+	statistics_available = TRUE;
+}
+
+/**
+ * tracker_data_get_statistics_available:
+ *
+ * Returns: whether the Statistics and Aggregates tables are kept up
+ * to date, so queries can be answered from them.
+ **/
+gboolean
+tracker_data_get_statistics_available (void)
+{
+	return statistics_available;
 }
 
 static void
@@ -979,11 +1848,19 @@ tracker_data_resource_buffer_flush (GError **error)
 			g_ptr_array_add (properties, NULL);
 			g_ptr_array_add (text, NULL);
 
-			tracker_db_interface_sqlite_fts_update_text (iface,
-			                                             resource_buffer->id,
-			                                             (const gchar **) properties->pdata,
-			                                             (const gchar **) text->pdata,
-			                                             create);
+			if (fts_deferred || resource_buffer->fts_unindexed) {
+				/* Leave rebuilding the FTS row to
+				 * tracker_data_update_fts_queued() */
+				tracker_db_interface_sqlite_fts_queue_update (iface,
+				                                              resource_buffer->id);
+				update_buffer.fts_queued = TRUE;
+			} else {
+				tracker_db_interface_sqlite_fts_update_text (iface,
+				                                             resource_buffer->id,
+				                                             (const gchar **) properties->pdata,
+				                                             (const gchar **) text->pdata,
+				                                             create);
+			}
 			update_buffer.fts_ever_updated = TRUE;
 			g_ptr_array_free (properties, TRUE);
 			g_ptr_array_free (text, TRUE);
@@ -1034,6 +1911,11 @@ tracker_data_update_buffer_flush (GError **error)
 		g_hash_table_remove_all (update_buffer.resources);
 	}
 	resource_buffer = NULL;
+
+#if HAVE_TRACKER_FTS
+	/* Whatever wasn't picked up by the FTS tokenizer by now won't be */
+	tracker_fts_clear_pretokenized ();
+#endif
 }
 
 void
@@ -1056,6 +1938,8 @@ tracker_data_update_buffer_clear (void)
 
 #if HAVE_TRACKER_FTS
 	update_buffer.fts_ever_updated = FALSE;
+	update_buffer.fts_queued = FALSE;
+	tracker_fts_clear_pretokenized ();
 #endif
 
 	if (update_buffer.class_counts) {
@@ -1075,6 +1959,24 @@ tracker_data_update_buffer_clear (void)
 
 		g_hash_table_remove_all (update_buffer.class_counts);
 	}
+
+	if (update_buffer.property_counts) {
+		GHashTableIter iter;
+		TrackerProperty *property;
+		gpointer count_ptr;
+
+		g_hash_table_iter_init (&iter, update_buffer.property_counts);
+		while (g_hash_table_iter_next (&iter, (gpointer*) &property, &count_ptr)) {
+			tracker_property_set_count (property,
+			                            tracker_property_get_count (property) - GPOINTER_TO_INT (count_ptr));
+		}
+
+		g_hash_table_remove_all (update_buffer.property_counts);
+	}
+
+	if (update_buffer.property_sums) {
+		g_hash_table_remove_all (update_buffer.property_sums);
+	}
 }
 
 static void
@@ -1454,6 +2356,17 @@ get_old_property_values (TrackerProperty  *property,
 				guint i, n_props;
 				TrackerProperty   **properties, *prop;
 
+				/* Only text in the index may be deleted from it,
+				 * queued resources are indexed from scratch.
+				 */
+				if ((fts_deferred || tracker_data_has_fts_queued ()) &&
+				    tracker_db_interface_sqlite_fts_is_queued (iface, resource_buffer->id)) {
+					resource_buffer->fts_unindexed = TRUE;
+				} else if (fts_deferred) {
+					/* fts_view still has the indexed text */
+					tracker_db_interface_sqlite_fts_delete_id (iface, resource_buffer->id);
+				}
+
 				/* first fulltext indexed property to be modified
 				 * retrieve values of all fulltext indexed properties
 				 */
@@ -1470,6 +2383,10 @@ get_old_property_values (TrackerProperty  *property,
 						old_values = get_property_values (prop);
 						property_name = tracker_property_get_name (prop);
 
+						if (fts_deferred || resource_buffer->fts_unindexed) {
+							continue;
+						}
+
 						/* delete old fts entries */
 						for (i = 0; i < old_values->len; i++) {
 							tracker_db_interface_sqlite_fts_delete_text (iface,
@@ -1720,6 +2637,8 @@ cache_insert_metadata_decomposed (TrackerProperty  *property,
 		g_value_unset (&gvalue);
 
 	} else {
+		add_property_sum (property, &gvalue, 1);
+
 		cache_insert_value (table_name, field_name,
 		                    tracker_property_get_transient (property),
 		                    &gvalue,
@@ -1732,6 +2651,7 @@ cache_insert_metadata_decomposed (TrackerProperty  *property,
 			process_domain_indexes (property, &gvalue, field_name, graph, graph_id);
 		}
 
+		add_property_count (property, 1);
 		change = TRUE;
 	}
 
@@ -1928,6 +2848,33 @@ cache_update_metadata_decomposed (TrackerProperty  *property,
 		g_value_set_int64 (&gvalue, value_id);
 	}
 
+	if (statistics_enabled && property_has_count (property)) {
+		GArray *old_values;
+
+		/* Only a new value changes the count, updates
+		 * replace the single value there may be */
+		old_values = get_old_property_values (property, &new_error);
+
+		if (new_error) {
+			g_clear_error (&new_error);
+		} else if (multiple_values || old_values->len == 0) {
+			if (value_set_add_value (old_values, &gvalue)) {
+				add_property_count (property, 1);
+				add_property_sum (property, &gvalue, 1);
+			}
+		} else {
+			GValue *old_value = &g_array_index (old_values, GValue, 0);
+
+			/* the single value is replaced */
+			add_property_sum (property, old_value, -1);
+			add_property_sum (property, &gvalue, 1);
+
+			g_value_unset (old_value);
+			g_value_init (old_value, G_VALUE_TYPE (&gvalue));
+			g_value_copy (&gvalue, old_value);
+		}
+	}
+
 	cache_insert_value (table_name, field_name,
 	                    tracker_property_get_transient (property),
 	                    &gvalue,
@@ -1985,6 +2932,8 @@ delete_metadata_decomposed (TrackerProperty  *property,
 		/* value not found */
 		g_value_unset (&gvalue);
 	} else {
+		add_property_sum (property, &gvalue, -1);
+
 		cache_delete_value (table_name, field_name,
 		                    tracker_property_get_transient (property),
 		                    &gvalue, multiple_values,
@@ -2012,6 +2961,7 @@ delete_metadata_decomposed (TrackerProperty  *property,
 			}
 		}
 
+		add_property_count (property, -1);
 		change = TRUE;
 	}
 
@@ -2160,6 +3110,18 @@ cache_delete_resource_type_full (TrackerClass *class,
 		field_name = tracker_property_get_name (prop);
 
 		if (direct_delete) {
+			if (statistics_enabled && property_has_count (prop)) {
+				old_values = get_old_property_values (prop, NULL);
+
+				if (old_values) {
+					add_property_count (prop, - (gint) old_values->len);
+
+					for (y = 0; y < old_values->len; y++) {
+						add_property_sum (prop, &g_array_index (old_values, GValue, y), -1);
+					}
+				}
+			}
+
 			if (multiple_values) {
 				db_delete_row (iface, table_name, resource_buffer->id);
 			}
@@ -2178,11 +3140,13 @@ cache_delete_resource_type_full (TrackerClass *class,
 			g_value_copy (old_gvalue, &gvalue);
 
 			value_set_remove_value (old_values, &gvalue);
+			add_property_sum (prop, &gvalue, -1);
 			cache_delete_value (table_name, field_name,
 			                    tracker_property_get_transient (prop),
 			                    &gvalue, multiple_values,
 			                    tracker_property_get_fulltext_indexed (prop),
 			                    tracker_property_get_data_type (prop) == TRACKER_PROPERTY_TYPE_DATETIME);
+			add_property_count (prop, -1);
 
 
 			if (!multiple_values) {
@@ -2310,6 +3274,7 @@ resource_buffer_switch (const gchar *graph,
 		}
 #if HAVE_TRACKER_FTS
 		resource_buffer->fts_updated = FALSE;
+		resource_buffer->fts_unindexed = FALSE;
 #endif
 		if (resource_buffer->create) {
 			resource_buffer->types = g_ptr_array_new ();
@@ -3351,6 +4316,12 @@ tracker_data_commit_transaction (GError **error)
 		return;
 	}
 
+	if (change_log_untrimmed >= CHANGE_LOG_TRIM_INTERVAL) {
+		change_log_trim (iface);
+	}
+
+	statistics_save (iface);
+
 	tracker_db_interface_end_db_transaction (iface,
 	                                         &actual_error);
 
@@ -3394,10 +4365,19 @@ tracker_data_commit_transaction (GError **error)
 		g_hash_table_remove_all (update_buffer.class_counts);
 	}
 
+	if (update_buffer.property_counts) {
+		g_hash_table_remove_all (update_buffer.property_counts);
+	}
+
 #if HAVE_TRACKER_FTS
 	if (update_buffer.fts_ever_updated) {
 		update_buffer.fts_ever_updated = FALSE;
 	}
+
+	if (update_buffer.fts_queued) {
+		update_buffer.fts_queued = FALSE;
+		g_atomic_int_set (&fts_pending, 1);
+	}
 #endif
 
 	tracker_db_interface_execute_query (iface, NULL, "PRAGMA cache_size = %d", TRACKER_DB_CACHE_SIZE_DEFAULT);
@@ -3472,6 +4452,156 @@ tracker_data_rollback_transaction (void)
 	}
 }
 
+/**
+ * tracker_data_set_fts_deferred:
+ * @deferred: whether FTS updates are deferred
+ *
+ * When deferred, committing a transaction only records the resources
+ * whose fulltext indexed properties changed, their FTS rows are then
+ * rebuilt in batches by tracker_data_update_fts_queued(). Until then,
+ * fts:match won't see the changes.
+ **/
+void
+tracker_data_set_fts_deferred (gboolean deferred)
+{
+#if HAVE_TRACKER_FTS
+	fts_deferred = deferred;
+
+	/* Resources may be left queued from a previous run */
+	g_atomic_int_set (&fts_pending, 1);
+#endif
+}
+
+/**
+ * tracker_data_has_fts_queued:
+ *
+ * Returns: %TRUE if there might be resources queued for
+ * tracker_data_update_fts_queued(). Can be called from any thread.
+ **/
+gboolean
+tracker_data_has_fts_queued (void)
+{
+#if HAVE_TRACKER_FTS
+	return g_atomic_int_get (&fts_pending) != 0;
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * tracker_data_update_fts_queued:
+ * @max_docs: maximum number of resources to handle, or -1 for all
+ * @error: return location for errors
+ *
+ * Rebuilds the FTS rows of resources queued in deferred mode,
+ * in its own transaction.
+ *
+ * Returns: the number of resources handled, or -1 on error.
+ **/
+gint
+tracker_data_update_fts_queued (gint     max_docs,
+                                GError **error)
+{
+#if HAVE_TRACKER_FTS
+	TrackerDBInterface *iface;
+	GError *actual_error = NULL;
+	gint n_docs;
+
+	g_return_val_if_fail (!in_transaction, -1);
+
+	if (!tracker_data_has_fts_queued ()) {
+		return 0;
+	}
+
+	iface = tracker_db_manager_get_db_interface ();
+
+	tracker_db_interface_start_transaction (iface);
+
+	n_docs = tracker_db_interface_sqlite_fts_update_queued (iface, max_docs, &actual_error);
+
+	if (actual_error) {
+		tracker_db_interface_execute_query (iface, NULL, "ROLLBACK");
+		g_propagate_error (error, actual_error);
+		return -1;
+	}
+
+	tracker_db_interface_end_db_transaction (iface, &actual_error);
+
+	if (actual_error) {
+		tracker_db_interface_execute_query (iface, NULL, "ROLLBACK");
+		g_propagate_error (error, actual_error);
+		return -1;
+	}
+
+	if (max_docs < 0 || n_docs < max_docs) {
+		g_atomic_int_set (&fts_pending, 0);
+	}
+
+	return n_docs;
+#else
+	return 0;
+#endif
+}
+
+/* Merges FTS index segments, min_segments of a level at a time in
+ * steps of n_pages pages, for about time_slice milliseconds. Returns
+ * TRUE if there's more left to merge.
+ */
+gboolean
+tracker_data_fts_merge (gint     n_pages,
+                        gint     min_segments,
+                        gint     time_slice,
+                        GError **error)
+{
+#if HAVE_TRACKER_FTS
+	TrackerDBInterface *iface;
+	GError *actual_error = NULL;
+	gboolean done = FALSE;
+	gint64 end_time;
+
+	g_return_val_if_fail (!in_transaction, FALSE);
+
+	iface = tracker_db_manager_get_db_interface ();
+	end_time = g_get_monotonic_time () + time_slice * G_TIME_SPAN_MILLISECOND;
+
+	while (!done && g_get_monotonic_time () < end_time) {
+		tracker_db_interface_start_transaction (iface);
+
+		tracker_db_interface_sqlite_fts_merge (iface, n_pages, min_segments,
+		                                       &done, &actual_error);
+
+		if (!actual_error) {
+			tracker_db_interface_end_db_transaction (iface, &actual_error);
+		}
+
+		if (actual_error) {
+			tracker_db_interface_execute_query (iface, NULL, "ROLLBACK");
+			g_propagate_error (error, actual_error);
+			return FALSE;
+		}
+	}
+
+	return !done;
+#else
+	return FALSE;
+#endif
+}
+
+gboolean
+tracker_data_get_fts_segment_stats (gint *n_segments,
+                                    gint *n_levels,
+                                    gint *max_level_segments)
+{
+#if HAVE_TRACKER_FTS
+	return tracker_db_interface_sqlite_fts_get_segment_stats (tracker_db_manager_get_db_interface (),
+	                                                          n_segments, n_levels,
+	                                                          max_level_segments);
+#else
+	*n_segments = *n_levels = *max_level_segments = 0;
+	return FALSE;
+#endif
+}
+
 static GVariant *
 update_sparql (const gchar  *update,
                gboolean      blank,
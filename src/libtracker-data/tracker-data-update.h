@@ -97,6 +97,28 @@ void     tracker_data_update_buffer_might_flush     (GError                   **
 void     tracker_data_load_turtle_file              (GFile                     *file,
                                                      GError                   **error);
 
+/* Deferred FTS updates */
+void     tracker_data_set_fts_deferred              (gboolean                   deferred);
+gboolean tracker_data_has_fts_queued                (void);
+gint     tracker_data_update_fts_queued             (gint                       max_docs,
+                                                     GError                   **error);
+gboolean tracker_data_fts_merge                     (gint                       n_pages,
+                                                     gint                       min_segments,
+                                                     gint                       time_slice,
+                                                     GError                   **error);
+gboolean tracker_data_get_fts_segment_stats         (gint                      *n_segments,
+                                                     gint                      *n_levels,
+                                                     gint                      *max_level_segments);
+
+/* Change log */
+void     tracker_data_change_log_init               (TrackerDBInterface        *iface);
+gint     tracker_data_get_change_log_start          (void);
+
+/* Statistics */
+void     tracker_data_statistics_init               (TrackerDBInterface        *iface,
+                                                     gboolean                   read_only);
+gboolean tracker_data_get_statistics_available      (void);
+
 void     tracker_data_sync                          (void);
 void     tracker_data_replay_journal                (TrackerBusyCallback        busy_callback,
                                                      gpointer                   busy_user_data,
@@ -47,6 +47,7 @@
 #include <unicode/uregex.h>
 #include <unicode/ustring.h>
 #include <unicode/ucol.h>
+#include <unicode/uloc.h>
 #endif
 
 #include "tracker-collation.h"
@@ -55,6 +56,7 @@
 #include "tracker-db-manager.h"
 
 #define UNKNOWN_STATUS 0.5
+#define REGEX_CACHE_SIZE 32
 
 typedef struct {
 	TrackerDBStatement *head;
@@ -91,6 +93,10 @@ struct TrackerDBInterface {
 	gchar *busy_status;
 
 	gchar *fts_insert_str;
+
+	/* Compiled SPARQL regexes, most recently used first */
+	GHashTable *regex_cache;
+	GQueue regex_lru;
 };
 
 struct TrackerDBInterfaceClass {
@@ -110,6 +116,14 @@ struct TrackerDBCursor {
 	/* used for direct access as libtracker-sparql is thread-safe and
 	   uses a single shared connection with SQLite mutex disabled */
 	gboolean threadsafe;
+
+	/* keyset continuation, see tracker_db_cursor_set_continuation() */
+	gint n_columns;
+	gint *key_columns;
+	gint n_keys;
+	gchar *checksum;
+	GVariant *first_keys;
+	GVariant *keys;
 };
 
 struct TrackerDBCursorClass {
@@ -145,6 +159,7 @@ static gboolean            tracker_db_cursor_get_boolean            (TrackerSpar
 static gboolean            db_cursor_iter_next                      (TrackerDBCursor       *cursor,
                                                                      GCancellable          *cancellable,
                                                                      GError               **error);
+static void                db_cursor_update_keys                    (TrackerDBCursor       *cursor);
 
 enum {
 	PROP_0,
@@ -499,6 +514,71 @@ function_sparql_haversine_distance (sqlite3_context *context,
 	sqlite3_result_double (context, d);
 }
 
+typedef struct {
+	gchar *key;
+	GRegex *regex;
+} TrackerDBRegex;
+
+static void
+db_regex_free (TrackerDBRegex *entry)
+{
+	g_free (entry->key);
+	g_regex_unref (entry->regex);
+	g_slice_free (TrackerDBRegex, entry);
+}
+
+/* Auxdata only keeps the regex for one execution of the statement,
+ * the connection keeps the last few so the patterns queries are run
+ * with over and over are not compiled every time.
+ */
+static GRegex *
+db_interface_get_regex (TrackerDBInterface  *db_interface,
+                        const gchar         *pattern,
+                        GRegexCompileFlags   regex_flags,
+                        GError             **error)
+{
+	TrackerDBRegex *entry;
+	GRegex *regex;
+	GList *link;
+	gchar *key;
+
+	key = g_strdup_printf ("%x/%s", regex_flags, pattern);
+	link = g_hash_table_lookup (db_interface->regex_cache, key);
+
+	if (link) {
+		g_free (key);
+		g_queue_unlink (&db_interface->regex_lru, link);
+		g_queue_push_head_link (&db_interface->regex_lru, link);
+		entry = link->data;
+
+		return g_regex_ref (entry->regex);
+	}
+
+	/* Studies the pattern, PCRE JIT compiles it where available */
+	regex = g_regex_new (pattern, regex_flags | G_REGEX_OPTIMIZE, 0, error);
+
+	if (!regex) {
+		g_free (key);
+		return NULL;
+	}
+
+	if (db_interface->regex_lru.length >= REGEX_CACHE_SIZE) {
+		entry = g_queue_pop_tail (&db_interface->regex_lru);
+		g_hash_table_remove (db_interface->regex_cache, entry->key);
+		db_regex_free (entry);
+	}
+
+	entry = g_slice_new (TrackerDBRegex);
+	entry->key = key;
+	entry->regex = g_regex_ref (regex);
+
+	g_queue_push_head (&db_interface->regex_lru, entry);
+	g_hash_table_insert (db_interface->regex_cache, key,
+	                     db_interface->regex_lru.head);
+
+	return regex;
+}
+
 static void
 function_sparql_regex (sqlite3_context *context,
                        int              argc,
@@ -549,7 +629,8 @@ function_sparql_regex (sqlite3_context *context,
 			flags++;
 		}
 
-		regex = g_regex_new (pattern, regex_flags, 0, &error);
+		regex = db_interface_get_regex (sqlite3_user_data (context),
+		                                pattern, regex_flags, &error);
 
 		if (error) {
 			sqlite3_result_error (context, error->message, -1);
@@ -565,6 +646,186 @@ function_sparql_regex (sqlite3_context *context,
 	sqlite3_result_int (context, ret);
 }
 
+/* Fast paths for the case and accent functions. Most strings are
+ * plain ASCII or Latin-1, these are handled in UTF-8 straight from
+ * the database with table lookups. Anything else goes through the
+ * UTF-16 conversion and ICU/libunistring, as casing rules beyond
+ * Latin-1 may depend on the surrounding characters.
+ */
+
+/* Second byte of the UTF-8 encoding of U+00C0 to U+00FF (0xC3 0x80
+ * to 0xC3 0xBF), lowercased. Only × (U+00D7) and ß (U+00DF) in the
+ * uppercase range are left alone.
+ */
+static const guchar latin1_lower[64] = {
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+	0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0x97,
+	0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0x9f,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+	0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+	0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+};
+
+/* Base letter of U+00C0 to U+00FF once NFKD decomposed and
+ * unaccented, 0 for those without a decomposition (Æ, Ð, ×, Ø,
+ * Þ, ß, æ, ð, ÷, ø, þ).
+ */
+static const gchar latin1_unaccent[64] = {
+	'A', 'A', 'A', 'A', 'A', 'A',  0,  'C',
+	'E', 'E', 'E', 'E', 'I', 'I', 'I', 'I',
+	 0,  'N', 'O', 'O', 'O', 'O', 'O',  0,
+	 0,  'U', 'U', 'U', 'U', 'Y',  0,   0,
+	'a', 'a', 'a', 'a', 'a', 'a',  0,  'c',
+	'e', 'e', 'e', 'e', 'i', 'i', 'i', 'i',
+	 0,  'n', 'o', 'o', 'o', 'o', 'o',  0,
+	 0,  'u', 'u', 'u', 'u', 'y',  0,  'y',
+};
+
+/* Returns FALSE if @value has characters the fast path can't
+ * deal with, otherwise sets the result on @context.
+ */
+static gboolean
+fast_lower_case (sqlite3_context *context,
+                 sqlite3_value   *value,
+                 gboolean         case_fold)
+{
+	const guchar *zInput;
+	guchar *zOutput;
+	gboolean changed = FALSE;
+	int nInput, i;
+
+	zInput = sqlite3_value_text (value);
+
+	if (!zInput) {
+		return TRUE;
+	}
+
+	nInput = sqlite3_value_bytes (value);
+
+	for (i = 0; i < nInput; i++) {
+		if (zInput[i] < 0x80) {
+			changed |= (zInput[i] >= 'A' && zInput[i] <= 'Z');
+		} else if (zInput[i] == 0xc3 && i + 1 < nInput &&
+		           zInput[i + 1] >= 0x80 && zInput[i + 1] <= 0xbf) {
+			/* ß folds to "ss" */
+			if (case_fold && zInput[i + 1] == 0x9f) {
+				return FALSE;
+			}
+
+			changed |= (latin1_lower[zInput[i + 1] - 0x80] != zInput[i + 1]);
+			i++;
+		} else if (zInput[i] == 0xc2 && i + 1 < nInput &&
+		           zInput[i + 1] >= 0x80 && zInput[i + 1] <= 0xbf) {
+			/* µ folds to μ */
+			if (case_fold && zInput[i + 1] == 0xb5) {
+				return FALSE;
+			}
+
+			i++;
+		} else {
+			return FALSE;
+		}
+	}
+
+	if (!changed) {
+		sqlite3_result_text (context, (const gchar *) zInput, nInput, SQLITE_TRANSIENT);
+		return TRUE;
+	}
+
+	zOutput = sqlite3_malloc (nInput + 1);
+
+	if (!zOutput) {
+		sqlite3_result_error_nomem (context);
+		return TRUE;
+	}
+
+	for (i = 0; i < nInput; i++) {
+		if (zInput[i] < 0x80) {
+			zOutput[i] = g_ascii_tolower (zInput[i]);
+		} else {
+			zOutput[i] = zInput[i];
+
+			if (zInput[i] == 0xc3) {
+				zOutput[i + 1] = latin1_lower[zInput[i + 1] - 0x80];
+			} else {
+				zOutput[i + 1] = zInput[i + 1];
+			}
+
+			i++;
+		}
+	}
+
+	zOutput[nInput] = '\0';
+	sqlite3_result_text (context, (gchar *) zOutput, nInput, sqlite3_free);
+
+	return TRUE;
+}
+
+static gboolean
+fast_unaccent (sqlite3_context *context,
+               sqlite3_value   *value)
+{
+	const guchar *zInput;
+	guchar *zOutput;
+	gboolean changed = FALSE;
+	int nInput, nOutput = 0, i;
+
+	zInput = sqlite3_value_text (value);
+
+	if (!zInput) {
+		return TRUE;
+	}
+
+	nInput = sqlite3_value_bytes (value);
+
+	/* U+0080 to U+00BF have compatibility decompositions
+	 * (e.g. ½ or NBSP), those go the slow way.
+	 */
+	for (i = 0; i < nInput; i++) {
+		if (zInput[i] < 0x80) {
+			continue;
+		} else if (zInput[i] == 0xc3 && i + 1 < nInput &&
+		           zInput[i + 1] >= 0x80 && zInput[i + 1] <= 0xbf) {
+			changed |= (latin1_unaccent[zInput[i + 1] - 0x80] != 0);
+			i++;
+		} else {
+			return FALSE;
+		}
+	}
+
+	if (!changed) {
+		sqlite3_result_text (context, (const gchar *) zInput, nInput, SQLITE_TRANSIENT);
+		return TRUE;
+	}
+
+	zOutput = sqlite3_malloc (nInput + 1);
+
+	if (!zOutput) {
+		sqlite3_result_error_nomem (context);
+		return TRUE;
+	}
+
+	for (i = 0; i < nInput; i++) {
+		if (zInput[i] < 0x80) {
+			zOutput[nOutput++] = zInput[i];
+		} else if (latin1_unaccent[zInput[i + 1] - 0x80] != 0) {
+			zOutput[nOutput++] = latin1_unaccent[zInput[i + 1] - 0x80];
+			i++;
+		} else {
+			zOutput[nOutput++] = zInput[i];
+			zOutput[nOutput++] = zInput[i + 1];
+			i++;
+		}
+	}
+
+	zOutput[nOutput] = '\0';
+	sqlite3_result_text (context, (gchar *) zOutput, nOutput, sqlite3_free);
+
+	return TRUE;
+}
+
 #ifdef HAVE_LIBUNISTRING
 
 static void
@@ -579,6 +840,10 @@ function_sparql_lower_case (sqlite3_context *context,
 
 	g_assert (argc == 1);
 
+	if (fast_lower_case (context, argv[0], FALSE)) {
+		return;
+	}
+
 	zInput = sqlite3_value_text16 (argv[0]);
 
 	if (!zInput) {
@@ -604,6 +869,10 @@ function_sparql_case_fold (sqlite3_context *context,
 
 	g_assert (argc == 1);
 
+	if (fast_lower_case (context, argv[0], TRUE)) {
+		return;
+	}
+
 	zInput = sqlite3_value_text16 (argv[0]);
 
 	if (!zInput) {
@@ -673,6 +942,10 @@ function_sparql_unaccent (sqlite3_context *context,
 
 	g_assert (argc == 1);
 
+	if (fast_unaccent (context, argv[0])) {
+		return;
+	}
+
 	zInput = sqlite3_value_text (argv[0]);
 
 	if (!zInput) {
@@ -691,6 +964,25 @@ function_sparql_unaccent (sqlite3_context *context,
 
 #elif HAVE_LIBICU
 
+static gboolean
+icu_locale_has_special_casing (void)
+{
+	static gsize initialized = 0;
+	static gboolean special_casing = FALSE;
+
+	if (g_once_init_enter (&initialized)) {
+		const gchar *locale;
+
+		locale = uloc_getDefault ();
+		special_casing = (g_str_has_prefix (locale, "tr") ||
+		                  g_str_has_prefix (locale, "az") ||
+		                  g_str_has_prefix (locale, "lt"));
+		g_once_init_leave (&initialized, 1);
+	}
+
+	return special_casing;
+}
+
 static void
 function_sparql_lower_case (sqlite3_context *context,
                             int              argc,
@@ -704,6 +996,12 @@ function_sparql_lower_case (sqlite3_context *context,
 
 	g_assert (argc == 1);
 
+	/* Turkish and friends lowercase 'I' differently */
+	if (!icu_locale_has_special_casing () &&
+	    fast_lower_case (context, argv[0], FALSE)) {
+		return;
+	}
+
 	zInput = sqlite3_value_text16 (argv[0]);
 
 	if (!zInput) {
@@ -746,6 +1044,10 @@ function_sparql_case_fold (sqlite3_context *context,
 
 	g_assert (argc == 1);
 
+	if (fast_lower_case (context, argv[0], TRUE)) {
+		return;
+	}
+
 	zInput = sqlite3_value_text16 (argv[0]);
 
 	if (!zInput) {
@@ -849,6 +1151,10 @@ function_sparql_unaccent (sqlite3_context *context,
 
 	g_assert (argc == 1);
 
+	if (fast_unaccent (context, argv[0])) {
+		return;
+	}
+
 	zInput = sqlite3_value_text16 (argv[0]);
 
 	if (!zInput) {
@@ -1172,6 +1478,19 @@ tracker_db_interface_sqlite_fts_init (TrackerDBInterface  *db_interface,
 
 		g_strfreev (fts_columns);
 	}
+
+	/* Resources whose FTS rows are yet to be rebuilt, when
+	 * the FTS index is updated in deferred mode. None of their
+	 * text is in the index.
+	 */
+	if (sqlite3_exec (db_interface->db,
+	                  "CREATE TABLE IF NOT EXISTS fts_pending "
+	                  "(docid INTEGER PRIMARY KEY)",
+	                  NULL, NULL, NULL) != SQLITE_OK &&
+	    create) {
+		g_warning ("FTS pending table creation failed: %s",
+		           sqlite3_errmsg (db_interface->db));
+	}
 #endif
 }
 
@@ -1184,7 +1503,17 @@ tracker_db_interface_sqlite_fts_alter_table (TrackerDBInterface  *db_interface,
 {
 	if (!tracker_fts_alter_table (db_interface->db, "fts", properties, multivalued)) {
 		g_critical ("Failed to update FTS columns");
+		return;
 	}
+
+	/* The new table indexes all of fts_view, queued resources too */
+	sqlite3_exec (db_interface->db, "DELETE FROM fts_pending", NULL, NULL, NULL);
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_settings_changed (TrackerDBInterface *db_interface)
+{
+	return tracker_fts_settings_changed (db_interface->db, "fts");
 }
 
 gboolean
@@ -1251,6 +1580,239 @@ tracker_db_interface_sqlite_fts_update_text (TrackerDBInterface  *db_interface,
 	return TRUE;
 }
 
+/* Removes the FTS row of a resource, the text in fts_view must
+ * still be the indexed one, as that is what gets tokenized to
+ * find the entries to delete.
+ */
+gboolean
+tracker_db_interface_sqlite_fts_delete_id (TrackerDBInterface *db_interface,
+                                           int                 id)
+{
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+
+	stmt = tracker_db_interface_create_statement (db_interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
+	                                              &error,
+	                                              "DELETE FROM fts WHERE docid=?");
+
+	if (!stmt || error) {
+		if (error) {
+			g_warning ("Could not create FTS delete statement: %s",
+			           error->message);
+			g_error_free (error);
+		}
+		return FALSE;
+	}
+
+	tracker_db_statement_bind_int (stmt, 0, id);
+	tracker_db_statement_execute (stmt, &error);
+	g_object_unref (stmt);
+
+	if (error) {
+		g_warning ("Could not delete FTS text: %s", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_queue_update (TrackerDBInterface *db_interface,
+                                              int                 id)
+{
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+
+	stmt = tracker_db_interface_create_statement (db_interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
+	                                              &error,
+	                                              "INSERT OR IGNORE INTO fts_pending (docid) VALUES (?)");
+
+	if (!stmt || error) {
+		if (error) {
+			g_warning ("Could not create FTS queue statement: %s",
+			           error->message);
+			g_error_free (error);
+		}
+		return FALSE;
+	}
+
+	tracker_db_statement_bind_int (stmt, 0, id);
+	tracker_db_statement_execute (stmt, &error);
+	g_object_unref (stmt);
+
+	if (error) {
+		g_warning ("Could not queue FTS update: %s", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Returns TRUE if the resource is queued for FTS indexing, none
+ * of its text is in the index then.
+ */
+gboolean
+tracker_db_interface_sqlite_fts_is_queued (TrackerDBInterface *db_interface,
+                                           int                 id)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gboolean queued = FALSE;
+
+	stmt = tracker_db_interface_create_statement (db_interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_SELECT,
+	                                              &error,
+	                                              "SELECT 1 FROM fts_pending WHERE docid = ?");
+
+	if (stmt) {
+		tracker_db_statement_bind_int (stmt, 0, id);
+		cursor = tracker_db_statement_start_cursor (stmt, &error);
+		g_object_unref (stmt);
+
+		if (cursor) {
+			queued = tracker_db_cursor_iter_next (cursor, NULL, &error);
+			g_object_unref (cursor);
+		}
+	}
+
+	if (error) {
+		g_warning ("Could not check FTS queue: %s", error->message);
+		g_error_free (error);
+	}
+
+	return queued;
+}
+
+/* Rebuilds the FTS rows of up to max_docs queued resources (all
+ * of them if max_docs is negative), returns how many were handled
+ * or -1 on error. Must be called inside a transaction.
+ */
+gint
+tracker_db_interface_sqlite_fts_update_queued (TrackerDBInterface  *db_interface,
+                                               gint                 max_docs,
+                                               GError             **error)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GError *inner_error = NULL;
+	GArray *docids;
+	guint i;
+
+	stmt = tracker_db_interface_create_statement (db_interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_SELECT,
+	                                              &inner_error,
+	                                              "SELECT docid FROM fts_pending ORDER BY docid LIMIT ?");
+	if (!stmt) {
+		g_propagate_error (error, inner_error);
+		return -1;
+	}
+
+	tracker_db_statement_bind_int (stmt, 0, max_docs);
+	cursor = tracker_db_statement_start_cursor (stmt, &inner_error);
+	g_object_unref (stmt);
+
+	if (!cursor) {
+		g_propagate_error (error, inner_error);
+		return -1;
+	}
+
+	docids = g_array_new (FALSE, FALSE, sizeof (gint));
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, &inner_error)) {
+		gint docid = tracker_db_cursor_get_int (cursor, 0);
+		g_array_append_val (docids, docid);
+	}
+
+	g_object_unref (cursor);
+
+	if (inner_error) {
+		g_propagate_error (error, inner_error);
+		g_array_free (docids, TRUE);
+		return -1;
+	}
+
+	for (i = 0; i < docids->len; i++) {
+		gint docid = g_array_index (docids, gint, i);
+
+		/* The rows are rebuilt from fts_view, so no need
+		 * to pass the text along. Nothing of queued resources
+		 * is indexed, their old rows were deleted on queueing.
+		 */
+		if (!tracker_db_interface_sqlite_fts_update_text (db_interface,
+		                                                  docid,
+		                                                  NULL, NULL,
+		                                                  TRUE)) {
+			g_set_error (error,
+			             TRACKER_DB_INTERFACE_ERROR,
+			             TRACKER_DB_QUERY_ERROR,
+			             "Could not update FTS text for resource %d",
+			             docid);
+			g_array_free (docids, TRUE);
+			return -1;
+		}
+	}
+
+	if (docids->len > 0) {
+		stmt = tracker_db_interface_create_statement (db_interface,
+		                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
+		                                              &inner_error,
+		                                              "DELETE FROM fts_pending WHERE docid <= ?");
+		if (stmt) {
+			tracker_db_statement_bind_int (stmt, 0,
+			                               g_array_index (docids, gint, docids->len - 1));
+			tracker_db_statement_execute (stmt, &inner_error);
+			g_object_unref (stmt);
+		}
+
+		if (inner_error) {
+			g_propagate_error (error, inner_error);
+			g_array_free (docids, TRUE);
+			return -1;
+		}
+	}
+
+	i = docids->len;
+	g_array_free (docids, TRUE);
+
+	return i;
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_get_segment_stats (TrackerDBInterface *db_interface,
+                                                   gint               *n_segments,
+                                                   gint               *n_levels,
+                                                   gint               *max_level_segments)
+{
+	return tracker_fts_get_segment_stats (db_interface->db, "fts",
+	                                      n_segments, n_levels,
+	                                      max_level_segments);
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_merge (TrackerDBInterface  *db_interface,
+                                       gint                 n_pages,
+                                       gint                 min_segments,
+                                       gboolean            *done,
+                                       GError             **error)
+{
+	if (!tracker_fts_merge (db_interface->db, "fts",
+	                        n_pages, min_segments, done)) {
+		g_set_error (error,
+		             TRACKER_DB_INTERFACE_ERROR,
+		             TRACKER_DB_QUERY_ERROR,
+		             "Could not merge FTS segments: %s",
+		             sqlite3_errmsg (db_interface->db));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 gboolean
 tracker_db_interface_sqlite_fts_delete_text (TrackerDBInterface *db_interface,
                                              int                 id,
@@ -1336,6 +1898,10 @@ tracker_db_interface_sqlite_finalize (GObject *object)
 	close_database (db_interface);
 	g_free (db_interface->fts_insert_str);
 
+	g_queue_foreach (&db_interface->regex_lru, (GFunc) db_regex_free, NULL);
+	g_queue_clear (&db_interface->regex_lru);
+	g_hash_table_unref (db_interface->regex_cache);
+
 	g_message ("Closed sqlite3 database:'%s'", db_interface->filename);
 
 	g_free (db_interface->filename);
@@ -1376,6 +1942,7 @@ prepare_database (TrackerDBInterface *db_interface)
 	db_interface->dynamic_statements = g_hash_table_new_full (g_str_hash, g_str_equal,
 	                                                          NULL,
 	                                                          (GDestroyNotify) g_object_unref);
+	db_interface->regex_cache = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 static void
@@ -1880,6 +2447,17 @@ tracker_db_cursor_finalize (GObject *object)
 	}
 	g_free (cursor->variable_names);
 
+	g_free (cursor->key_columns);
+	g_free (cursor->checksum);
+
+	if (cursor->first_keys) {
+		g_variant_unref (cursor->first_keys);
+	}
+
+	if (cursor->keys) {
+		g_variant_unref (cursor->keys);
+	}
+
 	G_OBJECT_CLASS (tracker_db_cursor_parent_class)->finalize (object);
 }
 
@@ -1960,6 +2538,7 @@ tracker_db_cursor_class_init (TrackerDBCursorClass *class)
 	sparql_cursor_class->next_finish = (gboolean (*) (TrackerSparqlCursor *, GAsyncResult *, GError **)) tracker_db_cursor_iter_next_finish;
 	sparql_cursor_class->rewind = (void (*) (TrackerSparqlCursor *)) tracker_db_cursor_rewind;
 	sparql_cursor_class->close = (void (*) (TrackerSparqlCursor *)) tracker_db_cursor_close;
+	sparql_cursor_class->get_continuation = (gchar * (*) (TrackerSparqlCursor *)) tracker_db_cursor_get_continuation;
 
 	sparql_cursor_class->get_integer = (gint64 (*) (TrackerSparqlCursor *, gint)) tracker_db_cursor_get_int;
 	sparql_cursor_class->get_double = (gdouble (*) (TrackerSparqlCursor *, gint)) tracker_db_cursor_get_double;
@@ -1991,6 +2570,7 @@ tracker_db_cursor_sqlite_new (sqlite3_stmt        *sqlite_stmt,
 	cursor = g_object_new (TRACKER_TYPE_DB_CURSOR, NULL);
 
 	cursor->finished = FALSE;
+	cursor->n_columns = -1;
 
 	/* used for direct access as libtracker-sparql is thread-safe and
 	   uses a single shared connection with SQLite mutex disabled */
@@ -2082,6 +2662,12 @@ tracker_db_cursor_rewind (TrackerDBCursor *cursor)
 	sqlite3_reset (cursor->stmt);
 	cursor->finished = FALSE;
 
+	if (cursor->keys) {
+		g_variant_unref (cursor->keys);
+	}
+
+	cursor->keys = cursor->first_keys ? g_variant_ref (cursor->first_keys) : NULL;
+
 	if (cursor->threadsafe) {
 		tracker_db_manager_unlock ();
 	}
@@ -2139,6 +2725,10 @@ db_cursor_iter_next (TrackerDBCursor *cursor,
 
 		cursor->finished = (result != SQLITE_ROW);
 
+		if (!cursor->finished && cursor->n_keys > 0) {
+			db_cursor_update_keys (cursor);
+		}
+
 		if (cursor->threadsafe) {
 			tracker_db_manager_unlock ();
 		}
@@ -2150,9 +2740,109 @@ db_cursor_iter_next (TrackerDBCursor *cursor,
 guint
 tracker_db_cursor_get_n_columns (TrackerDBCursor *cursor)
 {
+	if (cursor->n_columns >= 0) {
+		/* the ORDER BY keys are selected after the visible columns */
+		return cursor->n_columns;
+	}
+
 	return sqlite3_column_count (cursor->stmt);
 }
 
+/* Makes the cursor remember the ORDER BY keys of the current row, so
+ * tracker_db_cursor_get_continuation() can tell where the next page
+ * starts. @keys are the ones the query was continued from, if any.
+ */
+void
+tracker_db_cursor_set_continuation (TrackerDBCursor *cursor,
+                                    gint             n_columns,
+                                    const gint      *key_columns,
+                                    gint             n_keys,
+                                    const gchar     *checksum,
+                                    GVariant        *keys)
+{
+	g_return_if_fail (TRACKER_IS_DB_CURSOR (cursor));
+	g_return_if_fail (n_keys > 0);
+
+	cursor->n_columns = n_columns;
+	cursor->key_columns = g_memdup (key_columns, n_keys * sizeof (gint));
+	cursor->n_keys = n_keys;
+	cursor->checksum = g_strdup (checksum);
+
+	if (keys) {
+		cursor->first_keys = g_variant_ref_sink (keys);
+		cursor->keys = g_variant_ref (keys);
+	}
+}
+
+static void
+db_cursor_update_keys (TrackerDBCursor *cursor)
+{
+	GVariantBuilder builder;
+	GVariant *keys;
+	gint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("av"));
+
+	for (i = 0; i < cursor->n_keys; i++) {
+		gint column = cursor->key_columns[i];
+		GVariant *value;
+
+		switch (sqlite3_column_type (cursor->stmt, column)) {
+		case SQLITE_INTEGER:
+			value = g_variant_new_int64 (sqlite3_column_int64 (cursor->stmt, column));
+			break;
+		case SQLITE_FLOAT:
+			value = g_variant_new_double (sqlite3_column_double (cursor->stmt, column));
+			break;
+		case SQLITE_NULL:
+			value = g_variant_new_tuple (NULL, 0);
+			break;
+		default:
+			value = g_variant_new_string ((const gchar *) sqlite3_column_text (cursor->stmt, column));
+			break;
+		}
+
+		g_variant_builder_add (&builder, "v", value);
+	}
+
+	keys = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	if (cursor->keys) {
+		g_variant_unref (cursor->keys);
+	}
+
+	cursor->keys = keys;
+}
+
+/* Token for tracker_sparql_connection_query_continue(): the checksum
+ * of the query and the ORDER BY keys of the last row returned.
+ */
+gchar *
+tracker_db_cursor_get_continuation (TrackerDBCursor *cursor)
+{
+	gchar *result = NULL;
+
+	g_return_val_if_fail (TRACKER_IS_DB_CURSOR (cursor), NULL);
+
+	if (cursor->threadsafe) {
+		tracker_db_manager_lock ();
+	}
+
+	if (cursor->keys) {
+		GVariant *continuation;
+
+		continuation = g_variant_new ("(s@av)", cursor->checksum, cursor->keys);
+		result = g_variant_print (continuation, FALSE);
+		g_variant_unref (g_variant_ref_sink (continuation));
+	}
+
+	if (cursor->threadsafe) {
+		tracker_db_manager_unlock ();
+	}
+
+	return result;
+}
+
 void
 tracker_db_cursor_get_value (TrackerDBCursor *cursor,
                              guint            column,
@@ -2251,12 +2941,12 @@ tracker_db_cursor_get_value_type (TrackerDBCursor *cursor,
 
 	if (column_type == SQLITE_NULL) {
 		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
-	} else if (column < cursor->n_types) {
+	} else if (column < cursor->n_types &&
+	           cursor->types[column] != TRACKER_PROPERTY_TYPE_UNKNOWN &&
+	           cursor->types[column] != TRACKER_PROPERTY_TYPE_INTEGER) {
 		switch (cursor->types[column]) {
 		case TRACKER_PROPERTY_TYPE_RESOURCE:
 			return TRACKER_SPARQL_VALUE_TYPE_URI;
-		case TRACKER_PROPERTY_TYPE_INTEGER:
-			return TRACKER_SPARQL_VALUE_TYPE_INTEGER;
 		case TRACKER_PROPERTY_TYPE_DOUBLE:
 			return TRACKER_SPARQL_VALUE_TYPE_DOUBLE;
 		case TRACKER_PROPERTY_TYPE_DATETIME:
@@ -2266,7 +2956,18 @@ tracker_db_cursor_get_value_type (TrackerDBCursor *cursor,
 		default:
 			return TRACKER_SPARQL_VALUE_TYPE_STRING;
 		}
-	} else {
+	}
+
+	/* Integers and values of unknown type, e.g. of expressions, are
+	 * typed after how SQLite stores them. INTEGER and DOUBLE columns
+	 * can then be read with get_int() and get_double() without any
+	 * conversion. */
+	switch (column_type) {
+	case SQLITE_INTEGER:
+		return TRACKER_SPARQL_VALUE_TYPE_INTEGER;
+	case SQLITE_FLOAT:
+		return TRACKER_SPARQL_VALUE_TYPE_DOUBLE;
+	default:
 		return TRACKER_SPARQL_VALUE_TYPE_STRING;
 	}
 }
@@ -52,6 +52,8 @@ void                tracker_db_interface_sqlite_wal_hook               (TrackerD
 void                tracker_db_interface_sqlite_fts_alter_table        (TrackerDBInterface       *interface,
                                                                         GHashTable               *properties,
                                                                         GHashTable               *multivalued);
+gboolean            tracker_db_interface_sqlite_fts_settings_changed
+                                                                       (TrackerDBInterface       *interface);
 int                 tracker_db_interface_sqlite_fts_update_text        (TrackerDBInterface       *interface,
                                                                         int                       id,
                                                                         const gchar             **properties,
@@ -61,6 +63,24 @@ int                 tracker_db_interface_sqlite_fts_update_text        (TrackerD
 gboolean            tracker_db_interface_sqlite_fts_delete_text        (TrackerDBInterface       *db_interface,
 									int                       id,
 									const gchar              *property);
+gboolean            tracker_db_interface_sqlite_fts_delete_id          (TrackerDBInterface       *interface,
+                                                                        int                       id);
+gboolean            tracker_db_interface_sqlite_fts_queue_update       (TrackerDBInterface       *interface,
+                                                                        int                       id);
+gboolean            tracker_db_interface_sqlite_fts_is_queued          (TrackerDBInterface       *interface,
+                                                                        int                       id);
+gint                tracker_db_interface_sqlite_fts_update_queued      (TrackerDBInterface       *interface,
+                                                                        gint                      max_docs,
+                                                                        GError                  **error);
+gboolean            tracker_db_interface_sqlite_fts_get_segment_stats  (TrackerDBInterface       *interface,
+                                                                        gint                     *n_segments,
+                                                                        gint                     *n_levels,
+                                                                        gint                     *max_level_segments);
+gboolean            tracker_db_interface_sqlite_fts_merge              (TrackerDBInterface       *interface,
+                                                                        gint                      n_pages,
+                                                                        gint                      min_segments,
+                                                                        gboolean                 *done,
+                                                                        GError                  **error);
 void                tracker_db_interface_sqlite_fts_update_commit      (TrackerDBInterface       *interface);
 void                tracker_db_interface_sqlite_fts_update_rollback    (TrackerDBInterface       *interface);
 #endif
@@ -65,7 +65,8 @@ typedef enum {
 	TRACKER_DB_CORRUPT,
 	TRACKER_DB_INTERRUPTED,
 	TRACKER_DB_OPEN_ERROR,
-	TRACKER_DB_NO_SPACE
+	TRACKER_DB_NO_SPACE,
+	TRACKER_DB_CHANGES_EXPIRED
 } TrackerDBInterfaceError;
 
 typedef enum {
@@ -156,6 +157,13 @@ gint64                  tracker_db_cursor_get_int                    (TrackerDBC
                                                                       guint                       column);
 gdouble                 tracker_db_cursor_get_double                 (TrackerDBCursor            *cursor,
                                                                       guint                       column);
+void                    tracker_db_cursor_set_continuation           (TrackerDBCursor            *cursor,
+                                                                      gint                        n_columns,
+                                                                      const gint                 *key_columns,
+                                                                      gint                        n_keys,
+                                                                      const gchar                *checksum,
+                                                                      GVariant                   *keys);
+gchar *                 tracker_db_cursor_get_continuation           (TrackerDBCursor            *cursor);
 
 G_END_DECLS
 
@@ -66,6 +66,11 @@
 #define LAST_CRAWL_FILENAME           "last-crawl.txt"
 #define NEED_MTIME_CHECK_FILENAME     "no-need-mtime-check.txt"
 
+/* Refresh index statistics when the resource count changed by 10% */
+#define ANALYZE_CHANGE_RATIO          0.1
+/* Rows of each index looked at by ANALYZE, see PRAGMA analysis_limit */
+#define ANALYZE_ROWS_LIMIT            1000
+
 typedef enum {
 	TRACKER_DB_LOCATION_DATA_DIR,
 	TRACKER_DB_LOCATION_USER_DATA_DIR,
@@ -694,6 +699,55 @@ tracker_db_manager_set_current_locale (void)
 	g_free (current_locale);
 }
 
+static gint64
+db_get_int64 (TrackerDBInterface *iface,
+              const gchar        *query)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	gint64 value = -1;
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE,
+	                                              NULL, "%s", query);
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, NULL);
+		g_object_unref (stmt);
+	}
+
+	if (cursor) {
+		if (tracker_db_cursor_iter_next (cursor, NULL, NULL) &&
+		    tracker_db_cursor_get_value_type (cursor, 0) != TRACKER_SPARQL_VALUE_TYPE_UNBOUND) {
+			value = tracker_db_cursor_get_int (cursor, 0);
+		}
+		g_object_unref (cursor);
+	}
+
+	return value;
+}
+
+/* The index statistics only describe how values are distributed, so
+ * they only need refreshing once the number of resources has changed
+ * by more than ANALYZE_CHANGE_RATIO since the last ANALYZE.
+ */
+static gboolean
+db_manager_stats_outdated (TrackerDBInterface *iface)
+{
+	gint64 analyzed, current;
+
+	/* The first field of the stat column is the number of rows */
+	analyzed = db_get_int64 (iface,
+	                         "SELECT MAX(CAST(stat AS INTEGER)) FROM sqlite_stat1 "
+	                         "WHERE tbl = 'Resource'");
+	if (analyzed <= 0) {
+		return TRUE;
+	}
+
+	current = db_get_int64 (iface, "SELECT COUNT(*) FROM Resource");
+
+	return ABS (current - analyzed) > analyzed * ANALYZE_CHANGE_RATIO;
+}
+
 static void
 db_manager_analyze (TrackerDB           db,
                     TrackerDBInterface *iface)
@@ -702,14 +756,23 @@ db_manager_analyze (TrackerDB           db,
 
 	current_mtime = tracker_file_get_mtime (dbs[db].abs_filename);
 
-	if (current_mtime > dbs[db].mtime) {
+	if (current_mtime <= dbs[db].mtime) {
+		g_message ("  Not updating DB:'%s', no changes since last optimize", dbs[db].name);
+	} else if (!db_manager_stats_outdated (iface)) {
+		g_message ("  Not updating DB:'%s', statistics still match its size", dbs[db].name);
+		dbs[db].mtime = current_mtime;
+	} else {
 		g_message ("  Analyzing DB:'%s'", dbs[db].name);
-		db_exec_no_reply (iface, "ANALYZE %s.Services", dbs[db].name);
+		/* Index statistics are used by the SPARQL translator
+		 * to order joins, see tracker_data_statistics_init().
+		 * Approximate ones are enough for that, so only a
+		 * bounded number of rows of each index is looked at,
+		 * which keeps this short on large databases. */
+		db_exec_no_reply (iface, "PRAGMA analysis_limit = %d", ANALYZE_ROWS_LIMIT);
+		db_exec_no_reply (iface, "ANALYZE");
 
 		/* Remember current mtime for future */
 		dbs[db].mtime = current_mtime;
-	} else {
-		g_message ("  Not updating DB:'%s', no changes since last optimize", dbs[db].name);
 	}
 }
 
@@ -66,6 +66,9 @@ struct _TrackerPropertyPrivate {
 	gchar         *default_value;
 	GPtrArray     *is_new_domain_index;
 	gboolean       force_journal;
+	gint           count;
+	gint           rows_per_value;
+	gboolean       aggregated;
 
 	GArray        *super_properties;
 	GArray        *domain_indexes;
@@ -653,6 +656,46 @@ tracker_property_get_force_journal (TrackerProperty *property)
 	return priv->force_journal;
 }
 
+/* Number of stored values, kept by tracker-data-update.c */
+gint
+tracker_property_get_count (TrackerProperty *property)
+{
+	TrackerPropertyPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_PROPERTY (property), 0);
+
+	priv = GET_PRIV (property);
+
+	return priv->count;
+}
+
+/* Average number of rows with the same value, as found by ANALYZE
+ * in the index of the property, 0 if unknown */
+gint
+tracker_property_get_rows_per_value (TrackerProperty *property)
+{
+	TrackerPropertyPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_PROPERTY (property), 0);
+
+	priv = GET_PRIV (property);
+
+	return priv->rows_per_value;
+}
+
+/* tracker:aggregated, the sum of the values is kept up to date */
+gboolean
+tracker_property_get_aggregated (TrackerProperty *property)
+{
+	TrackerPropertyPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_PROPERTY (property), FALSE);
+
+	priv = GET_PRIV (property);
+
+	return priv->aggregated;
+}
+
 TrackerProperty **
 tracker_property_get_super_properties (TrackerProperty *property)
 {
@@ -1077,6 +1120,45 @@ tracker_property_set_force_journal (TrackerProperty *property,
 	priv->force_journal = value;
 }
 
+void
+tracker_property_set_count (TrackerProperty *property,
+                            gint             value)
+{
+	TrackerPropertyPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_PROPERTY (property));
+
+	priv = GET_PRIV (property);
+
+	priv->count = value;
+}
+
+void
+tracker_property_set_rows_per_value (TrackerProperty *property,
+                                     gint             value)
+{
+	TrackerPropertyPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_PROPERTY (property));
+
+	priv = GET_PRIV (property);
+
+	priv->rows_per_value = value;
+}
+
+void
+tracker_property_set_aggregated (TrackerProperty *property,
+                                 gboolean         value)
+{
+	TrackerPropertyPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_PROPERTY (property));
+
+	priv = GET_PRIV (property);
+
+	priv->aggregated = value;
+}
+
 void
 tracker_property_add_super_property (TrackerProperty *property,
                                      TrackerProperty *value)
@@ -100,6 +100,9 @@ gboolean            tracker_property_get_cardinality_changed (TrackerProperty
 gboolean            tracker_property_get_is_inverse_functional_property
                                                              (TrackerProperty      *property);
 gboolean            tracker_property_get_force_journal       (TrackerProperty      *property);
+gint                tracker_property_get_count               (TrackerProperty      *property);
+gint                tracker_property_get_rows_per_value      (TrackerProperty      *property);
+gboolean            tracker_property_get_aggregated          (TrackerProperty      *property);
 TrackerProperty **  tracker_property_get_super_properties    (TrackerProperty      *property);
 void                tracker_property_set_uri                 (TrackerProperty      *property,
                                                               const gchar          *value);
@@ -148,6 +151,12 @@ void                tracker_property_set_is_inverse_functional_property
                                                               gboolean              value);
 void                tracker_property_set_force_journal       (TrackerProperty      *property,
                                                               gboolean              value);
+void                tracker_property_set_count               (TrackerProperty      *property,
+                                                              gint                  value);
+void                tracker_property_set_rows_per_value      (TrackerProperty      *property,
+                                                              gint                  value);
+void                tracker_property_set_aggregated          (TrackerProperty      *property,
+                                                              gboolean              value);
 void                tracker_property_add_super_property      (TrackerProperty      *property,
                                                               TrackerProperty      *value);
 void                tracker_property_del_super_property      (TrackerProperty      *property,
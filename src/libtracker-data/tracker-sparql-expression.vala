@@ -28,6 +28,19 @@ class Tracker.Sparql.Expression : Object {
 
 	string? fts_sql;
 
+	// Variable of the last fts:rank call translated, and where
+	string? last_fts_rank;
+	unowned StringBuilder? last_fts_rank_sql;
+	long last_fts_rank_begin;
+	long last_fts_rank_end;
+
+	// Variable of the fts:rank call the last ORDER BY condition
+	// consists of, null if the condition is anything else
+	internal string? order_fts_rank;
+
+	// Whether an aggregate function was translated
+	internal bool aggregated;
+
 	public Expression (Query query) {
 		this.query = query;
 	}
@@ -68,7 +81,7 @@ class Tracker.Sparql.Expression : Object {
 		return query.get_last_string (strip);
 	}
 
-	string escape_sql_string_literal (string literal) {
+	internal static string escape_sql_string_literal (string literal) {
 		return "'%s'".printf (string.joinv ("''", literal.split ("'")));
 	}
 
@@ -241,16 +254,30 @@ class Tracker.Sparql.Expression : Object {
 		}
 	}
 
-	internal void translate_order_condition (StringBuilder sql) throws Sparql.Error {
+	// Returns whether the order is descending
+	internal bool translate_order_condition (StringBuilder sql) throws Sparql.Error {
+		string direction = "";
+
 		if (accept (SparqlTokenType.ASC)) {
-			translate_expression_as_order_condition (sql);
-			sql.append (" ASC");
+			direction = " ASC";
 		} else if (accept (SparqlTokenType.DESC)) {
-			translate_expression_as_order_condition (sql);
-			sql.append (" DESC");
-		} else {
-			translate_expression_as_order_condition (sql);
+			direction = " DESC";
 		}
+
+		long begin = sql.len;
+		last_fts_rank = null;
+		translate_expression_as_order_condition (sql);
+
+		// the fts:rank call is all there is to the condition
+		order_fts_rank = null;
+		if (last_fts_rank != null && last_fts_rank_sql == sql &&
+		    last_fts_rank_begin == begin && last_fts_rank_end == sql.len) {
+			order_fts_rank = last_fts_rank;
+		}
+
+		sql.append (direction);
+
+		return direction == " DESC";
 	}
 
 	void translate_bound_call (StringBuilder sql) throws Sparql.Error {
@@ -290,24 +317,159 @@ class Tracker.Sparql.Expression : Object {
 	void translate_regex (StringBuilder sql) throws Sparql.Error {
 		expect (SparqlTokenType.REGEX);
 		expect (SparqlTokenType.OPEN_PARENS);
-		sql.append ("SparqlRegex(");
+
+		long begin = sql.len;
+		uint n_bindings = query.bindings.length ();
 		translate_expression_as_string (sql);
-		sql.append (", ");
+		string text = sql.str.substring (begin);
+		bool text_has_bindings = (query.bindings.length () != n_bindings);
+		sql.truncate (begin);
+
 		expect (SparqlTokenType.COMMA);
 		// SQLite's sqlite3_set_auxdata doesn't work correctly with bound
 		// strings for the regex in function_sparql_regex.
 		// translate_expression (sql);
-		sql.append (escape_sql_string_literal (parse_string_literal ()));
-		sql.append (", ");
+		string pattern = parse_string_literal ();
+		string flags = "";
 		if (accept (SparqlTokenType.COMMA)) {
 			// Same as above
 			// translate_expression (sql);
-			sql.append (escape_sql_string_literal (parse_string_literal ()));
-		} else {
-			sql.append ("''");
+			flags = parse_string_literal ();
 		}
-		sql.append (")");
 		expect (SparqlTokenType.CLOSE_PARENS);
+
+		// the text is repeated in the rewritten forms, which would
+		// break the order of its bindings
+		if (flags == "" && !text_has_bindings &&
+		    translate_simple_regex (sql, text, pattern)) {
+			return;
+		}
+
+		sql.append ("SparqlRegex(");
+		sql.append (text);
+		sql.append (", ");
+		sql.append (escape_sql_string_literal (pattern));
+		sql.append (", ");
+		sql.append (escape_sql_string_literal (flags));
+		sql.append (")");
+
+		// every pattern gets its own SQL, keep them out of the statement cache
+		query.no_cache = true;
+	}
+
+	// Rewrites regexes that match a literal string, optionally anchored,
+	// into comparisons SQLite can use indexes for. GLOB checks the exact
+	// bytes as collated comparisons may consider different strings equal.
+	// Note that $ also matches before a trailing newline.
+	bool translate_simple_regex (StringBuilder sql, string text, string pattern) {
+		bool anchored_start, anchored_end;
+		string? literal = get_regex_literal (pattern, out anchored_start, out anchored_end);
+
+		if (literal == null) {
+			return false;
+		}
+
+		string glob = escape_glob (literal);
+
+		if (anchored_start && anchored_end) {
+			// regex(?x, '^abc$') => (?x IN ('abc', 'abc\n') AND (?x GLOB 'abc' OR ?x GLOB 'abc\n'))
+			sql.append_printf ("(%s IN (", text);
+			append_string_binding (sql, literal);
+			sql.append (", ");
+			append_string_binding (sql, literal + "\n");
+			sql.append_printf (") AND (%s GLOB ", text);
+			append_string_binding (sql, glob);
+			sql.append_printf (" OR %s GLOB ", text);
+			append_string_binding (sql, glob + "\n");
+			sql.append ("))");
+		} else if (anchored_start) {
+			// regex(?x, '^abc') => (?x BETWEEN 'abc' AND 'abc\u0010fffd' AND ?x GLOB 'abc*')
+			sql.append_printf ("(%s BETWEEN ", text);
+			append_string_binding (sql, literal);
+			sql.append (" AND ");
+			append_string_binding (sql, literal + COLLATION_LAST_CHAR.to_string ());
+			sql.append_printf (" AND %s GLOB ", text);
+			append_string_binding (sql, glob + "*");
+			sql.append (")");
+		} else if (anchored_end) {
+			// regex(?x, 'abc$') => (?x GLOB '*abc' OR ?x GLOB '*abc\n')
+			sql.append_printf ("(%s GLOB ", text);
+			append_string_binding (sql, "*" + glob);
+			sql.append_printf (" OR %s GLOB ", text);
+			append_string_binding (sql, "*" + glob + "\n");
+			sql.append (")");
+		} else {
+			// regex(?x, 'abc') => (?x GLOB '*abc*')
+			sql.append_printf ("(%s GLOB ", text);
+			append_string_binding (sql, "*" + glob + "*");
+			sql.append (")");
+		}
+
+		return true;
+	}
+
+	// Returns the string matched by a pattern without metacharacters
+	// other than ^ and $ anchors and escaped punctuation, null otherwise
+	static string? get_regex_literal (string pattern, out bool anchored_start, out bool anchored_end) {
+		var literal = new StringBuilder ();
+		int i = 0;
+
+		anchored_start = pattern.has_prefix ("^");
+		anchored_end = false;
+
+		if (anchored_start) {
+			i++;
+		}
+
+		while (i < pattern.length) {
+			char c = pattern[i];
+
+			if (c == '\\') {
+				// \d, \w and friends are not literals
+				if (i + 1 >= pattern.length || !pattern[i + 1].ispunct ()) {
+					return null;
+				}
+				literal.append_c (pattern[i + 1]);
+				i += 2;
+			} else if (c == '$' && i == pattern.length - 1) {
+				anchored_end = true;
+				i++;
+			} else if ("^$.|?*+()[]{}".index_of_char (c) >= 0) {
+				return null;
+			} else {
+				literal.append_c (c);
+				i++;
+			}
+		}
+
+		if (literal.len == 0) {
+			return null;
+		}
+
+		return literal.str;
+	}
+
+	static string escape_glob (string literal) {
+		var glob = new StringBuilder ();
+
+		for (int i = 0; i < literal.length; i++) {
+			char c = literal[i];
+
+			if (c == '*' || c == '?' || c == '[') {
+				glob.append_printf ("[%c]", c);
+			} else {
+				glob.append_c (c);
+			}
+		}
+
+		return glob.str;
+	}
+
+	void append_string_binding (StringBuilder sql, string literal) {
+		sql.append ("?");
+		var binding = new LiteralBinding ();
+		binding.literal = literal;
+		query.bindings.append (binding);
 	}
 
 	void translate_exists (StringBuilder sql) throws Sparql.Error {
@@ -681,7 +843,11 @@ class Tracker.Sparql.Expression : Object {
 		} else if (uri == FTS_NS + "rank") {
 			bool is_var;
 			string v = pattern.parse_var_or_term (null, out is_var);
+			last_fts_rank_sql = sql;
+			last_fts_rank_begin = sql.len;
 			sql.append_printf ("\"%s_u_rank\"", v);
+			last_fts_rank_end = sql.len;
+			last_fts_rank = v;
 
 			return PropertyType.DOUBLE;
 		} else if (uri == FTS_NS + "offsets") {
@@ -697,45 +863,50 @@ class Tracker.Sparql.Expression : Object {
 
 			string v = pattern.parse_var_or_term (null, out is_var);
 			var variable = context.get_variable (v);
-			var fts = new StringBuilder ();
-
-			fts.append_printf ("snippet(\"fts\"");
+			var args = new StringBuilder ();
 
 			// "start match" text
 			if (accept (SparqlTokenType.COMMA)) {
-				fts.append (", ");
-				translate_expression_as_string (fts);
+				args.append (", ");
+				translate_expression_as_string (args);
 
 				// "end match" text
 				expect (SparqlTokenType.COMMA);
-				fts.append (", ");
-				translate_expression_as_string (fts);
+				args.append (", ");
+				translate_expression_as_string (args);
 			} else {
-				fts.append(",'',''");
+				args.append(",'',''");
 			}
 
 			// "ellipsis" text
 			if (accept (SparqlTokenType.COMMA)) {
-				fts.append (", ");
-				translate_expression_as_string (fts);
+				args.append (", ");
+				translate_expression_as_string (args);
 			} else {
-				fts.append (", '...'");
+				args.append (", '...'");
 			}
 
-			// lookup column
-			fts.append (", -1");
+			var n_words = new StringBuilder ();
 
 			// Approximate number of words in context
 			if (accept (SparqlTokenType.COMMA)) {
-				fts.append (", ");
-				translate_expression_as_string (fts);
+				translate_expression_as_string (n_words);
 			} else {
-				fts.append (", 5");
+				n_words.append ("5");
 			}
 
-			fts.append (")");
+			if (accept (SparqlTokenType.COMMA)) {
+				// Maximum number of matches to look at, the text
+				// is only scanned up to there and snippets are cached
+				var max_matches = new StringBuilder ();
+				translate_expression_as_string (max_matches);
+
+				fts_sql = "tracker_snippet(docid, (SELECT \"tracker:modified\" FROM \"rdfs:Resource\" WHERE ID = docid), %s%s, %s, %s)".printf (pattern.match_literal ?? "NULL", args.str, n_words.str, max_matches.str);
+			} else {
+				// lookup column
+				fts_sql = "snippet(\"fts\"%s, -1, %s)".printf (args.str, n_words.str);
+			}
 
-			fts_sql = fts.str;
 			sql.append (variable.sql_expression);
 			return PropertyType.STRING;
 		} else if (uri == TRACKER_NS + "id") {
@@ -832,6 +1003,8 @@ class Tracker.Sparql.Expression : Object {
 				throw get_error ("Unknown function");
 			}
 
+			query.add_dependency (prop.id);
+
 			var expr = new StringBuilder ();
 			translate_expression (expr);
 
@@ -934,9 +1107,19 @@ class Tracker.Sparql.Expression : Object {
 		switch (last ()) {
 		case SparqlTokenType.STRING_LITERAL1:
 		case SparqlTokenType.STRING_LITERAL2:
-			var sb = new StringBuilder ();
-
 			string s = get_last_string (1);
+
+			if (s.index_of_char ('\\') < 0) {
+				// no escape sequences, avoid copying long literals once more
+				if (accept (SparqlTokenType.DOUBLE_CIRCUMFLEX)) {
+					// typed literal
+					type = parse_type_uri ();
+				}
+
+				return (owned) s;
+			}
+
+			var sb = new StringBuilder.sized (s.length);
 			string* p = s;
 			string* end = p + s.length;
 			while ((long) p < (long) end) {
@@ -984,7 +1167,7 @@ class Tracker.Sparql.Expression : Object {
 				type = parse_type_uri ();
 			}
 
-			return sb.str;
+			return (owned) sb.str;
 		case SparqlTokenType.STRING_LITERAL_LONG1:
 		case SparqlTokenType.STRING_LITERAL_LONG2:
 			string result = get_last_string (3);
@@ -1186,7 +1369,6 @@ class Tracker.Sparql.Expression : Object {
 			return PropertyType.BOOLEAN;
 		case SparqlTokenType.REGEX:
 			translate_regex (sql);
-			query.no_cache = true;
 			return PropertyType.BOOLEAN;
 		case SparqlTokenType.EXISTS:
 		case SparqlTokenType.NOT:
@@ -1224,6 +1406,7 @@ class Tracker.Sparql.Expression : Object {
 			return type;
 		case SparqlTokenType.GROUP_CONCAT:
 			next ();
+			aggregated = true;
 			sql.append ("GROUP_CONCAT(");
 			expect (SparqlTokenType.OPEN_PARENS);
 			translate_expression_as_string (sql);
@@ -1478,6 +1661,7 @@ class Tracker.Sparql.Expression : Object {
 	}
 
 	PropertyType translate_aggregate_expression (StringBuilder sql) throws Sparql.Error {
+		aggregated = true;
 		expect (SparqlTokenType.OPEN_PARENS);
 		if (accept (SparqlTokenType.DISTINCT)) {
 			sql.append ("DISTINCT ");
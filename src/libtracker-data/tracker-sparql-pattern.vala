@@ -160,6 +160,7 @@ class Tracker.Sparql.Pattern : Object {
 	weak Expression expression;
 
 	int counter;
+	int n_triples_blocks;
 
 	int next_table_index;
 
@@ -170,8 +171,12 @@ class Tracker.Sparql.Pattern : Object {
 	string current_predicate;
 	bool current_predicate_is_var;
 	public Variable? fts_subject;
+
+	static int top_k_serial;
 	public string[] fts_variables;
 	internal StringBuilder? match_str;
+	// Quoted text of the first fts:match in the current query
+	internal string? match_literal;
 	public bool queries_fts_data = false;
 
 	public Pattern (Query query) {
@@ -255,11 +260,18 @@ class Tracker.Sparql.Pattern : Object {
 		var pattern_sql = new StringBuilder ();
 		var old_bindings = (owned) query.bindings;
 
+		// keyset pagination, see query_continue ()
+		bool keyset = !subquery && query.continued;
+		bool resumed = keyset && query.continuation != null;
+		bool distinct = false;
+		string[] select_columns = {};
+
 		sql.append ("SELECT ");
 
 		expect (SparqlTokenType.SELECT);
 
 		if (accept (SparqlTokenType.DISTINCT)) {
+			distinct = true;
 			sql.append ("DISTINCT ");
 		} else if (accept (SparqlTokenType.REDUCED)) {
 		}
@@ -294,6 +306,10 @@ class Tracker.Sparql.Pattern : Object {
 		var where_bindings = (owned) query.bindings;
 		query.bindings = (owned) old_bindings;
 
+		// aggregates in subqueries of the select expressions count too
+		bool outer_aggregated = expression.aggregated;
+		expression.aggregated = false;
+
 		bool first = true;
 		if (accept (SparqlTokenType.STAR)) {
 			foreach (var variable in context.var_set.get_keys ()) {
@@ -320,9 +336,14 @@ class Tracker.Sparql.Pattern : Object {
 					sql.append (", ");
 				}
 
+				long column_begin = sql.len;
 				type = expression.translate_select_expression (sql, subquery, i);
 				result.types += type;
 
+				if (keyset) {
+					select_columns += sql.str.substring (column_begin);
+				}
+
 				switch (current ()) {
 				case SparqlTokenType.FROM:
 				case SparqlTokenType.WHERE:
@@ -340,6 +361,9 @@ class Tracker.Sparql.Pattern : Object {
 			}
 		}
 
+		bool aggregated = expression.aggregated;
+		expression.aggregated = outer_aggregated || aggregated;
+
 		if (queries_fts_data && fts_subject != null) {
 			// Ensure there's a docid to match on in FTS queries
 			if (!first) {
@@ -356,19 +380,34 @@ class Tracker.Sparql.Pattern : Object {
 			query.bindings.append (binding);
 		}
 
+		int n_sql_columns = result.types.length;
+
 		if (first) {
 			sql.append ("NULL");
+			n_sql_columns = 1;
+		} else if (queries_fts_data && fts_subject != null) {
+			// docid
+			n_sql_columns++;
 		}
 
+		long select_end = sql.len;
+
 		// select from results of WHERE clause
 		sql.append (" FROM (");
 		sql.append (pattern_sql.str);
 		sql.append (")");
+		long pattern_end = sql.len;
+		bool grouped = false;
+		long having_begin = -1;
+		string? rank_order = null;
 
 		set_location (after_where);
 
+		string[] group_keys = {};
+
 		if (accept (SparqlTokenType.GROUP)) {
 			expect (SparqlTokenType.BY);
+			grouped = true;
 			sql.append (" GROUP BY ");
 			bool first_group = true;
 			do {
@@ -377,27 +416,97 @@ class Tracker.Sparql.Pattern : Object {
 				} else {
 					sql.append (", ");
 				}
+				long key_begin = sql.len;
+				uint key_bindings = query.bindings.length ();
 				expression.translate_expression (sql);
+
+				if (keyset) {
+					group_keys += inline_literals (sql.str.substring (key_begin), key_bindings);
+				}
 			} while (current () != SparqlTokenType.HAVING && current () != SparqlTokenType.ORDER && current () != SparqlTokenType.LIMIT && current () != SparqlTokenType.OFFSET && current () != SparqlTokenType.CLOSE_BRACE && current () != SparqlTokenType.CLOSE_PARENS && current () != SparqlTokenType.EOF);
 
 			if (accept (SparqlTokenType.HAVING)) {
 				sql.append (" HAVING ");
+				having_begin = sql.len;
 				expression.translate_constraint (sql);
 			}
 		}
 
+		long order_start = sql.len;
+		string[] order_keys = {};
+		bool[] order_descending = {};
+
 		if (accept (SparqlTokenType.ORDER)) {
 			expect (SparqlTokenType.BY);
 			sql.append (" ORDER BY ");
 			bool first_order = true;
+			int n_order = 0;
+			bool descending = false;
 			do {
 				if (first_order) {
 					first_order = false;
 				} else {
 					sql.append (", ");
 				}
-				expression.translate_order_condition (sql);
+				long key_begin = sql.len;
+				uint key_bindings = query.bindings.length ();
+				descending = expression.translate_order_condition (sql);
+				n_order++;
+
+				if (keyset) {
+					string key = sql.str.substring (key_begin);
+					if (key.has_suffix (descending ? " DESC" : " ASC")) {
+						key = key.substring (0, key.length - (descending ? 5 : 4));
+					}
+					order_keys += inline_literals (key, key_bindings);
+					order_descending += descending;
+				}
 			} while (current () != SparqlTokenType.LIMIT && current () != SparqlTokenType.OFFSET && current () != SparqlTokenType.CLOSE_BRACE && current () != SparqlTokenType.CLOSE_PARENS && current () != SparqlTokenType.EOF);
+
+			// ORDER BY DESC (fts:rank (?v)) alone
+			if (n_order == 1 && descending && expression.order_fts_rank != null) {
+				rank_order = expression.order_fts_rank;
+			}
+
+			if (keyset) {
+				// Continuing after the last row needs a total order,
+				// rows tying on the ORDER BY keys are sorted by what
+				// tells them apart: the groups, the distinct rows, or
+				// the bindings of the pattern variables
+				string[] tie_keys = {};
+
+				if (grouped) {
+					tie_keys = group_keys;
+				} else if (distinct) {
+					if (select_columns.length == 0) {
+						throw new Sparql.Error.UNSUPPORTED ("SELECT DISTINCT * can't be continued");
+					}
+					foreach (string column in select_columns) {
+						int alias = column.last_index_of (" AS ");
+						if (alias < 0) {
+							throw new Sparql.Error.UNSUPPORTED ("SELECT DISTINCT can only be continued when all selected expressions are named");
+						}
+						tie_keys += column.substring (alias + 4);
+					}
+				} else {
+					var variables = new List<Variable> ();
+					foreach (var variable in context.var_set.get_keys ()) {
+						variables.insert_sorted (variable, (a, b) => a.index - b.index);
+					}
+					foreach (var variable in variables) {
+						tie_keys += variable.sql_expression;
+					}
+				}
+
+				foreach (string key in tie_keys) {
+					if (key in order_keys) {
+						continue;
+					}
+					sql.append_printf (", %s", key);
+					order_keys += key;
+					order_descending += false;
+				}
+			}
 		}
 
 		int limit = -1;
@@ -419,6 +528,35 @@ class Tracker.Sparql.Pattern : Object {
 			}
 		}
 
+		if (resumed) {
+			if (order_keys.length == 0) {
+				throw new Sparql.Error.UNSUPPORTED ("Only queries with ORDER BY can be continued");
+			}
+
+			// the original OFFSET is done with
+			offset = -1;
+		}
+
+		// the top k rows are not the top k of the total order of continued
+		// queries, nor the ones left after DISTINCT or aggregation
+		if (rank_order != null && limit >= 0 && !grouped && !keyset && !distinct && !aggregated) {
+			// Only the best ranked limit + offset rows may be returned,
+			// drop the others right after the WHERE clause is applied,
+			// before the select expressions are computed and sorted.
+			// LIMIT -1 keeps SQLite from flattening the subquery, which
+			// could otherwise apply the filter before all joins.
+			var top_k = new StringBuilder ();
+			top_k.append_printf (" WHERE tracker_rank_top_k(\"%s_u_rank\", %d, ?)",
+			                     rank_order, limit + int.max (offset, 0));
+			sql.insert (pattern_end, top_k.str);
+			sql.insert (pattern_end - 1, " LIMIT -1");
+
+			var binding = new LiteralBinding ();
+			binding.literal = AtomicInt.add (ref top_k_serial, 1).to_string ();
+			binding.data_type = PropertyType.INTEGER;
+			query.bindings.append (binding);
+		}
+
 		// LIMIT and OFFSET
 		if (limit >= 0) {
 			sql.append (" LIMIT ?");
@@ -445,6 +583,56 @@ class Tracker.Sparql.Pattern : Object {
 			query.bindings.append (binding);
 		}
 
+		if (order_keys.length > 0) {
+			if (queries_fts_data && match_str != null && fts_subject != null) {
+				throw new Sparql.Error.UNSUPPORTED ("Queries using fts:offsets or fts:snippet can't be continued");
+			}
+
+			// insert from the end of the statement to the start, so
+			// the recorded offsets stay valid
+			if (resumed) {
+				var constraint = get_keyset_constraint (order_keys, order_descending, query.continuation.get_child_value (1), 0);
+
+				if (!grouped) {
+					sql.insert (pattern_end, " WHERE " + constraint);
+				} else if (having_begin < 0) {
+					sql.insert (order_start, " HAVING " + constraint);
+				} else {
+					sql.insert (order_start, ") AND " + constraint);
+					sql.insert (having_begin, "(");
+				}
+			}
+
+			// the cursor reads the keys of the last row from these
+			// columns, after the ones returned to the client
+			var key_columns = new StringBuilder ();
+
+			for (int i = 0; i < order_keys.length; i++) {
+				int column = -1;
+
+				// ORDER BY ?x for SELECT (... AS ?x)
+				for (int j = 0; j < select_columns.length; j++) {
+					if (select_columns[j].has_suffix (" AS " + order_keys[i])) {
+						column = j;
+						break;
+					}
+				}
+
+				if (column < 0) {
+					if (distinct) {
+						throw new Sparql.Error.UNSUPPORTED ("SELECT DISTINCT can only be continued when ordered by selected expressions");
+					}
+
+					key_columns.append_printf (", %s", order_keys[i]);
+					column = n_sql_columns++;
+				}
+
+				result.key_columns += column;
+			}
+
+			sql.insert (select_end, key_columns.str);
+		}
+
 		if (queries_fts_data && match_str != null && fts_subject != null) {
 			var str = new StringBuilder ("SELECT ");
 			first = true;
@@ -468,11 +656,294 @@ class Tracker.Sparql.Pattern : Object {
 
 		result.type = type;
 		match_str = null;
+		match_literal = null;
 		fts_subject = null;
 
 		return result;
 	}
 
+	bool is_iri_or_var () {
+		switch (current ()) {
+		case SparqlTokenType.VAR:
+		case SparqlTokenType.IRI_REF:
+		case SparqlTokenType.PN_PREFIX:
+		case SparqlTokenType.COLON:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Answers the counts of a class or of the values of a property, and
+	// the sum or average of the values of a tracker:aggregated property,
+	// from the Statistics and Aggregates tables libtracker-data keeps up
+	// to date on each commit, instead of going through all the rows:
+	//
+	//   SELECT (COUNT (?r) AS ?c) WHERE { ?r a nfo:Document }
+	//   SELECT ?t (COUNT (?r) AS ?c) WHERE { ?r a ?t } GROUP BY ?t
+	//   SELECT (SUM (?s) AS ?total) WHERE { ?r nfo:fileSize ?s }
+	//
+	// Returns null for any other query, the caller then translates it
+	// from the start as usual.
+	internal SelectContext? translate_statistics_select (StringBuilder sql) throws Sparql.Error {
+		string? group_variable = null;
+		string? argument = null;
+
+		expect (SparqlTokenType.SELECT);
+
+		if (accept (SparqlTokenType.VAR)) {
+			group_variable = get_last_string ().substring (1);
+		}
+
+		if (!accept (SparqlTokenType.OPEN_PARENS)) {
+			return null;
+		}
+
+		var function = current ();
+		if (function != SparqlTokenType.COUNT && function != SparqlTokenType.SUM && function != SparqlTokenType.AVG) {
+			return null;
+		}
+		next ();
+
+		if (!accept (SparqlTokenType.OPEN_PARENS)) {
+			return null;
+		}
+
+		if (accept (SparqlTokenType.VAR)) {
+			argument = get_last_string ().substring (1);
+		} else if (function != SparqlTokenType.COUNT || !accept (SparqlTokenType.STAR)) {
+			return null;
+		}
+
+		if (!accept (SparqlTokenType.CLOSE_PARENS) || !accept (SparqlTokenType.AS) || !accept (SparqlTokenType.VAR)) {
+			return null;
+		}
+
+		string result_variable = get_last_string ().substring (1);
+
+		if (!accept (SparqlTokenType.CLOSE_PARENS)) {
+			return null;
+		}
+
+		accept (SparqlTokenType.WHERE);
+
+		if (!accept (SparqlTokenType.OPEN_BRACE) || current () != SparqlTokenType.VAR) {
+			return null;
+		}
+
+		bool is_var;
+		string subject = parse_var_or_term (null, out is_var);
+		string predicate;
+
+		if (accept (SparqlTokenType.A)) {
+			predicate = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type";
+		} else if (is_iri_or_var () && current () != SparqlTokenType.VAR) {
+			predicate = parse_var_or_term (null, out is_var);
+		} else {
+			return null;
+		}
+
+		if (!is_iri_or_var ()) {
+			return null;
+		}
+
+		bool object_is_var;
+		string object = parse_var_or_term (null, out object_is_var);
+
+		accept (SparqlTokenType.DOT);
+
+		if (!accept (SparqlTokenType.CLOSE_BRACE)) {
+			return null;
+		}
+
+		if (group_variable != null) {
+			if (!accept (SparqlTokenType.GROUP) || !accept (SparqlTokenType.BY) || !accept (SparqlTokenType.VAR) ||
+			    get_last_string ().substring (1) != group_variable) {
+				return null;
+			}
+		}
+
+		if (current () != SparqlTokenType.EOF || (object_is_var && object == subject)) {
+			return null;
+		}
+
+		// COUNT (*) counts the same rows
+		if (argument != null && argument != subject && !(object_is_var && argument == object)) {
+			return null;
+		}
+
+		var result = new SelectContext (query);
+
+		if (predicate == "http://www.w3.org/1999/02/22-rdf-syntax-ns#type") {
+			if (function != SparqlTokenType.COUNT || (argument != null && argument != subject)) {
+				return null;
+			}
+
+			if (group_variable != null) {
+				if (!object_is_var || object != group_variable) {
+					return null;
+				}
+
+				query.add_dependency_on_all ();
+
+				sql.append ("SELECT (SELECT Uri FROM Resource WHERE ID = Statistics.ID), Count FROM Statistics ");
+				sql.append ("WHERE Count > 0 AND ID IN (SELECT ID FROM \"rdfs:Class\")");
+
+				result.types += PropertyType.RESOURCE;
+				result.variable_names += group_variable;
+			} else {
+				unowned Class? cl = null;
+				if (!object_is_var) {
+					cl = Ontologies.get_class_by_uri (object);
+				}
+
+				if (cl == null) {
+					return null;
+				}
+
+				query.add_dependency (cl.id);
+
+				sql.append_printf ("SELECT COALESCE ((SELECT Count FROM Statistics WHERE ID = %d), 0)", cl.id);
+			}
+
+			result.types += PropertyType.INTEGER;
+			result.variable_names += result_variable;
+
+			return result;
+		}
+
+		var prop = Ontologies.get_property_by_uri (predicate);
+
+		// transient values are not counted
+		if (group_variable != null || !object_is_var || prop == null || prop.transient) {
+			return null;
+		}
+
+		query.add_dependency (prop.id);
+
+		string count_sql = "COALESCE ((SELECT Count FROM Statistics WHERE ID = %d), 0)".printf (prop.id);
+
+		if (function == SparqlTokenType.COUNT) {
+			sql.append_printf ("SELECT %s", count_sql);
+			result.types += PropertyType.INTEGER;
+		} else {
+			if (argument != object || !prop.aggregated ||
+			    (prop.data_type != PropertyType.INTEGER && prop.data_type != PropertyType.DOUBLE)) {
+				return null;
+			}
+
+			// the table is summed up in case the store did not add the row yet
+			string sum_sql = "COALESCE ((SELECT Sum FROM Aggregates WHERE ID = %d), (SELECT TOTAL (\"%s\") FROM \"%s\"))".printf (prop.id, prop.name, prop.table_name);
+
+			// like SQLite, no values sum up to NULL
+			if (function == SparqlTokenType.AVG) {
+				sql.append_printf ("SELECT CASE %s WHEN 0 THEN NULL ELSE %s / %s END", count_sql, sum_sql, count_sql);
+				result.types += PropertyType.DOUBLE;
+			} else if (prop.data_type == PropertyType.INTEGER) {
+				sql.append_printf ("SELECT CASE %s WHEN 0 THEN NULL ELSE CAST (%s AS INTEGER) END", count_sql, sum_sql);
+				result.types += PropertyType.INTEGER;
+			} else {
+				sql.append_printf ("SELECT CASE %s WHEN 0 THEN NULL ELSE %s END", count_sql, sum_sql);
+				result.types += PropertyType.DOUBLE;
+			}
+		}
+
+		result.variable_names += result_variable;
+
+		return result;
+	}
+
+	// Replaces the ? placeholders of an ORDER BY condition by the
+	// literals bound to them, as it is repeated in other parts of the
+	// statement for continued queries
+	string inline_literals (string sql, uint first_binding) throws Sparql.Error {
+		unowned List<LiteralBinding> binding = query.bindings.nth (first_binding);
+
+		if (binding == null) {
+			return sql;
+		}
+
+		var result = new StringBuilder ();
+		char quote = 0;
+
+		for (int i = 0; i < sql.length; i++) {
+			char c = sql[i];
+
+			if (quote != 0) {
+				if (c == quote) {
+					quote = 0;
+				}
+			} else if (c == '\'' || c == '"') {
+				quote = c;
+			} else if (c == '?' && binding != null) {
+				var literal = binding.data.literal;
+
+				switch (binding.data.data_type) {
+				case PropertyType.INTEGER:
+					result.append (int.parse (literal).to_string ());
+					break;
+				case PropertyType.BOOLEAN:
+					if (literal == "true" || literal == "1") {
+						result.append ("1");
+					} else if (literal == "false" || literal == "0") {
+						result.append ("0");
+					} else {
+						throw new Sparql.Error.TYPE ("`%s' is not a valid boolean".printf (literal));
+					}
+					break;
+				case PropertyType.DATE:
+				case PropertyType.DATETIME:
+					throw new Sparql.Error.UNSUPPORTED ("Queries ordered by date literals can't be continued");
+				default:
+					result.append (Expression.escape_sql_string_literal (literal));
+					break;
+				}
+
+				binding = binding.next;
+				continue;
+			}
+
+			result.append_c (c);
+		}
+
+		return result.str;
+	}
+
+	// Rows sorting after the continuation keys, NULL sorts before any
+	// value. The order is total, no other row has the same keys
+	string get_keyset_constraint (string[] keys, bool[] descending, Variant values, int i) throws Sparql.Error {
+		if (values.n_children () != keys.length) {
+			throw new Sparql.Error.PARSE ("Continuation does not match the ORDER BY of the query");
+		}
+
+		var value = values.get_child_value (i).get_variant ();
+		string key = keys[i];
+		string literal = null;
+		string after, equal;
+
+		if (value.is_of_type (VariantType.INT64)) {
+			literal = value.get_int64 ().to_string ();
+		} else if (value.is_of_type (VariantType.DOUBLE)) {
+			literal = value.get_double ().to_string ();
+		} else if (value.is_of_type (VariantType.STRING)) {
+			literal = Expression.escape_sql_string_literal (value.get_string ());
+		}
+
+		if (literal == null) {
+			equal = "%s IS NULL".printf (key);
+			after = descending[i] ? "0" : "%s IS NOT NULL".printf (key);
+		} else {
+			equal = "%s = %s".printf (key, literal);
+			after = descending[i] ? "(%s < %s OR %s IS NULL)".printf (key, literal, key) : "%s > %s".printf (key, literal);
+		}
+
+		if (i == keys.length - 1) {
+			return after;
+		}
+
+		return "(%s OR (%s AND %s))".printf (after, equal, get_keyset_constraint (keys, descending, values, i + 1));
+	}
+
 	internal void translate_exists (StringBuilder sql) throws Sparql.Error {
 		bool not = accept (SparqlTokenType.NOT);
 		expect (SparqlTokenType.EXISTS);
@@ -684,9 +1155,21 @@ class Tracker.Sparql.Pattern : Object {
 
 		sql.append (" FROM ");
 		bool first = true;
-		foreach (DataTable table in triple_context.tables) {
+		var ordered_tables = order_tables ();
+		// CROSS JOIN keeps SQLite from reordering the tables
+		string separator = (ordered_tables != null) ? " CROSS JOIN " : ", ";
+
+		if (query.join_plan != null) {
+			query.join_plan.append_printf ("  Basic graph pattern %d (%s):\n",
+			                               ++n_triples_blocks,
+			                               ordered_tables != null ? "reordered" : "as written");
+		}
+
+		unowned List<DataTable> tables = (ordered_tables != null) ? ordered_tables : triple_context.tables;
+
+		foreach (DataTable table in tables) {
 			if (!first) {
-				sql.append (", ");
+				sql.append (separator);
 			} else {
 				first = false;
 			}
@@ -696,6 +1179,14 @@ class Tracker.Sparql.Pattern : Object {
 				sql.append_printf ("(%s)", table.predicate_variable.get_sql_query (query));
 			}
 			sql.append_printf (" AS \"%s\"", table.sql_query_tablename);
+
+			if (query.join_plan != null) {
+				if (table.estimated_rows >= 0) {
+					query.join_plan.append_printf ("    %s: ~%.0f rows\n", table.sql_query_tablename, table.estimated_rows);
+				} else {
+					query.join_plan.append_printf ("    %s: unknown rows\n", table.sql_query_tablename);
+				}
+			}
 		}
 
 		foreach (var variable in triple_context.variables) {
@@ -771,6 +1262,7 @@ class Tracker.Sparql.Pattern : Object {
 				if (match_str == null) {
 				        match_str = new StringBuilder ();
 					match_str.append_printf (" MATCH '%s'", escaped_literal);
+					match_literal = "'%s'".printf (escaped_literal);
 				}
 			} else {
 				sql.append (" = ");
@@ -905,6 +1397,16 @@ class Tracker.Sparql.Pattern : Object {
 						in_domain = true;
 						break;
 					}
+					// domain index column in the class table, see parse_object
+					foreach (Class cl in prop.get_domain_indexes ()) {
+						if (binding.type == cl) {
+							in_domain = true;
+							break;
+						}
+					}
+					if (in_domain) {
+						break;
+					}
 				}
 
 				if (in_domain) {
@@ -926,6 +1428,125 @@ class Tracker.Sparql.Pattern : Object {
 		}
 	}
 
+	void translate_simple_optional (StringBuilder sql) throws Sparql.Error {
+		// perform join-less optional (like non-optional except for the IS NOT NULL check)
+		expect (SparqlTokenType.OPEN_BRACE);
+
+		current_subject = parse_var_or_term (sql, out current_subject_is_var);
+		parse_property_list_not_empty (sql, true);
+
+		accept (SparqlTokenType.DOT);
+		expect (SparqlTokenType.CLOSE_BRACE);
+	}
+
+	void skip_group () throws Sparql.Error {
+		expect (SparqlTokenType.OPEN_BRACE);
+		int n_braces = 1;
+		while (n_braces > 0) {
+			if (accept (SparqlTokenType.OPEN_BRACE)) {
+				n_braces++;
+			} else if (accept (SparqlTokenType.CLOSE_BRACE)) {
+				n_braces--;
+			} else if (current () == SparqlTokenType.EOF) {
+				throw get_error ("unexpected end of query, expected }");
+			} else {
+				next ();
+			}
+		}
+	}
+
+	// Translates the simple optionals further down in the group into the
+	// current triples block, before the OPTIONAL at the current location
+	// ends it. They commute with the patterns in between as long as these
+	// don't use the variable they bind, and each saves a LEFT JOIN.
+	// Returns the locations of the translated optionals, to skip them later.
+	SourceLocation[] hoist_simple_optionals (StringBuilder sql) throws Sparql.Error {
+		SourceLocation[] hoisted = { };
+		var start = get_location ();
+		var seen = new HashTable<string,bool> (str_hash, str_equal);
+		int depth = 0;
+
+		while (true) {
+			if (depth == 0) {
+				if (current () == SparqlTokenType.CLOSE_BRACE || current () == SparqlTokenType.EOF) {
+					break;
+				} else if (current () == SparqlTokenType.FILTER) {
+					// filters apply to the group as a whole
+					skip_filter ();
+					continue;
+				} else if (current () == SparqlTokenType.OPTIONAL) {
+					var optional_location = get_location ();
+					expect (SparqlTokenType.OPTIONAL);
+
+					if (is_simple_optional () && !uses_seen_variable (seen)) {
+						translate_simple_optional (sql);
+						hoisted += optional_location;
+						continue;
+					}
+				}
+			}
+
+			if (accept (SparqlTokenType.VAR)) {
+				seen.insert (get_last_string ().substring (1), true);
+				continue;
+			}
+
+			switch (current ()) {
+			case SparqlTokenType.OPEN_BRACE:
+			case SparqlTokenType.OPEN_PARENS:
+			case SparqlTokenType.OPEN_BRACKET:
+				depth++;
+				break;
+			case SparqlTokenType.CLOSE_BRACE:
+			case SparqlTokenType.CLOSE_PARENS:
+			case SparqlTokenType.CLOSE_BRACKET:
+				depth--;
+				break;
+			default:
+				break;
+			}
+
+			next ();
+		}
+
+		set_location (start);
+
+		return hoisted;
+	}
+
+	// Whether the simple optional at the current location binds a
+	// variable already used in the group
+	bool uses_seen_variable (HashTable<string,bool> seen) throws Sparql.Error {
+		var optional_start = get_location ();
+
+		try {
+			while (!accept (SparqlTokenType.CLOSE_BRACE)) {
+				if (accept (SparqlTokenType.VAR)) {
+					var name = get_last_string ().substring (1);
+					if (context.var_set.lookup (context.get_variable (name)) != VariableState.BOUND &&
+					    seen.contains (name)) {
+						return true;
+					}
+				} else {
+					next ();
+				}
+			}
+
+			return false;
+		} finally {
+			set_location (optional_start);
+		}
+	}
+
+	static bool is_hoisted (SourceLocation[] hoisted, SourceLocation location) {
+		foreach (var hoisted_location in hoisted) {
+			if (hoisted_location.pos == location.pos) {
+				return true;
+			}
+		}
+		return false;
+	}
+
 	internal Context translate_group_graph_pattern (StringBuilder sql) throws Sparql.Error {
 		expect (SparqlTokenType.OPEN_BRACE);
 
@@ -947,6 +1568,7 @@ class Tracker.Sparql.Pattern : Object {
 		context = result;
 
 		SourceLocation[] filters = { };
+		SourceLocation[] hoisted_optionals = { };
 
 		bool in_triples_block = false;
 		bool in_group_graph_pattern = false;
@@ -959,18 +1581,19 @@ class Tracker.Sparql.Pattern : Object {
 
 		while (true) {
 			// check whether we have GraphPatternNotTriples | Filter
+			var optional_location = get_location ();
 			if (accept (SparqlTokenType.OPTIONAL)) {
-				if (!in_group_graph_pattern && is_simple_optional ()) {
-					// perform join-less optional (like non-optional except for the IS NOT NULL check)
+				if (is_hoisted (hoisted_optionals, optional_location)) {
+					// already translated, see hoist_simple_optionals
+					skip_group ();
+				} else if (!in_group_graph_pattern && is_simple_optional ()) {
 					found_simple_optional = true;
-					expect (SparqlTokenType.OPEN_BRACE);
-
-					current_subject = parse_var_or_term (sql, out current_subject_is_var);
-					parse_property_list_not_empty (sql, true);
-
-					accept (SparqlTokenType.DOT);
-					expect (SparqlTokenType.CLOSE_BRACE);
+					translate_simple_optional (sql);
 				} else {
+					if (in_triples_block && !in_group_graph_pattern) {
+						hoisted_optionals = hoist_simple_optionals (sql);
+					}
+
 					if (!in_triples_block && !in_group_graph_pattern) {
 						// expand { OPTIONAL { ... } } into { { } OPTIONAL { ... } }
 						// empty graph pattern => return one result without bound variables
@@ -1309,6 +1932,8 @@ class Tracker.Sparql.Pattern : Object {
 		Property prop = null;
 
 		Class subject_type = null;
+		// class whose table is used for the triple, if any
+		Class db_class = null;
 
 		if (!current_predicate_is_var) {
 			prop = Ontologies.get_property_by_uri (current_predicate);
@@ -1323,10 +1948,14 @@ class Tracker.Sparql.Pattern : Object {
 					throw new Sparql.Error.UNKNOWN_CLASS ("Unknown class `%s'".printf (object));
 				}
 				db_table = cl.name;
+				db_class = cl;
 				subject_type = cl;
+				query.add_dependency (cl.id);
 			} else if (prop == null) {
 				if (current_predicate == "http://www.tracker-project.org/ontologies/fts#match") {
 					// fts:match
+					query.add_dependency_on_all ();
+					query.fts_match = true;
 					db_table = "fts";
 					share_table = false;
 					is_fts_match = true;
@@ -1335,6 +1964,8 @@ class Tracker.Sparql.Pattern : Object {
 					throw new Sparql.Error.UNKNOWN_PROPERTY ("Unknown property `%s'".printf (current_predicate));
 				}
 			} else {
+				query.add_dependency (prop.id);
+
 				if (current_predicate == "http://www.w3.org/2000/01/rdf-schema#domain"
 				    && current_subject_is_var
 				    && !object_is_var) {
@@ -1362,6 +1993,7 @@ class Tracker.Sparql.Pattern : Object {
 							foreach (VariableBinding b in list.list) {
 								if (b.type == cl) {
 									db_table = cl.name;
+									db_class = cl;
 									stop = true;
 									break;
 								}
@@ -1373,8 +2005,12 @@ class Tracker.Sparql.Pattern : Object {
 					}
 				}
 
-				if (db_table == null)
+				if (db_table == null) {
 					db_table = prop.table_name;
+					if (!prop.multiple_values) {
+						db_class = prop.domain;
+					}
+				}
 
 				if (prop.multiple_values) {
 					// we can never share the table with multiple triples
@@ -1414,8 +2050,22 @@ class Tracker.Sparql.Pattern : Object {
 				}
 			}
 			table = get_table (current_subject, db_table, share_table, out newtable);
+
+			if (newtable) {
+				if (is_fts_match) {
+					// fts matches are looked up in the index, start with them
+					table.estimated_rows = 0;
+				} else if (db_class != null) {
+					table.estimated_rows = db_class.count;
+				} else {
+					table.estimated_rows = prop.count;
+				}
+			}
+
+			estimate_triple_rows (table, prop, object_is_var, rdftype || is_fts_match, in_simple_optional);
 		} else {
 			// variable in predicate
+			query.add_dependency_on_all ();
 			newtable = true;
 			table = new DataTable ();
 			table.predicate_variable = context.predicate_variable_map.lookup (context.get_variable (current_predicate));
@@ -1515,7 +2165,7 @@ class Tracker.Sparql.Pattern : Object {
 
 				sql.append_printf ("\"%s\".\"docid\" AS \"ID\", ",
 				                   binding.table.sql_query_tablename);
-				sql.append_printf ("tracker_rank(matchinfo(\"%s\".\"fts\", 'cl'),fts_column_weights()) " +
+				sql.append_printf ("tracker_rank(matchinfo(\"%s\".\"fts\", 'pcnalx'),fts_column_weights()) " +
 				                   "AS \"%s_u_rank\", ",
 				                   binding.table.sql_query_tablename,
 				                   context.get_variable (current_subject).name);
@@ -1584,6 +2234,101 @@ class Tracker.Sparql.Pattern : Object {
 		}
 	}
 
+	// Narrows down the rows expected from the table given what the triple binds,
+	// using the counts kept by libtracker-data and the index statistics of ANALYZE
+	void estimate_triple_rows (DataTable table, Property? prop, bool object_is_var, bool object_is_class, bool in_simple_optional) {
+		double rows = table.estimated_rows;
+
+		if (!current_subject_is_var) {
+			rows = double.min (rows, 1);
+		}
+
+		if (prop != null && !object_is_class) {
+			if (!object_is_var) {
+				if (prop.rows_per_value > 0) {
+					rows = double.min (rows, prop.rows_per_value);
+				} else if (prop.is_inverse_functional_property) {
+					rows = double.min (rows, 1);
+				} else if (prop.indexed) {
+					// no statistics, assume values are somewhat spread
+					rows = double.min (rows, Math.sqrt (prop.count));
+				}
+			} else if (!prop.multiple_values && !in_simple_optional) {
+				// only rows with a value match
+				rows = double.min (rows, prop.count);
+			}
+		}
+
+		table.estimated_rows = rows;
+	}
+
+	bool tables_joined (DataTable table, List<DataTable> tables) {
+		foreach (var variable in triple_context.variables) {
+			bool in_table = false, in_tables = false;
+
+			foreach (VariableBinding binding in triple_context.var_bindings.lookup (variable).list) {
+				if (binding.table == table) {
+					in_table = true;
+				} else if (binding.table != null && tables.find (binding.table) != null) {
+					in_tables = true;
+				}
+			}
+
+			if (in_table && in_tables) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// SQLite has no statistics about our tables, so join the tables of a
+	// basic graph pattern starting with the one expected to match the least
+	// rows, then the smallest one joined with those already picked.
+	// Returns null to leave the order as written, when rows can't be
+	// estimated for all tables or when it's the same order.
+	List<DataTable>? order_tables () {
+		var remaining = triple_context.tables.copy ();
+
+		if (remaining.length () < 2) {
+			return null;
+		}
+
+		foreach (DataTable table in remaining) {
+			if (table.estimated_rows < 0) {
+				return null;
+			}
+		}
+
+		var ordered = new List<DataTable> ();
+		bool reordered = false;
+
+		while (remaining != null) {
+			DataTable best = null;
+			bool best_joined = false;
+
+			foreach (DataTable table in remaining) {
+				bool joined = (ordered == null || tables_joined (table, ordered));
+
+				if (best == null ||
+				    (joined && !best_joined) ||
+				    (joined == best_joined && table.estimated_rows < best.estimated_rows)) {
+					best = table;
+					best_joined = joined;
+				}
+			}
+
+			if (best != remaining.data) {
+				reordered = true;
+			}
+
+			remaining.remove (best);
+			ordered.append (best);
+		}
+
+		return reordered ? (owned) ordered : null;
+	}
+
 	DataTable get_table (string subject, string db_table, bool share_table, out bool newtable) {
 		string tablestring = "%s.%s".printf (subject, db_table);
 		DataTable table = null;
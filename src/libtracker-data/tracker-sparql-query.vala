@@ -29,6 +29,8 @@ namespace Tracker.Sparql {
 		public string sql_db_tablename; // as in db schema
 		public string sql_query_tablename; // temp. name, generated
 		public PredicateVariable predicate_variable;
+		// rows expected to match the triples using the table, -1 if unknown
+		public double estimated_rows = -1;
 	}
 
 	abstract class DataBinding : Object {
@@ -158,6 +160,8 @@ namespace Tracker.Sparql {
 		public PropertyType type;
 		public PropertyType[] types = {};
 		public string[] variable_names = {};
+		// Result columns of the ORDER BY keys, for continued queries
+		public int[] key_columns = {};
 
 		public SelectContext (Query query, Context? parent_context = null) {
 			base (query, parent_context);
@@ -243,6 +247,21 @@ public class Tracker.Sparql.Query : Object {
 
 	public bool no_cache { get; set; }
 
+	// Join orders of the basic graph patterns, only kept for get_plan ()
+	internal StringBuilder? join_plan;
+
+	// Set by execute_cursor_continued (), the continuation is null for
+	// the first page, otherwise (checksum, ORDER BY keys)
+	internal bool continued;
+	internal Variant? continuation;
+
+	// Ids of the classes and properties the query reads, null once it
+	// may read any of them, only kept for get_dependencies ()
+	HashTable<int,int>? dependencies;
+
+	// Whether the query has fts:match triples, see uses_fts_match ()
+	internal bool fts_match;
+
 	public Query (string query) {
 		no_cache = false; /* Start with false, expression sets it */
 		tokens = new TokenInfo[BUFFER_SIZE];
@@ -253,6 +272,8 @@ public class Tracker.Sparql.Query : Object {
 
 		this.query_string = query;
 
+		dependencies = new HashTable<int,int> (direct_hash, direct_equal);
+
 		expression = new Expression (this);
 		pattern = new Pattern (this);
 	}
@@ -435,6 +456,30 @@ public class Tracker.Sparql.Query : Object {
 		}
 	}
 
+	// Runs the query from the row the continuation token was taken at
+	// on, see Pattern.translate_select for the rewrite
+	public DBCursor? execute_cursor_continued (string? token, bool threadsafe) throws DBInterfaceError, Sparql.Error, DateError {
+		continued = true;
+
+		if (token != null) {
+			try {
+				continuation = Variant.parse (new VariantType ("(sav)"), token);
+			} catch (VariantParseError e) {
+				throw new Sparql.Error.PARSE ("Invalid continuation: %s".printf (e.message));
+			}
+
+			if (continuation.get_child_value (0).get_string () != get_checksum ()) {
+				throw new Sparql.Error.PARSE ("Continuation does not belong to this query");
+			}
+		}
+
+		return execute_cursor (threadsafe);
+	}
+
+	string get_checksum () {
+		return Checksum.compute_for_string (ChecksumType.MD5, query_string);
+	}
+
 	public Variant? execute_update (bool blank) throws GLib.Error {
 		Variant result = null;
 		assert (update_extensions);
@@ -543,6 +588,20 @@ public class Tracker.Sparql.Query : Object {
 
 		// build SQL
 		var sql = new StringBuilder ();
+
+		if (!continued && Data.get_statistics_available ()) {
+			var select_location = get_location ();
+
+			var statistics_context = pattern.translate_statistics_select (sql);
+			if (statistics_context != null) {
+				context = statistics_context;
+				return sql.str;
+			}
+
+			set_location (select_location);
+			sql.truncate (0);
+		}
+
 		context = pattern.translate_select (sql);
 
 		expect (SparqlTokenType.EOF);
@@ -554,7 +613,19 @@ public class Tracker.Sparql.Query : Object {
 		SelectContext context;
 		string sql = get_select_query (out context);
 
-		return exec_sql_cursor (sql, context.types, context.variable_names, true);
+		var cursor = exec_sql_cursor (sql, context.types, context.variable_names, true);
+
+		if (continued && context.key_columns.length > 0) {
+			Variant? keys = null;
+
+			if (continuation != null) {
+				keys = continuation.get_child_value (1);
+			}
+
+			cursor.set_continuation (context.types.length, context.key_columns, get_checksum (), keys);
+		}
+
+		return cursor;
 	}
 
 	string get_ask_query () throws DBInterfaceError, Sparql.Error, DateError {
@@ -592,6 +663,82 @@ public class Tracker.Sparql.Query : Object {
 		return exec_sql_cursor (get_ask_query (), new PropertyType[] { PropertyType.BOOLEAN }, new string[] { "result" }, true);
 	}
 
+	// Describes how the query would run: the join order picked for each
+	// basic graph pattern, the SQL, and the SQLite query plan
+	public string get_plan () throws DBInterfaceError, Sparql.Error, DateError {
+		string sql;
+
+		join_plan = new StringBuilder ();
+		no_cache = true;
+
+		prepare_execute ();
+
+		switch (current ()) {
+		case SparqlTokenType.SELECT:
+			SelectContext context;
+			sql = get_select_query (out context);
+			break;
+		case SparqlTokenType.ASK:
+			sql = get_ask_query ();
+			break;
+		default:
+			throw get_error ("expected SELECT or ASK");
+		}
+
+		var plan = new StringBuilder ();
+		plan.append ("Join order:\n");
+		plan.append (join_plan.len > 0 ? join_plan.str : "  (no basic graph patterns)\n");
+		plan.append_printf ("\nSQL:\n  %s\n\nSQLite plan:\n", sql);
+
+		var cursor = prepare_for_exec ("EXPLAIN QUERY PLAN " + sql).start_cursor ();
+
+		while (cursor.next ()) {
+			// selectid, order, from, detail
+			plan.append_printf ("  %d %d %d %s\n",
+			                    (int) cursor.get_integer (0),
+			                    (int) cursor.get_integer (1),
+			                    (int) cursor.get_integer (2),
+			                    cursor.get_string (3));
+		}
+
+		join_plan = null;
+
+		return plan.str;
+	}
+
+	internal void add_dependency (int id) {
+		if (dependencies != null) {
+			dependencies.insert (id, id);
+		}
+	}
+
+	// Variable predicates and full text searches read any table
+	internal void add_dependency_on_all () {
+		dependencies = null;
+	}
+
+	// Ids of the classes and properties whose data the executed query
+	// read, its results only change with statements about these.
+	// Returns null if it may depend on any data.
+	public int[]? get_dependencies () {
+		if (dependencies == null) {
+			return null;
+		}
+
+		int[] ids = {};
+		foreach (int id in dependencies.get_keys ()) {
+			ids += id;
+		}
+
+		return ids;
+	}
+
+	// Whether the translated query searches the FTS index, its
+	// results then depend on resources queued for FTS indexing
+	public bool uses_fts_match () {
+		return fts_match;
+	}
+
 	private void parse_from_or_into_param () throws Sparql.Error {
 		if (accept (SparqlTokenType.IRI_REF)) {
 			current_graph = get_last_string (1);
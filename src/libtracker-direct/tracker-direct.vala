@@ -72,10 +72,15 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 		}
 	}
 
-	Sparql.Cursor query_unlocked (string sparql, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+	Sparql.Cursor query_unlocked (string sparql, bool continued, string? continuation, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
 		try {
 			var query_object = new Sparql.Query (sparql);
-			var cursor = query_object.execute_cursor (true);
+			DBCursor cursor;
+			if (continued) {
+				cursor = query_object.execute_cursor_continued (continuation, true);
+			} else {
+				cursor = query_object.execute_cursor (true);
+			}
 			cursor.connection = this;
 			return cursor;
 		} catch (DBInterfaceError e) {
@@ -85,16 +90,32 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 		}
 	}
 
-	public override Sparql.Cursor query (string sparql, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+	Sparql.Cursor query_locked (string sparql, bool continued, string? continuation, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
 		DBManager.lock ();
 		try {
-			return query_unlocked (sparql, cancellable);
+			return query_unlocked (sparql, continued, continuation, cancellable);
 		} finally {
 			DBManager.unlock ();
 		}
 	}
 
+	public override Sparql.Cursor query (string sparql, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		return query_locked (sparql, false, null, cancellable);
+	}
+
 	public async override Sparql.Cursor query_async (string sparql, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		return yield query_internal_async (sparql, false, null, cancellable);
+	}
+
+	public override Sparql.Cursor query_continue (string sparql, string? continuation, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		return query_locked (sparql, true, continuation, cancellable);
+	}
+
+	public async override Sparql.Cursor query_continue_async (string sparql, string? continuation, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		return yield query_internal_async (sparql, true, continuation, cancellable);
+	}
+
+	async Sparql.Cursor query_internal_async (string sparql, bool continued, string? continuation, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
 		if (!DBManager.trylock ()) {
 			// run in a separate thread
 			Sparql.Error sparql_error = null;
@@ -105,7 +126,7 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 
 			g_io_scheduler_push_job (job => {
 				try {
-					result = query (sparql, cancellable);
+					result = query_locked (sparql, continued, continuation, cancellable);
 				} catch (IOError e_io) {
 					io_error = e_io;
 				} catch (Sparql.Error e_spql) {
@@ -116,7 +137,7 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 
 				var source = new IdleSource ();
 				source.set_callback (() => {
-					query_async.callback ();
+					query_internal_async.callback ();
 					return false;
 				});
 				source.attach (context);
@@ -136,7 +157,7 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 			}
 		}
 		try {
-			return query_unlocked (sparql, cancellable);
+			return query_unlocked (sparql, continued, continuation, cancellable);
 		} finally {
 			DBManager.unlock ();
 		}
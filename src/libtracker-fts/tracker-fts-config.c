@@ -43,6 +43,7 @@
 #define DEFAULT_IGNORE_STOP_WORDS    TRUE
 #define DEFAULT_ENABLE_STEMMER       FALSE  /* As per GB#526346, disabled */
 #define DEFAULT_ENABLE_UNACCENT      TRUE
+#define DEFAULT_DETECT_LANGUAGE      FALSE
 
 static void config_set_property         (GObject       *object,
                                          guint          param_id,
@@ -64,6 +65,7 @@ enum {
 	PROP_ENABLE_UNACCENT,
 	PROP_IGNORE_NUMBERS,
 	PROP_IGNORE_STOP_WORDS,
+	PROP_DETECT_LANGUAGE,
 
 	/* Performance */
 	PROP_MAX_WORDS_TO_INDEX,
@@ -119,6 +121,13 @@ tracker_fts_config_class_init (TrackerFTSConfigClass *klass)
 	                                                       " Flag to ignore stop words in FTS (default=TRUE)",
 	                                                       DEFAULT_IGNORE_STOP_WORDS,
 	                                                       G_PARAM_READWRITE));
+	g_object_class_install_property (object_class,
+	                                 PROP_DETECT_LANGUAGE,
+	                                 g_param_spec_boolean ("detect-language",
+	                                                       "Detect language",
+	                                                       " Flag to pick stop words and stemmer per document (default=FALSE)",
+	                                                       DEFAULT_DETECT_LANGUAGE,
+	                                                       G_PARAM_READWRITE));
 	g_object_class_install_property (object_class,
 	                                 PROP_MAX_WORDS_TO_INDEX,
 	                                 g_param_spec_int ("max-words-to-index",
@@ -164,6 +173,10 @@ config_set_property (GObject      *object,
 		tracker_fts_config_set_ignore_stop_words (TRACKER_FTS_CONFIG (object),
 		                                          g_value_get_boolean (value));
 		break;
+	case PROP_DETECT_LANGUAGE:
+		tracker_fts_config_set_detect_language (TRACKER_FTS_CONFIG (object),
+		                                        g_value_get_boolean (value));
+		break;
 	case PROP_MAX_WORDS_TO_INDEX:
 		tracker_fts_config_set_max_words_to_index (TRACKER_FTS_CONFIG (object),
 		                                           g_value_get_int (value));
@@ -200,6 +213,9 @@ config_get_property (GObject    *object,
 	case PROP_IGNORE_STOP_WORDS:
 		g_value_set_boolean (value, tracker_fts_config_get_ignore_stop_words (config));
 		break;
+	case PROP_DETECT_LANGUAGE:
+		g_value_set_boolean (value, tracker_fts_config_get_detect_language (config));
+		break;
 	case PROP_MAX_WORDS_TO_INDEX:
 		g_value_set_int (value, tracker_fts_config_get_max_words_to_index (config));
 		break;
@@ -238,6 +254,7 @@ config_constructed (GObject *object)
 	g_settings_bind (settings, "enable-unaccent", object, "enable-unaccent", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 	g_settings_bind (settings, "ignore-numbers", object, "ignore-numbers", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 	g_settings_bind (settings, "ignore-stop-words", object, "ignore-stop-words", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
+	g_settings_bind (settings, "detect-language", object, "detect-language", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 	g_settings_bind (settings, "max-words-to-index", object, "max-words-to-index", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 }
 
@@ -331,6 +348,14 @@ tracker_fts_config_get_ignore_stop_words (TrackerFTSConfig *config)
 	return g_settings_get_boolean (G_SETTINGS (config),  "ignore-stop-words");
 }
 
+gboolean
+tracker_fts_config_get_detect_language (TrackerFTSConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_FTS_CONFIG (config), DEFAULT_DETECT_LANGUAGE);
+
+	return g_settings_get_boolean (G_SETTINGS (config), "detect-language");
+}
+
 gint
 tracker_fts_config_get_max_words_to_index (TrackerFTSConfig *config)
 {
@@ -339,6 +364,55 @@ tracker_fts_config_get_max_words_to_index (TrackerFTSConfig *config)
 	return g_settings_get_int (G_SETTINGS (config), "max-words-to-index");
 }
 
+static gint
+compare_lengths (gconstpointer a,
+                 gconstpointer b)
+{
+	return *((const gint *) a) - *((const gint *) b);
+}
+
+/* Returns the prefix lengths as given to the fts4 prefix= option,
+ * sorted and without duplicates, e.g. "2,3". Or NULL if none.
+ */
+gchar *
+tracker_fts_config_get_prefix_indexes (TrackerFTSConfig *config)
+{
+	GVariant *value;
+	const gint32 *lengths;
+	gint32 *sorted;
+	GString *str = NULL;
+	gsize i, n_lengths;
+
+	g_return_val_if_fail (TRACKER_IS_FTS_CONFIG (config), NULL);
+
+	value = g_settings_get_value (G_SETTINGS (config), "prefix-indexes");
+	lengths = g_variant_get_fixed_array (value, &n_lengths, sizeof (gint32));
+	sorted = g_memdup (lengths, n_lengths * sizeof (gint32));
+	g_variant_unref (value);
+
+	qsort (sorted, n_lengths, sizeof (gint32), compare_lengths);
+
+	for (i = 0; i < n_lengths; i++) {
+		/* Prefixes as long as words make no sense */
+		if (sorted[i] <= 0 || sorted[i] > DEFAULT_MAX_WORD_LENGTH ||
+		    (i > 0 && sorted[i] == sorted[i - 1])) {
+			continue;
+		}
+
+		if (!str) {
+			str = g_string_new (NULL);
+		} else {
+			g_string_append_c (str, ',');
+		}
+
+		g_string_append_printf (str, "%d", sorted[i]);
+	}
+
+	g_free (sorted);
+
+	return str ? g_string_free (str, FALSE) : NULL;
+}
+
 void
 tracker_fts_config_set_max_word_length (TrackerFTSConfig *config,
                                         gint              value)
@@ -389,6 +463,31 @@ tracker_fts_config_set_ignore_stop_words (TrackerFTSConfig *config,
 	g_object_notify (G_OBJECT (config), "ignore-stop-words");
 }
 
+void
+tracker_fts_config_set_detect_language (TrackerFTSConfig *config,
+                                        gboolean          value)
+{
+	g_return_if_fail (TRACKER_IS_FTS_CONFIG (config));
+
+	g_settings_set_boolean (G_SETTINGS (config), "detect-language", value);
+	g_object_notify (G_OBJECT (config), "detect-language");
+}
+
+void
+tracker_fts_config_set_prefix_indexes (TrackerFTSConfig *config,
+                                       const gint       *lengths,
+                                       gsize             n_lengths)
+{
+	GVariant *value;
+
+	g_return_if_fail (TRACKER_IS_FTS_CONFIG (config));
+
+	value = g_variant_new_fixed_array (G_VARIANT_TYPE_INT32,
+	                                   lengths, n_lengths,
+	                                   sizeof (gint32));
+	g_settings_set_value (G_SETTINGS (config), "prefix-indexes", value);
+}
+
 void
 tracker_fts_config_set_max_words_to_index (TrackerFTSConfig *config,
                                            gint              value)
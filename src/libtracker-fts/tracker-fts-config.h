@@ -54,7 +54,9 @@ gboolean          tracker_fts_config_get_enable_stemmer     (TrackerFTSConfig *c
 gboolean          tracker_fts_config_get_enable_unaccent    (TrackerFTSConfig *config);
 gboolean          tracker_fts_config_get_ignore_numbers     (TrackerFTSConfig *config);
 gboolean          tracker_fts_config_get_ignore_stop_words  (TrackerFTSConfig *config);
+gboolean          tracker_fts_config_get_detect_language    (TrackerFTSConfig *config);
 gint              tracker_fts_config_get_max_words_to_index (TrackerFTSConfig *config);
+gchar *           tracker_fts_config_get_prefix_indexes     (TrackerFTSConfig *config);
 void              tracker_fts_config_set_enable_stemmer     (TrackerFTSConfig *config,
                                                              gboolean          value);
 void              tracker_fts_config_set_enable_unaccent    (TrackerFTSConfig *config,
@@ -63,10 +65,15 @@ void              tracker_fts_config_set_ignore_numbers     (TrackerFTSConfig *c
                                                              gboolean          value);
 void              tracker_fts_config_set_ignore_stop_words  (TrackerFTSConfig *config,
                                                              gboolean          value);
+void              tracker_fts_config_set_detect_language    (TrackerFTSConfig *config,
+                                                             gboolean          value);
 void              tracker_fts_config_set_max_words_to_index (TrackerFTSConfig *config,
                                                              gint              value);
 void              tracker_fts_config_set_max_word_length    (TrackerFTSConfig *config,
                                                              gint              value);
+void              tracker_fts_config_set_prefix_indexes     (TrackerFTSConfig *config,
+                                                             const gint       *lengths,
+                                                             gsize             n_lengths);
 
 G_END_DECLS
 
@@ -34,6 +34,8 @@
 
 typedef struct TrackerTokenizer TrackerTokenizer;
 typedef struct TrackerCursor TrackerCursor;
+typedef struct PretokenizedText PretokenizedText;
+typedef struct PretokenizedWord PretokenizedWord;
 
 struct TrackerTokenizer {
   sqlite3_tokenizer base;
@@ -44,6 +46,7 @@ struct TrackerTokenizer {
   gboolean enable_unaccent;
   gboolean ignore_numbers;
   gboolean ignore_stop_words;
+  gboolean detect_language;
 };
 
 struct TrackerCursor {
@@ -51,9 +54,47 @@ struct TrackerCursor {
 
   TrackerTokenizer *tokenizer;
   TrackerParser *parser;
+  PretokenizedText *pretokenized;
   guint n_words;
 };
 
+/*
+** Fulltext values of at least PRETOKENIZE_MIN_SIZE bytes can be
+** tokenized ahead of time on worker threads, trackerOpen() then
+** replays the tokens instead of running the parser on the writer
+** thread, while it holds the write transaction.
+*/
+#define PRETOKENIZE_MIN_SIZE  4096
+#define PRETOKENIZE_MAX_BYTES (64 * 1024 * 1024)
+
+struct PretokenizedWord {
+  int offset;                  /* Offset of the word in words */
+  int len;
+  int start;
+  int end;
+  int pos;
+};
+
+struct PretokenizedText {
+  gint ref_count;
+  gchar *text;
+  int len;
+  guint hash;
+  gboolean done;
+  gboolean dropped;
+  GArray *word_array;          /* Array of PretokenizedWord */
+  GString *words;              /* NUL separated words */
+};
+
+static GMutex pretokenize_mutex;
+static GCond pretokenize_cond;
+static GHashTable *pretokenized = NULL;
+static GThreadPool *pretokenize_pool = NULL;
+static TrackerTokenizer *pretokenizer = NULL;
+static gsize pretokenized_bytes = 0;
+static GPrivate pretokenize_parser_key = G_PRIVATE_INIT ((GDestroyNotify) tracker_parser_free);
+static GPrivate pretokenize_language_key = G_PRIVATE_INIT (g_object_unref);
+
 /*
 ** Create a new tokenizer instance.
 */
@@ -64,6 +105,7 @@ static int trackerCreate(
 ){
   TrackerTokenizer *p;
   TrackerFTSConfig *config;
+  int i;
 
   p = (TrackerTokenizer *)sqlite3_malloc(sizeof(TrackerTokenizer));
   if( !p ){
@@ -88,6 +130,15 @@ static int trackerCreate(
 
   g_object_unref (config);
 
+  /* Given as "tokenize=TrackerTokenizer detect-language", so it's
+  ** fixed for the lifetime of the table whatever the config says.
+  */
+  for (i = 0; i < argc; i++){
+    if( strcmp(argv[i], "detect-language")==0 ){
+      p->detect_language = TRUE;
+    }
+  }
+
   *ppTokenizer = (sqlite3_tokenizer *)p;
 
   return SQLITE_OK;
@@ -103,6 +154,207 @@ static int trackerDestroy(sqlite3_tokenizer *pTokenizer){
   return SQLITE_OK;
 }
 
+/*
+** Picks the stop words and stemmer for the text about to be
+** tokenized. Texts too short to guess from, like search terms,
+** get the default language.
+*/
+static void
+tokenizer_set_language (TrackerTokenizer *p,
+                        TrackerLanguage  *language,
+                        const char       *zInput,
+                        int               nInput)
+{
+  if (p->detect_language) {
+    tracker_language_set_language_code (language,
+                                        tracker_language_detect (zInput, nInput));
+  }
+}
+
+static void
+pretokenized_text_unref (PretokenizedText *pt)
+{
+  if (!g_atomic_int_dec_and_test (&pt->ref_count)) {
+    return;
+  }
+
+  if (pt->word_array) {
+    g_array_free (pt->word_array, TRUE);
+  }
+  if (pt->words) {
+    g_string_free (pt->words, TRUE);
+  }
+  g_free (pt->text);
+  g_slice_free (PretokenizedText, pt);
+}
+
+static guint
+text_hash (const gchar *text,
+           int          len)
+{
+  guint hash = 5381;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    hash = (hash << 5) + hash + (guchar) text[i];
+  }
+
+  return hash;
+}
+
+static guint
+pretokenized_text_hash (gconstpointer key)
+{
+  return ((const PretokenizedText *) key)->hash;
+}
+
+static gboolean
+pretokenized_text_equal (gconstpointer a,
+                         gconstpointer b)
+{
+  const PretokenizedText *pa = a, *pb = b;
+
+  return (pa->hash == pb->hash && pa->len == pb->len &&
+          memcmp (pa->text, pb->text, pa->len) == 0);
+}
+
+/*
+** Runs on the worker threads, breaks the text into words the same
+** way trackerNext() would.
+*/
+static void
+pretokenize_func (gpointer data,
+                  gpointer user_data)
+{
+  PretokenizedText *pt = data;
+  TrackerTokenizer *p = user_data;
+  TrackerParser *parser;
+  TrackerLanguage *language;
+  GArray *word_array;
+  GString *words;
+  const gchar *token;
+  gboolean stop_word;
+  int pos, start, end, len, n_words = 0;
+
+  if (g_atomic_int_get (&pt->dropped)) {
+    /* Nobody is waiting for these anymore */
+    g_mutex_lock (&pretokenize_mutex);
+    pt->done = TRUE;
+    g_cond_broadcast (&pretokenize_cond);
+    g_mutex_unlock (&pretokenize_mutex);
+
+    pretokenized_text_unref (pt);
+    return;
+  }
+
+  parser = g_private_get (&pretokenize_parser_key);
+  language = g_private_get (&pretokenize_language_key);
+
+  if (!parser) {
+    /* Stemmers aren't thread safe, use a language per thread */
+    language = tracker_language_new (NULL);
+    parser = tracker_parser_new (language);
+
+    g_private_set (&pretokenize_language_key, language);
+    g_private_set (&pretokenize_parser_key, parser);
+  }
+
+  tokenizer_set_language (p, language, pt->text, pt->len);
+  tracker_parser_reset (parser, pt->text, pt->len,
+                        p->max_word_length,
+                        p->enable_stemmer,
+                        p->enable_unaccent,
+                        p->ignore_stop_words,
+                        TRUE,
+                        p->ignore_numbers);
+
+  word_array = g_array_new (FALSE, FALSE, sizeof (PretokenizedWord));
+  words = g_string_new (NULL);
+
+  while (n_words <= p->max_words) {
+    PretokenizedWord word;
+
+    do {
+      token = tracker_parser_next (parser, &pos, &start, &end,
+                                   &stop_word, &len);
+    } while (token && stop_word && p->ignore_stop_words);
+
+    if (!token) {
+      break;
+    }
+
+    word.offset = words->len;
+    word.len = len;
+    word.start = start;
+    word.end = end;
+    word.pos = pos;
+
+    g_string_append_len (words, token, len);
+    g_string_append_c (words, '\0');
+    g_array_append_val (word_array, word);
+    n_words++;
+  }
+
+  g_mutex_lock (&pretokenize_mutex);
+  pt->word_array = word_array;
+  pt->words = words;
+  pt->done = TRUE;
+  g_cond_broadcast (&pretokenize_cond);
+  g_mutex_unlock (&pretokenize_mutex);
+
+  pretokenized_text_unref (pt);
+}
+
+/*
+** Returns the tokens of zInput if it was handed to
+** tracker_tokenizer_pretokenize(), waiting for them if
+** still in the works. They stay around until
+** tracker_tokenizer_clear_pretokenized().
+*/
+static PretokenizedText *
+pretokenized_text_take (TrackerTokenizer *p,
+                        const char       *zInput,
+                        int               nInput)
+{
+  PretokenizedText key, *pt = NULL;
+
+  if (nInput < PRETOKENIZE_MIN_SIZE) {
+    return NULL;
+  }
+
+  g_mutex_lock (&pretokenize_mutex);
+
+  /* Tokens from a table with other settings are no good */
+  if (pretokenized && g_hash_table_size (pretokenized) > 0 &&
+      pretokenizer->detect_language == p->detect_language) {
+    key.text = (gchar *) zInput;
+    key.len = nInput;
+    key.hash = text_hash (zInput, nInput);
+
+    pt = g_hash_table_lookup (pretokenized, &key);
+
+    if (pt) {
+      /* Left in the table, replacing a FTS row tokenizes
+       * the same text twice. */
+      g_atomic_int_inc (&pt->ref_count);
+
+      while (!pt->done) {
+        g_cond_wait (&pretokenize_cond, &pretokenize_mutex);
+      }
+
+      if (!pt->word_array) {
+        /* Dropped before it was tokenized */
+        pretokenized_text_unref (pt);
+        pt = NULL;
+      }
+    }
+  }
+
+  g_mutex_unlock (&pretokenize_mutex);
+
+  return pt;
+}
+
 /*
 ** Prepare to begin tokenizing a particular string.  The input
 ** string to be tokenized is pInput[0..nBytes-1].  A cursor
@@ -123,19 +375,23 @@ static int trackerOpen(
     nInput = strlen(zInput);
   }
 
-  parser = tracker_parser_new (p->language);
-  tracker_parser_reset (parser, zInput, nInput,
-			p->max_word_length,
-			p->enable_stemmer,
-			p->enable_unaccent,
-			p->ignore_stop_words,
-			TRUE,
-			p->ignore_numbers);
-
   pCsr = (TrackerCursor *)sqlite3_malloc(sizeof(TrackerCursor));
   memset(pCsr, 0, sizeof(TrackerCursor));
   pCsr->tokenizer = p;
-  pCsr->parser = parser;
+  pCsr->pretokenized = pretokenized_text_take (p, zInput, nInput);
+
+  if (!pCsr->pretokenized) {
+    tokenizer_set_language (p, p->language, zInput, nInput);
+    parser = tracker_parser_new (p->language);
+    tracker_parser_reset (parser, zInput, nInput,
+                          p->max_word_length,
+                          p->enable_stemmer,
+                          p->enable_unaccent,
+                          p->ignore_stop_words,
+                          TRUE,
+                          p->ignore_numbers);
+    pCsr->parser = parser;
+  }
 
   *ppCursor = (sqlite3_tokenizer_cursor *)pCsr;
   return SQLITE_OK;
@@ -147,7 +403,12 @@ static int trackerOpen(
 static int trackerClose(sqlite3_tokenizer_cursor *pCursor){
   TrackerCursor *pCsr = (TrackerCursor *)pCursor;
 
-  tracker_parser_free (pCsr->parser);
+  if (pCsr->parser) {
+    tracker_parser_free (pCsr->parser);
+  }
+  if (pCsr->pretokenized) {
+    pretokenized_text_unref (pCsr->pretokenized);
+  }
   sqlite3_free(pCsr);
   return SQLITE_OK;
 }
@@ -171,6 +432,27 @@ static int trackerNext(
 
   p  = cursor->tokenizer;
 
+  if (cursor->pretokenized){
+    PretokenizedText *pt = cursor->pretokenized;
+    PretokenizedWord *word;
+
+    /* Already capped to max_words */
+    if (cursor->n_words >= pt->word_array->len){
+      return SQLITE_DONE;
+    }
+
+    word = &g_array_index (pt->word_array, PretokenizedWord, cursor->n_words);
+    *ppToken = &pt->words->str[word->offset];
+    *piStartOffset = word->start;
+    *piEndOffset = word->end;
+    *piPosition = word->pos;
+    *pnBytes = word->len;
+
+    cursor->n_words++;
+
+    return SQLITE_OK;
+  }
+
   if (cursor->n_words > p->max_words){
     return SQLITE_DONE;
   }
@@ -233,3 +515,88 @@ gboolean tracker_tokenizer_initialize (sqlite3 *db) {
 
   return (rc == SQLITE_OK);
 }
+
+/*
+** Queues text for tokenization on a worker thread, the result is
+** picked up by the tokenizer if the same text is indexed later on.
+** Only worth it for big texts, smaller ones are ignored.
+*/
+void tracker_tokenizer_pretokenize (const gchar *text, int len) {
+  PretokenizedText *pt;
+
+  if (len < 0) {
+    len = strlen (text);
+  }
+
+  if (len < PRETOKENIZE_MIN_SIZE) {
+    return;
+  }
+
+  g_mutex_lock (&pretokenize_mutex);
+
+  if (!pretokenize_pool) {
+    TrackerFTSConfig *config;
+    const char *argv[] = { "detect-language" };
+
+    /* Same arguments tracker_fts_create_table() gives */
+    config = tracker_fts_config_new ();
+    trackerCreate (tracker_fts_config_get_detect_language (config) ? 1 : 0,
+                   argv, (sqlite3_tokenizer **) &pretokenizer);
+    g_object_unref (config);
+
+    pretokenized = g_hash_table_new_full (pretokenized_text_hash,
+                                          pretokenized_text_equal,
+                                          (GDestroyNotify) pretokenized_text_unref,
+                                          NULL);
+    pretokenize_pool = g_thread_pool_new (pretokenize_func, pretokenizer,
+                                          MAX (1, (gint) g_get_num_processors () - 1),
+                                          FALSE, NULL);
+  }
+
+  if (pretokenized_bytes + len > PRETOKENIZE_MAX_BYTES) {
+    g_mutex_unlock (&pretokenize_mutex);
+    return;
+  }
+
+  pt = g_slice_new0 (PretokenizedText);
+  pt->ref_count = 2;  /* Hash table and worker */
+  pt->text = g_memdup (text, len);
+  pt->len = len;
+  pt->hash = text_hash (text, len);
+
+  if (g_hash_table_contains (pretokenized, pt)) {
+    g_mutex_unlock (&pretokenize_mutex);
+    pt->ref_count = 1;
+    pretokenized_text_unref (pt);
+    return;
+  }
+
+  g_hash_table_add (pretokenized, pt);
+  pretokenized_bytes += len;
+  g_thread_pool_push (pretokenize_pool, pt, NULL);
+
+  g_mutex_unlock (&pretokenize_mutex);
+}
+
+/*
+** Drops the pretokenized texts nobody picked up.
+*/
+void tracker_tokenizer_clear_pretokenized (void) {
+  GHashTableIter iter;
+  PretokenizedText *pt;
+
+  g_mutex_lock (&pretokenize_mutex);
+
+  if (pretokenized) {
+    g_hash_table_iter_init (&iter, pretokenized);
+
+    while (g_hash_table_iter_next (&iter, (gpointer *) &pt, NULL)) {
+      g_atomic_int_set (&pt->dropped, TRUE);
+      g_hash_table_iter_remove (&iter);
+    }
+
+    pretokenized_bytes = 0;
+  }
+
+  g_mutex_unlock (&pretokenize_mutex);
+}
@@ -27,5 +27,8 @@
 #define __TRACKER_FTS_TOKENIZER_H__
 
 gboolean tracker_tokenizer_initialize (sqlite3 *db);
+void     tracker_tokenizer_pretokenize (const gchar *text,
+                                        int          len);
+void     tracker_tokenizer_clear_pretokenized (void);
 
 #endif /* __TRACKER_FTS_TOKENIZER_H__ */
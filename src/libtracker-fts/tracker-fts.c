@@ -21,8 +21,12 @@
 
 #include "config.h"
 
+#include <math.h>
+#include <string.h>
+
 #include <libtracker-common/tracker-common.h>
 
+#include "tracker-fts-config.h"
 #include "tracker-fts-tokenizer.h"
 #include "tracker-fts.h"
 
@@ -76,14 +80,25 @@ tracker_fts_shutdown (void)
 	return TRUE;
 }
 
+/* BM25 parameters: term frequency saturation and
+ * document length normalization. */
+#define BM25_K1 1.2
+#define BM25_B  0.75
+
+/* Scores documents with BM25, each column being weighted
+ * with its tracker:weight. Expects matchinfo with the 'pcnalx'
+ * format.
+ */
 static void
 function_rank (sqlite3_context *context,
                int              argc,
                sqlite3_value   *argv[])
 {
 	guint *matchinfo, *weights;
+	guint n_phrases, n_columns, n_docs;
+	guint *avg_lengths, *lengths, *hits;
 	gdouble rank = 0;
-	gint i, n_columns;
+	guint i, j;
 
 	if (argc != 2) {
 		sqlite3_result_error(context,
@@ -94,17 +109,155 @@ function_rank (sqlite3_context *context,
 
 	matchinfo = (unsigned int *) sqlite3_value_blob (argv[0]);
 	weights = (unsigned int *) sqlite3_value_blob (argv[1]);
-	n_columns = matchinfo[0];
 
-	for (i = 0; i < n_columns; i++) {
-		if (matchinfo[i + 1] != 0) {
-			rank += (gdouble) weights[i];
+	n_phrases = matchinfo[0];
+	n_columns = matchinfo[1];
+	n_docs = matchinfo[2];
+	avg_lengths = &matchinfo[3];
+	lengths = &matchinfo[3 + n_columns];
+	hits = &matchinfo[3 + 2 * n_columns];
+
+	for (i = 0; i < n_phrases; i++) {
+		for (j = 0; j < n_columns; j++) {
+			guint *phrase_hits = &hits[3 * (i * n_columns + j)];
+			gdouble tf, df, idf, norm;
+
+			if (phrase_hits[0] == 0 || weights[j] == 0) {
+				continue;
+			}
+
+			tf = phrase_hits[0];
+			df = phrase_hits[2];
+
+			/* Always positive, even for terms present
+			 * in over half of the documents. */
+			idf = log (1 + (n_docs - df + 0.5) / (df + 0.5));
+
+			norm = 1 - BM25_B;
+			if (avg_lengths[j] > 0) {
+				norm += BM25_B * lengths[j] / avg_lengths[j];
+			}
+
+			rank += weights[j] * idf * (tf * (BM25_K1 + 1)) / (tf + BM25_K1 * norm);
 		}
 	}
 
 	sqlite3_result_double(context, rank);
 }
 
+typedef struct {
+	gint64 serial;
+	gint k;
+	gint n_ranks;
+	gdouble ranks[1];
+} RankHeap;
+
+static RankHeap *
+rank_heap_new (gint   k,
+               gint64 serial)
+{
+	RankHeap *heap;
+
+	heap = g_malloc (sizeof (RankHeap) + (k - 1) * sizeof (gdouble));
+	heap->serial = serial;
+	heap->k = k;
+	heap->n_ranks = 0;
+
+	return heap;
+}
+
+/* Min-heap of the k best ranks so far, returns FALSE if
+ * the rank can't make it into the top k. */
+static gboolean
+rank_heap_add (RankHeap *heap,
+               gdouble   rank)
+{
+	gint i = heap->n_ranks, child;
+
+	if (heap->n_ranks < heap->k) {
+		/* Sift up */
+		while (i > 0 && heap->ranks[(i - 1) / 2] > rank) {
+			heap->ranks[i] = heap->ranks[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+
+		heap->ranks[i] = rank;
+		heap->n_ranks++;
+		return TRUE;
+	}
+
+	if (rank < heap->ranks[0]) {
+		return FALSE;
+	}
+
+	/* Replace the lowest rank and sift down */
+	i = 0;
+
+	while ((child = 2 * i + 1) < heap->n_ranks) {
+		if (child + 1 < heap->n_ranks &&
+		    heap->ranks[child + 1] < heap->ranks[child]) {
+			child++;
+		}
+
+		if (heap->ranks[child] >= rank) {
+			break;
+		}
+
+		heap->ranks[i] = heap->ranks[child];
+		i = child;
+	}
+
+	heap->ranks[i] = rank;
+
+	return TRUE;
+}
+
+/* tracker_rank_top_k(rank, k, serial) filters out rows that can't
+ * be among the k best ranked ones. Rows must be fed after all other
+ * constraints were applied. The heap is kept as auxiliary data of
+ * the constant k argument, the serial changes on every query so a
+ * cached statement doesn't see ranks from a previous run.
+ */
+static void
+function_rank_top_k (sqlite3_context *context,
+                     int              argc,
+                     sqlite3_value   *argv[])
+{
+	RankHeap *heap;
+	gboolean keep;
+	gint64 serial;
+	gint k;
+
+	if (argc != 3) {
+		sqlite3_result_error(context,
+		                     "wrong number of arguments to function tracker_rank_top_k()",
+		                     -1);
+		return;
+	}
+
+	k = sqlite3_value_int (argv[1]);
+	serial = sqlite3_value_int64 (argv[2]);
+
+	if (k <= 0) {
+		sqlite3_result_int (context, TRUE);
+		return;
+	}
+
+	heap = sqlite3_get_auxdata (context, 1);
+
+	if (heap && heap->k == k && heap->serial == serial) {
+		keep = rank_heap_add (heap, sqlite3_value_double (argv[0]));
+	} else {
+		heap = rank_heap_new (k, serial);
+		keep = rank_heap_add (heap, sqlite3_value_double (argv[0]));
+
+		/* Might free the heap right away */
+		sqlite3_set_auxdata (context, 1, heap, g_free);
+	}
+
+	sqlite3_result_int (context, keep);
+}
+
 static void
 function_offsets (sqlite3_context *context,
                   int              argc,
@@ -180,7 +333,13 @@ function_weights (sqlite3_context *context,
 		while ((rc = sqlite3_step (stmt)) != SQLITE_DONE) {
 			if (rc == SQLITE_ROW) {
 				guint weight;
-				weight = sqlite3_column_int (stmt, 0);
+
+				/* Unset weights default to 1, as in TrackerProperty */
+				if (sqlite3_column_type (stmt, 0) == SQLITE_NULL) {
+					weight = 1;
+				} else {
+					weight = sqlite3_column_int (stmt, 0);
+				}
 				g_array_append_val (weight_array, weight);
 			} else if (rc != SQLITE_BUSY) {
 				break;
@@ -215,15 +374,582 @@ function_property_names (sqlite3_context *context,
 	sqlite3_result_blob (context, property_names, sizeof (property_names), NULL);
 }
 
+/* Bounded snippets, only the text around the first matches of
+ * the query terms is looked at, results are cached per connection
+ * as paging/re-rendering result lists asks for the same snippets.
+ */
+#define SNIPPET_CACHE_SIZE 64
+#define SNIPPET_MAX_TERMS  64
+
+typedef struct {
+	TrackerLanguage *language;
+	TrackerParser *parser;
+	gint max_word_length;
+	gint max_words;
+	gboolean enable_stemmer;
+	gboolean enable_unaccent;
+	gboolean ignore_numbers;
+	gboolean ignore_stop_words;
+	gboolean detect_language;
+
+	GHashTable *entries;
+	GQueue lru;
+} SnippetCache;
+
+typedef struct {
+	gchar *key;
+	gchar *snippet;
+} SnippetCacheEntry;
+
+typedef struct {
+	gchar *word;
+	gboolean prefix;
+} SnippetTerm;
+
+typedef struct {
+	gint start;
+	gint end;
+	gint term;
+} SnippetToken;
+
+static void
+snippet_cache_entry_free (SnippetCacheEntry *entry)
+{
+	g_free (entry->key);
+	g_free (entry->snippet);
+	g_slice_free (SnippetCacheEntry, entry);
+}
+
+static SnippetCache *
+snippet_cache_new (void)
+{
+	TrackerFTSConfig *config;
+	SnippetCache *cache;
+
+	cache = g_slice_new0 (SnippetCache);
+	cache->language = tracker_language_new (NULL);
+	cache->parser = tracker_parser_new (cache->language);
+	cache->entries = g_hash_table_new (g_str_hash, g_str_equal);
+	g_queue_init (&cache->lru);
+
+	/* Words must be broken as the tokenizer does */
+	config = tracker_fts_config_new ();
+	cache->max_word_length = tracker_fts_config_get_max_word_length (config);
+	cache->max_words = tracker_fts_config_get_max_words_to_index (config);
+	cache->enable_stemmer = tracker_fts_config_get_enable_stemmer (config);
+	cache->enable_unaccent = tracker_fts_config_get_enable_unaccent (config);
+	cache->ignore_numbers = tracker_fts_config_get_ignore_numbers (config);
+	cache->ignore_stop_words = (g_strcmp0 (g_getenv ("TRACKER_FTS_STOP_WORDS"), "0") == 0 ?
+	                            FALSE : tracker_fts_config_get_ignore_stop_words (config));
+	cache->detect_language = tracker_fts_config_get_detect_language (config);
+	g_object_unref (config);
+
+	return cache;
+}
+
+static void
+snippet_cache_free (SnippetCache *cache)
+{
+	g_queue_foreach (&cache->lru, (GFunc) snippet_cache_entry_free, NULL);
+	g_queue_clear (&cache->lru);
+	g_hash_table_unref (cache->entries);
+	tracker_parser_free (cache->parser);
+	g_object_unref (cache->language);
+	g_slice_free (SnippetCache, cache);
+}
+
+static gboolean
+snippet_cache_lookup (SnippetCache  *cache,
+                      const gchar   *key,
+                      const gchar  **snippet)
+{
+	GList *link;
+
+	link = g_hash_table_lookup (cache->entries, key);
+
+	if (!link) {
+		return FALSE;
+	}
+
+	/* Move to the front */
+	g_queue_unlink (&cache->lru, link);
+	g_queue_push_head_link (&cache->lru, link);
+
+	*snippet = ((SnippetCacheEntry *) link->data)->snippet;
+
+	return TRUE;
+}
+
+static void
+snippet_cache_insert (SnippetCache *cache,
+                      gchar        *key,
+                      gchar        *snippet)
+{
+	SnippetCacheEntry *entry;
+
+	if (cache->lru.length >= SNIPPET_CACHE_SIZE) {
+		entry = g_queue_pop_tail (&cache->lru);
+		g_hash_table_remove (cache->entries, entry->key);
+		snippet_cache_entry_free (entry);
+	}
+
+	entry = g_slice_new (SnippetCacheEntry);
+	entry->key = key;
+	entry->snippet = snippet;
+
+	g_queue_push_head (&cache->lru, entry);
+	g_hash_table_insert (cache->entries, entry->key, cache->lru.head);
+}
+
+static void
+snippet_parser_reset (SnippetCache *cache,
+                      const gchar  *text,
+                      gint          len)
+{
+	if (cache->detect_language) {
+		tracker_language_set_language_code (cache->language,
+		                                    tracker_language_detect (text, len));
+	}
+
+	tracker_parser_reset (cache->parser, text, len,
+	                      cache->max_word_length,
+	                      cache->enable_stemmer,
+	                      cache->enable_unaccent,
+	                      cache->ignore_stop_words,
+	                      TRUE,
+	                      cache->ignore_numbers);
+}
+
+static const gchar *
+snippet_parser_next (SnippetCache *cache,
+                     gint         *start,
+                     gint         *end,
+                     gint         *len)
+{
+	const gchar *word;
+	gboolean stop_word;
+	gint pos;
+
+	do {
+		word = tracker_parser_next (cache->parser, &pos,
+		                            start, end,
+		                            &stop_word, len);
+	} while (word && stop_word && cache->ignore_stop_words);
+
+	return word;
+}
+
+static void
+snippet_term_free (SnippetTerm *term)
+{
+	g_free (term->word);
+	g_slice_free (SnippetTerm, term);
+}
+
+/* Extracts the terms to highlight from a MATCH expression, operators,
+ * column filters and excluded terms are left out, phrases are looked
+ * up as separate terms.
+ */
+static GPtrArray *
+snippet_get_terms (SnippetCache *cache,
+                   const gchar  *match)
+{
+	GPtrArray *terms;
+	gboolean excluded = FALSE;
+	const gchar *p = match;
+
+	terms = g_ptr_array_new_with_free_func ((GDestroyNotify) snippet_term_free);
+
+	while (*p && terms->len < SNIPPET_MAX_TERMS) {
+		const gchar *start, *word, *colon, *text;
+		gchar *token;
+		gboolean prefix = FALSE;
+		SnippetTerm *term = NULL;
+		gint word_start, word_end, word_len;
+
+		while (*p && (g_ascii_isspace (*p) || strchr ("\"()", *p))) {
+			p++;
+		}
+
+		if (!*p) {
+			break;
+		}
+
+		start = p;
+
+		while (*p && !g_ascii_isspace (*p) && !strchr ("\"()", *p)) {
+			p++;
+		}
+
+		token = g_strndup (start, p - start);
+
+		if (strcmp (token, "NOT") == 0) {
+			excluded = TRUE;
+			g_free (token);
+			continue;
+		} else if (excluded || token[0] == '-' ||
+		           strcmp (token, "OR") == 0 ||
+		           strcmp (token, "AND") == 0 ||
+		           strcmp (token, "NEAR") == 0 ||
+		           g_str_has_prefix (token, "NEAR/")) {
+			excluded = FALSE;
+			g_free (token);
+			continue;
+		}
+
+		if (g_str_has_suffix (token, "*")) {
+			token[strlen (token) - 1] = '\0';
+			prefix = TRUE;
+		}
+
+		colon = strrchr (token, ':');
+		text = colon ? colon + 1 : token;
+		snippet_parser_reset (cache, text, strlen (text));
+
+		while (terms->len < SNIPPET_MAX_TERMS &&
+		       (word = snippet_parser_next (cache, &word_start, &word_end, &word_len)) != NULL) {
+			term = g_slice_new0 (SnippetTerm);
+			term->word = g_strndup (word, word_len);
+			g_ptr_array_add (terms, term);
+		}
+
+		/* Only the last word of "foo-ba*" is a prefix */
+		if (term) {
+			term->prefix = prefix;
+		}
+
+		g_free (token);
+	}
+
+	return terms;
+}
+
+static gint
+snippet_match_term (GPtrArray   *terms,
+                    const gchar *word,
+                    gint         len)
+{
+	guint i;
+
+	for (i = 0; i < terms->len; i++) {
+		SnippetTerm *term = g_ptr_array_index (terms, i);
+		gsize term_len = strlen (term->word);
+
+		if (term_len > (gsize) len ||
+		    (!term->prefix && term_len != (gsize) len)) {
+			continue;
+		}
+
+		if (strncmp (word, term->word, term_len) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static gint
+count_bits (guint64 mask)
+{
+	gint n;
+
+	for (n = 0; mask; n++) {
+		mask &= mask - 1;
+	}
+
+	return n;
+}
+
+/* Returns the best n_words long snippet of text, looking at most at
+ * max_matches matches, *score is the number of distinct terms in it.
+ */
+static gchar *
+snippet_for_text (SnippetCache *cache,
+                  GPtrArray    *terms,
+                  const gchar  *text,
+                  gint          text_len,
+                  const gchar  *start_match,
+                  const gchar  *end_match,
+                  const gchar  *ellipsis,
+                  gint          n_words,
+                  gint          max_matches,
+                  gint         *score)
+{
+	GArray *tokens;
+	SnippetToken *token;
+	GString *str;
+	const gchar *word;
+	gint n_matches = 0, stop_at = -1;
+	gint best = -1, best_score = 0;
+	gint i, j, first, last, slack;
+	gboolean more = FALSE;
+
+	tokens = g_array_new (FALSE, FALSE, sizeof (SnippetToken));
+	snippet_parser_reset (cache, text, text_len);
+
+	while (TRUE) {
+		SnippetToken new_token;
+		gint len;
+
+		if ((gint) tokens->len >= cache->max_words) {
+			/* Matches can't go beyond what was indexed */
+			more = TRUE;
+			break;
+		}
+
+		if (stop_at >= 0 && (gint) tokens->len >= stop_at) {
+			more = TRUE;
+			break;
+		}
+
+		word = snippet_parser_next (cache, &new_token.start, &new_token.end, &len);
+
+		if (!word) {
+			break;
+		}
+
+		new_token.term = snippet_match_term (terms, word, len);
+		g_array_append_val (tokens, new_token);
+
+		if (new_token.term >= 0 &&
+		    ++n_matches == max_matches) {
+			/* Leave room for the context after the last match */
+			stop_at = tokens->len + n_words - 1;
+		}
+	}
+
+	token = (SnippetToken *) tokens->data;
+	n_matches = 0;
+
+	for (i = 0; i < (gint) tokens->len; i++) {
+		guint64 mask = 0;
+		gint window_score;
+
+		if (token[i].term < 0) {
+			continue;
+		}
+
+		if (max_matches > 0 && n_matches++ == max_matches) {
+			break;
+		}
+
+		for (j = i; j < (gint) tokens->len && j < i + n_words; j++) {
+			if (token[j].term >= 0) {
+				mask |= G_GUINT64_CONSTANT (1) << token[j].term;
+			}
+		}
+
+		window_score = count_bits (mask);
+
+		if (window_score > best_score) {
+			best_score = window_score;
+			best = i;
+		}
+	}
+
+	*score = best_score;
+
+	if (best < 0) {
+		g_array_free (tokens, TRUE);
+		return NULL;
+	}
+
+	/* Center the matches in the window */
+	last = best;
+
+	for (j = best; j < (gint) tokens->len && j < best + n_words; j++) {
+		if (token[j].term >= 0) {
+			last = j;
+		}
+	}
+
+	slack = n_words - (last - best + 1);
+	first = MAX (0, best - slack / 2);
+	last = MIN ((gint) tokens->len, first + n_words);
+	first = MAX (0, last - n_words);
+
+	str = g_string_new (NULL);
+
+	if (first > 0) {
+		g_string_append (str, ellipsis);
+	}
+
+	for (i = first; i < last; i++) {
+		if (i > first) {
+			g_string_append_len (str, &text[token[i - 1].end],
+			                     token[i].start - token[i - 1].end);
+		}
+
+		if (token[i].term >= 0) {
+			g_string_append (str, start_match);
+		}
+
+		g_string_append_len (str, &text[token[i].start],
+		                     token[i].end - token[i].start);
+
+		if (token[i].term >= 0) {
+			g_string_append (str, end_match);
+		}
+	}
+
+	if (more || last < (gint) tokens->len) {
+		g_string_append (str, ellipsis);
+	}
+
+	g_array_free (tokens, TRUE);
+
+	return g_string_free (str, FALSE);
+}
+
+static gchar *
+snippet_for_document (SnippetCache *cache,
+                      sqlite3      *db,
+                      gint64        docid,
+                      const gchar  *match,
+                      const gchar  *start_match,
+                      const gchar  *end_match,
+                      const gchar  *ellipsis,
+                      gint          n_words,
+                      gint          max_matches)
+{
+	sqlite3_stmt *stmt;
+	GPtrArray *terms;
+	gchar *snippet = NULL;
+	gint best_score = 0;
+
+	terms = snippet_get_terms (cache, match);
+
+	if (terms->len == 0 ||
+	    sqlite3_prepare_v2 (db, "SELECT * FROM fts_view WHERE rowid = ?",
+	                        -1, &stmt, NULL) != SQLITE_OK) {
+		g_ptr_array_unref (terms);
+		return NULL;
+	}
+
+	sqlite3_bind_int64 (stmt, 1, docid);
+
+	if (sqlite3_step (stmt) == SQLITE_ROW) {
+		gint i;
+
+		/* Column 0 is the rowid */
+		for (i = 1; i < sqlite3_column_count (stmt); i++) {
+			const gchar *text;
+			gchar *column_snippet;
+			gint score;
+
+			text = (const gchar *) sqlite3_column_text (stmt, i);
+
+			if (!text) {
+				continue;
+			}
+
+			column_snippet = snippet_for_text (cache, terms, text,
+			                                   sqlite3_column_bytes (stmt, i),
+			                                   start_match, end_match, ellipsis,
+			                                   n_words, max_matches, &score);
+
+			if (score > best_score) {
+				g_free (snippet);
+				snippet = column_snippet;
+				best_score = score;
+
+				if (best_score == (gint) terms->len) {
+					/* Can't get any better */
+					break;
+				}
+			} else {
+				g_free (column_snippet);
+			}
+		}
+	}
+
+	sqlite3_finalize (stmt);
+	g_ptr_array_unref (terms);
+
+	return snippet;
+}
+
+/* tracker_snippet(docid, modified, match, start, end, ellipsis, n_words, max_matches)
+ * The modification stamp of the resource is part of the cache key, so
+ * updated documents get a fresh snippet.
+ */
+static void
+function_snippet (sqlite3_context *context,
+                  int              argc,
+                  sqlite3_value   *argv[])
+{
+	SnippetCache *cache;
+	const gchar *match, *start_match, *end_match, *ellipsis;
+	const gchar *snippet;
+	gchar *key, *new_snippet;
+	gint64 docid, modified;
+	gint n_words, max_matches;
+
+	if (argc != 8) {
+		sqlite3_result_error(context,
+		                     "wrong number of arguments to function tracker_snippet()",
+		                     -1);
+		return;
+	}
+
+	cache = sqlite3_user_data (context);
+	docid = sqlite3_value_int64 (argv[0]);
+	modified = sqlite3_value_int64 (argv[1]);
+	match = (const gchar *) sqlite3_value_text (argv[2]);
+	start_match = (const gchar *) sqlite3_value_text (argv[3]);
+	end_match = (const gchar *) sqlite3_value_text (argv[4]);
+	ellipsis = (const gchar *) sqlite3_value_text (argv[5]);
+	n_words = sqlite3_value_int (argv[6]);
+	max_matches = sqlite3_value_int (argv[7]);
+
+	if (!match || n_words <= 0) {
+		sqlite3_result_null (context);
+		return;
+	}
+
+	key = g_strdup_printf ("%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT ":%d:%d:%s\037%s\037%s\037%s",
+	                       docid, modified, n_words, max_matches, match,
+	                       start_match ? start_match : "",
+	                       end_match ? end_match : "",
+	                       ellipsis ? ellipsis : "");
+
+	if (snippet_cache_lookup (cache, key, &snippet)) {
+		g_free (key);
+	} else {
+		new_snippet = snippet_for_document (cache,
+		                                    sqlite3_context_db_handle (context),
+		                                    docid, match,
+		                                    start_match ? start_match : "",
+		                                    end_match ? end_match : "",
+		                                    ellipsis ? ellipsis : "",
+		                                    n_words, max_matches);
+		snippet_cache_insert (cache, key, new_snippet);
+		snippet = new_snippet;
+	}
+
+	if (snippet) {
+		sqlite3_result_text (context, snippet, -1, SQLITE_TRANSIENT);
+	} else {
+		sqlite3_result_null (context);
+	}
+}
+
 static void
 fts_register_functions (sqlite3 *db)
 {
 	sqlite3_create_function (db, "tracker_rank", 2, SQLITE_ANY,
 	                         NULL, &function_rank,
 	                         NULL, NULL);
+	sqlite3_create_function (db, "tracker_rank_top_k", 3, SQLITE_ANY,
+	                         NULL, &function_rank_top_k,
+	                         NULL, NULL);
 	sqlite3_create_function (db, "tracker_offsets", 2, SQLITE_ANY,
 	                         NULL, &function_offsets,
 	                         NULL, NULL);
+	sqlite3_create_function_v2 (db, "tracker_snippet", 8, SQLITE_ANY,
+	                            snippet_cache_new (), &function_snippet,
+	                            NULL, NULL,
+	                            (void (*) (void *)) snippet_cache_free);
 	sqlite3_create_function (db, "fts_column_weights", 0, SQLITE_ANY,
 	                         NULL, &function_weights,
 	                         NULL, NULL);
@@ -264,6 +990,50 @@ tracker_fts_init_db (sqlite3    *db,
 	return TRUE;
 }
 
+/* Tokenizes a fulltext value on a worker thread, ahead
+ * of it being inserted in the FTS table.
+ */
+void
+tracker_fts_pretokenize (const gchar *text,
+                         gint         len)
+{
+	g_return_if_fail (initialized == TRUE);
+
+	tracker_tokenizer_pretokenize (text, len);
+}
+
+void
+tracker_fts_clear_pretokenized (void)
+{
+	tracker_tokenizer_clear_pretokenized ();
+}
+
+static gchar *
+get_prefix_indexes (void)
+{
+	TrackerFTSConfig *config;
+	gchar *prefix_indexes;
+
+	config = tracker_fts_config_new ();
+	prefix_indexes = tracker_fts_config_get_prefix_indexes (config);
+	g_object_unref (config);
+
+	return prefix_indexes;
+}
+
+static gboolean
+get_detect_language (void)
+{
+	TrackerFTSConfig *config;
+	gboolean detect_language;
+
+	config = tracker_fts_config_new ();
+	detect_language = tracker_fts_config_get_detect_language (config);
+	g_object_unref (config);
+
+	return detect_language;
+}
+
 gboolean
 tracker_fts_create_table (sqlite3    *db,
                           gchar      *table_name,
@@ -272,12 +1042,14 @@ tracker_fts_create_table (sqlite3    *db,
 {
 	GString *str, *from, *fts;
 	GHashTableIter iter;
-	gchar *index_table;
+	gchar *index_table, *prefix_indexes;
 	GList *columns;
 	gint rc;
 
 	g_return_val_if_fail (initialized == TRUE, FALSE);
 
+	prefix_indexes = get_prefix_indexes ();
+
 	/* Create view on tables/columns marked as FTS-indexed */
 	g_hash_table_iter_init (&iter, tables);
 	str = g_string_new ("CREATE VIEW fts_view AS SELECT Resource.ID as rowid ");
@@ -287,6 +1059,11 @@ tracker_fts_create_table (sqlite3    *db,
 	g_string_append_printf (fts, "%s USING fts4(content=\"fts_view\", ",
 				table_name);
 
+	if (prefix_indexes) {
+		g_string_append_printf (fts, "prefix=\"%s\", ", prefix_indexes);
+		g_free (prefix_indexes);
+	}
+
 	while (g_hash_table_iter_next (&iter, (gpointer *) &index_table,
 				       (gpointer *) &columns)) {
 		while (columns) {
@@ -324,38 +1101,48 @@ tracker_fts_create_table (sqlite3    *db,
 		return FALSE;
 	}
 
-	g_string_append (fts, "tokenize=TrackerTokenizer)");
+	/* The tokenizer argument makes the table self describing,
+	 * the language a document was indexed with must be known
+	 * to delete it.
+	 */
+	if (get_detect_language ()) {
+		g_string_append (fts, "tokenize=TrackerTokenizer detect-language)");
+	} else {
+		g_string_append (fts, "tokenize=TrackerTokenizer)");
+	}
 	rc = sqlite3_exec(db, fts->str, NULL, 0, NULL);
 	g_string_free (fts, TRUE);
 
 	return (rc == SQLITE_OK);
 }
 
-gboolean
-tracker_fts_alter_table (sqlite3    *db,
-			 gchar      *table_name,
-			 GHashTable *tables,
-			 GHashTable *grouped_columns)
+static gboolean
+fts_alter_table (sqlite3    *db,
+		 gchar      *table_name,
+		 GHashTable *tables,
+		 GHashTable *grouped_columns)
 {
 	gchar *query, *tmp_name;
 	int rc;
 
-	g_return_val_if_fail (initialized == TRUE, FALSE);
-
 	tmp_name = g_strdup_printf ("%s_TMP", table_name);
 
-	query = g_strdup_printf ("DROP VIEW fts_view");
-	rc = sqlite3_prepare_v2 (db, query, -1, NULL, NULL);
+	rc = sqlite3_exec (db, "DROP VIEW IF EXISTS fts_view", NULL, NULL, NULL);
+
+	if (rc != SQLITE_OK) {
+		g_free (tmp_name);
+		return FALSE;
+	}
 
 	if (!tracker_fts_create_table (db, tmp_name, tables, grouped_columns)) {
 		g_free (tmp_name);
-		g_free (query);
 		return FALSE;
 	}
 
-	query = g_strdup_printf ("INSERT INTO %s (docid) SELECT docid FROM %s",
-				 tmp_name, table_name);
-	rc = sqlite3_prepare_v2 (db, query, -1, NULL, NULL);
+	/* With external content, this reindexes all of fts_view */
+	query = g_strdup_printf ("INSERT INTO %s(%s) VALUES('rebuild')",
+				 tmp_name, tmp_name);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
 	g_free (query);
 
 	if (rc != SQLITE_OK) {
@@ -363,9 +1150,8 @@ tracker_fts_alter_table (sqlite3    *db,
 		return FALSE;
 	}
 
-	query = g_strdup_printf ("INSERT INTO %s(%s) VALUES('rebuild')",
-				 tmp_name, tmp_name);
-	rc = sqlite3_prepare_v2 (db, query, -1, NULL, NULL);
+	query = g_strdup_printf ("DROP TABLE %s", table_name);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
 	g_free (query);
 
 	if (rc != SQLITE_OK) {
@@ -375,15 +1161,163 @@ tracker_fts_alter_table (sqlite3    *db,
 
 	query = g_strdup_printf ("ALTER TABLE %s RENAME TO %s",
 				 tmp_name, table_name);
-	rc = sqlite3_prepare_v2 (db, query, -1, NULL, NULL);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
 	g_free (query);
 	g_free (tmp_name);
 
+	return (rc == SQLITE_OK);
+}
+
+gboolean
+tracker_fts_alter_table (sqlite3    *db,
+			 gchar      *table_name,
+			 GHashTable *tables,
+			 GHashTable *grouped_columns)
+{
+	int rc;
+
+	g_return_val_if_fail (initialized == TRUE, FALSE);
+
+	/* fts_view is dropped first, as it is recreated with the new
+	 * columns. Any step failing must leave the view and the old
+	 * table in place, callers carry on with the existing index.
+	 */
+	rc = sqlite3_exec (db, "SAVEPOINT fts_alter", NULL, NULL, NULL);
 
 	if (rc != SQLITE_OK) {
-		g_free (tmp_name);
 		return FALSE;
 	}
 
-	return TRUE;
+	if (!fts_alter_table (db, table_name, tables, grouped_columns)) {
+		sqlite3_exec (db, "ROLLBACK TO fts_alter", NULL, NULL, NULL);
+		sqlite3_exec (db, "RELEASE fts_alter", NULL, NULL, NULL);
+		return FALSE;
+	}
+
+	rc = sqlite3_exec (db, "RELEASE fts_alter", NULL, NULL, NULL);
+
+	return (rc == SQLITE_OK);
+}
+
+/* Returns TRUE if the prefix indexes or language detection
+ * of the existing FTS table differ from the configured ones.
+ */
+gboolean
+tracker_fts_settings_changed (sqlite3     *db,
+                              const gchar *table_name)
+{
+	sqlite3_stmt *stmt;
+	gchar *prefix_indexes, *current = NULL;
+	gboolean changed = FALSE;
+	int rc;
+
+	g_return_val_if_fail (initialized == TRUE, FALSE);
+
+	rc = sqlite3_prepare_v2 (db,
+	                         "SELECT sql FROM sqlite_master "
+	                         "WHERE type = 'table' AND name = ?",
+	                         -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		return FALSE;
+	}
+
+	sqlite3_bind_text (stmt, 1, table_name, -1, SQLITE_STATIC);
+
+	if (sqlite3_step (stmt) == SQLITE_ROW) {
+		const gchar *sql, *start, *end;
+
+		sql = (const gchar *) sqlite3_column_text (stmt, 0);
+		start = sql ? strstr (sql, "prefix=\"") : NULL;
+
+		if (start) {
+			start += strlen ("prefix=\"");
+			end = strchr (start, '"');
+
+			if (end) {
+				current = g_strndup (start, end - start);
+			}
+		}
+
+		prefix_indexes = get_prefix_indexes ();
+		changed = (g_strcmp0 (current, prefix_indexes) != 0);
+		g_free (prefix_indexes);
+		g_free (current);
+
+		if (sql && (strstr (sql, "detect-language") != NULL) != get_detect_language ()) {
+			changed = TRUE;
+		}
+	}
+
+	sqlite3_finalize (stmt);
+
+	return changed;
+}
+
+/* Counts the segments of the FTS index, the more segments per level
+ * the more b-trees each query has to look into.
+ */
+gboolean
+tracker_fts_get_segment_stats (sqlite3     *db,
+                               const gchar *table_name,
+                               gint        *n_segments,
+                               gint        *n_levels,
+                               gint        *max_level_segments)
+{
+	sqlite3_stmt *stmt;
+	gchar *query;
+	int rc;
+
+	g_return_val_if_fail (initialized == TRUE, FALSE);
+
+	*n_segments = *n_levels = *max_level_segments = 0;
+
+	query = g_strdup_printf ("SELECT level, COUNT(*) FROM \"%s_segdir\" "
+	                         "GROUP BY level", table_name);
+	rc = sqlite3_prepare_v2 (db, query, -1, &stmt, NULL);
+	g_free (query);
+
+	if (rc != SQLITE_OK) {
+		return FALSE;
+	}
+
+	while ((rc = sqlite3_step (stmt)) == SQLITE_ROW) {
+		gint count = sqlite3_column_int (stmt, 1);
+
+		*n_segments += count;
+		*max_level_segments = MAX (*max_level_segments, count);
+		(*n_levels)++;
+	}
+
+	sqlite3_finalize (stmt);
+
+	return (rc == SQLITE_DONE);
+}
+
+/* Runs an incremental merge step, writing at most n_pages pages and
+ * merging min_segments segments of a level at a time. *done is set
+ * once there's nothing left to merge.
+ */
+gboolean
+tracker_fts_merge (sqlite3     *db,
+                   const gchar *table_name,
+                   gint         n_pages,
+                   gint         min_segments,
+                   gboolean    *done)
+{
+	gchar *query;
+	int rc, changes;
+
+	g_return_val_if_fail (initialized == TRUE, FALSE);
+
+	query = g_strdup_printf ("INSERT INTO %s(%s) VALUES('merge=%d,%d')",
+	                         table_name, table_name, n_pages, min_segments);
+
+	changes = sqlite3_total_changes (db);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
+	g_free (query);
+
+	/* Less than 2 changes means no work was done */
+	*done = (sqlite3_total_changes (db) - changes < 2);
+
+	return (rc == SQLITE_OK);
 }
@@ -40,6 +40,21 @@ gboolean    tracker_fts_alter_table      (sqlite3    *db,
                                           gchar      *table_name,
                                           GHashTable *tables,
                                           GHashTable *grouped_columns);
+gboolean    tracker_fts_settings_changed (sqlite3     *db,
+                                          const gchar *table_name);
+void        tracker_fts_pretokenize      (const gchar *text,
+                                          gint         len);
+void        tracker_fts_clear_pretokenized (void);
+gboolean    tracker_fts_get_segment_stats (sqlite3     *db,
+                                           const gchar *table_name,
+                                           gint        *n_segments,
+                                           gint        *n_levels,
+                                           gint        *max_level_segments);
+gboolean    tracker_fts_merge            (sqlite3     *db,
+                                          const gchar *table_name,
+                                          gint         n_pages,
+                                          gint         min_segments,
+                                          gboolean    *done);
 
 
 G_END_DECLS
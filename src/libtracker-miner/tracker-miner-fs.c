@@ -3721,6 +3721,35 @@ tracker_miner_fs_file_notify (TrackerMinerFS *fs,
 	item_add_or_update_continue (fs, task, error);
 }
 
+/**
+ * tracker_miner_fs_file_notify_unchanged:
+ * @fs: a #TrackerMinerFS
+ * @file: a #GFile
+ *
+ * Notifies @fs that all processing on @file has been finished, and
+ * that the file contents were found to be unchanged since the file
+ * was last indexed. As opposed to tracker_miner_fs_file_notify(),
+ * previously stored data for @file is kept, only the updates added
+ * to the #TrackerSparqlBuilder given in #TrackerMinerFS::process-file
+ * are applied, so these should take care of deleting any prior
+ * values of the properties being updated.
+ *
+ * Since: 1.4
+ **/
+void
+tracker_miner_fs_file_notify_unchanged (TrackerMinerFS *fs,
+                                        GFile          *file)
+{
+	g_return_if_fail (TRACKER_IS_MINER_FS (fs));
+	g_return_if_fail (G_IS_FILE (file));
+
+	g_object_set_qdata (G_OBJECT (file),
+	                    fs->priv->quark_attribute_updated,
+	                    GINT_TO_POINTER (TRUE));
+
+	tracker_miner_fs_file_notify (fs, file, NULL);
+}
+
 /**
  * tracker_miner_fs_set_throttle:
  * @fs: a #TrackerMinerFS
@@ -187,6 +187,8 @@ void                  tracker_miner_fs_writeback_notify      (TrackerMinerFS  *f
 void                  tracker_miner_fs_file_notify           (TrackerMinerFS  *fs,
                                                               GFile           *file,
                                                               const GError    *error);
+void                  tracker_miner_fs_file_notify_unchanged (TrackerMinerFS  *fs,
+                                                              GFile           *file);
 
 /* URNs */
 const gchar          *tracker_miner_fs_get_urn               (TrackerMinerFS  *fs,
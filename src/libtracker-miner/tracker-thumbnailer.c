@@ -21,6 +21,8 @@
 
 #include <string.h>
 
+#include <glib/gstdio.h>
+
 #include <libtracker-common/tracker-dbus.h>
 
 #include "tracker-thumbnailer.h"
@@ -35,6 +37,13 @@
  * thumbnails for files being mined. It is also used to create
  * thumbnails for album art found embedded in some medias.
  *
+ * Requests are sent in the order they were queued, coalesced per URI
+ * where that doesn't change the outcome, so a file moved several times,
+ * or moved and then deleted, only results in a single request to the
+ * thumbnailer. Pending requests are saved to disk shortly after being
+ * queued and when the object is finalized, and queued again next time
+ * a #TrackerThumbnailer is created by the same program.
+ *
  * This follows the thumbnailer specification:
  * http://live.gnome.org/ThumbnailerSpec
  **/
@@ -47,6 +56,25 @@
 #define THUMBMAN_PATH           "/org/freedesktop/thumbnails/Thumbnailer1"
 #define THUMBMAN_INTERFACE      "org.freedesktop.thumbnails.Thumbnailer1"
 
+/* Maximum number of URIs sent in a single Delete/Move call, requests
+ * are also flushed as soon as this many are queued.
+ */
+#define MAX_BATCH_SIZE          2000
+
+/* Seconds after a request is queued until the queue is saved */
+#define QUEUE_SAVE_DELAY        5
+
+#define QUEUE_GROUP             "Queue"
+
+typedef struct {
+	/* NULL for removals */
+	gchar *from;
+	/* The removed URI or the move destination */
+	gchar *uri;
+	/* Position in the queue, only ever grows */
+	guint seq;
+} QueueItem;
+
 typedef struct {
 	GDBusProxy *cache_proxy;
 	GDBusProxy *manager_proxy;
@@ -54,15 +82,28 @@ typedef struct {
 
 	GStrv supported_mime_types;
 
-	GSList *removes;
-	GSList *moves_to;
-	GSList *moves_from;
+	/* QueueItems, in the order they were requested */
+	GQueue *queue;
+	/* URI -> link of the pending removal of it */
+	GHashTable *removes;
+	/* Destination URI -> link of the pending move, while the
+	 * moved file is still there */
+	GHashTable *moves;
+	/* URI -> seq of the last queued item involving it */
+	GHashTable *touched;
+	guint seq;
+
+	gchar *queue_file;
+	gboolean queue_saved;
+	guint queue_save_id;
 
 	guint request_id;
 	gboolean service_is_available;
 } TrackerThumbnailerPrivate;
 
 static void tracker_thumbnailer_initable_iface_init (GInitableIface *iface);
+static void queue_save                              (TrackerThumbnailerPrivate *private);
+static void queue_clear                             (TrackerThumbnailerPrivate *private);
 
 G_DEFINE_TYPE_WITH_CODE (TrackerThumbnailer, tracker_thumbnailer, G_TYPE_OBJECT,
 			 G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
@@ -92,14 +133,20 @@ tracker_thumbnailer_finalize (GObject *object)
 
 	g_strfreev (private->supported_mime_types);
 
-	g_slist_foreach (private->removes, (GFunc) g_free, NULL);
-	g_slist_free (private->removes);
+	if (private->queue_save_id != 0) {
+		g_source_remove (private->queue_save_id);
+	}
 
-	g_slist_foreach (private->moves_to, (GFunc) g_free, NULL);
-	g_slist_free (private->moves_to);
+	if (private->service_is_available) {
+		queue_save (private);
+	}
 
-	g_slist_foreach (private->moves_from, (GFunc) g_free, NULL);
-	g_slist_free (private->moves_from);
+	queue_clear (private);
+	g_queue_free (private->queue);
+	g_hash_table_unref (private->removes);
+	g_hash_table_unref (private->moves);
+	g_hash_table_unref (private->touched);
+	g_free (private->queue_file);
 
 	G_OBJECT_CLASS (tracker_thumbnailer_parent_class)->finalize (object);
 }
@@ -126,6 +173,354 @@ should_be_thumbnailed (GStrv        list,
 	return should_thumbnail;
 }
 
+static void
+queue_touch (TrackerThumbnailerPrivate *private,
+             const gchar               *uri,
+             guint                      seq)
+{
+	g_hash_table_replace (private->touched, g_strdup (uri), GUINT_TO_POINTER (seq));
+}
+
+static gboolean
+queue_touched_after (TrackerThumbnailerPrivate *private,
+                     const gchar               *uri,
+                     guint                      seq)
+{
+	gpointer value;
+
+	if (!g_hash_table_lookup_extended (private->touched, uri, NULL, &value)) {
+		return FALSE;
+	}
+
+	return GPOINTER_TO_UINT (value) > seq;
+}
+
+static GList *
+queue_append (TrackerThumbnailerPrivate *private,
+              const gchar               *from,
+              const gchar               *uri)
+{
+	QueueItem *item;
+
+	item = g_slice_new (QueueItem);
+	item->from = g_strdup (from);
+	item->uri = g_strdup (uri);
+	item->seq = ++private->seq;
+
+	if (from) {
+		queue_touch (private, from, item->seq);
+	}
+
+	queue_touch (private, uri, item->seq);
+
+	g_queue_push_tail (private->queue, item);
+
+	return private->queue->tail;
+}
+
+static void
+queue_item_free (QueueItem *item)
+{
+	g_free (item->from);
+	g_free (item->uri);
+	g_slice_free (QueueItem, item);
+}
+
+/* Turns a pending move into the removal of the thumbnail at its
+ * source, at the same position in the queue. Used when the moved
+ * file goes away before the move was sent.
+ */
+static void
+queue_item_to_removal (TrackerThumbnailerPrivate *private,
+                       GList                     *link)
+{
+	QueueItem *item = link->data;
+
+	g_hash_table_remove (private->moves, item->uri);
+
+	g_free (item->uri);
+	item->uri = item->from;
+	item->from = NULL;
+
+	if (!g_hash_table_contains (private->removes, item->uri)) {
+		g_hash_table_insert (private->removes, g_strdup (item->uri), link);
+	}
+}
+
+static void
+queue_move (TrackerThumbnailerPrivate *private,
+            const gchar               *from_uri,
+            const gchar               *to_uri)
+{
+	GList *link;
+
+	if (g_strcmp0 (from_uri, to_uri) == 0) {
+		return;
+	}
+
+	link = g_hash_table_lookup (private->moves, from_uri);
+
+	if (link) {
+		QueueItem *item = link->data;
+
+		/* The file is not at the destination of that move
+		 * anymore, whatever happens below */
+		g_hash_table_remove (private->moves, from_uri);
+
+		/* from_uri was itself the destination of a pending move,
+		 * collapse both into a single move from the original
+		 * location, unless requests queued after that one involve
+		 * to_uri and must see it as it was.
+		 */
+		if (!queue_touched_after (private, to_uri, item->seq)) {
+			GList *replaced;
+
+			if (g_strcmp0 (item->from, to_uri) == 0) {
+				/* Moved back to where it started, nothing to do */
+				queue_item_free (item);
+				g_queue_delete_link (private->queue, link);
+				return;
+			}
+
+			/* A file already moved there before that move
+			 * gets overwritten */
+			replaced = g_hash_table_lookup (private->moves, to_uri);
+
+			if (replaced) {
+				queue_item_to_removal (private, replaced);
+			}
+
+			g_free (item->uri);
+			item->uri = g_strdup (to_uri);
+			queue_touch (private, to_uri, item->seq);
+			g_hash_table_insert (private->moves, g_strdup (to_uri), link);
+			return;
+		}
+	}
+
+	/* A file moved to to_uri before gets overwritten, its
+	 * thumbnail has to go instead of being moved there */
+	link = g_hash_table_lookup (private->moves, to_uri);
+
+	if (link) {
+		queue_item_to_removal (private, link);
+	}
+
+	link = queue_append (private, from_uri, to_uri);
+	g_hash_table_insert (private->moves, g_strdup (to_uri), link);
+}
+
+static void
+queue_remove (TrackerThumbnailerPrivate *private,
+              const gchar               *uri)
+{
+	GList *link;
+
+	/* The thumbnail for a moved file is still stored for
+	 * its original URI, so the move request can be replaced
+	 * by a removal of that one.
+	 */
+	link = g_hash_table_lookup (private->moves, uri);
+
+	if (link) {
+		queue_item_to_removal (private, link);
+		return;
+	}
+
+	if (g_hash_table_contains (private->removes, uri)) {
+		return;
+	}
+
+	link = queue_append (private, NULL, uri);
+	g_hash_table_insert (private->removes, g_strdup (uri), link);
+}
+
+static void
+queue_clear (TrackerThumbnailerPrivate *private)
+{
+	g_queue_foreach (private->queue, (GFunc) queue_item_free, NULL);
+	g_queue_clear (private->queue);
+	g_hash_table_remove_all (private->removes);
+	g_hash_table_remove_all (private->moves);
+	g_hash_table_remove_all (private->touched);
+}
+
+static guint
+queue_length (TrackerThumbnailerPrivate *private)
+{
+	return g_queue_get_length (private->queue);
+}
+
+static gchar *
+queue_file_path (void)
+{
+	const gchar *prgname;
+	gchar *basename, *path;
+
+	prgname = g_get_prgname ();
+	basename = g_strdup_printf ("thumbnailer-queue-%s",
+	                            prgname ? prgname : "unknown");
+	path = g_build_filename (g_get_user_cache_dir (),
+	                         "tracker",
+	                         basename,
+	                         NULL);
+	g_free (basename);
+
+	return path;
+}
+
+static void
+queue_load (TrackerThumbnailerPrivate *private)
+{
+	GKeyFile *key_file;
+	GStrv methods, from, to;
+	gsize n_methods, n_from, n_to;
+	guint i;
+
+	key_file = g_key_file_new ();
+
+	if (!g_key_file_load_from_file (key_file, private->queue_file,
+	                                G_KEY_FILE_NONE, NULL)) {
+		g_key_file_free (key_file);
+		return;
+	}
+
+	methods = g_key_file_get_string_list (key_file, QUEUE_GROUP,
+	                                      "Methods", &n_methods, NULL);
+	from = g_key_file_get_string_list (key_file, QUEUE_GROUP,
+	                                   "From", &n_from, NULL);
+	to = g_key_file_get_string_list (key_file, QUEUE_GROUP,
+	                                 "To", &n_to, NULL);
+
+	if (methods && from && to &&
+	    n_methods == n_from && n_methods == n_to) {
+		for (i = 0; i < n_methods; i++) {
+			if (g_strcmp0 (methods[i], "Delete") == 0) {
+				queue_remove (private, to[i]);
+			} else {
+				queue_move (private, from[i], to[i]);
+			}
+		}
+	}
+
+	g_message ("Thumbnailer queue restored with %d items from '%s'",
+	           queue_length (private),
+	           private->queue_file);
+
+	g_strfreev (methods);
+	g_strfreev (from);
+	g_strfreev (to);
+	g_key_file_free (key_file);
+
+	/* Left on disk until the requests are sent or
+	 * the queue is saved again */
+	private->queue_saved = TRUE;
+}
+
+static void
+queue_save (TrackerThumbnailerPrivate *private)
+{
+	GKeyFile *key_file;
+	GError *error = NULL;
+	const gchar **methods, **from, **to;
+	gchar *dirname;
+	GList *l;
+	guint i;
+
+	if (queue_length (private) == 0) {
+		if (private->queue_saved) {
+			g_unlink (private->queue_file);
+			private->queue_saved = FALSE;
+		}
+
+		return;
+	}
+
+	key_file = g_key_file_new ();
+
+	/* Removals are saved with the same URI as source and
+	 * destination, so all lists keep the queue order */
+	methods = g_new0 (const gchar *, queue_length (private) + 1);
+	from = g_new0 (const gchar *, queue_length (private) + 1);
+	to = g_new0 (const gchar *, queue_length (private) + 1);
+
+	for (l = private->queue->head, i = 0; l; l = l->next, i++) {
+		QueueItem *item = l->data;
+
+		methods[i] = item->from ? "Move" : "Delete";
+		from[i] = item->from ? item->from : item->uri;
+		to[i] = item->uri;
+	}
+
+	g_key_file_set_string_list (key_file, QUEUE_GROUP, "Methods", methods, i);
+	g_key_file_set_string_list (key_file, QUEUE_GROUP, "From", from, i);
+	g_key_file_set_string_list (key_file, QUEUE_GROUP, "To", to, i);
+	g_free (methods);
+	g_free (from);
+	g_free (to);
+
+	dirname = g_path_get_dirname (private->queue_file);
+	g_mkdir_with_parents (dirname, 0700);
+	g_free (dirname);
+
+	if (!g_key_file_save_to_file (key_file, private->queue_file, &error)) {
+		g_warning ("Could not save thumbnailer queue to '%s': %s",
+		           private->queue_file,
+		           error->message);
+		g_error_free (error);
+	} else {
+		g_debug ("Thumbnailer queue saved with %d pending items",
+		         queue_length (private));
+		private->queue_saved = TRUE;
+	}
+
+	g_key_file_free (key_file);
+}
+
+static gboolean
+queue_save_cb (gpointer user_data)
+{
+	TrackerThumbnailerPrivate *private = user_data;
+
+	private->queue_save_id = 0;
+	queue_save (private);
+
+	return FALSE;
+}
+
+/* Requests not sent yet survive a crash, apart from
+ * the ones queued during the last QUEUE_SAVE_DELAY */
+static void
+queue_schedule_save (TrackerThumbnailerPrivate *private)
+{
+	if (private->queue_save_id == 0) {
+		private->queue_save_id = g_timeout_add_seconds (QUEUE_SAVE_DELAY,
+		                                                queue_save_cb,
+		                                                private);
+	}
+}
+
+static void
+send_batch (TrackerThumbnailerPrivate *private,
+            const gchar               *method,
+            GVariant                  *parameters,
+            guint                      n_items)
+{
+	g_dbus_proxy_call (private->cache_proxy,
+	                   method,
+	                   parameters,
+	                   G_DBUS_CALL_FLAGS_NONE,
+	                   -1,
+	                   NULL,
+	                   NULL,
+	                   NULL);
+
+	g_message ("Thumbnailer %s request sent with %d items to thumbnailer daemon, request ID:%d...",
+	           method,
+	           n_items,
+	           private->request_id++);
+}
+
 static gboolean
 tracker_thumbnailer_initable_init (GInitable     *initable,
 				   GCancellable  *cancellable,
@@ -226,6 +621,7 @@ tracker_thumbnailer_initable_init (GInitable     *initable,
 			g_hash_table_unref (hash);
 
 			private->service_is_available = TRUE;
+			queue_load (private);
 		}
 
 		g_free (mime_types);
@@ -254,6 +650,18 @@ tracker_thumbnailer_class_init (TrackerThumbnailerClass *klass)
 static void
 tracker_thumbnailer_init (TrackerThumbnailer *thumbnailer)
 {
+	TrackerThumbnailerPrivate *private;
+
+	private = tracker_thumbnailer_get_instance_private (thumbnailer);
+
+	private->queue = g_queue_new ();
+	private->removes = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, NULL);
+	private->moves = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                        g_free, NULL);
+	private->touched = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, NULL);
+	private->queue_file = queue_file_path ();
 }
 
 /**
@@ -285,7 +693,8 @@ tracker_thumbnailer_new (void)
  * @to_uri: URI of the file after the move
  *
  * Adds a new request to tell the thumbnailer that @from_uri was moved to
- * @to_uri. Stored requests can be sent with tracker_thumbnailer_send().
+ * @to_uri. Stored requests can be sent with tracker_thumbnailer_send(),
+ * they are sent right away once enough of them are queued.
  *
  * Returns: #TRUE if successfully stored to be reported, #FALSE otherwise.
  *
@@ -314,13 +723,17 @@ tracker_thumbnailer_move_add (TrackerThumbnailer *thumbnailer,
 		return FALSE;
 	}
 
-	private->moves_from = g_slist_prepend (private->moves_from, g_strdup (from_uri));
-	private->moves_to = g_slist_prepend (private->moves_to, g_strdup (to_uri));
+	queue_move (private, from_uri, to_uri);
+	queue_schedule_save (private);
 
 	g_debug ("Thumbnailer request to move uri from:'%s' to:'%s' queued",
 	         from_uri,
 	         to_uri);
 
+	if (queue_length (private) >= MAX_BATCH_SIZE) {
+		tracker_thumbnailer_send (thumbnailer);
+	}
+
 	return TRUE;
 }
 
@@ -331,7 +744,8 @@ tracker_thumbnailer_move_add (TrackerThumbnailer *thumbnailer,
  * @mime_type: mime-type of the file
  *
  * Adds a new request to tell the thumbnailer that @uri was removed.
- * Stored requests can be sent with tracker_thumbnailer_send().
+ * Stored requests can be sent with tracker_thumbnailer_send(),
+ * they are sent right away once enough of them are queued.
  *
  * Returns: #TRUE if successfully stored to be reported, #FALSE otherwise.
  *
@@ -358,10 +772,15 @@ tracker_thumbnailer_remove_add (TrackerThumbnailer *thumbnailer,
 		return FALSE;
 	}
 
-	private->removes = g_slist_prepend (private->removes, g_strdup (uri));
+	queue_remove (private, uri);
+	queue_schedule_save (private);
 
 	g_debug ("Thumbnailer request to remove uri:'%s', appended to queue", uri);
 
+	if (queue_length (private) >= MAX_BATCH_SIZE) {
+		tracker_thumbnailer_send (thumbnailer);
+	}
+
 	return TRUE;
 }
 
@@ -409,11 +828,39 @@ tracker_thumbnailer_cleanup (TrackerThumbnailer *thumbnailer,
 	return TRUE;
 }
 
+static void
+send_pending (TrackerThumbnailerPrivate *private,
+              gboolean                   move,
+              GPtrArray                 *from,
+              GPtrArray                 *to)
+{
+	if (to->len == 0) {
+		return;
+	}
+
+	g_ptr_array_add (to, NULL);
+
+	if (move) {
+		g_ptr_array_add (from, NULL);
+		send_batch (private, "Move",
+		            g_variant_new ("(^as^as)", from->pdata, to->pdata),
+		            to->len - 1);
+	} else {
+		send_batch (private, "Delete",
+		            g_variant_new ("(^as)", to->pdata),
+		            to->len - 1);
+	}
+
+	g_ptr_array_set_size (from, 0);
+	g_ptr_array_set_size (to, 0);
+}
+
 /**
  * tracker_thumbnailer_send:
  * @thumbnailer: Thumbnailer object
  *
- * Sends to the thumbnailer all stored requests.
+ * Sends to the thumbnailer all stored requests, in the order they were
+ * queued, in batches of up to 2000 URIs per D-Bus call.
  *
  * Since: 0.8
  */
@@ -421,7 +868,9 @@ void
 tracker_thumbnailer_send (TrackerThumbnailer *thumbnailer)
 {
 	TrackerThumbnailerPrivate *private;
-	guint list_len;
+	GPtrArray *from, *to;
+	gboolean move = FALSE;
+	GList *l;
 
 	g_return_if_fail (TRACKER_IS_THUMBNAILER (thumbnailer));
 
@@ -431,69 +880,38 @@ tracker_thumbnailer_send (TrackerThumbnailer *thumbnailer)
 		return;
 	}
 
-	list_len = g_slist_length (private->removes);
+	from = g_ptr_array_sized_new (MIN (queue_length (private), MAX_BATCH_SIZE) + 1);
+	to = g_ptr_array_sized_new (MIN (queue_length (private), MAX_BATCH_SIZE) + 1);
 
-	if (list_len > 0) {
-		GStrv uri_strv;
+	/* Consecutive requests of the same kind go in one call */
+	for (l = private->queue->head; l; l = l->next) {
+		QueueItem *item = l->data;
 
-		uri_strv = tracker_dbus_slist_to_strv (private->removes);
-
-		g_dbus_proxy_call (private->cache_proxy,
-		                   "Delete",
-		                   g_variant_new ("(^as)", uri_strv),
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1,
-		                   NULL,
-		                   NULL,
-		                   NULL);
-
-		g_message ("Thumbnailer removes queue sent with %d items to thumbnailer daemon, request ID:%d...",
-		           list_len,
-		           private->request_id++);
+		if ((item->from != NULL) != move || to->len == MAX_BATCH_SIZE) {
+			send_pending (private, move, from, to);
+			move = (item->from != NULL);
+		}
 
-		/* Clean up newly created GStrv */
-		g_strfreev (uri_strv);
+		if (move) {
+			g_ptr_array_add (from, item->from);
+		}
 
-		/* Clean up privately held data */
-		g_slist_foreach (private->removes, (GFunc) g_free, NULL);
-		g_slist_free (private->removes);
-		private->removes = NULL;
+		g_ptr_array_add (to, item->uri);
 	}
 
-	list_len = g_slist_length (private->moves_from);
-
-	if (list_len > 0) {
-		GStrv from_strv, to_strv;
+	send_pending (private, move, from, to);
 
-		g_assert (list_len == g_slist_length (private->moves_to));
+	g_ptr_array_unref (from);
+	g_ptr_array_unref (to);
 
-		from_strv = tracker_dbus_slist_to_strv (private->moves_from);
-		to_strv = tracker_dbus_slist_to_strv (private->moves_to);
+	/* The variants above hold copies of the strings */
+	queue_clear (private);
 
-		g_dbus_proxy_call (private->cache_proxy,
-		                   "Move",
-		                   g_variant_new ("(^as^as)", from_strv, to_strv),
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1,
-		                   NULL,
-		                   NULL,
-		                   NULL);
-
-		g_message ("Thumbnailer moves queue sent with %d items to thumbnailer daemon, request ID:%d...",
-		           list_len,
-		           private->request_id++);
-
-		/* Clean up newly created GStrv */
-		g_strfreev (from_strv);
-		g_strfreev (to_strv);
-
-		/* Clean up privately held data */
-		g_slist_foreach (private->moves_from, (GFunc) g_free, NULL);
-		g_slist_free (private->moves_from);
-		private->moves_from = NULL;
-
-		g_slist_foreach (private->moves_to, (GFunc) g_free, NULL);
-		g_slist_free (private->moves_to);
-		private->moves_to = NULL;
+	if (private->queue_save_id != 0) {
+		g_source_remove (private->queue_save_id);
+		private->queue_save_id = 0;
 	}
+
+	/* Drops the saved queue */
+	queue_save (private);
 }
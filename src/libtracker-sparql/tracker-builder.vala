@@ -509,7 +509,9 @@ public class Tracker.Sparql.Builder : Object {
 			states.length--;
 		}
 
-		str.append_printf (" \"%s\"", escape_string (literal));
+		str.append (" \"");
+		append_escaped_string (str, literal);
+		str.append_c ('"');
 		states += State.OBJECT;
 
 		length++;
@@ -532,4 +532,71 @@ public abstract class Tracker.Sparql.Connection : Object {
 		warning ("Interface 'statistics_async' not implemented");
 		return null;
 	}
+
+	/**
+	 * tracker_sparql_connection_query_continue:
+	 * @self: a #TrackerSparqlConnection
+	 * @sparql: string containing the SPARQL query
+	 * @continuation: a token from tracker_sparql_cursor_get_continuation(),
+	 *                or %NULL for the first page
+	 * @cancellable: a #GCancellable used to cancel the operation
+	 * @error: #GError for error reporting.
+	 *
+	 * Executes a SPARQL query with ORDER BY, returning the rows that
+	 * follow the row @continuation was retrieved at. Instead of skipping
+	 * all previous rows like a growing OFFSET does, the query only
+	 * fetches rows sorting after the ORDER BY keys of that row, so deep
+	 * pages are as fast as the first one if the keys are indexed.
+	 *
+	 * The LIMIT of @sparql is the page size, its OFFSET only applies to
+	 * the first page. Rows inserted or deleted before the continuation
+	 * point do not shift the following pages. The API call is
+	 * completely synchronous, so it may block.
+	 *
+	 * Returns: a #TrackerSparqlCursor, call
+	 * tracker_sparql_cursor_get_continuation() on it after the last row
+	 * of the page to continue further. On error, #NULL is returned and
+	 * the @error is set accordingly. Call g_object_unref() on the
+	 * returned cursor when no longer needed.
+	 *
+	 * Since: 1.4
+	 */
+	public virtual Cursor query_continue (string sparql, string? continuation, Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		throw new Sparql.Error.UNSUPPORTED ("Continued queries are not supported by this connection");
+	}
+
+	/**
+	 * tracker_sparql_connection_query_continue_async:
+	 * @self: a #TrackerSparqlConnection
+	 * @sparql: string containing the SPARQL query
+	 * @continuation: a token from tracker_sparql_cursor_get_continuation(),
+	 *                or %NULL for the first page
+	 * @cancellable: a #GCancellable used to cancel the operation
+	 * @_callback_: user-defined #GAsyncReadyCallback to be called when
+	 *              asynchronous operation is finished.
+	 * @_user_data_: user-defined data to be passed to @_callback_
+	 *
+	 * Executes asynchronously a continued SPARQL query, see
+	 * tracker_sparql_connection_query_continue().
+	 *
+	 * Since: 1.4
+	 */
+
+	/**
+	 * tracker_sparql_connection_query_continue_finish:
+	 * @self: a #TrackerSparqlConnection
+	 * @_res_: a #GAsyncResult with the result of the operation
+	 * @error: #GError for error reporting.
+	 *
+	 * Finishes the asynchronous continued SPARQL query operation.
+	 *
+	 * Returns: a #TrackerSparqlCursor if results were found, #NULL otherwise.
+	 * On error, #NULL is returned and the @error is set accordingly.
+	 * Call g_object_unref() on the returned cursor when no longer needed.
+	 *
+	 * Since: 1.4
+	 */
+	public async virtual Cursor query_continue_async (string sparql, string? continuation, Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		throw new Sparql.Error.UNSUPPORTED ("Continued queries are not supported by this connection");
+	}
 }
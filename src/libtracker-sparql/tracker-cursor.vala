@@ -291,4 +291,25 @@ public abstract class Tracker.Sparql.Cursor : Object {
 		}
 		return false;
 	}
+
+	/**
+	 * tracker_sparql_cursor_get_continuation:
+	 * @self: a #TrackerSparqlCursor
+	 *
+	 * Retrieves a token to fetch the rows following the current one
+	 * with tracker_sparql_connection_query_continue(). This is only
+	 * available for cursors returned by that function for queries with
+	 * ORDER BY.
+	 *
+	 * The token is opaque and only valid for the same query.
+	 *
+	 * Returns: a newly allocated string, or %NULL if the query can't be
+	 * continued or no row was fetched yet. Call g_free() on it when no
+	 * longer needed.
+	 *
+	 * Since: 1.4
+	 */
+	public virtual string? get_continuation () {
+		return null;
+	}
 }
@@ -48,6 +48,16 @@ namespace Tracker.Sparql {
 	public string escape_string (string literal) {
 		StringBuilder str = new StringBuilder ();
 
+		append_escaped_string (str, literal);
+
+		return str.str;
+	}
+
+	/* Appends the escaped version of @literal to @str, so callers
+	 * building bigger strings avoid one intermediate copy per literal,
+	 * which matters for long texts as nie:plainTextContent.
+	 */
+	internal void append_escaped_string (StringBuilder str, string literal) {
 		/* Shouldn't cast from const to non-const here, but we know
 		 * the compiler is going to complain and it's just because
 		 * Vala string manipulation doesn't allow us to do this more
@@ -87,8 +97,6 @@ namespace Tracker.Sparql {
 
 			p++;
 		}
-
-		return str.str;
 	}
 
 	[CCode (cname = "uuid_generate")]
@@ -59,7 +59,9 @@ struct ProcessFileData {
 	TrackerSparqlBuilder *sparql;
 	GCancellable *cancellable;
 	GFile *file;
+	GFileInfo *file_info;
 	gchar *mime_type;
+	gchar *fingerprint;
 };
 
 struct TrackerMinerFilesPrivate {
@@ -1998,6 +2000,54 @@ miner_files_add_rdf_types (TrackerSparqlBuilder *sparql,
 	g_strfreev (rdf_types);
 }
 
+static void
+sparql_builder_update_file_times (TrackerSparqlBuilder *sparql,
+                                  const gchar          *urn,
+                                  GFileInfo            *file_info)
+{
+	guint64 time_;
+
+	/* Update nfo:fileLastModified */
+	tracker_sparql_builder_delete_open (sparql, NULL);
+	tracker_sparql_builder_subject_iri (sparql, urn);
+	tracker_sparql_builder_predicate (sparql, "nfo:fileLastModified");
+	tracker_sparql_builder_object_variable (sparql, "lastmodified");
+	tracker_sparql_builder_delete_close (sparql);
+	tracker_sparql_builder_where_open (sparql);
+	tracker_sparql_builder_subject_iri (sparql, urn);
+	tracker_sparql_builder_predicate (sparql, "nfo:fileLastModified");
+	tracker_sparql_builder_object_variable (sparql, "lastmodified");
+	tracker_sparql_builder_where_close (sparql);
+	tracker_sparql_builder_insert_open (sparql, NULL);
+	tracker_sparql_builder_graph_open (sparql, TRACKER_OWN_GRAPH_URN);
+	tracker_sparql_builder_subject_iri (sparql, urn);
+	time_ = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	tracker_sparql_builder_predicate (sparql, "nfo:fileLastModified");
+	tracker_sparql_builder_object_date (sparql, (time_t *) &time_);
+	tracker_sparql_builder_graph_close (sparql);
+	tracker_sparql_builder_insert_close (sparql);
+
+	/* Update nfo:fileLastAccessed */
+	tracker_sparql_builder_delete_open (sparql, NULL);
+	tracker_sparql_builder_subject_iri (sparql, urn);
+	tracker_sparql_builder_predicate (sparql, "nfo:fileLastAccessed");
+	tracker_sparql_builder_object_variable (sparql, "lastaccessed");
+	tracker_sparql_builder_delete_close (sparql);
+	tracker_sparql_builder_where_open (sparql);
+	tracker_sparql_builder_subject_iri (sparql, urn);
+	tracker_sparql_builder_predicate (sparql, "nfo:fileLastAccessed");
+	tracker_sparql_builder_object_variable (sparql, "lastaccessed");
+	tracker_sparql_builder_where_close (sparql);
+	tracker_sparql_builder_insert_open (sparql, NULL);
+	tracker_sparql_builder_graph_open (sparql, TRACKER_OWN_GRAPH_URN);
+	tracker_sparql_builder_subject_iri (sparql, urn);
+	time_ = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_ACCESS);
+	tracker_sparql_builder_predicate (sparql, "nfo:fileLastAccessed");
+	tracker_sparql_builder_object_date (sparql, (time_t *) &time_);
+	tracker_sparql_builder_graph_close (sparql);
+	tracker_sparql_builder_insert_close (sparql);
+}
+
 static void
 process_file_data_free (ProcessFileData *data)
 {
@@ -2005,7 +2055,9 @@ process_file_data_free (ProcessFileData *data)
 	g_object_unref (data->sparql);
 	g_object_unref (data->cancellable);
 	g_object_unref (data->file);
+	g_clear_object (&data->file_info);
 	g_free (data->mime_type);
+	g_free (data->fingerprint);
 	g_slice_free (ProcessFileData, data);
 }
 
@@ -2095,38 +2147,23 @@ sparql_builder_finish (ProcessFileData *data,
 }
 
 static void
-process_file_cb (GObject      *object,
-                 GAsyncResult *result,
-                 gpointer      user_data)
+process_file_add_metadata (ProcessFileData *data)
 {
 	TrackerMinerFilesPrivate *priv;
 	TrackerSparqlBuilder *sparql;
-	ProcessFileData *data;
 	const gchar *mime_type, *urn, *parent_urn;
 	GFileInfo *file_info;
 	guint64 time_;
 	GFile *file;
 	gchar *uri;
-	GError *error = NULL;
 	gboolean is_iri;
 	gboolean is_directory;
 
-	data = user_data;
-	file = G_FILE (object);
+	file = data->file;
+	file_info = data->file_info;
 	sparql = data->sparql;
-	file_info = g_file_query_info_finish (file, result, &error);
 	priv = TRACKER_MINER_FILES (data->miner)->private;
 
-	if (error) {
-		/* Something bad happened, notify about the error */
-		tracker_miner_fs_file_notify (TRACKER_MINER_FS (data->miner), file, error);
-		priv->extraction_queue = g_list_remove (priv->extraction_queue, data);
-		process_file_data_free (data);
-		g_error_free (error);
-
-		return;
-	}
-
 	uri = g_file_get_uri (file);
 	mime_type = g_file_info_get_content_type (file_info);
 	urn = miner_files_get_file_urn (TRACKER_MINER_FILES (data->miner), file, &is_iri);
@@ -2198,10 +2235,177 @@ process_file_cb (GObject      *object,
 	priv->extraction_queue = g_list_remove (priv->extraction_queue, data);
 	process_file_data_free (data);
 
-	g_object_unref (file_info);
 	g_free (uri);
 }
 
+static void
+process_file_unchanged (ProcessFileData *data)
+{
+	TrackerMinerFilesPrivate *priv;
+	const gchar *urn;
+	gboolean is_iri;
+	gchar *uri;
+
+	priv = TRACKER_MINER_FILES (data->miner)->private;
+	urn = miner_files_get_file_urn (data->miner, data->file, &is_iri);
+
+	uri = g_file_get_uri (data->file);
+	g_debug ("Contents of '%s' are unchanged, updating attributes only", uri);
+	g_free (uri);
+
+	sparql_builder_update_file_times (data->sparql, urn, data->file_info);
+	tracker_miner_fs_file_notify_unchanged (TRACKER_MINER_FS (data->miner), data->file);
+
+	priv->extraction_queue = g_list_remove (priv->extraction_queue, data);
+	process_file_data_free (data);
+}
+
+static void
+fingerprint_compute_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+	GError *error = NULL;
+	gchar *fingerprint;
+
+	fingerprint = tracker_file_get_content_fingerprint (task_data, cancellable, &error);
+
+	if (error) {
+		g_task_return_error (task, error);
+	} else {
+		g_task_return_pointer (task, fingerprint, g_free);
+	}
+}
+
+static void
+fingerprint_compute_cb (GObject      *object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+	ProcessFileData *data = user_data;
+	GError *error = NULL;
+	gchar *fingerprint;
+
+	fingerprint = g_task_propagate_pointer (G_TASK (result), &error);
+
+	if (error) {
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			TrackerMinerFilesPrivate *priv;
+
+			priv = TRACKER_MINER_FILES (data->miner)->private;
+			tracker_miner_fs_file_notify (TRACKER_MINER_FS (data->miner), data->file, error);
+			priv->extraction_queue = g_list_remove (priv->extraction_queue, data);
+			process_file_data_free (data);
+			g_error_free (error);
+			return;
+		}
+
+		g_error_free (error);
+	}
+
+	if (g_strcmp0 (fingerprint, data->fingerprint) == 0) {
+		process_file_unchanged (data);
+	} else {
+		process_file_add_metadata (data);
+	}
+
+	g_free (fingerprint);
+}
+
+static void
+fingerprint_query_cb (GObject      *object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+	TrackerSparqlCursor *cursor;
+	ProcessFileData *data = user_data;
+	GError *error = NULL;
+	GTask *task;
+
+	cursor = tracker_sparql_connection_query_finish (TRACKER_SPARQL_CONNECTION (object),
+	                                                 result, &error);
+
+	if (cursor && tracker_sparql_cursor_next (cursor, NULL, &error)) {
+		data->fingerprint = g_strdup (tracker_sparql_cursor_get_string (cursor, 0, NULL));
+	}
+
+	if (error) {
+		g_message ("Could not query content fingerprint: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_clear_object (&cursor);
+
+	if (!data->fingerprint) {
+		/* Nothing to compare with, index as usual */
+		process_file_add_metadata (data);
+		return;
+	}
+
+	task = g_task_new (data->miner, data->cancellable,
+	                   fingerprint_compute_cb, data);
+	g_task_set_task_data (task, g_object_ref (data->file), g_object_unref);
+	g_task_run_in_thread (task, fingerprint_compute_thread);
+	g_object_unref (task);
+}
+
+static void
+process_file_cb (GObject      *object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+	TrackerMinerFilesPrivate *priv;
+	ProcessFileData *data;
+	GFileInfo *file_info;
+	const gchar *urn;
+	GFile *file;
+	GError *error = NULL;
+	gboolean is_iri;
+
+	data = user_data;
+	file = G_FILE (object);
+	file_info = g_file_query_info_finish (file, result, &error);
+	priv = TRACKER_MINER_FILES (data->miner)->private;
+
+	if (error) {
+		/* Something bad happened, notify about the error */
+		tracker_miner_fs_file_notify (TRACKER_MINER_FS (data->miner), file, error);
+		priv->extraction_queue = g_list_remove (priv->extraction_queue, data);
+		process_file_data_free (data);
+		g_error_free (error);
+
+		return;
+	}
+
+	data->file_info = file_info;
+	urn = miner_files_get_file_urn (TRACKER_MINER_FILES (data->miner), file, &is_iri);
+
+	if (is_iri &&
+	    g_file_info_get_file_type (file_info) == G_FILE_TYPE_REGULAR) {
+		gchar *query;
+
+		/* The file is already known, if tracker-extract left a
+		 * fingerprint of its contents and that still matches,
+		 * this was an mtime-only change, so there's no need to
+		 * drop the extracted metadata and have it extracted
+		 * and FTS indexed again.
+		 */
+		query = g_strdup_printf ("SELECT ?fingerprint { "
+		                         "  <%s> tracker:contentFingerprint ?fingerprint "
+		                         "}", urn);
+		tracker_sparql_connection_query_async (tracker_miner_get_connection (TRACKER_MINER (data->miner)),
+		                                       query,
+		                                       data->cancellable,
+		                                       fingerprint_query_cb,
+		                                       data);
+		g_free (query);
+		return;
+	}
+
+	process_file_add_metadata (data);
+}
+
 static gboolean
 miner_files_process_file (TrackerMinerFS       *fs,
                           GFile                *file,
@@ -2248,7 +2452,6 @@ process_file_attributes_cb (GObject      *object,
 	ProcessFileData *data;
 	const gchar *urn;
 	GFileInfo *file_info;
-	guint64 time_;
 	GFile *file;
 	gchar *uri;
 	GError *error = NULL;
@@ -2282,45 +2485,7 @@ process_file_attributes_cb (GObject      *object,
 		return;
 	}
 
-	/* Update nfo:fileLastModified */
-	tracker_sparql_builder_delete_open (sparql, NULL);
-	tracker_sparql_builder_subject_iri (sparql, urn);
-	tracker_sparql_builder_predicate (sparql, "nfo:fileLastModified");
-	tracker_sparql_builder_object_variable (sparql, "lastmodified");
-	tracker_sparql_builder_delete_close (sparql);
-	tracker_sparql_builder_where_open (sparql);
-	tracker_sparql_builder_subject_iri (sparql, urn);
-	tracker_sparql_builder_predicate (sparql, "nfo:fileLastModified");
-	tracker_sparql_builder_object_variable (sparql, "lastmodified");
-	tracker_sparql_builder_where_close (sparql);
-	tracker_sparql_builder_insert_open (sparql, NULL);
-	tracker_sparql_builder_graph_open (sparql, TRACKER_OWN_GRAPH_URN);
-	tracker_sparql_builder_subject_iri (sparql, urn);
-	time_ = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
-	tracker_sparql_builder_predicate (sparql, "nfo:fileLastModified");
-	tracker_sparql_builder_object_date (sparql, (time_t *) &time_);
-	tracker_sparql_builder_graph_close (sparql);
-	tracker_sparql_builder_insert_close (sparql);
-
-	/* Update nfo:fileLastAccessed */
-	tracker_sparql_builder_delete_open (sparql, NULL);
-	tracker_sparql_builder_subject_iri (sparql, urn);
-	tracker_sparql_builder_predicate (sparql, "nfo:fileLastAccessed");
-	tracker_sparql_builder_object_variable (sparql, "lastaccessed");
-	tracker_sparql_builder_delete_close (sparql);
-	tracker_sparql_builder_where_open (sparql);
-	tracker_sparql_builder_subject_iri (sparql, urn);
-	tracker_sparql_builder_predicate (sparql, "nfo:fileLastAccessed");
-	tracker_sparql_builder_object_variable (sparql, "lastaccessed");
-	tracker_sparql_builder_where_close (sparql);
-	tracker_sparql_builder_insert_open (sparql, NULL);
-	tracker_sparql_builder_graph_open (sparql, TRACKER_OWN_GRAPH_URN);
-	tracker_sparql_builder_subject_iri (sparql, urn);
-	time_ = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_ACCESS);
-	tracker_sparql_builder_predicate (sparql, "nfo:fileLastAccessed");
-	tracker_sparql_builder_object_date (sparql, (time_t *) &time_);
-	tracker_sparql_builder_graph_close (sparql);
-	tracker_sparql_builder_insert_close (sparql);
+	sparql_builder_update_file_times (sparql, urn, file_info);
 
 	g_object_unref (file_info);
 	g_free (uri);
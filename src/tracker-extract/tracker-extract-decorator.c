@@ -25,6 +25,7 @@
 #include "tracker-extract-decorator.h"
 #include "tracker-extract-persistence.h"
 #include "tracker-extract-priority-dbus.h"
+#include "tracker-extract-statistics-dbus.h"
 
 enum {
 	PROP_EXTRACTOR = 1
@@ -56,6 +57,7 @@ struct _TrackerExtractDecoratorPrivate {
 	/* DBus name -> AppData */
 	GHashTable *apps;
 	TrackerExtractDBusPriority *iface;
+	TrackerExtractDBusStatistics *statistics_iface;
 };
 
 typedef struct {
@@ -134,6 +136,7 @@ tracker_extract_decorator_finalize (GObject *object)
 		g_timer_destroy (priv->timer);
 
 	g_object_unref (priv->iface);
+	g_object_unref (priv->statistics_iface);
 	g_hash_table_unref (priv->apps);
 	g_hash_table_unref (priv->recovery_files);
 
@@ -152,6 +155,17 @@ decorator_save_info (TrackerSparqlBuilder    *sparql,
 
 	urn = tracker_decorator_info_get_urn (decorator_info);
 
+	/* Add the preupdate chunk first, prepending it afterwards would
+	 * move around the whole update, which may contain long texts.
+	 */
+	builder = tracker_extract_info_get_preupdate_builder (info);
+	result = tracker_sparql_builder_get_result (builder);
+
+	if (result && *result) {
+		tracker_sparql_builder_append (sparql, result);
+		tracker_sparql_builder_append (sparql, "\n");
+	}
+
 	tracker_sparql_builder_insert_open (sparql, NULL);
 	tracker_sparql_builder_graph_open (sparql, TRACKER_OWN_GRAPH_URN);
 
@@ -182,13 +196,7 @@ decorator_save_info (TrackerSparqlBuilder    *sparql,
 		tracker_sparql_builder_where_close (sparql);
 	}
 
-	/* Prepend/append pre/postupdate chunks */
-	builder = tracker_extract_info_get_preupdate_builder (info);
-	result = tracker_sparql_builder_get_result (builder);
-
-	if (result && *result)
-		tracker_sparql_builder_prepend (sparql, result);
-
+	/* Append postupdate chunk */
 	builder = tracker_extract_info_get_postupdate_builder (info);
 	result = tracker_sparql_builder_get_result (builder);
 
@@ -540,6 +548,24 @@ handle_clear_rdf_types_cb (TrackerExtractDBusPriority *iface,
 	return TRUE;
 }
 
+static gboolean
+handle_get_statistics_cb (TrackerExtractDBusStatistics *iface,
+                          GDBusMethodInvocation        *invocation,
+                          TrackerExtractDecorator      *decorator)
+{
+	TrackerExtractDecoratorPrivate *priv;
+	GVariant *modules;
+	gint unhandled;
+
+	priv = TRACKER_EXTRACT_DECORATOR (decorator)->priv;
+	modules = tracker_extract_get_statistics (priv->extractor, &unhandled);
+
+	tracker_extract_dbus_statistics_complete_get_statistics (iface, invocation,
+	                                                         modules, unhandled);
+
+	return TRUE;
+}
+
 static void
 tracker_extract_decorator_class_init (TrackerExtractDecoratorClass *klass)
 {
@@ -655,6 +681,11 @@ tracker_extract_decorator_initable_init (GInitable     *initable,
 	tracker_extract_dbus_priority_set_supported_rdf_types (priv->iface,
 	                                                       supported_classes);
 
+	priv->statistics_iface = tracker_extract_dbus_statistics_skeleton_new ();
+	g_signal_connect (priv->statistics_iface, "handle-get-statistics",
+	                  G_CALLBACK (handle_get_statistics_cb),
+	                  decorator);
+
 	conn = g_bus_get_sync (TRACKER_IPC_BUS, NULL, error);
 	if (conn == NULL) {
 		ret = FALSE;
@@ -669,6 +700,14 @@ tracker_extract_decorator_initable_init (GInitable     *initable,
 		goto out;
 	}
 
+	if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (priv->statistics_iface),
+	                                       conn,
+	                                       "/org/freedesktop/Tracker1/Extract/Statistics",
+	                                       error)) {
+		ret = FALSE;
+		goto out;
+	}
+
 	/* Chainup to parent's init last, to have a chance to export our
 	 * DBus interface before RequestName returns. Otherwise our iface
 	 * won't be ready by the time the tracker-extract appear on the bus. */
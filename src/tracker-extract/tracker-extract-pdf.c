@@ -193,32 +193,163 @@ read_outline (PopplerDocument      *document,
 	}
 }
 
+/* Pages are handed out to extraction threads in chunks of this size */
+#define PAGES_PER_CHUNK 8
+
+typedef struct {
+	gchar *contents;
+	gsize len;
+	gint n_pages;
+	gsize n_bytes;
+	gint64 deadline;
+
+	/* Everything below is protected by the mutex */
+	GMutex mutex;
+	gint next_page;
+	gchar **page_texts;
+	gboolean *pages_done;
+	gint n_pages_in_order;
+	gsize bytes_in_order;
+	gboolean stop;
+} ContentExtraction;
+
+static void
+extract_content_pages (ContentExtraction *ce,
+                       PopplerDocument   *document)
+{
+	gboolean stop = FALSE;
+
+	while (!stop) {
+		gint first, last, i;
+
+		g_mutex_lock (&ce->mutex);
+
+		if (ce->next_page >= ce->n_pages ||
+		    g_get_monotonic_time () >= ce->deadline) {
+			ce->stop = TRUE;
+		}
+
+		stop = ce->stop;
+		first = ce->next_page;
+		last = MIN (first + PAGES_PER_CHUNK, ce->n_pages);
+		ce->next_page = last;
+
+		g_mutex_unlock (&ce->mutex);
+
+		for (i = first; !stop && i < last; i++) {
+			PopplerPage *page;
+			gchar *text;
+
+			page = poppler_document_get_page (document, i);
+			text = poppler_page_get_text (page);
+			g_object_unref (page);
+
+			g_mutex_lock (&ce->mutex);
+
+			ce->page_texts[i] = text;
+			ce->pages_done[i] = TRUE;
+
+			/* Only pages with all their predecessors extracted
+			 * count towards the limit, so we never stop before
+			 * the first n_bytes of the document are available.
+			 */
+			while (ce->n_pages_in_order < ce->n_pages &&
+			       ce->pages_done[ce->n_pages_in_order]) {
+				text = ce->page_texts[ce->n_pages_in_order];
+				ce->bytes_in_order += text ? strlen (text) : 0;
+				ce->n_pages_in_order++;
+			}
+
+			if (ce->bytes_in_order >= ce->n_bytes) {
+				ce->stop = TRUE;
+			}
+
+			stop = ce->stop;
+
+			g_mutex_unlock (&ce->mutex);
+		}
+	}
+}
+
+static gpointer
+extract_content_thread (gpointer user_data)
+{
+	ContentExtraction *ce = user_data;
+	PopplerDocument *document;
+
+	/* Poppler documents can't be shared across threads,
+	 * each thread parses its own from the mapped file.
+	 */
+	document = poppler_document_new_from_data (ce->contents, ce->len, NULL, NULL);
+
+	if (document) {
+		extract_content_pages (ce, document);
+		g_object_unref (document);
+	}
+
+	return NULL;
+}
+
 static gchar *
 extract_content_text (PopplerDocument *document,
+                      gchar           *contents,
+                      gsize            len,
                       gsize            n_bytes)
 {
+	ContentExtraction ce = { 0 };
+	GPtrArray *threads;
 	GString *string;
 	GTimer *timer;
 	gsize remaining_bytes;
-	gint n_pages, i;
-	gdouble elapsed;
+	gint n_threads, i;
+
+	ce.contents = contents;
+	ce.len = len;
+	ce.n_pages = poppler_document_get_n_pages (document);
+	ce.n_bytes = n_bytes;
+	ce.deadline = g_get_monotonic_time () + EXTRACTION_PROCESS_TIMEOUT * G_USEC_PER_SEC;
+	ce.page_texts = g_new0 (gchar *, ce.n_pages);
+	ce.pages_done = g_new0 (gboolean, ce.n_pages);
+	g_mutex_init (&ce.mutex);
 
-	n_pages = poppler_document_get_n_pages (document);
 	string = g_string_new ("");
 	timer = g_timer_new ();
 
-	for (i = 0, remaining_bytes = n_bytes, elapsed = g_timer_elapsed (timer, NULL);
-	     i < n_pages && remaining_bytes > 0 && elapsed < EXTRACTION_PROCESS_TIMEOUT;
-	     i++, elapsed = g_timer_elapsed (timer, NULL)) {
-		PopplerPage *page;
+	n_threads = MIN ((gint) g_get_num_processors (),
+	                 (ce.n_pages + PAGES_PER_CHUNK - 1) / PAGES_PER_CHUNK);
+	threads = g_ptr_array_new ();
+
+	/* The calling thread extracts pages too, using the
+	 * document we already have.
+	 */
+	for (i = 1; i < n_threads; i++) {
+		g_ptr_array_add (threads,
+		                 g_thread_new ("tracker-extract-pdf",
+		                               extract_content_thread,
+		                               &ce));
+	}
+
+	extract_content_pages (&ce, document);
+
+	for (i = 0; i < (gint) threads->len; i++) {
+		g_thread_join (g_ptr_array_index (threads, i));
+	}
+
+	g_ptr_array_free (threads, TRUE);
+
+	if (g_get_monotonic_time () >= ce.deadline) {
+		g_debug ("Extraction timed out, %d seconds reached", EXTRACTION_PROCESS_TIMEOUT);
+	}
+
+	for (i = 0, remaining_bytes = n_bytes;
+	     i < ce.n_pages_in_order && remaining_bytes > 0;
+	     i++) {
 		gsize written_bytes = 0;
 		gchar *text;
 
-		page = poppler_document_get_page (document, i);
-		text = poppler_page_get_text (page);
+		text = ce.page_texts[i];
 
 		if (!text) {
-			g_object_unref (page);
 			continue;
 		}
 
@@ -234,22 +365,23 @@ extract_content_text (PopplerDocument *document,
 		g_debug ("Extracted %" G_GSIZE_FORMAT " bytes from page %d, "
 		         "%" G_GSIZE_FORMAT " bytes remaining",
 		         written_bytes, i, remaining_bytes);
-
-		g_free (text);
-		g_object_unref (page);
-	}
-
-	if (elapsed >= EXTRACTION_PROCESS_TIMEOUT) {
-		g_debug ("Extraction timed out, %d seconds reached", EXTRACTION_PROCESS_TIMEOUT);
 	}
 
-	g_debug ("Content extraction finished: %d/%d pages indexed in %2.2f seconds, "
-	         "%" G_GSIZE_FORMAT " bytes extracted",
+	g_debug ("Content extraction finished: %d/%d pages indexed in %2.2f seconds "
+	         "using %d threads, %" G_GSIZE_FORMAT " bytes extracted",
 	         i,
-	         n_pages,
+	         ce.n_pages,
 	         g_timer_elapsed (timer, NULL),
+	         MAX (n_threads, 1),
 	         (n_bytes - remaining_bytes));
 
+	for (i = 0; i < ce.n_pages; i++) {
+		g_free (ce.page_texts[i]);
+	}
+
+	g_free (ce.page_texts);
+	g_free (ce.pages_done);
+	g_mutex_clear (&ce.mutex);
 	g_timer_destroy (timer);
 
 	return g_string_free (string, FALSE);
@@ -735,7 +867,7 @@ tracker_extract_get_metadata (TrackerExtractInfo *info)
 
 	config = tracker_main_get_config ();
 	n_bytes = tracker_config_get_max_bytes (config);
-	content = extract_content_text (document, n_bytes);
+	content = extract_content_text (document, contents, len, n_bytes);
 
 	if (content) {
 		tracker_sparql_builder_predicate (metadata, "nie:plainTextContent");
@@ -20,10 +20,13 @@
 #include "config.h"
 
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/resource.h>
 
 #include <gmodule.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 
 #include <gio/gunixoutputstream.h>
@@ -45,9 +48,24 @@
 
 extern gboolean debug;
 
+/* Upper limits (in milliseconds) of the extraction latency
+ * histogram buckets, the last bucket holds everything above.
+ */
+static const guint latency_buckets[] = { 10, 50, 100, 500, 1000, 5000, 10000 };
+
+#define N_LATENCY_BUCKETS (G_N_ELEMENTS (latency_buckets) + 1)
+
 typedef struct {
 	gint extracted_count;
 	gint failed_count;
+	gint cancelled_count;
+
+	/* Accumulated over every call into the module */
+	guint64 bytes_read;
+	gdouble wall_time;
+	gdouble cpu_time;
+	glong peak_rss_delta;
+	guint latency_histogram[N_LATENCY_BUCKETS];
 } StatisticsData;
 
 typedef struct {
@@ -95,6 +113,7 @@ typedef struct {
 
 	guint signal_id;
 	guint success : 1;
+	guint cancelled : 1;
 } TrackerExtractTask;
 
 static void tracker_extract_finalize (GObject *object);
@@ -204,10 +223,17 @@ report_statistics (GObject *object)
 			name = g_module_name (module);
 			name_without_path = strrchr (name, G_DIR_SEPARATOR) + 1;
 
-			g_message ("    Module:'%s', extracted:%d, failures:%d",
+			g_message ("    Module:'%s', extracted:%d, failures:%d, cancelled:%d, "
+			           "read:%" G_GUINT64_FORMAT " bytes, wall:%.2fs, cpu:%.2fs, "
+			           "peak RSS delta:%ld KiB",
 			           name_without_path,
 			           data->extracted_count,
-			           data->failed_count);
+			           data->failed_count,
+			           data->cancelled_count,
+			           data->bytes_read,
+			           data->wall_time,
+			           data->cpu_time,
+			           data->peak_rss_delta);
 		}
 	}
 
@@ -245,6 +271,96 @@ tracker_extract_new (gboolean     disable_shutdown,
 	return object;
 }
 
+/* Must be called with the task mutex held */
+static StatisticsData *
+statistics_data_lookup (TrackerExtractPrivate *priv,
+                        GModule               *module)
+{
+	StatisticsData *stats_data;
+
+	stats_data = g_hash_table_lookup (priv->statistics_data, module);
+
+	if (!stats_data) {
+		stats_data = g_slice_new0 (StatisticsData);
+		g_hash_table_insert (priv->statistics_data, module, stats_data);
+	}
+
+	return stats_data;
+}
+
+static gdouble
+get_thread_cpu_time (void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+		return ts.tv_sec + (ts.tv_nsec / 1e9);
+	}
+#endif
+
+	return 0;
+}
+
+static glong
+get_max_rss (void)
+{
+	struct rusage usage;
+
+	/* Peak resident set size of the whole process in KiB, the
+	 * growth over a module call is an upper bound of its peak
+	 * memory usage (and exact if nothing else runs concurrently).
+	 */
+	if (getrusage (RUSAGE_SELF, &usage) == 0) {
+		return usage.ru_maxrss;
+	}
+
+	return 0;
+}
+
+static void
+statistics_record_call (TrackerExtract *extract,
+                        GModule        *module,
+                        GFile          *file,
+                        gdouble         wall_time,
+                        gdouble         cpu_time,
+                        glong           rss_delta)
+{
+	TrackerExtractPrivate *priv;
+	StatisticsData *stats_data;
+	GStatBuf st;
+	gchar *path;
+	guint64 size = 0;
+	guint i;
+
+	priv = TRACKER_EXTRACT_GET_PRIVATE (extract);
+
+	path = g_file_get_path (file);
+
+	if (path && g_stat (path, &st) == 0) {
+		size = st.st_size;
+	}
+
+	g_free (path);
+
+	for (i = 0; i < G_N_ELEMENTS (latency_buckets); i++) {
+		if (wall_time * 1000 < latency_buckets[i]) {
+			break;
+		}
+	}
+
+	g_mutex_lock (&priv->task_mutex);
+
+	stats_data = statistics_data_lookup (priv, module);
+	stats_data->bytes_read += size;
+	stats_data->wall_time += wall_time;
+	stats_data->cpu_time += cpu_time;
+	stats_data->peak_rss_delta = MAX (stats_data->peak_rss_delta, rss_delta);
+	stats_data->latency_histogram[i]++;
+
+	g_mutex_unlock (&priv->task_mutex);
+}
+
 static void
 notify_task_finish (TrackerExtractTask *task,
                     gboolean            success)
@@ -262,19 +378,12 @@ notify_task_finish (TrackerExtractTask *task,
 	g_mutex_lock (&priv->task_mutex);
 
 	if (task->cur_module) {
-		stats_data = g_hash_table_lookup (priv->statistics_data,
-						  task->cur_module);
-
-		if (!stats_data) {
-			stats_data = g_slice_new0 (StatisticsData);
-			g_hash_table_insert (priv->statistics_data,
-					     task->cur_module,
-					     stats_data);
-		}
-
+		stats_data = statistics_data_lookup (priv, task->cur_module);
 		stats_data->extracted_count++;
 
-		if (!success) {
+		if (task->cancelled) {
+			stats_data->cancelled_count++;
+		} else if (!success) {
 			stats_data->failed_count++;
 		}
 	} else {
@@ -286,6 +395,26 @@ notify_task_finish (TrackerExtractTask *task,
 	g_mutex_unlock (&priv->task_mutex);
 }
 
+static gchar *
+get_content_fingerprint (GFile *file)
+{
+	GError *error = NULL;
+	gchar *fingerprint;
+
+	/* Lets the miner tell content changes apart from mere
+	 * mtime changes, so unchanged files are not extracted
+	 * (and FTS indexed) all over again.
+	 */
+	fingerprint = tracker_file_get_content_fingerprint (file, NULL, &error);
+
+	if (error) {
+		g_debug ("Could not fingerprint file contents: %s", error->message);
+		g_error_free (error);
+	}
+
+	return fingerprint;
+}
+
 static gboolean
 get_file_metadata (TrackerExtractTask  *task,
                    TrackerExtractInfo **info_out)
@@ -319,18 +448,47 @@ get_file_metadata (TrackerExtractTask  *task,
 	if (mime_used) {
 		if (task->cur_func) {
 			TrackerSparqlBuilder *statements;
+			gchar *fingerprint;
+			gdouble cpu_time;
+			gint64 wall_time;
+			glong max_rss;
 
 			g_debug ("Using %s...", g_module_name (task->cur_module));
 
+			/* Taken before extracting, so a file changing
+			 * meanwhile doesn't look unchanged afterwards. For
+			 * the files small enough to be fingerprinted, the
+			 * module then reads them from the page cache.
+			 */
+			fingerprint = get_content_fingerprint (tracker_extract_info_get_file (info));
+
+			wall_time = g_get_monotonic_time ();
+			cpu_time = get_thread_cpu_time ();
+			max_rss = get_max_rss ();
+
 			(task->cur_func) (info);
 
+			statistics_record_call (task->extract,
+			                        task->cur_module,
+			                        tracker_extract_info_get_file (info),
+			                        (gdouble) (g_get_monotonic_time () - wall_time) / G_USEC_PER_SEC,
+			                        get_thread_cpu_time () - cpu_time,
+			                        get_max_rss () - max_rss);
+
 			statements = tracker_extract_info_get_metadata_builder (info);
 			items = tracker_sparql_builder_get_length (statements);
 
 			if (items > 0) {
+				if (fingerprint) {
+					tracker_sparql_builder_predicate (statements, "tracker:contentFingerprint");
+					tracker_sparql_builder_object_string (statements, fingerprint);
+				}
+
 				tracker_sparql_builder_insert_close (statements);
 				task->success = TRUE;
 			}
+
+			g_free (fingerprint);
 		}
 
 		g_free (mime_used);
@@ -511,6 +669,7 @@ get_metadata (TrackerExtractTask *task)
 
 	if (task->cancellable &&
 	    g_cancellable_is_cancelled (task->cancellable)) {
+		task->cancelled = TRUE;
 		g_simple_async_result_set_error ((GSimpleAsyncResult *) task->res,
 		                                 TRACKER_DBUS_ERROR, 0,
 		                                 "Extraction of '%s' was cancelled",
@@ -745,6 +904,76 @@ tracker_extract_file (TrackerExtract      *extract,
 	g_object_unref (res);
 }
 
+GVariant *
+tracker_extract_get_statistics (TrackerExtract *extract,
+                                gint           *unhandled_count)
+{
+	TrackerExtractPrivate *priv;
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_return_val_if_fail (TRACKER_IS_EXTRACT (extract), NULL);
+
+	priv = TRACKER_EXTRACT_GET_PRIVATE (extract);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+
+	g_mutex_lock (&priv->task_mutex);
+
+	g_hash_table_iter_init (&iter, priv->statistics_data);
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		StatisticsData *data = value;
+		GVariantBuilder histogram;
+		gchar *name;
+		guint i;
+
+		g_variant_builder_init (&histogram, G_VARIANT_TYPE ("a(uu)"));
+
+		for (i = 0; i < N_LATENCY_BUCKETS; i++) {
+			g_variant_builder_add (&histogram, "(uu)",
+			                       i < G_N_ELEMENTS (latency_buckets) ?
+			                       latency_buckets[i] : G_MAXUINT,
+			                       data->latency_histogram[i]);
+		}
+
+		name = g_path_get_basename (g_module_name (key));
+
+		g_variant_builder_open (&builder, G_VARIANT_TYPE ("{sa{sv}}"));
+		g_variant_builder_add (&builder, "s", name);
+		g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
+		g_variant_builder_add (&builder, "{sv}", "extracted",
+		                       g_variant_new_int32 (data->extracted_count));
+		g_variant_builder_add (&builder, "{sv}", "failed",
+		                       g_variant_new_int32 (data->failed_count));
+		g_variant_builder_add (&builder, "{sv}", "cancelled",
+		                       g_variant_new_int32 (data->cancelled_count));
+		g_variant_builder_add (&builder, "{sv}", "bytes-read",
+		                       g_variant_new_uint64 (data->bytes_read));
+		g_variant_builder_add (&builder, "{sv}", "wall-time",
+		                       g_variant_new_double (data->wall_time));
+		g_variant_builder_add (&builder, "{sv}", "cpu-time",
+		                       g_variant_new_double (data->cpu_time));
+		g_variant_builder_add (&builder, "{sv}", "peak-rss-delta",
+		                       g_variant_new_int64 (data->peak_rss_delta));
+		g_variant_builder_add (&builder, "{sv}", "latency-histogram",
+		                       g_variant_builder_end (&histogram));
+		g_variant_builder_close (&builder);
+		g_variant_builder_close (&builder);
+
+		g_free (name);
+	}
+
+	if (unhandled_count) {
+		*unhandled_count = priv->unhandled_count;
+	}
+
+	g_mutex_unlock (&priv->task_mutex);
+
+	return g_variant_builder_end (&builder);
+}
+
 #ifdef HAVE_LIBMEDIAART
 
 MediaArtProcess *
@@ -60,6 +60,9 @@ void            tracker_extract_file                    (TrackerExtract
                                                          GAsyncReadyCallback     cb,
                                                          gpointer                user_data);
 
+GVariant *      tracker_extract_get_statistics          (TrackerExtract         *extract,
+                                                         gint                   *unhandled_count);
+
 #ifdef HAVE_LIBMEDIAART
 MediaArtProcess *
                 tracker_extract_get_media_art_process   (TrackerExtract         *extract);
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <gio/gio.h>
@@ -92,6 +93,7 @@ static gboolean
 process_chunk (const gchar  *read_bytes,
                gsize         read_size,
                gsize         buffer_size,
+               gsize         size_hint,
                gsize        *remaining_size,
                GString     **s)
 {
@@ -152,10 +154,14 @@ process_chunk (const gchar  *read_bytes,
 	         read_size,
 	         *remaining_size);
 
+	/* Allocate the whole expected text upfront if known,
+	 * so it isn't reallocated and copied while growing.
+	 */
+	if (*s == NULL)
+		*s = g_string_sized_new (MAX (size_hint, read_size) + 1);
+
 	/* Append non-NIL terminated bytes */
-	*s = (*s ?
-	      g_string_append_len (*s, read_bytes, read_size) :
-	      g_string_new_len (read_bytes, read_size));
+	g_string_append_len (*s, read_bytes, read_size);
 
 	return TRUE;
 }
@@ -304,6 +310,7 @@ tracker_read_text_from_stream (GInputStream *stream,
 		if (!process_chunk (buf,
 		                    n_bytes_read,
 		                    BUFFER_SIZE,
+		                    0,
 		                    &n_bytes_remaining,
 		                    &s)) {
 			break;
@@ -335,9 +342,14 @@ tracker_read_text_from_fd (gint  fd,
 	FILE *fz;
 	GString *s = NULL;
 	gsize n_bytes_remaining = max_bytes;
+	gsize size_hint = 0;
+	struct stat st;
 
 	g_return_val_if_fail (max_bytes > 0, NULL);
 
+	if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode))
+		size_hint = MIN ((gsize) st.st_size, max_bytes);
+
 	if ((fz = fdopen (fd, "r")) == NULL) {
 		g_warning ("Cannot read from FD... could not extract text");
 		close (fd);
@@ -366,6 +378,7 @@ tracker_read_text_from_fd (gint  fd,
 		if (!process_chunk (buf,
 		                    n_bytes_read,
 		                    BUFFER_SIZE,
+		                    size_hint,
 		                    &n_bytes_remaining,
 		                    &s)) {
 			break;
@@ -85,6 +85,7 @@ public class Tracker.Backup : Object {
 			var busy_callback = notifier.get_callback ();
 
 			Data.backup_restore (journal, null, busy_callback);
+			Tracker.QueryCache.clear ();
 
 			request.end ();
 		} catch (Error e) {
@@ -37,6 +37,8 @@
 #define CONFIG_PATH   "/org/freedesktop/tracker/store/"
 
 #define GRAPHUPDATED_DELAY_DEFAULT	1000
+#define FTS_INDEX_DELAY_DEFAULT	0
+#define QUERY_CACHE_SIZE_DEFAULT	0
 
 static void config_set_property         (GObject       *object,
                                          guint          param_id,
@@ -53,6 +55,9 @@ enum {
 	PROP_0,
 	PROP_VERBOSITY,
 	PROP_GRAPHUPDATED_DELAY,
+	PROP_FTS_INDEX_DELAY,
+	PROP_FTS_STRICT_FRESHNESS,
+	PROP_QUERY_CACHE_SIZE,
 };
 
 G_DEFINE_TYPE (TrackerConfig, tracker_config, G_TYPE_SETTINGS);
@@ -86,6 +91,33 @@ tracker_config_class_init (TrackerConfigClass *klass)
 	                                                    GRAPHUPDATED_DELAY_DEFAULT,
 	                                                    G_PARAM_READWRITE));
 
+	g_object_class_install_property (object_class,
+	                                 PROP_FTS_INDEX_DELAY,
+	                                 g_param_spec_int  ("fts-index-delay",
+	                                                    "FTS index delay",
+	                                                    "Maximum FTS index lag in ms, 0 to update it synchronously (0)",
+	                                                    0,
+	                                                    3600000,
+	                                                    FTS_INDEX_DELAY_DEFAULT,
+	                                                    G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_FTS_STRICT_FRESHNESS,
+	                                 g_param_spec_boolean ("fts-strict-freshness",
+	                                                       "FTS strict freshness",
+	                                                       "Catch up with the FTS index before fts:match queries",
+	                                                       TRUE,
+	                                                       G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_QUERY_CACHE_SIZE,
+	                                 g_param_spec_int  ("query-cache-size",
+	                                                    "Query cache size",
+	                                                    "Maximum number of cached query results, 0 to disable (0)",
+	                                                    0,
+	                                                    10000,
+	                                                    QUERY_CACHE_SIZE_DEFAULT,
+	                                                    G_PARAM_READWRITE));
 }
 
 static void
@@ -105,6 +137,21 @@ config_set_property (GObject      *object,
 		                                       g_value_get_int (value));
 		break;
 
+	case PROP_FTS_INDEX_DELAY:
+		tracker_config_set_fts_index_delay (TRACKER_CONFIG (object),
+		                                    g_value_get_int (value));
+		break;
+
+	case PROP_FTS_STRICT_FRESHNESS:
+		tracker_config_set_fts_strict_freshness (TRACKER_CONFIG (object),
+		                                         g_value_get_boolean (value));
+		break;
+
+	case PROP_QUERY_CACHE_SIZE:
+		tracker_config_set_query_cache_size (TRACKER_CONFIG (object),
+		                                     g_value_get_int (value));
+		break;
+
 	case PROP_VERBOSITY:
 		tracker_config_set_verbosity (TRACKER_CONFIG (object),
 		                              g_value_get_enum (value));
@@ -126,6 +173,18 @@ config_get_property (GObject    *object,
 		g_value_set_int (value, tracker_config_get_graphupdated_delay (TRACKER_CONFIG (object)));
 		break;
 
+	case PROP_FTS_INDEX_DELAY:
+		g_value_set_int (value, tracker_config_get_fts_index_delay (TRACKER_CONFIG (object)));
+		break;
+
+	case PROP_FTS_STRICT_FRESHNESS:
+		g_value_set_boolean (value, tracker_config_get_fts_strict_freshness (TRACKER_CONFIG (object)));
+		break;
+
+	case PROP_QUERY_CACHE_SIZE:
+		g_value_set_int (value, tracker_config_get_query_cache_size (TRACKER_CONFIG (object)));
+		break;
+
 		/* General */
 	case PROP_VERBOSITY:
 		g_value_set_enum (value, tracker_config_get_verbosity (TRACKER_CONFIG (object)));
@@ -179,6 +238,9 @@ config_constructed (GObject *object)
 	 */
 	g_settings_bind (settings, "verbosity", object, "verbosity", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 	g_settings_bind (settings, "graphupdated-delay", object, "graphupdated-delay", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "fts-index-delay", object, "fts-index-delay", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "fts-strict-freshness", object, "fts-strict-freshness", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "query-cache-size", object, "query-cache-size", G_SETTINGS_BIND_GET);
 }
 
 TrackerConfig *
@@ -259,3 +321,57 @@ tracker_config_set_graphupdated_delay (TrackerConfig *config,
 	g_settings_set_int(G_SETTINGS (config), "graphupdated-delay", value);
 	g_object_notify (G_OBJECT (config), "graphupdated-delay");
 }
+
+gint
+tracker_config_get_fts_index_delay (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), FTS_INDEX_DELAY_DEFAULT);
+
+	return g_settings_get_int (G_SETTINGS (config), "fts-index-delay");
+}
+
+void
+tracker_config_set_fts_index_delay (TrackerConfig *config,
+                                    gint           value)
+{
+	g_return_if_fail (TRACKER_IS_CONFIG (config));
+
+	g_settings_set_int (G_SETTINGS (config), "fts-index-delay", value);
+	g_object_notify (G_OBJECT (config), "fts-index-delay");
+}
+
+gboolean
+tracker_config_get_fts_strict_freshness (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), TRUE);
+
+	return g_settings_get_boolean (G_SETTINGS (config), "fts-strict-freshness");
+}
+
+void
+tracker_config_set_fts_strict_freshness (TrackerConfig *config,
+                                         gboolean       value)
+{
+	g_return_if_fail (TRACKER_IS_CONFIG (config));
+
+	g_settings_set_boolean (G_SETTINGS (config), "fts-strict-freshness", value);
+	g_object_notify (G_OBJECT (config), "fts-strict-freshness");
+}
+
+gint
+tracker_config_get_query_cache_size (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), QUERY_CACHE_SIZE_DEFAULT);
+
+	return g_settings_get_int (G_SETTINGS (config), "query-cache-size");
+}
+
+void
+tracker_config_set_query_cache_size (TrackerConfig *config,
+                                     gint           value)
+{
+	g_return_if_fail (TRACKER_IS_CONFIG (config));
+
+	g_settings_set_int (G_SETTINGS (config), "query-cache-size", value);
+	g_object_notify (G_OBJECT (config), "query-cache-size");
+}
@@ -56,6 +56,21 @@ gint           tracker_config_get_graphupdated_delay               (TrackerConfi
 void           tracker_config_set_graphupdated_delay               (TrackerConfig *config,
                                                                     gint           value);
 
+gint           tracker_config_get_fts_index_delay                  (TrackerConfig *config);
+
+void           tracker_config_set_fts_index_delay                  (TrackerConfig *config,
+                                                                    gint           value);
+
+gboolean       tracker_config_get_fts_strict_freshness             (TrackerConfig *config);
+
+void           tracker_config_set_fts_strict_freshness             (TrackerConfig *config,
+                                                                    gboolean       value);
+
+gint           tracker_config_get_query_cache_size                 (TrackerConfig *config);
+
+void           tracker_config_set_query_cache_size                 (TrackerConfig *config,
+                                                                    gint           value);
+
 G_END_DECLS
 
 #endif /* __TRACKER_STORE_CONFIG_H__ */
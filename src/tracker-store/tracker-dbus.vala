@@ -111,6 +111,7 @@ public class Tracker.DBus {
 		if (old_owner != "" && new_owner == "") {
 			/* This means that old_owner got removed */
 			resources.unreg_batches (old_owner);
+			resources.prune_subscriptions (old_owner);
 		}
 	}
 
@@ -234,6 +235,7 @@ public class Tracker.DBus {
 		}
 
 		resources.enable_signals ();
+		statistics.enable_signals ();
 
 		return true;
 	}
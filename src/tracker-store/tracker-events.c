@@ -70,6 +70,20 @@ tracker_events_add_insert (gint         graph_id,
 
 	for (i = 0; i < rdf_types->len; i++) {
 		if (tracker_class_get_notify (rdf_types->pdata[i])) {
+			/* Inserting back what was deleted within the
+			 * transaction leaves nothing to notify.
+			 */
+			if (tracker_class_remove_delete_event (rdf_types->pdata[i],
+			                                       graph_id,
+			                                       subject_id,
+			                                       pred_id,
+			                                       object_id)) {
+				if (private->total > 0) {
+					private->total--;
+				}
+				continue;
+			}
+
 			tracker_class_add_insert_event (rdf_types->pdata[i],
 			                                graph_id,
 			                                subject_id,
@@ -100,6 +114,20 @@ tracker_events_add_delete (gint         graph_id,
 
 	for (i = 0; i < rdf_types->len; i++) {
 		if (tracker_class_get_notify (rdf_types->pdata[i])) {
+			/* Deleting what was inserted within the
+			 * transaction leaves nothing to notify.
+			 */
+			if (tracker_class_remove_insert_event (rdf_types->pdata[i],
+			                                       graph_id,
+			                                       subject_id,
+			                                       pred_id,
+			                                       object_id)) {
+				if (private->total > 0) {
+					private->total--;
+				}
+				continue;
+			}
+
 			tracker_class_add_delete_event (rdf_types->pdata[i],
 			                                graph_id,
 			                                subject_id,
@@ -60,6 +60,9 @@ License which can be viewed at:
 		message ("Store options:");
 		message ("  Readonly mode  ........................  %s", readonly_mode ? "yes" : "no");
 		message ("  GraphUpdated Delay ....................  %d", config.graphupdated_delay);
+		message ("  FTS index delay .......................  %d", config.fts_index_delay);
+		message ("  FTS strict freshness ..................  %s", config.fts_strict_freshness ? "yes" : "no");
+		message ("  Query cache size ......................  %d", config.query_cache_size);
 	}
 
 	static void do_shutdown () {
@@ -106,6 +109,10 @@ License which can be viewed at:
 	}
 
 	static void initialize_signal_handler () {
+		// subscribers closing their pipe must not kill us,
+		// writes fail with EPIPE instead
+		Posix.signal (Posix.SIGPIPE, Posix.SIG_IGN);
+
 		Unix.signal_add (Posix.SIGTERM, () => signal_handler (Posix.SIGTERM));
 		Unix.signal_add (Posix.SIGINT, () => signal_handler (Posix.SIGINT));
 	}
@@ -274,6 +281,9 @@ License which can be viewed at:
 			return 1;
 		}
 
+		Tracker.Store.init_fts (config.fts_index_delay, config.fts_strict_freshness);
+		Tracker.QueryCache.init (config.query_cache_size);
+
 		db_config = null;
 		notifier = null;
 
@@ -304,6 +314,7 @@ License which can be viewed at:
 		message ("Shutdown started");
 
 		Tracker.Store.shutdown ();
+		Tracker.QueryCache.shutdown ();
 
 		Timeout.add (5000, shutdown_timeout_cb, Priority.LOW);
 
@@ -314,6 +325,13 @@ License which can be viewed at:
 		Tracker.Events.shutdown ();
 
 		Tracker.DBus.shutdown ();
+
+		/* Refresh the index statistics used to order joins, only
+		 * done if the number of resources changed noticeably */
+		if (!readonly_mode) {
+			Tracker.DBManager.optimize ();
+		}
+
 		Tracker.Data.Manager.shutdown ();
 		Tracker.Log.shutdown ();
 
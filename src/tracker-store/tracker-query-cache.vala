@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Results of Steroids queries, kept as the buffer sent to the client,
+ * so identical queries are answered without running them. An entry is
+ * dropped once a transaction changes any of the classes or properties
+ * the query read. Entries are only used from the main loop, the update
+ * thread hands the changes over to it. */
+public class Tracker.QueryCache {
+	/* Larger results are sent but not kept */
+	const size_t MAX_RESULT_SIZE = 1024 * 1024;
+
+	/* Passes a result on to the client, keeping a copy of it until
+	 * it grows larger than MAX_RESULT_SIZE */
+	public class Recorder : FilterOutputStream {
+		ByteArray? copy;
+
+		public Recorder (OutputStream base_stream, bool cacheable) {
+			Object (base_stream: base_stream);
+
+			if (cacheable) {
+				copy = new ByteArray ();
+			}
+		}
+
+		public override ssize_t write (uint8[] buffer, Cancellable? cancellable = null) throws IOError {
+			ssize_t written = base_stream.write (buffer, cancellable);
+
+			if (copy != null) {
+				if (copy.len + written > MAX_RESULT_SIZE) {
+					copy = null;
+				} else {
+					copy.append (buffer[0:written]);
+				}
+			}
+
+			return written;
+		}
+
+		/* The copy, null if the result is not to be cached */
+		public Bytes? steal_as_bytes () {
+			if (copy == null) {
+				return null;
+			}
+
+			return ByteArray.free_to_bytes ((owned) copy);
+		}
+	}
+
+	class Entry {
+		public string query;
+		public Bytes data;
+		public string[] variable_names;
+		public int[] dependencies;
+		public uint last_used;
+	}
+
+	static int max_entries;
+	static HashTable<string,Entry> entries;
+	/* Ticks on each lookup, to find the least recently used entry */
+	static uint clock;
+
+	/* Bumped on each commit, results of queries running
+	 * meanwhile may be stale and are not kept. Atomic, it is
+	 * bumped from the update thread */
+	static uint generation;
+
+	/* Ids of the predicates and classes of the statements inserted or
+	 * deleted since the last commit, added to from the update thread.
+	 * Rolled back statements are left in, they only drop entries. */
+	static Mutex changed_mutex;
+	static HashTable<int,int> changed;
+	static int rdf_type_id;
+
+	public static void init (int size) {
+		max_entries = size;
+
+		if (max_entries <= 0) {
+			return;
+		}
+
+		entries = new HashTable<string,Entry> (str_hash, str_equal);
+		changed = new HashTable<int,int> (direct_hash, direct_equal);
+		rdf_type_id = Ontologies.get_property_by_uri ("http://www.w3.org/1999/02/22-rdf-syntax-ns#type").id;
+
+		Tracker.Data.add_insert_statement_callback (on_statement);
+		Tracker.Data.add_delete_statement_callback (on_statement);
+		Tracker.Data.add_commit_statement_callback (on_statements_committed);
+	}
+
+	public static void shutdown () {
+		if (max_entries <= 0) {
+			return;
+		}
+
+		Tracker.Data.remove_insert_statement_callback (on_statement);
+		Tracker.Data.remove_delete_statement_callback (on_statement);
+		Tracker.Data.remove_commit_statement_callback (on_statements_committed);
+
+		entries = null;
+		changed = null;
+		max_entries = 0;
+	}
+
+	public static bool is_enabled () {
+		return max_entries > 0;
+	}
+
+	public static uint get_generation () {
+		return AtomicUint.get (ref generation);
+	}
+
+	public static Bytes? lookup (string query, out string[] variable_names) {
+		variable_names = null;
+
+		var entry = entries.lookup (query);
+
+		if (entry == null) {
+			return null;
+		}
+
+		entry.last_used = ++clock;
+
+		variable_names = entry.variable_names;
+
+		return entry.data;
+	}
+
+	/* @query_generation is get_generation () from before the query
+	 * was scheduled, null @dependencies means any data */
+	public static void add (string query, uint query_generation, string[] variable_names, Bytes data, int[]? dependencies) {
+		if (query_generation != get_generation () || dependencies == null ||
+		    data.length > MAX_RESULT_SIZE || entries.contains (query)) {
+			return;
+		}
+
+		if (entries.size () >= max_entries) {
+			Entry? oldest = null;
+
+			foreach (var candidate in entries.get_values ()) {
+				if (oldest == null || candidate.last_used < oldest.last_used) {
+					oldest = candidate;
+				}
+			}
+
+			entries.remove (oldest.query);
+		}
+
+		var entry = new Entry ();
+		entry.query = query;
+		entry.data = data;
+		entry.variable_names = variable_names;
+		entry.dependencies = dependencies;
+		entry.last_used = ++clock;
+
+		entries.insert (entry.query, entry);
+	}
+
+	/* After the database got replaced */
+	public static void clear () {
+		if (max_entries <= 0) {
+			return;
+		}
+
+		AtomicUint.inc (ref generation);
+		entries.remove_all ();
+	}
+
+	static void on_statement (int graph_id, string? graph, int subject_id, string subject, int pred_id, int object_id, string? object, PtrArray rdf_types) {
+		changed_mutex.lock ();
+
+		changed.insert (pred_id, pred_id);
+
+		/* rdf:type statements insert or delete rows of the class
+		 * table and of the tables of its properties */
+		if (pred_id == rdf_type_id) {
+			changed.insert (object_id, object_id);
+		}
+
+		changed_mutex.unlock ();
+	}
+
+	/* Runs in the update thread */
+	static void on_statements_committed (Tracker.Data.CommitType commit_type) {
+		AtomicUint.inc (ref generation);
+
+		changed_mutex.lock ();
+		var ids = (owned) changed;
+		changed = new HashTable<int,int> (direct_hash, direct_equal);
+		changed_mutex.unlock ();
+
+		if (ids.size () == 0) {
+			return;
+		}
+
+		/* Before the reply to the update is sent, which
+		 * is dispatched from the main loop too */
+		Idle.add (() => {
+			drop_entries (ids);
+			return false;
+		}, GLib.Priority.HIGH);
+	}
+
+	static void drop_entries (HashTable<int,int> ids) {
+		if (entries == null || entries.size () == 0) {
+			return;
+		}
+
+		/* Values of a property are also values of its super
+		 * properties, queries may read either */
+		var dropped = new HashTable<int,int> (direct_hash, direct_equal);
+
+		foreach (var prop in Ontologies.get_properties ()) {
+			if (ids.contains (prop.id) || ids.contains (prop.domain.id)) {
+				add_property (dropped, prop);
+			}
+		}
+
+		foreach (var cl in Ontologies.get_classes ()) {
+			if (ids.contains (cl.id)) {
+				add_class (dropped, cl);
+			}
+		}
+
+		entries.foreach_remove ((query, entry) => {
+			foreach (int id in entry.dependencies) {
+				if (dropped.contains (id)) {
+					return true;
+				}
+			}
+
+			return false;
+		});
+	}
+
+	static void add_property (HashTable<int,int> ids, Property prop) {
+		ids.insert (prop.id, prop.id);
+
+		foreach (unowned Property super_property in prop.get_super_properties ()) {
+			add_property (ids, super_property);
+		}
+	}
+
+	static void add_class (HashTable<int,int> ids, Class cl) {
+		ids.insert (cl.id, cl.id);
+
+		foreach (unowned Class super_class in cl.get_super_classes ()) {
+			add_class (ids, super_class);
+		}
+	}
+}
@@ -18,6 +18,11 @@
  * Boston, MA  02110-1301, USA.
  */
 
+[DBus (name = "org.freedesktop.Tracker1.Resources.Error")]
+public errordomain Tracker.ResourcesError {
+	CHANGES_EXPIRED
+}
+
 [DBus (name = "org.freedesktop.Tracker1.Resources")]
 public class Tracker.Resources : Object {
 	public const string PATH = "/org/freedesktop/Tracker1/Resources";
@@ -50,6 +55,7 @@ public class Tracker.Resources : Object {
 	const int DBUS_ARBITRARY_MAX_MSG_SIZE = 10000000;
 
 	DBusConnection connection;
+	GenericArray<Subscription> subscriptions = new GenericArray<Subscription> ();
 	uint signal_timeout;
 	bool regular_commit_pending;
 	Tracker.Config config;
@@ -200,6 +206,111 @@ public class Tracker.Resources : Object {
 		/* no longer needed, just return */
 	}
 
+	/* Sends the logged changes after modseq through the pipe, the
+	 * same way as Steroids.Query. Clients keep the last modseq they
+	 * got to resume from there later. CHANGES_EXPIRED means changes
+	 * were dropped from the log since, so everything must be queried
+	 * again, the MAX (tracker:modified) of that query then being
+	 * the modseq to resume from.
+	 */
+	public async string[] get_changes_since (BusName sender, int modseq, string[] classes, int limit, UnixOutputStream output_stream) throws Error, ResourcesError {
+		var request = DBusRequest.begin (sender, "Resources.GetChangesSince (modseq: %d)", modseq);
+		try {
+			int[] class_ids = new int[classes.length];
+			for (int i = 0; i < classes.length; i++) {
+				unowned Class? cl = Ontologies.get_class_by_uri (classes[i]);
+				if (cl == null || !cl.notify) {
+					throw new DBusError.INVALID_ARGS ("Class '%s' does not exist or is not notified of changes", classes[i]);
+				}
+				class_ids[i] = cl.id;
+			}
+
+			string[] variable_names = null;
+
+			try {
+				yield Tracker.Store.changes_since (modseq, class_ids, limit, cursor => {
+					variable_names = Tracker.Steroids.send_cursor (cursor, output_stream);
+				}, sender);
+			} catch (DBInterfaceError.CHANGES_EXPIRED e) {
+				throw new ResourcesError.CHANGES_EXPIRED (e.message);
+			}
+
+			request.end ();
+
+			return variable_names;
+		} catch (Error e) {
+			request.end (e);
+			if (e is Sparql.Error || e is DBusError || e is ResourcesError) {
+				throw e;
+			} else {
+				throw new Sparql.Error.INTERNAL (e.message);
+			}
+		}
+	}
+
+	public async void subscribe (BusName sender, string[] classes, string[] predicates, string[] graphs, UnixOutputStream output_stream) throws Error {
+		var request = DBusRequest.begin (sender, "Resources.Subscribe");
+		try {
+			var class_uris = new HashTable<string, bool> (str_hash, str_equal);
+			foreach (string uri in classes) {
+				unowned Class? cl = Ontologies.get_class_by_uri (uri);
+				if (cl == null || !cl.notify) {
+					throw new DBusError.INVALID_ARGS ("Class '%s' does not exist or is not notified of changes", uri);
+				}
+				class_uris.insert (cl.uri, true);
+			}
+
+			var predicate_ids = new HashTable<int, bool> (direct_hash, direct_equal);
+			foreach (string uri in predicates) {
+				unowned Property? prop = Ontologies.get_property_by_uri (uri);
+				if (prop == null) {
+					throw new DBusError.INVALID_ARGS ("Property '%s' does not exist", uri);
+				}
+				predicate_ids.insert (prop.id, true);
+			}
+
+			var graph_ids = new HashTable<int, bool> (direct_hash, direct_equal);
+			if (graphs.length > 0) {
+				var query = new StringBuilder ("SELECT");
+				foreach (string uri in graphs) {
+					if (uri.index_of_char ('>') >= 0) {
+						throw new DBusError.INVALID_ARGS ("Invalid graph '%s'", uri);
+					}
+					query.append_printf (" tracker:id(<%s>)", uri);
+				}
+				query.append (" {}");
+
+				yield Tracker.Store.sparql_query (query.str, Tracker.Store.Priority.HIGH, cursor => {
+					if (cursor.next ()) {
+						for (int i = 0; i < cursor.n_columns; i++) {
+							graph_ids.insert ((int) cursor.get_integer (i), true);
+						}
+					}
+				}, sender);
+
+				if (graph_ids.contains (0)) {
+					throw new DBusError.INVALID_ARGS ("Subscribing to graphs that do not exist");
+				}
+			}
+
+			Unix.set_fd_nonblocking (output_stream.fd, true);
+
+			subscriptions.add (new Subscription (sender, output_stream,
+			                                     classes.length > 0 ? class_uris : null,
+			                                     predicates.length > 0 ? predicate_ids : null,
+			                                     graphs.length > 0 ? graph_ids : null));
+
+			request.end ();
+		} catch (Error e) {
+			request.end (e);
+			if (e is Sparql.Error || e is DBusError) {
+				throw e;
+			} else {
+				throw new Sparql.Error.INTERNAL (e.message);
+			}
+		}
+	}
+
 	bool emit_graph_updated (Class cl) {
 		if (cl.has_insert_events () || cl.has_delete_events ()) {
 			var builder = new VariantBuilder ((VariantType) "a(iiii)");
@@ -224,6 +335,16 @@ public class Tracker.Resources : Object {
 	}
 
 	bool on_emit_signals () {
+		if (subscriptions.length > 0) {
+			unowned Class[] classes = Tracker.Events.get_classes ();
+
+			for (int i = 0; i < subscriptions.length; i++) {
+				subscriptions[i].send_events (classes);
+			}
+
+			prune_subscriptions (null);
+		}
+
 		foreach (var cl in Tracker.Events.get_classes ()) {
 			emit_graph_updated (cl);
 		}
@@ -363,4 +484,176 @@ public class Tracker.Resources : Object {
 	public void unreg_batches (string old_owner) {
 		Tracker.Store.unreg_batches (old_owner);
 	}
+
+	// drops the subscriptions of a client that went away,
+	// or the ones whose pipe got closed if sender is null
+	[DBus (visible = false)]
+	public void prune_subscriptions (string? sender) {
+		for (int i = subscriptions.length - 1; i >= 0; i--) {
+			var subscription = subscriptions[i];
+
+			if (sender != null && subscription.sender == sender) {
+				subscription.close ();
+			}
+
+			if (subscription.closed) {
+				subscriptions.remove_index_fast (i);
+			}
+		}
+	}
+}
+
+/* A client receiving the changes to some classes, optionally only to
+ * some predicates and graphs, through a pipe instead of GraphUpdated.
+ * For each class with matching changes the stream has the class URI
+ * length and bytes, then the number of deletes and inserts each
+ * followed by their (graph, subject, predicate, object) ids, all of
+ * them 32 bit integers in host byte order.
+ */
+class Tracker.Subscription : Object {
+	/* Clients falling this far behind are dropped */
+	const size_t MAX_PENDING_SIZE = 16 * 1024 * 1024;
+
+	public string sender { get; private set; }
+	public bool closed { get; private set; }
+
+	UnixOutputStream output_stream;
+	HashTable<string, bool>? classes;
+	HashTable<int, bool>? predicates;
+	HashTable<int, bool>? graphs;
+
+	Queue<Bytes> pending = new Queue<Bytes> ();
+	size_t pending_size;
+	bool writing;
+
+	public Subscription (string sender, UnixOutputStream output_stream, HashTable<string, bool>? classes, HashTable<int, bool>? predicates, HashTable<int, bool>? graphs) {
+		this.sender = sender;
+		this.output_stream = output_stream;
+		this.classes = classes;
+		this.predicates = predicates;
+		this.graphs = graphs;
+	}
+
+	bool matches (int graph_id, int pred_id) {
+		return (predicates == null || predicates.contains (pred_id)) &&
+		       (graphs == null || graphs.contains (graph_id));
+	}
+
+	void put_events (DataOutputStream data_stream, int[] events) throws IOError {
+		data_stream.put_int32 (events.length / 4);
+		foreach (int id in events) {
+			data_stream.put_int32 (id);
+		}
+	}
+
+	public void send_events (Class[] notify_classes) {
+		if (closed) {
+			return;
+		}
+
+		var memory_stream = new MemoryOutputStream.resizable ();
+		var data_stream = new DataOutputStream (memory_stream);
+		data_stream.set_byte_order (DataStreamByteOrder.HOST_ENDIAN);
+
+		try {
+			foreach (var cl in notify_classes) {
+				if (classes != null && !classes.contains (cl.uri)) {
+					continue;
+				}
+
+				int[] deletes = {};
+				int[] inserts = {};
+
+				cl.foreach_delete_event ((graph_id, subject_id, pred_id, object_id) => {
+					if (matches (graph_id, pred_id)) {
+						deletes += graph_id;
+						deletes += subject_id;
+						deletes += pred_id;
+						deletes += object_id;
+					}
+				});
+
+				cl.foreach_insert_event ((graph_id, subject_id, pred_id, object_id) => {
+					if (matches (graph_id, pred_id)) {
+						inserts += graph_id;
+						inserts += subject_id;
+						inserts += pred_id;
+						inserts += object_id;
+					}
+				});
+
+				if (deletes.length == 0 && inserts.length == 0) {
+					continue;
+				}
+
+				data_stream.put_int32 (cl.uri.length);
+				data_stream.put_string (cl.uri);
+				put_events (data_stream, deletes);
+				put_events (data_stream, inserts);
+			}
+
+			data_stream.close ();
+		} catch (IOError e) {
+			// writing to memory does not fail
+			assert_not_reached ();
+		}
+
+		if (memory_stream.get_data_size () == 0) {
+			return;
+		}
+
+		var bytes = memory_stream.steal_as_bytes ();
+
+		if (pending_size + bytes.get_size () > MAX_PENDING_SIZE) {
+			warning ("Dropping the change subscription of %s, it does not keep up with the changes", sender);
+			close ();
+			return;
+		}
+
+		pending.push_tail (bytes);
+		pending_size += bytes.get_size ();
+
+		if (!writing) {
+			flush.begin ();
+		}
+	}
+
+	async void flush () {
+		writing = true;
+
+		while (!closed && !pending.is_empty ()) {
+			var bytes = pending.pop_head ();
+			pending_size -= bytes.get_size ();
+
+			try {
+				while (bytes.get_size () > 0) {
+					var written = yield output_stream.write_bytes_async (bytes);
+					bytes = new Bytes.from_bytes (bytes, written, bytes.get_size () - written);
+				}
+			} catch (Error e) {
+				// the client closed its end of the pipe
+				closed = true;
+			}
+		}
+
+		writing = false;
+
+		if (closed) {
+			close ();
+		}
+	}
+
+	public void close () {
+		closed = true;
+		pending.clear ();
+		pending_size = 0;
+
+		// with a write in flight, flush () closes it when done
+		if (!writing && !output_stream.is_closed ()) {
+			try {
+				output_stream.close ();
+			} catch (Error e) {
+			}
+		}
+	}
 }
@@ -21,35 +21,55 @@
 public class Tracker.Statistics : Object {
 	public const string PATH = "/org/freedesktop/Tracker1/Statistics";
 
-	static bool initialized;
+	/* Counts are notified when they changed by this much */
+	const int THRESHOLD_PERCENT = 5;
+	const uint NOTIFY_DELAY = 1000;
 
-	[DBus (signature = "aas")]
-	public new Variant get (BusName sender) throws GLib.Error {
-		var request = DBusRequest.begin (sender, "Statistics.Get");
+	/* class or property name -> last notified count */
+	HashTable<string,int> notified_counts;
+	uint notify_timeout;
 
-		if (!initialized) {
-			var iface = DBManager.get_db_interface ();
-
-			foreach (var cl in Ontologies.get_classes ()) {
-				/* xsd classes do not derive from rdfs:Resource and do not use separate tables */
-				if (!cl.name.has_prefix ("xsd:")) {
-					/* update statistics */
-					var stmt = iface.create_statement (DBStatementCacheType.NONE,
-						                           "SELECT COUNT(1) FROM \"%s\"",
-						                            cl.name);
-
-					var stat_cursor = stmt.start_cursor ();
-					if (stat_cursor.next ()) {
-						cl.count = (int) stat_cursor.get_integer (0);
-					} else {
-						warning ("Unable to query instance count for class %s", cl.name);
-					}
-				}
-			}
+	/* Same format as Get, only with the counts that changed enough */
+	public signal void changed ([DBus (signature = "aas")] Variant counts);
+
+	public Statistics () {
+		notified_counts = new HashTable<string,int> (str_hash, str_equal);
+	}
+
+	[DBus (visible = false)]
+	public void enable_signals () {
+		/* The ontology is loaded by now */
+		foreach (var cl in Ontologies.get_classes ()) {
+			notified_counts.insert (cl.name, cl.count);
+		}
 
-			initialized = true;
+		foreach (var prop in Ontologies.get_properties ()) {
+			notified_counts.insert (prop.name, prop.count);
 		}
 
+		Tracker.Data.add_commit_statement_callback (on_statements_committed);
+	}
+
+	[DBus (visible = false)]
+	public void disable_signals () {
+		Tracker.Data.remove_commit_statement_callback (on_statements_committed);
+
+		if (notify_timeout != 0) {
+			Source.remove (notify_timeout);
+			notify_timeout = 0;
+		}
+	}
+
+	~Statistics () {
+		this.disable_signals ();
+	}
+
+	/* The counts are kept by libtracker-data on each commit, so there
+	 * is no need to query the database here */
+	[DBus (signature = "aas")]
+	public new Variant get (BusName sender) throws GLib.Error {
+		var request = DBusRequest.begin (sender, "Statistics.Get");
+
 		var builder = new VariantBuilder ((VariantType) "aas");
 
 		foreach (var cl in Ontologies.get_classes ()) {
@@ -68,4 +88,127 @@ public class Tracker.Statistics : Object {
 
 		return builder.end ();
 	}
+
+	/* Number of values of the given properties, all with values if empty */
+	[DBus (signature = "aas")]
+	public Variant get_properties (BusName sender, string[] properties) throws GLib.Error {
+		var request = DBusRequest.begin (sender, "Statistics.GetProperties");
+
+		var builder = new VariantBuilder ((VariantType) "aas");
+
+		if (properties.length == 0) {
+			foreach (var prop in Ontologies.get_properties ()) {
+				if (prop.count == 0) {
+					continue;
+				}
+
+				builder.open ((VariantType) "as");
+				builder.add ("s", prop.name);
+				builder.add ("s", prop.count.to_string ());
+				builder.close ();
+			}
+		} else {
+			foreach (string name in properties) {
+				var prop = Ontologies.get_property_by_uri (expand_name (name));
+
+				if (prop == null) {
+					request.end ();
+					throw new Sparql.Error.UNKNOWN_PROPERTY ("Property '%s' not found in the ontology", name);
+				}
+
+				builder.open ((VariantType) "as");
+				builder.add ("s", prop.name);
+				builder.add ("s", prop.count.to_string ());
+				builder.close ();
+			}
+		}
+
+		request.end ();
+
+		return builder.end ();
+	}
+
+	/* The more segments, the more b-trees full text searches go through.
+	 * Read in a query thread, like any other query */
+	public async void get_fts_fragmentation (BusName sender, out int segments, out int levels, out int max_level_segments) throws GLib.Error {
+		var request = DBusRequest.begin (sender, "Statistics.GetFtsFragmentation");
+
+		try {
+			yield Tracker.Store.fts_segment_stats (out segments, out levels, out max_level_segments, sender);
+
+			request.end ();
+		} catch (Error e) {
+			request.end (e);
+			throw new Sparql.Error.INTERNAL (e.message);
+		}
+	}
+
+	static string expand_name (string name) {
+		var parts = name.split (":", 2);
+
+		if (parts.length == 2 && !name.contains ("://")) {
+			foreach (var ns in Ontologies.get_namespaces ()) {
+				if (ns.prefix == parts[0]) {
+					return ns.uri + parts[1];
+				}
+			}
+		}
+
+		return name;
+	}
+
+	static bool crossed_threshold (int old_count, int new_count) {
+		if (old_count == new_count) {
+			return false;
+		}
+
+		if (old_count == 0 || new_count == 0) {
+			return true;
+		}
+
+		return (new_count - old_count).abs () * 100 >= old_count * THRESHOLD_PERCENT;
+	}
+
+	void add_if_changed (VariantBuilder builder, string name, int count, ref bool changed) {
+		if (!crossed_threshold (notified_counts.lookup (name), count)) {
+			return;
+		}
+
+		notified_counts.insert (name, count);
+
+		builder.open ((VariantType) "as");
+		builder.add ("s", name);
+		builder.add ("s", count.to_string ());
+		builder.close ();
+
+		changed = true;
+	}
+
+	bool on_notify_counts () {
+		var builder = new VariantBuilder ((VariantType) "aas");
+		bool changed = false;
+
+		foreach (var cl in Ontologies.get_classes ()) {
+			add_if_changed (builder, cl.name, cl.count, ref changed);
+		}
+
+		foreach (var prop in Ontologies.get_properties ()) {
+			add_if_changed (builder, prop.name, prop.count, ref changed);
+		}
+
+		if (changed) {
+			this.changed (builder.end ());
+		}
+
+		notify_timeout = 0;
+
+		return false;
+	}
+
+	void on_statements_committed (Tracker.Data.CommitType commit_type) {
+		/* Compare the counts at most once per NOTIFY_DELAY */
+		if (notify_timeout == 0) {
+			notify_timeout = Timeout.add (NOTIFY_DELAY, on_notify_counts);
+		}
+	}
 }
@@ -24,56 +24,129 @@ public class Tracker.Steroids : Object {
 
 	public const int BUFFER_SIZE = 65536;
 
-	public async string[] query (BusName sender, string query, UnixOutputStream output_stream) throws Error {
-		var request = DBusRequest.begin (sender, "Steroids.Query");
-		request.debug ("query: %s", query);
-		try {
-			string[] variable_names = null;
+	// runs in the query thread, also used by Resources.GetChangesSince
+	internal static string[] send_cursor (DBCursor cursor, OutputStream output_stream) throws Error {
+		var buffered_stream = new BufferedOutputStream.sized (output_stream, BUFFER_SIZE);
+
+		int n_columns = cursor.n_columns;
+
+		/* Each row is [n_columns, types, offsets of the terminating
+		 * nul of each value] in host byte order, then the values */
+		int[] header = new int[1 + 2 * n_columns];
+		var row = new ByteArray ();
+		var number = new uint8[24];
+		uint8[] nul = { 0 };
+
+		var variable_names = new string[n_columns];
+		for (int i = 0; i < n_columns; i++) {
+			variable_names[i] = cursor.get_variable_name (i);
+		}
 
-			yield Tracker.Store.sparql_query (query, Tracker.Store.Priority.HIGH, cursor => {
-				var data_output_stream = new DataOutputStream (new BufferedOutputStream.sized (output_stream, BUFFER_SIZE));
-				data_output_stream.set_byte_order (DataStreamByteOrder.HOST_ENDIAN);
+		header[0] = n_columns;
 
-				int n_columns = cursor.n_columns;
+		while (cursor.next ()) {
+			row.set_size (0);
 
-				int[] column_sizes = new int[n_columns];
-				int[] column_offsets = new int[n_columns];
-				string[] column_data = new string[n_columns];
+			for (int i = 0; i < n_columns ; i++) {
+				var type = cursor.get_value_type (i);
 
-				variable_names = new string[n_columns];
-				for (int i = 0; i < n_columns; i++) {
-					variable_names[i] = cursor.get_variable_name (i);
+				if (type == Sparql.ValueType.INTEGER) {
+					/* Stored as integer, format it ourselves
+					 * rather than have SQLite convert it */
+					int start = format_integer (number, cursor.get_integer (i));
+					row.append (number[start:number.length]);
+				} else if (type != Sparql.ValueType.UNBOUND) {
+					long length;
+					unowned uint8[] str = (uint8[]) cursor.get_string (i, out length);
+					str.length = (int) length;
+					row.append (str);
 				}
 
-				while (cursor.next ()) {
-					int last_offset = -1;
+				row.append (nul);
 
-					for (int i = 0; i < n_columns ; i++) {
-						unowned string str = cursor.get_string (i);
+				/* Cast from enum to int */
+				header[1 + i] = (int) type;
+				header[1 + n_columns + i] = (int) row.len - 1;
+			}
 
-						column_sizes[i] = str != null ? str.length : 0;
-						column_data[i]  = str;
+			unowned uint8[] header_data = (uint8[]) header;
+			header_data.length = header.length * (int) sizeof (int);
 
-						last_offset += column_sizes[i] + 1;
-						column_offsets[i] = last_offset;
-					}
+			size_t bytes_written;
+			buffered_stream.write_all (header_data, out bytes_written);
+			buffered_stream.write_all (row.data, out bytes_written);
+		}
 
-					data_output_stream.put_int32 (n_columns);
+		buffered_stream.close ();
 
-					for (int i = 0; i < n_columns ; i++) {
-						/* Cast from enum to int */
-						data_output_stream.put_int32 ((int) cursor.get_value_type (i));
-					}
+		return variable_names;
+	}
 
-					for (int i = 0; i < n_columns ; i++) {
-						data_output_stream.put_int32 (column_offsets[i]);
-					}
+	/* Writes the decimal digits of value at the end of buffer, the same
+	 * as SQLite does, and returns the index of the first one */
+	static int format_integer (uint8[] buffer, int64 value) {
+		uint64 n = value < 0 ? -(uint64) value : (uint64) value;
+		int i = buffer.length;
+
+		do {
+			buffer[--i] = (uint8) ('0' + (int) (n % 10));
+			n /= 10;
+		} while (n > 0);
+
+		if (value < 0) {
+			buffer[--i] = (uint8) '-';
+		}
+
+		return i;
+	}
 
-					for (int i = 0; i < n_columns ; i++) {
-						data_output_stream.put_string (column_data[i] != null ? column_data[i] : "");
-						data_output_stream.put_byte (0);
+	static async void send_cached (Bytes data, UnixOutputStream output_stream) throws Error {
+		size_t written = 0;
+
+		while (written < data.length) {
+			ssize_t n = yield output_stream.write_bytes_async (new Bytes.from_bytes (data, written, data.length - written));
+			written += (size_t) n;
+		}
+
+		yield output_stream.close_async ();
+	}
+
+	public async string[] query (BusName sender, string query, UnixOutputStream output_stream) throws Error {
+		var request = DBusRequest.begin (sender, "Steroids.Query");
+		request.debug ("query: %s", query);
+		try {
+			string[] variable_names = null;
+
+			if (QueryCache.is_enabled ()) {
+				var cached = QueryCache.lookup (query, out variable_names);
+
+				if (cached != null) {
+					request.debug ("cached result");
+					yield send_cached (cached, output_stream);
+				} else {
+					uint generation = QueryCache.get_generation ();
+					Bytes data = null;
+
+					var dependencies = yield Tracker.Store.sparql_query_with_dependencies (query, Tracker.Store.Priority.HIGH, (cursor, query_dependencies) => {
+						/* Stream the result as usual, only keeping
+						 * a copy if it may be cached */
+						var recorder = new QueryCache.Recorder (output_stream, query_dependencies != null);
+						variable_names = send_cursor (cursor, recorder);
+						data = recorder.steal_as_bytes ();
+					}, sender);
+
+					if (data != null) {
+						QueryCache.add (query, generation, variable_names, data, dependencies);
 					}
 				}
+
+				request.end ();
+
+				return variable_names;
+			}
+
+			yield Tracker.Store.sparql_query (query, Tracker.Store.Priority.HIGH, cursor => {
+				variable_names = send_cursor (cursor, output_stream);
 			}, sender);
 
 			request.end ();
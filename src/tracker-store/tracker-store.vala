@@ -24,8 +24,18 @@ public class Tracker.Store {
 
 	const int MAX_TASK_TIME = 30;
 
+	const int FTS_INDEX_BATCH_SIZE = 500;
+
+	/* FTS segments are merged once the store has been idle
+	 * for a while, in short slices so updates don't wait long. */
+	const int FTS_MERGE_IDLE_TIME = 30;
+	const int FTS_MERGE_TIME_SLICE = 50;
+	const int FTS_MERGE_PAGES = 16;
+	const int FTS_MERGE_MIN_SEGMENTS = 4;
+
 	static Queue<Task> query_queues[3 /* TRACKER_STORE_N_PRIORITIES */];
 	static Queue<Task> update_queues[3 /* TRACKER_STORE_N_PRIORITIES */];
+	static Queue<Task> fts_queue;
 	static int n_queries_running;
 	static bool update_running;
 	static ThreadPool<Task> update_pool;
@@ -35,6 +45,12 @@ public class Tracker.Store {
 	static int max_task_time;
 	static bool active;
 	static SourceFunc active_callback;
+	static int fts_index_delay;
+	static bool fts_strict_freshness;
+	static uint fts_index_timeout_id;
+	static uint fts_merge_timeout_id;
+	static bool fts_merging;
+	static bool fts_merge_disabled;
 
 	public enum Priority {
 		HIGH,
@@ -48,9 +64,13 @@ public class Tracker.Store {
 		UPDATE,
 		UPDATE_BLANK,
 		TURTLE,
+		FTS_INDEX,
+		FTS_MERGE,
 	}
 
 	public delegate void SparqlQueryInThread (DBCursor cursor) throws Error;
+	/* @dependencies as returned by sparql_query_with_dependencies () */
+	public delegate void SparqlQueryWithDependenciesInThread (DBCursor cursor, int[]? dependencies) throws Error;
 
 	abstract class Task {
 		public TaskType type;
@@ -64,6 +84,15 @@ public class Tracker.Store {
 		public Cancellable cancellable;
 		public uint watchdog_id;
 		public unowned SparqlQueryInThread in_thread;
+		/* Set instead of in_thread when the dependencies are
+		 * wanted, see Sparql.Query.get_dependencies () */
+		public unowned SparqlQueryWithDependenciesInThread in_thread_with_dependencies;
+		public int[]? dependencies;
+		/* Set when the query uses fts:match while resources are
+		 * queued for FTS indexing, it is not run then. It runs
+		 * regardless once the index caught up for it */
+		public bool fts_catch_up;
+		public bool fts_caught_up;
 
 		~QueryTask () {
 			if (watchdog_id > 0) {
@@ -72,6 +101,19 @@ public class Tracker.Store {
 		}
 	}
 
+	class ChangesTask : QueryTask {
+		public int modseq;
+		public int[] class_ids;
+		public int limit;
+	}
+
+	class FtsStatsTask : QueryTask {
+		public bool available;
+		public int n_segments;
+		public int n_levels;
+		public int max_level_segments;
+	}
+
 	class UpdateTask : Task {
 		public string query;
 		public Variant blank_nodes;
@@ -82,6 +124,15 @@ public class Tracker.Store {
 		public string path;
 	}
 
+	class FtsIndexTask : Task {
+		public int max_docs;
+		public int n_docs;
+	}
+
+	class FtsMergeTask : Task {
+		public bool more;
+	}
+
 	static void sched () {
 		Task task = null;
 
@@ -106,6 +157,7 @@ public class Tracker.Store {
 				var query_task = (QueryTask) task;
 				query_task.watchdog_id = Timeout.add_seconds (max_task_time, () => {
 					query_task.cancellable.cancel ();
+					query_task.watchdog_id = 0;
 					return false;
 				});
 			}
@@ -119,11 +171,12 @@ public class Tracker.Store {
 		}
 
 		if (!update_running) {
-			for (int i = 0; i < Priority.N_PRIORITIES; i++) {
+			/* FTS index batches are kept apart from updates so they
+			 * don't count as pending batch updates, but go first to
+			 * honor the configured index delay. */
+			task = fts_queue.pop_head ();
+			for (int i = 0; task == null && i < Priority.N_PRIORITIES; i++) {
 				task = update_queues[i].pop_head ();
-				if (task != null) {
-					break;
-				}
 			}
 			if (task != null) {
 				update_running = true;
@@ -171,6 +224,13 @@ public class Tracker.Store {
 				}
 			}
 
+			/* The task may be queued again, e.g. after an FTS
+			 * catch up, sched () arms a new watchdog then */
+			if (query_task.watchdog_id > 0) {
+				Source.remove (query_task.watchdog_id);
+				query_task.watchdog_id = 0;
+			}
+
 			task.callback ();
 			task.error = null;
 
@@ -193,9 +253,20 @@ public class Tracker.Store {
 			task.callback ();
 			task.error = null;
 
+			update_running = false;
+		} else if (task.type == TaskType.FTS_INDEX || task.type == TaskType.FTS_MERGE) {
+			task.callback ();
+			task.error = null;
+
 			update_running = false;
 		}
 
+		if (task.type != TaskType.QUERY && task.type != TaskType.FTS_INDEX &&
+		    task.type != TaskType.FTS_MERGE) {
+			schedule_fts_index ();
+			schedule_fts_merge ();
+		}
+
 		if (n_queries_running == 0 && !update_running && active_callback != null) {
 			active_callback ();
 		}
@@ -209,10 +280,51 @@ public class Tracker.Store {
 		try {
 			if (task.type == TaskType.QUERY) {
 				var query_task = (QueryTask) task;
+				DBCursor cursor;
+
+				if (task is FtsStatsTask) {
+					var stats_task = (FtsStatsTask) task;
+					int n_segments, n_levels, max_level_segments;
+
+					stats_task.available = Tracker.Data.get_fts_segment_stats (out n_segments,
+					                                                           out n_levels,
+					                                                           out max_level_segments);
+					stats_task.n_segments = n_segments;
+					stats_task.n_levels = n_levels;
+					stats_task.max_level_segments = max_level_segments;
+
+					cursor = null;
+				} else if (task is ChangesTask) {
+					var changes_task = (ChangesTask) task;
+
+					cursor = Tracker.Data.query_changes_since (changes_task.modseq,
+					                                           changes_task.class_ids,
+					                                           changes_task.limit);
+				} else {
+					var query = new Sparql.Query (query_task.query);
+
+					cursor = query.execute_cursor (false);
+
+					if (query_task.in_thread_with_dependencies != null) {
+						query_task.dependencies = query.get_dependencies ();
+					}
 
-				var cursor = Tracker.Data.query_sparql_cursor (query_task.query);
+					/* The cursor is not stepped yet, the query
+					 * runs again once the index caught up */
+					if (!query_task.fts_caught_up &&
+					    query.uses_fts_match () && needs_fts_catch_up ()) {
+						query_task.fts_catch_up = true;
+						cursor = null;
+					}
+				}
 
-				query_task.in_thread (cursor);
+				if (cursor != null) {
+					if (query_task.in_thread_with_dependencies != null) {
+						query_task.in_thread_with_dependencies (cursor, query_task.dependencies);
+					} else {
+						query_task.in_thread (cursor);
+					}
+				}
 			} else {
 				var iface = DBManager.get_db_interface ();
 				iface.sqlite_wal_hook (wal_hook);
@@ -236,6 +348,16 @@ public class Tracker.Store {
 					} finally {
 						Tracker.Events.reset_pending ();
 					}
+				} else if (task.type == TaskType.FTS_INDEX) {
+					var fts_task = (FtsIndexTask) task;
+
+					fts_task.n_docs = Tracker.Data.update_fts_queued (fts_task.max_docs);
+				} else if (task.type == TaskType.FTS_MERGE) {
+					var merge_task = (FtsMergeTask) task;
+
+					merge_task.more = Tracker.Data.fts_merge (FTS_MERGE_PAGES,
+					                                          FTS_MERGE_MIN_SEGMENTS,
+					                                          FTS_MERGE_TIME_SLICE);
 				}
 			}
 		} catch (Error e) {
@@ -304,6 +426,7 @@ public class Tracker.Store {
 			query_queues[i] = new Queue<Task> ();
 			update_queues[i] = new Queue<Task> ();
 		}
+		fts_queue = new Queue<Task> ();
 
 		try {
 			update_pool = new ThreadPool<Task>.with_owned_data (pool_dispatch_cb, 1, true);
@@ -321,6 +444,16 @@ public class Tracker.Store {
 	}
 
 	public static void shutdown () {
+		if (fts_index_timeout_id != 0) {
+			Source.remove (fts_index_timeout_id);
+			fts_index_timeout_id = 0;
+		}
+
+		if (fts_merge_timeout_id != 0) {
+			Source.remove (fts_merge_timeout_id);
+			fts_merge_timeout_id = 0;
+		}
+
 		query_pool = null;
 		update_pool = null;
 		checkpoint_pool = null;
@@ -329,15 +462,179 @@ public class Tracker.Store {
 			query_queues[i] = null;
 			update_queues[i] = null;
 		}
+		fts_queue = null;
+	}
+
+	/* With a delay > 0, the FTS index is updated in batches in the
+	 * background, lagging at most delay ms behind the data. */
+	public static void init_fts (int delay, bool strict_freshness) {
+		fts_index_delay = delay;
+		fts_strict_freshness = strict_freshness;
+
+		Tracker.Data.set_fts_deferred (delay > 0);
+
+		/* Catch up with anything left from a previous run */
+		fts_index_in_background.begin ();
+
+		schedule_fts_merge ();
+	}
+
+	static void schedule_fts_index () {
+		if (fts_index_delay <= 0 || fts_index_timeout_id != 0 ||
+		    !Tracker.Data.has_fts_queued ()) {
+			return;
+		}
+
+		fts_index_timeout_id = Timeout.add (fts_index_delay, () => {
+			fts_index_timeout_id = 0;
+			fts_index_in_background.begin ();
+			return false;
+		});
+	}
+
+	static async int fts_index (int max_docs) throws Error {
+		var task = new FtsIndexTask ();
+		task.type = TaskType.FTS_INDEX;
+		task.max_docs = max_docs;
+		task.callback = fts_index.callback;
+
+		fts_queue.push_tail (task);
+
+		sched ();
+
+		yield;
+
+		if (task.error != null) {
+			throw task.error;
+		}
+
+		return task.n_docs;
+	}
+
+	static async void fts_index_in_background () {
+		try {
+			/* Index in batches, so updates can run in between */
+			while ((yield fts_index (FTS_INDEX_BATCH_SIZE)) == FTS_INDEX_BATCH_SIZE);
+		} catch (Error e) {
+			warning ("Could not update FTS index: %s", e.message);
+		}
+	}
+
+	static bool updates_pending () {
+		for (int i = 0; i < Priority.N_PRIORITIES; i++) {
+			if (update_queues[i].get_length () > 0) {
+				return true;
+			}
+		}
+
+		return update_running;
+	}
+
+	/* (Re)starts the idle timer, merging only starts after
+	 * FTS_MERGE_IDLE_TIME seconds without updates. */
+	static void schedule_fts_merge () {
+		if (fts_merge_disabled || fts_merging) {
+			return;
+		}
+
+		if (fts_merge_timeout_id != 0) {
+			Source.remove (fts_merge_timeout_id);
+		}
+
+		fts_merge_timeout_id = Timeout.add_seconds (FTS_MERGE_IDLE_TIME, () => {
+			fts_merge_timeout_id = 0;
+			fts_merge_in_background.begin ();
+			return false;
+		});
+	}
+
+	static async bool fts_merge () throws Error {
+		var task = new FtsMergeTask ();
+		task.type = TaskType.FTS_MERGE;
+		task.callback = fts_merge.callback;
+
+		fts_queue.push_tail (task);
+
+		sched ();
+
+		yield;
+
+		if (task.error != null) {
+			throw task.error;
+		}
+
+		return task.more;
+	}
+
+	static async void fts_merge_in_background () {
+		int n_segments, n_levels, max_level_segments;
+
+		try {
+			if (!(yield fts_segment_stats (out n_segments, out n_levels, out max_level_segments, "")) ||
+			    max_level_segments < FTS_MERGE_MIN_SEGMENTS) {
+				return;
+			}
+		} catch (Error e) {
+			warning ("Could not read FTS index segments: %s", e.message);
+			return;
+		}
+
+		debug ("FTS index has %d segments in %d levels (up to %d in a level), merging",
+		       n_segments, n_levels, max_level_segments);
+
+		fts_merging = true;
+
+		try {
+			/* Give way as soon as there are updates to run */
+			while (!updates_pending () && (yield fts_merge ()));
+		} catch (Error e) {
+			/* e.g. SQLite without incremental merge support */
+			warning ("Could not merge FTS index segments, disabling: %s", e.message);
+			fts_merge_disabled = true;
+		}
+
+		fts_merging = false;
+
+		try {
+			if (yield fts_segment_stats (out n_segments, out n_levels, out max_level_segments, "")) {
+				debug ("FTS index has %d segments in %d levels (up to %d in a level)",
+				       n_segments, n_levels, max_level_segments);
+			}
+		} catch (Error e) {
+			warning ("Could not read FTS index segments: %s", e.message);
+		}
+
+		if (updates_pending ()) {
+			/* Interrupted, try again next time the store is idle */
+			schedule_fts_merge ();
+		}
+	}
+
+	/* Can be called from any thread */
+	static bool needs_fts_catch_up () {
+		return (fts_index_delay > 0 && fts_strict_freshness &&
+		        Tracker.Data.has_fts_queued ());
 	}
 
 	public static async void sparql_query (string sparql, Priority priority, SparqlQueryInThread in_thread, string client_id) throws Error {
+		yield sparql_query_internal (sparql, priority, in_thread, null, client_id);
+	}
+
+	/* Also returns the ids of the classes and properties the query
+	 * read, null if it may have read any. They are passed to
+	 * @in_thread as well, before the cursor is read */
+	public static async int[]? sparql_query_with_dependencies (string sparql, Priority priority, SparqlQueryWithDependenciesInThread in_thread, string client_id) throws Error {
+		return yield sparql_query_internal (sparql, priority, null, in_thread, client_id);
+	}
+
+	static async int[]? sparql_query_internal (string sparql, Priority priority, SparqlQueryInThread? in_thread, SparqlQueryWithDependenciesInThread? in_thread_with_dependencies, string client_id) throws Error {
 		var task = new QueryTask ();
 		task.type = TaskType.QUERY;
 		task.query = sparql;
 		task.cancellable = new Cancellable ();
 		task.in_thread = in_thread;
-		task.callback = sparql_query.callback;
+		task.in_thread_with_dependencies = in_thread_with_dependencies;
+		task.callback = sparql_query_internal.callback;
 		task.client_id = client_id;
 
 		query_queues[priority].push_tail (task);
@@ -349,6 +646,73 @@ public class Tracker.Store {
 		if (task.error != null) {
 			throw task.error;
 		}
+
+		if (task.fts_catch_up) {
+			yield fts_index (-1);
+
+			task.fts_catch_up = false;
+			task.fts_caught_up = true;
+			query_queues[priority].push_tail (task);
+
+			sched ();
+
+			yield;
+
+			if (task.error != null) {
+				throw task.error;
+			}
+		}
+
+		return task.dependencies;
+	}
+
+	/* Reads the change log, scheduled along with queries */
+	public static async void changes_since (int modseq, int[] class_ids, int limit, SparqlQueryInThread in_thread, string client_id) throws Error {
+		var task = new ChangesTask ();
+		task.type = TaskType.QUERY;
+		task.modseq = modseq;
+		task.class_ids = class_ids;
+		task.limit = limit;
+		task.cancellable = new Cancellable ();
+		task.in_thread = in_thread;
+		task.callback = changes_since.callback;
+		task.client_id = client_id;
+
+		query_queues[Priority.HIGH].push_tail (task);
+
+		sched ();
+
+		yield;
+
+		if (task.error != null) {
+			throw task.error;
+		}
+	}
+
+	/* Reads the FTS index segment counts in a query thread, returns
+	 * false if there is no FTS index */
+	public static async bool fts_segment_stats (out int n_segments, out int n_levels, out int max_level_segments, string client_id) throws Error {
+		var task = new FtsStatsTask ();
+		task.type = TaskType.QUERY;
+		task.cancellable = new Cancellable ();
+		task.callback = fts_segment_stats.callback;
+		task.client_id = client_id;
+
+		query_queues[Priority.HIGH].push_tail (task);
+
+		sched ();
+
+		yield;
+
+		if (task.error != null) {
+			throw task.error;
+		}
+
+		n_segments = task.n_segments;
+		n_levels = task.n_levels;
+		max_level_segments = task.max_level_segments;
+
+		return task.available;
 	}
 
 	public static async void sparql_update (string sparql, Priority priority, string client_id) throws Error {
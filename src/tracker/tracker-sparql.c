@@ -30,6 +30,7 @@
 #include <glib/gi18n.h>
 
 #include <libtracker-sparql/tracker-sparql.h>
+#include <libtracker-data/tracker-data.h>
 
 #include "tracker-sparql.h"
 #include "tracker-color.h"
@@ -89,6 +90,7 @@ static gboolean parse_tree            (const gchar  *option_name,
 static gchar *file;
 static gchar *query;
 static gboolean update;
+static gboolean plan;
 static gboolean list_classes;
 static gboolean list_class_prefixes;
 static gchar *list_properties;
@@ -112,6 +114,10 @@ static GOptionEntry entries[] = {
 	  N_("This is used with --query and for database updates only."),
 	  NULL,
 	},
+	{ "plan", 0, 0, G_OPTION_ARG_NONE, &plan,
+	  N_("Show the join order and database plan of the query instead of running it, used with --query or --file"),
+	  NULL,
+	},
 	{ "list-classes", 'c', 0, G_OPTION_ARG_NONE, &list_classes,
 	  N_("Retrieve classes"),
 	  NULL,
@@ -1063,6 +1069,53 @@ tree_get (TrackerSparqlConnection *connection,
 	return EXIT_SUCCESS;
 }
 
+/* Translates the query in this process, reading the database directly */
+static int
+sparql_plan (const gchar *sparql)
+{
+	TrackerSparqlQuery *sparql_query;
+	GError *error = NULL;
+	gchar *result;
+
+	if (!tracker_data_manager_init (TRACKER_DB_MANAGER_READONLY,
+	                                NULL,
+	                                NULL,
+	                                FALSE,
+	                                FALSE,
+	                                100,
+	                                100,
+	                                NULL,
+	                                NULL,
+	                                NULL,
+	                                &error)) {
+		g_printerr ("%s: %s\n",
+		            _("Failed to initialize data manager"),
+		            error->message);
+		g_error_free (error);
+		return EXIT_FAILURE;
+	}
+
+	sparql_query = tracker_sparql_query_new (sparql);
+	result = tracker_sparql_query_get_plan (sparql_query, &error);
+	g_object_unref (sparql_query);
+
+	tracker_data_manager_shutdown ();
+
+	if (error) {
+		g_printerr ("%s, %s\n",
+		            _("Could not get query plan"),
+		            error->message);
+		g_error_free (error);
+
+		return EXIT_FAILURE;
+	}
+
+	g_print ("%s", result);
+	g_free (result);
+
+	return EXIT_SUCCESS;
+}
+
 static int
 sparql_run (void)
 {
@@ -1371,6 +1424,12 @@ sparql_run (void)
 		g_free (path_in_utf8);
 	}
 
+	if (query && plan) {
+		g_object_unref (connection);
+
+		return sparql_plan (query);
+	}
+
 	if (query) {
 		if (G_UNLIKELY (update)) {
 			tracker_sparql_connection_update (connection, query, 0, NULL, &error);
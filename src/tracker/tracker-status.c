@@ -38,10 +38,12 @@
 
 #define STATUS_OPTIONS_ENABLED()	  \
 	(show_stat || \
+	 show_extractor_stats || \
 	 collect_debug_info)
 
 static gboolean show_stat;
 static gboolean show_all;
+static gboolean show_extractor_stats;
 static gboolean collect_debug_info;
 static gchar **terms;
 
@@ -56,6 +58,10 @@ static GOptionEntry entries[] = {
 	  N_("Show statistics about ALL RDF classes, not just common ones which is the default (implied by search terms)"),
 	  NULL
 	},
+	{ "extractor-stats", 'e', 0, G_OPTION_ARG_NONE, &show_extractor_stats,
+	  N_("Show time and resources spent by each extractor module since tracker-extract started"),
+	  NULL
+	},
 	{ "collect-debug-info", 0, 0, G_OPTION_ARG_NONE, &collect_debug_info,
 	  N_("Collect debug information useful for problem reporting and investigation, results are output to terminal"),
 	  NULL },
@@ -264,6 +270,131 @@ status_stat (void)
 	return EXIT_SUCCESS;
 }
 
+static void
+print_extractor_module_stats (const gchar *module,
+                              GVariant    *dict)
+{
+	GVariantIter *histogram;
+	gint extracted = 0, failed = 0, cancelled = 0;
+	guint64 bytes_read = 0;
+	gint64 peak_rss_delta = 0;
+	gdouble wall_time = 0, cpu_time = 0;
+	guint limit, count;
+	gchar *size;
+
+	g_variant_lookup (dict, "extracted", "i", &extracted);
+	g_variant_lookup (dict, "failed", "i", &failed);
+	g_variant_lookup (dict, "cancelled", "i", &cancelled);
+	g_variant_lookup (dict, "bytes-read", "t", &bytes_read);
+	g_variant_lookup (dict, "wall-time", "d", &wall_time);
+	g_variant_lookup (dict, "cpu-time", "d", &cpu_time);
+	g_variant_lookup (dict, "peak-rss-delta", "x", &peak_rss_delta);
+
+	size = g_format_size (bytes_read);
+
+	g_print ("  %s\n", module);
+	g_print ("    %s: %d, %s: %d, %s: %d\n",
+	         _("Extracted"), extracted,
+	         _("Failed"), failed,
+	         _("Cancelled"), cancelled);
+	g_print ("    %s: %s\n", _("Data read"), size);
+	g_print ("    %s: %.2fs, %s: %.2fs",
+	         _("Wall time"), wall_time,
+	         _("CPU time"), cpu_time);
+
+	if (extracted > 0) {
+		g_print (", %s: %.1fms", _("average"), (wall_time * 1000) / extracted);
+	}
+
+	g_print ("\n");
+	g_print ("    %s: %" G_GINT64_FORMAT " KiB\n",
+	         _("Largest peak memory increase"), peak_rss_delta);
+
+	if (g_variant_lookup (dict, "latency-histogram", "a(uu)", &histogram)) {
+		guint prev_limit = 0;
+
+		g_print ("    %s:\n", _("Latency"));
+
+		while (g_variant_iter_next (histogram, "(uu)", &limit, &count)) {
+			if (limit == G_MAXUINT) {
+				g_print ("      >= %5ums: %u\n", prev_limit, count);
+			} else {
+				g_print ("      <  %5ums: %u\n", limit, count);
+			}
+
+			prev_limit = limit;
+		}
+
+		g_variant_iter_free (histogram);
+	}
+
+	g_free (size);
+}
+
+static int
+status_extractor_stats (void)
+{
+	GDBusConnection *connection;
+	GVariant *reply, *modules, *dict;
+	GVariantIter iter;
+	GError *error = NULL;
+	const gchar *module;
+	gint unhandled;
+
+	connection = g_bus_get_sync (TRACKER_IPC_BUS, NULL, &error);
+
+	if (!connection) {
+		g_printerr ("%s: %s\n",
+		            _("Could not get D-Bus connection"),
+		            error ? error->message : _("No error given"));
+		g_clear_error (&error);
+		return EXIT_FAILURE;
+	}
+
+	reply = g_dbus_connection_call_sync (connection,
+	                                     "org.freedesktop.Tracker1.Miner.Extract",
+	                                     "/org/freedesktop/Tracker1/Extract/Statistics",
+	                                     "org.freedesktop.Tracker1.Extract.Statistics",
+	                                     "GetStatistics",
+	                                     NULL,
+	                                     G_VARIANT_TYPE ("(a{sa{sv}}i)"),
+	                                     G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                                     -1,
+	                                     NULL,
+	                                     &error);
+	g_object_unref (connection);
+
+	if (!reply) {
+		g_printerr ("%s, %s\n",
+		            _("Could not get extractor statistics"),
+		            error->message);
+		g_error_free (error);
+		return EXIT_FAILURE;
+	}
+
+	g_variant_get (reply, "(@a{sa{sv}}i)", &modules, &unhandled);
+
+	g_print ("%s:\n", _("Extractor statistics"));
+
+	if (g_variant_n_children (modules) == 0) {
+		g_print ("  %s\n", _("None"));
+	}
+
+	g_variant_iter_init (&iter, modules);
+
+	while (g_variant_iter_next (&iter, "{&s@a{sv}}", &module, &dict)) {
+		print_extractor_module_stats (module, dict);
+		g_variant_unref (dict);
+	}
+
+	g_print ("%s: %d\n", _("Files without a suitable extractor"), unhandled);
+
+	g_variant_unref (modules);
+	g_variant_unref (reply);
+
+	return EXIT_SUCCESS;
+}
+
 static int
 collect_debug (void)
 {
@@ -472,6 +603,10 @@ status_run (void)
 		return status_stat ();
 	}
 
+	if (show_extractor_stats) {
+		return status_extractor_stats ();
+	}
+
 	if (collect_debug_info) {
 		return collect_debug ();
 	}
@@ -31,6 +31,9 @@ from gi.repository import GObject
 from gi.repository import GLib
 import dbus
 from dbus.mainloop.glib import DBusGMainLoop
+import os
+import select
+import struct
 import time
 
 GRAPH_UPDATED_SIGNAL = "GraphUpdated"
@@ -39,6 +42,7 @@ SIGNALS_PATH = "/org/freedesktop/Tracker1/Resources"
 SIGNALS_IFACE = "org.freedesktop.Tracker1.Resources"
 
 CONTACT_CLASS_URI = "http://www.semanticdesktop.org/ontologies/2007/03/22/nco#PersonContact"
+FULLNAME_PROPERTY_URI = "http://www.semanticdesktop.org/ontologies/2007/03/22/nco#fullname"
 
 REASONABLE_TIMEOUT = 10 # Time waiting for the signal to be emitted
 
@@ -105,6 +109,20 @@ class TrackerStoreSignalsTests (CommonTrackerStoreTest):
         self.loop.quit ()
         self.bus._clean_up_signal_match (self.cb_id)
 
+    def __read (self, fd, size):
+        data = ""
+        while len (data) < size:
+            ready, _, _ = select.select ([fd], [], [], REASONABLE_TIMEOUT)
+            if not ready:
+                self.fail ("Timeout, the changes never came!")
+            data += os.read (fd, size - len (data))
+        return data
+
+    def __read_changes (self, fd):
+        count, = struct.unpack ("=i", self.__read (fd, 4))
+        data = self.__read (fd, count * 16)
+        return [struct.unpack_from ("=4i", data, i * 16) for i in range (count)]
+
 
     def test_01_insert_contact (self):
         self.clean_up_list.append ("test://signals-contact-add")
@@ -183,7 +201,66 @@ class TrackerStoreSignalsTests (CommonTrackerStoreTest):
 
         self.assertEquals (len (self.results_deletes), 1)
         self.assertEquals (len (self.results_inserts), 1)
-        
+
+    def test_05_replace_literal_contact (self):
+        self.clean_up_list.append ("test://signals-contact-replace")
+
+        self.__connect_signal ()
+        self.tracker.update ("INSERT { <test://signals-contact-replace> a nco:PersonContact; nco:fullname 'first value' }")
+        self.__wait_for_signal ()
+
+        self.__connect_signal ()
+        self.tracker.update ("""
+               DELETE { <test://signals-contact-replace> nco:fullname 'first value' }
+               INSERT { <test://signals-contact-replace> nco:fullname 'second value' }
+               """)
+        self.__wait_for_signal ()
+
+        # both literals have no object ID, the change must not be coalesced
+        self.assertEquals (len (self.results_deletes), 1)
+        self.assertEquals (len (self.results_inserts), 1)
+
+    def test_06_coalesced_contact (self):
+        self.clean_up_list.append ("test://signals-contact-coalesced")
+
+        self.__connect_signal ()
+        self.tracker.update ("""
+               INSERT { <test://signals-contact-coalesced> a nco:PersonContact;
+                        nco:hasPhoneNumber <tel:555555556> }
+               DELETE { <test://signals-contact-coalesced> nco:hasPhoneNumber <tel:555555556> }
+               """)
+        self.__wait_for_signal ()
+
+        # the phone number was inserted and deleted in between signals
+        self.assertEquals (len (self.results_deletes), 0)
+        self.assertEquals (len (self.results_inserts), 1)
+
+    def test_07_subscribe_contact (self):
+        self.clean_up_list.append ("test://signals-contact-subscribe")
+
+        read_fd, write_fd = os.pipe ()
+        resources = dbus.Interface (self.bus.get_object ("org.freedesktop.Tracker1", SIGNALS_PATH),
+                                    dbus_interface = SIGNALS_IFACE)
+        resources.Subscribe ([CONTACT_CLASS_URI], [FULLNAME_PROPERTY_URI], [],
+                             dbus.types.UnixFd (write_fd))
+        os.close (write_fd)
+
+        self.tracker.update ("""
+               INSERT { <test://signals-contact-subscribe> a nco:PersonContact;
+                        nco:fullname 'subscribed'; nco:nameGiven 'not subscribed' }
+               """)
+
+        length, = struct.unpack ("=i", self.__read (read_fd, 4))
+        self.assertEquals (self.__read (read_fd, length), CONTACT_CLASS_URI)
+
+        # only the nco:fullname change is sent
+        deletes = self.__read_changes (read_fd)
+        inserts = self.__read_changes (read_fd)
+        os.close (read_fd)
+
+        self.assertEquals (len (deletes), 0)
+        self.assertEquals (len (inserts), 1)
+
 
 if __name__ == "__main__":
     ut.main()
@@ -122,6 +122,21 @@ class TrackerStoreStatisticsTests (CommonTrackerStoreTest):
             else:
                 self.assertEquals (old_stats [k], new_stats [k])
 
+    def test_stats_04_property_counts (self):
+        self.clean_up_instances.append ("test://stats-04")
+        self.tracker.update ("INSERT { <test://stats-04> a nie:InformationElement. }")
+
+        old_count = int (self.tracker.get_property_stats (["nie:title"])[0][1])
+        self.tracker.update ("INSERT { <test://stats-04> nie:title 'Stats 04'. }")
+        self.assertEquals (int (self.tracker.get_property_stats (["nie:title"])[0][1]), old_count + 1)
+
+        # Replacing the value does not change the count
+        self.tracker.update ("INSERT OR REPLACE { <test://stats-04> nie:title 'Stats 04 bis'. }")
+        self.assertEquals (int (self.tracker.get_property_stats (["nie:title"])[0][1]), old_count + 1)
+
+        self.tracker.update ("DELETE { <test://stats-04> a rdfs:Resource. }")
+        self.assertEquals (int (self.tracker.get_property_stats (["nie:title"])[0][1]), old_count)
+
 if __name__ == "__main__":
     ut.main ()
 
@@ -296,11 +296,11 @@ class MinerFTSStopwordsTest (CommonMinerFTS):
         if "_" in langcode:
             langcode = langcode.split ("_")[0]
 
-        stopwordsfile = os.path.join (cfg.DATADIR, "tracker", "stop-words", "stopwords." + langcode)
+        stopwordsfile = os.path.join (cfg.STOP_WORDS_SRCDIR, "stopwords." + langcode)
 
         if not os.path.exists (stopwordsfile):
-            self.skipTest ("No stopwords for the current locale ('%s' doesn't exist)" % (stopwordsfile))
-            return []
+            # English stop words are merged into every language's list
+            stopwordsfile = os.path.join (cfg.STOP_WORDS_SRCDIR, "stopwords.en")
         
         stopwords = []
         counter = 0
@@ -515,6 +515,9 @@ class StoreHelper (Helper):
                 return self.stats_iface.Get ()
             raise (e)
 
+    def get_property_stats (self, properties):
+        return self.stats_iface.GetProperties (properties)
+
 
     def get_tracker_iface (self):
         return self.resources
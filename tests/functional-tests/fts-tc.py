@@ -26,6 +26,7 @@ import time
 import random
 import commands
 import configuration
+from common.utils import configuration as cfg
 from dbus.mainloop.glib import DBusGMainLoop
 from gi.repository import GObject
 import shutil
@@ -469,7 +470,7 @@ class stopwords (TestUpdate):
 	file_path =  configuration.MYDOCS + TEST_TEXT                   
                                                                         
         """copy the test files """                                      
-	test_file='/usr/share/tracker/stop-words/stopwords.en'
+	test_file=os.path.join(cfg.STOP_WORDS_SRCDIR, 'stopwords.en')
 	f1=open(test_file,'r')
 	lines = f1.readlines()
 	f1.close()
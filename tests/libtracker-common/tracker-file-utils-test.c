@@ -424,6 +424,48 @@ test_file_utils_cmp ()
         g_assert (tracker_file_cmp (two, three));
 }
 
+static void
+test_file_utils_get_content_fingerprint ()
+{
+        GFile *file;
+        GError *error = NULL;
+        gchar *fingerprint, *touched, *changed;
+
+        g_file_set_contents ("./fingerprint-test-file", "Some contents", -1, NULL);
+        file = g_file_new_for_path ("./fingerprint-test-file");
+
+        fingerprint = tracker_file_get_content_fingerprint (file, NULL, &error);
+        g_assert_no_error (error);
+        g_assert (fingerprint != NULL);
+
+        /* Rewriting the same contents keeps the fingerprint */
+        g_file_set_contents ("./fingerprint-test-file", "Some contents", -1, NULL);
+        touched = tracker_file_get_content_fingerprint (file, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpstr (fingerprint, ==, touched);
+
+        /* Same size, different contents */
+        g_file_set_contents ("./fingerprint-test-file", "Some Contents", -1, NULL);
+        changed = tracker_file_get_content_fingerprint (file, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpstr (fingerprint, !=, changed);
+
+        g_free (fingerprint);
+        g_free (touched);
+        g_free (changed);
+        g_object_unref (file);
+
+        remove_file ("./fingerprint-test-file");
+
+        /* File doesn't exist */
+        file = g_file_new_for_path ("./file-does-NOT-exist");
+        fingerprint = tracker_file_get_content_fingerprint (file, NULL, &error);
+        g_assert (fingerprint == NULL);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+        g_clear_error (&error);
+        g_object_unref (file);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -464,6 +506,8 @@ main (int argc, char **argv)
                          test_file_utils_is_hidden);
         g_test_add_func ("/libtracker-common/file-utils/cmp",
                          test_file_utils_cmp);
+        g_test_add_func ("/libtracker-common/file-utils/get_content_fingerprint",
+                         test_file_utils_get_content_fingerprint);
 
 	result = g_test_run ();
 
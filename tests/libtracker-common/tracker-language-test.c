@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <libtracker-common/tracker-language.h>
+
+typedef struct {
+	const gchar *text;
+	const gchar *language_code;
+} TestDataDetect;
+
+static const TestDataDetect test_data_detect[] = {
+	{ "The quick brown fox jumps over the lazy dog while all of the other animals are watching it from the barn", "en" },
+	{ "Le renard brun saute par dessus le chien paresseux pendant que les autres animaux le regardent depuis la grange", "fr" },
+	{ "Der schnelle braune Fuchs springt über den faulen Hund, während die anderen Tiere ihn aus der Scheune beobachten", "de" },
+	{ "El rápido zorro marrón salta sobre el perro perezoso mientras los otros animales lo miran desde el granero", "es" },
+	{ "Il veloce volpe marrone salta sopra il cane pigro mentre gli altri animali lo guardano dal fienile", "it" },
+	{ "A rápida raposa marrom pula sobre o cão preguiçoso enquanto os outros animais o observam do celeiro", "pt" },
+	{ "Den snabba bruna räven hoppar över den lata hunden medan de andra djuren tittar på den från ladan", "sv" },
+	/* Too short to tell */
+	{ "renard brun", NULL },
+	{ "", NULL },
+	{ NULL, NULL }
+};
+
+static void
+test_detect (gconstpointer user_data)
+{
+	const TestDataDetect *testdata = user_data;
+
+	g_assert_cmpstr (tracker_language_detect (testdata->text, -1), ==, testdata->language_code);
+}
+
+static void
+test_stop_words (void)
+{
+	TrackerLanguage *language;
+
+	language = tracker_language_new ("fr");
+	g_assert (tracker_language_is_stop_word (language, "avec"));
+	/* English stop words apply to every language */
+	g_assert (tracker_language_is_stop_word (language, "the"));
+	g_assert (!tracker_language_is_stop_word (language, "renard"));
+
+	tracker_language_set_language_code (language, "de");
+	g_assert (tracker_language_is_stop_word (language, "aber"));
+	g_assert (!tracker_language_is_stop_word (language, "avec"));
+
+	tracker_language_set_language_code (language, NULL);
+	g_assert_cmpstr (tracker_language_get_language_code (language), ==, "en");
+	g_assert (tracker_language_is_stop_word (language, "the"));
+	g_assert (!tracker_language_is_stop_word (language, "aber"));
+
+	g_object_unref (language);
+}
+
+static void
+count_trigram (const gchar *trigram,
+               gpointer     user_data)
+{
+	GPtrArray *trigrams = user_data;
+
+	g_ptr_array_add (trigrams, g_strdup (trigram));
+}
+
+static void
+test_trigrams (void)
+{
+	GPtrArray *trigrams;
+
+	trigrams = g_ptr_array_new_with_free_func (g_free);
+
+	tracker_language_foreach_trigram ("daß", -1, count_trigram, trigrams);
+	g_assert_cmpint (trigrams->len, ==, 3);
+	g_assert_cmpstr (g_ptr_array_index (trigrams, 0), ==, "_da");
+	g_assert_cmpstr (g_ptr_array_index (trigrams, 1), ==, "daß");
+	g_assert_cmpstr (g_ptr_array_index (trigrams, 2), ==, "aß_");
+
+	g_ptr_array_unref (trigrams);
+}
+
+int
+main (int argc, char **argv)
+{
+	gint i;
+
+	g_test_init (&argc, &argv, NULL);
+
+	g_setenv ("TRACKER_LANGUAGE_STOP_WORDS_DIR",
+	          TOP_BUILDDIR "/src/libtracker-common/stop-words",
+	          TRUE);
+
+	for (i = 0; test_data_detect[i].text != NULL; i++) {
+		gchar *testpath;
+
+		testpath = g_strdup_printf ("/libtracker-common/language/detect_%d", i);
+		g_test_add_data_func (testpath, &test_data_detect[i], test_detect);
+		g_free (testpath);
+	}
+
+	g_test_add_func ("/libtracker-common/language/stop-words", test_stop_words);
+	g_test_add_func ("/libtracker-common/language/trigrams", test_trigrams);
+
+	return g_test_run ();
+}
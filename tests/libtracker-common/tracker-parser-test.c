@@ -331,6 +331,11 @@ static const TestDataExpectedNWords test_data_nwords[] = {
 	{ "filename.txt",                                           TRUE,   2, -1 },
 	{ ".hidden.txt",                                            TRUE,   2, -1 },
 	{ "noextension.",                                           TRUE,   1, -1 },
+	/* Pure ASCII text is split without going through ICU, it
+	 *  must give the same words. */
+	{ "can't stop 1,000,000 snake_case",                        TRUE,   3, -1 },
+	{ "can't stop 1,000,000 snake_case",                        FALSE,  4, -1 },
+	{ "it's a naïve café, isn't it?",                           TRUE,   6, -1 },
 	{ "ホモ・サピエンス",                                          TRUE,   2, -1 }, /* katakana */
 	{ "喂人类",                                                   TRUE,   2, 3 }, /* chinese */
 	{ "Американские суда находятся в международных водах.",     TRUE,   6, -1 }, /* russian */
@@ -357,9 +362,9 @@ main (int argc, char **argv)
 
 	/* We want the tests to properly find the stopwords dictionaries, so we
 	 *  need to set the following envvar with the path where the
-	 *  dictionaries are. */
+	 *  compiled dictionaries are. */
 	g_setenv ("TRACKER_LANGUAGE_STOP_WORDS_DIR",
-	          TOP_SRCDIR "/src/libtracker-common/stop-words",
+	          TOP_BUILDDIR "/src/libtracker-common/stop-words",
 	          TRUE);
 
 	/* Add normalization checks */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+#include <libtracker-data/tracker-data-update.h>
+#include <libtracker-data/tracker-data.h>
+
+#include "tracker-data-test-common.h"
+
+/* Answered from the Statistics and Aggregates tables */
+#define SUM_QUERY "SELECT (SUM (?s) AS ?t) WHERE { ?f nfo:fileSize ?s }"
+#define AVG_QUERY "SELECT (AVG (?s) AS ?t) WHERE { ?f nfo:fileSize ?s }"
+#define COUNT_QUERY "SELECT (COUNT (?f) AS ?c) WHERE { ?f a nfo:FileDataObject }"
+
+/* The FILTER keeps these from being answered from the tables */
+#define SUM_REFERENCE_QUERY "SELECT (SUM (?s) AS ?t) WHERE { ?f nfo:fileSize ?s FILTER (?s >= 0) }"
+#define COUNT_REFERENCE_QUERY "SELECT (COUNT (?f) AS ?c) WHERE { ?f a nfo:FileDataObject FILTER (?f != <urn:none>) }"
+
+static gboolean
+query_number (const gchar *sparql,
+              gdouble     *value)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gboolean bound;
+
+	cursor = tracker_data_query_sparql_cursor (sparql, &error);
+	g_assert_no_error (error);
+
+	g_assert_true (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	bound = (tracker_db_cursor_get_value_type (cursor, 0) != TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+	*value = tracker_db_cursor_get_double (cursor, 0);
+
+	g_object_unref (cursor);
+
+	return bound;
+}
+
+static void
+check_aggregates (gdouble sum,
+                  gint    count)
+{
+	gdouble value, reference;
+
+	g_assert_true (query_number (SUM_QUERY, &value));
+	g_assert_true (query_number (SUM_REFERENCE_QUERY, &reference));
+	g_assert_cmpfloat (value, ==, sum);
+	g_assert_cmpfloat (reference, ==, sum);
+
+	g_assert_true (query_number (AVG_QUERY, &value));
+	g_assert_cmpfloat (value, ==, sum / count);
+
+	g_assert_true (query_number (COUNT_QUERY, &value));
+	g_assert_true (query_number (COUNT_REFERENCE_QUERY, &reference));
+	g_assert_cmpfloat (value, ==, count);
+	g_assert_cmpfloat (reference, ==, count);
+}
+
+static void
+test_aggregates (TestInfo      *info,
+                 gconstpointer  context)
+{
+	GError *error = NULL;
+	gdouble value;
+
+	test_data_manager_init ();
+
+	g_assert_true (tracker_data_get_statistics_available ());
+
+	/* No values sum up to NULL, as with SQLite */
+	g_assert_false (query_number (SUM_QUERY, &value));
+
+	tracker_data_update_sparql ("INSERT { "
+	                            "<urn:test:f1> a nfo:FileDataObject ; nfo:fileSize 10 . "
+	                            "<urn:test:f2> a nfo:FileDataObject ; nfo:fileSize 20 . "
+	                            "<urn:test:f3> a nfo:FileDataObject ; nfo:fileSize 30 }",
+	                            &error);
+	g_assert_no_error (error);
+	check_aggregates (60, 3);
+
+	/* Replaced values are taken out of the sum */
+	tracker_data_update_sparql ("INSERT OR REPLACE { <urn:test:f1> nfo:fileSize 15 }", &error);
+	g_assert_no_error (error);
+	check_aggregates (65, 3);
+
+	tracker_data_update_sparql ("DELETE { <urn:test:f2> nfo:fileSize 20 }", &error);
+	g_assert_no_error (error);
+	check_aggregates (45, 3);
+
+	tracker_data_update_sparql ("DELETE { <urn:test:f3> a rdfs:Resource }", &error);
+	g_assert_no_error (error);
+	check_aggregates (15, 2);
+
+	tracker_data_manager_shutdown ();
+}
+
+int
+main (int argc, char **argv)
+{
+	test_data_init (&argc, &argv);
+	test_data_add ("/libtracker-data/aggregates", test_aggregates);
+
+	return test_data_run ();
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+#include <libtracker-data/tracker-data-query.h>
+#include <libtracker-data/tracker-data-update.h>
+#include <libtracker-data/tracker-data.h>
+
+#include "tracker-data-test-common.h"
+
+static void
+update (const gchar *sparql)
+{
+	GError *error = NULL;
+
+	tracker_data_update_sparql (sparql, &error);
+	g_assert_no_error (error);
+}
+
+/* Returns the highest modseq seen, checks every row is an op on
+ * urn:test:contact, counting the ones about nco:fullname.
+ */
+static gint
+check_changes (gint  modseq,
+               gint  op,
+               gint *n_fullname)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gint last = modseq;
+
+	*n_fullname = 0;
+
+	cursor = tracker_data_query_changes_since (modseq, NULL, 0, -1, &error);
+	g_assert_no_error (error);
+	g_assert (cursor != NULL);
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, &error)) {
+		const gchar *predicate;
+
+		g_assert_cmpint (tracker_db_cursor_get_int (cursor, 0), >, modseq);
+		g_assert_cmpint (tracker_db_cursor_get_int (cursor, 0), >=, last);
+		last = tracker_db_cursor_get_int (cursor, 0);
+
+		g_assert_cmpstr (tracker_db_cursor_get_string (cursor, 2, NULL), ==, "urn:test:contact");
+		g_assert_cmpint (tracker_db_cursor_get_int (cursor, 4), ==, op);
+
+		predicate = tracker_db_cursor_get_string (cursor, 3, NULL);
+
+		if (g_strcmp0 (predicate, "http://www.semanticdesktop.org/ontologies/2007/03/22/nco#fullname") == 0) {
+			(*n_fullname)++;
+		}
+	}
+
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+
+	return last;
+}
+
+static void
+test_change_log (TestInfo      *info,
+                 gconstpointer  context)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gint start, modseq, n_fullname;
+
+	test_data_manager_init ();
+
+	start = tracker_data_get_change_log_start ();
+	g_assert_cmpint (start, >, 0);
+
+	update ("INSERT { <urn:test:contact> a nco:PersonContact ; nco:fullname 'John' }");
+
+	modseq = check_changes (start - 1, 1, &n_fullname);
+	g_assert_cmpint (modseq, >=, start);
+	g_assert_cmpint (n_fullname, ==, 1);
+
+	/* Nothing happened after the last modseq */
+	g_assert_cmpint (check_changes (modseq, 1, &n_fullname), ==, modseq);
+	g_assert_cmpint (n_fullname, ==, 0);
+
+	update ("DELETE { <urn:test:contact> nco:fullname 'John' } WHERE { }");
+
+	g_assert_cmpint (check_changes (modseq, 0, &n_fullname), >, modseq);
+	g_assert_cmpint (n_fullname, ==, 1);
+
+	/* Changes from before the log started are not known */
+	cursor = tracker_data_query_changes_since (start - 2, NULL, 0, -1, &error);
+	g_assert_error (error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_CHANGES_EXPIRED);
+	g_assert (cursor == NULL);
+	g_clear_error (&error);
+
+	tracker_data_manager_shutdown ();
+}
+
+int
+main (int argc, char **argv)
+{
+	test_data_init (&argc, &argv);
+	test_data_add ("/libtracker-data/change-log", test_change_log);
+
+	return test_data_run ();
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Measures reading numeric columns from a TrackerDBCursor, converting
+ * every value to text as Steroids used to, against reading them with
+ * the type SQLite stores them as.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libtracker-data/tracker-data.h>
+#include <libtracker-data/tracker-db-interface-sqlite.h>
+
+#define QUERY_REPEATS 3
+#define N_COLUMNS 3
+
+static gint n_rows = 1000000;
+
+static GOptionEntry entries[] = {
+	{ "rows", 'n', 0, G_OPTION_ARG_INT, &n_rows,
+	  "Number of rows to read (default: 1000000)", "N" },
+	{ NULL }
+};
+
+static TrackerPropertyType types[N_COLUMNS] = {
+	TRACKER_PROPERTY_TYPE_INTEGER,
+	TRACKER_PROPERTY_TYPE_INTEGER,
+	TRACKER_PROPERTY_TYPE_DOUBLE
+};
+
+static void
+populate (TrackerDBInterface *iface)
+{
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+	GRand *rand;
+	gint i;
+
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "CREATE TABLE files (id INTEGER, size INTEGER, mtime REAL)");
+	g_assert_no_error (error);
+
+	stmt = tracker_db_interface_create_statement (iface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_NONE,
+	                                              &error,
+	                                              "INSERT INTO files (id, size, mtime) VALUES (?, ?, ?)");
+	g_assert_no_error (error);
+
+	rand = g_rand_new_with_seed (42);
+
+	tracker_db_interface_start_transaction (iface);
+
+	for (i = 0; i < n_rows; i++) {
+		tracker_db_statement_bind_int (stmt, 0, i);
+		tracker_db_statement_bind_int (stmt, 1, g_rand_int_range (rand, 0, G_MAXINT32));
+		tracker_db_statement_bind_double (stmt, 2, g_rand_double_range (rand, 0, 2000000000));
+		tracker_db_statement_execute (stmt, &error);
+		g_assert_no_error (error);
+	}
+
+	tracker_db_interface_end_db_transaction (iface, &error);
+	g_assert_no_error (error);
+
+	g_rand_free (rand);
+	g_object_unref (stmt);
+}
+
+static void
+read_as_text (TrackerDBCursor *cursor)
+{
+	gsize total = 0;
+	gint i;
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+		for (i = 0; i < N_COLUMNS; i++) {
+			glong length;
+
+			tracker_db_cursor_get_string (cursor, i, &length);
+			total += length;
+		}
+	}
+
+	g_assert (total > 0);
+}
+
+static void
+read_typed (TrackerDBCursor *cursor)
+{
+	gdouble total = 0;
+	gint i;
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+		for (i = 0; i < N_COLUMNS; i++) {
+			switch (tracker_db_cursor_get_value_type (cursor, i)) {
+			case TRACKER_SPARQL_VALUE_TYPE_INTEGER:
+				total += tracker_db_cursor_get_int (cursor, i);
+				break;
+			case TRACKER_SPARQL_VALUE_TYPE_DOUBLE:
+				total += tracker_db_cursor_get_double (cursor, i);
+				break;
+			default:
+				g_assert_not_reached ();
+			}
+		}
+	}
+
+	g_assert (total > 0);
+}
+
+static void
+run_query (TrackerDBInterface *iface,
+           const gchar        *name,
+           void              (*read_cursor) (TrackerDBCursor *cursor))
+{
+	gdouble best = G_MAXDOUBLE;
+	gint i;
+
+	for (i = 0; i < QUERY_REPEATS; i++) {
+		TrackerDBStatement *stmt;
+		TrackerDBCursor *cursor;
+		GError *error = NULL;
+		GTimer *timer;
+
+		timer = g_timer_new ();
+
+		stmt = tracker_db_interface_create_statement (iface,
+		                                              TRACKER_DB_STATEMENT_CACHE_TYPE_NONE,
+		                                              &error,
+		                                              "SELECT id, size, mtime FROM files");
+		g_assert_no_error (error);
+
+		cursor = tracker_db_statement_start_sparql_cursor (stmt, types, N_COLUMNS,
+		                                                   NULL, 0, FALSE, &error);
+		g_assert_no_error (error);
+
+		read_cursor (cursor);
+
+		best = MIN (best, g_timer_elapsed (timer, NULL));
+
+		g_object_unref (cursor);
+		g_object_unref (stmt);
+		g_timer_destroy (timer);
+	}
+
+	g_print ("  %-10s %.2fms\n", name, best * 1000);
+}
+
+int
+main (int argc, char **argv)
+{
+	GOptionContext *context;
+	TrackerDBInterface *iface;
+	GError *error = NULL;
+	gchar *dir, *filename;
+
+	context = g_option_context_new ("- Benchmark reading numeric cursor columns");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_parse (context, &argc, &argv, NULL);
+	g_option_context_free (context);
+
+	dir = g_dir_make_tmp ("tracker-cursor-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	filename = g_build_filename (dir, "benchmark.db", NULL);
+	iface = tracker_db_interface_sqlite_new (filename, &error);
+	g_assert_no_error (error);
+
+	populate (iface);
+
+	g_print ("%d rows of id, size, mtime:\n", n_rows);
+	run_query (iface, "text", read_as_text);
+	run_query (iface, "typed", read_typed);
+
+	g_object_unref (iface);
+
+	g_unlink (filename);
+	g_rmdir (dir);
+	g_free (filename);
+	g_free (dir);
+
+	return 0;
+}
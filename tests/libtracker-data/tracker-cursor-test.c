@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+#include <libtracker-data/tracker-data-query.h>
+#include <libtracker-data/tracker-data-update.h>
+#include <libtracker-data/tracker-data.h>
+
+#include "tracker-data-test-common.h"
+
+/* ?s is an xsd:integer property. The expressions are typed after their
+ * first operand, so ?d is typed as an integer while SQLite holds a
+ * double in it */
+#define VALUE_TYPES_QUERY \
+	"SELECT ?s (?s * 1.5 AS ?d) (?s + 1 AS ?i) ?t " \
+	"WHERE { <urn:test:f1> nfo:fileSize ?s " \
+	"OPTIONAL { <urn:test:f1> nie:title ?t } }"
+
+static void
+test_value_types (TestInfo      *info,
+                  gconstpointer  context)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+
+	test_data_manager_init ();
+
+	tracker_data_update_sparql ("INSERT { <urn:test:f1> a nfo:FileDataObject ; nfo:fileSize 10 }",
+	                            &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_data_query_sparql_cursor (VALUE_TYPES_QUERY, &error);
+	g_assert_no_error (error);
+
+	g_assert_true (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_assert_cmpint (tracker_db_cursor_get_value_type (cursor, 0), ==, TRACKER_SPARQL_VALUE_TYPE_INTEGER);
+	g_assert_cmpint (tracker_db_cursor_get_int (cursor, 0), ==, 10);
+	g_assert_cmpint (tracker_db_cursor_get_value_type (cursor, 1), ==, TRACKER_SPARQL_VALUE_TYPE_DOUBLE);
+	g_assert_cmpfloat (tracker_db_cursor_get_double (cursor, 1), ==, 15.0);
+	g_assert_cmpint (tracker_db_cursor_get_value_type (cursor, 2), ==, TRACKER_SPARQL_VALUE_TYPE_INTEGER);
+	g_assert_cmpint (tracker_db_cursor_get_int (cursor, 2), ==, 11);
+	g_assert_cmpint (tracker_db_cursor_get_value_type (cursor, 3), ==, TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+
+	g_assert_false (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_object_unref (cursor);
+
+	tracker_data_manager_shutdown ();
+}
+
+int
+main (int argc, char **argv)
+{
+	test_data_init (&argc, &argv);
+	test_data_add ("/libtracker-data/cursor/value-types", test_value_types);
+
+	return test_data_run ();
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <locale.h>
+
+#include <glib/gstdio.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+
+#include "tracker-data-test-common.h"
+
+static gchar *tests_data_dir = NULL;
+static gchar *xdg_location = NULL;
+
+void
+test_data_init (int    *argc,
+                char ***argv)
+{
+	gchar *current_dir;
+
+	setlocale (LC_COLLATE, "en_US.utf8");
+
+	current_dir = g_get_current_dir ();
+	tests_data_dir = g_build_path (G_DIR_SEPARATOR_S, current_dir, "test-data", NULL);
+	g_free (current_dir);
+
+	g_test_init (argc, argv, NULL);
+}
+
+gint
+test_data_run (void)
+{
+	gint result;
+
+	result = g_test_run ();
+
+	g_remove (tests_data_dir);
+	g_free (tests_data_dir);
+	tests_data_dir = NULL;
+
+	return result;
+}
+
+void
+test_data_setup (TestInfo      *info,
+                 gconstpointer  context)
+{
+	if (!xdg_location) {
+		gchar *basename;
+
+		basename = g_strdup_printf ("%d", g_test_rand_int_range (0, G_MAXINT));
+		xdg_location = g_build_path (G_DIR_SEPARATOR_S, tests_data_dir, basename, NULL);
+		g_free (basename);
+
+		g_assert_true (g_setenv ("XDG_DATA_HOME", xdg_location, TRUE));
+		g_assert_true (g_setenv ("XDG_CACHE_HOME", xdg_location, TRUE));
+		g_assert_true (g_setenv ("TRACKER_DB_ONTOLOGIES_DIR", TOP_SRCDIR "/src/ontologies/", TRUE));
+	}
+}
+
+void
+test_data_teardown (TestInfo      *info,
+                    gconstpointer  context)
+{
+	gchar *cleanup_command;
+
+	g_print ("Removing temporary data (%s)\n", xdg_location);
+
+	cleanup_command = g_strdup_printf ("rm -Rf %s/", xdg_location);
+	g_spawn_command_line_sync (cleanup_command, NULL, NULL, NULL, NULL);
+	g_free (cleanup_command);
+
+	g_free (xdg_location);
+	xdg_location = NULL;
+}
+
+/* Creates an empty database with the default ontologies */
+void
+test_data_manager_init (void)
+{
+	GError *error = NULL;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           NULL,
+	                           NULL,
+	                           FALSE,
+	                           FALSE,
+	                           100,
+	                           100,
+	                           NULL,
+	                           NULL,
+	                           NULL,
+	                           &error);
+	g_assert_no_error (error);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __TRACKER_DATA_TEST_COMMON__
+#define __TRACKER_DATA_TEST_COMMON__
+
+#include <glib.h>
+
+#include <libtracker-data/tracker-data.h>
+
+typedef struct {
+	void *user_data;
+} TestInfo;
+
+/* Adds a test case running in its own XDG data and cache directories */
+#define test_data_add(path, func) \
+	g_test_add (path, TestInfo, NULL, test_data_setup, func, test_data_teardown)
+
+void test_data_init         (int            *argc,
+                             char         ***argv);
+gint test_data_run          (void);
+
+void test_data_setup        (TestInfo       *info,
+                             gconstpointer   context);
+void test_data_teardown     (TestInfo       *info,
+                             gconstpointer   context);
+
+void test_data_manager_init (void);
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+#include <libtracker-data/tracker-data-update.h>
+#include <libtracker-data/tracker-data.h>
+
+#include "tracker-data-test-common.h"
+
+#define PAGED_QUERY \
+	"SELECT ?c ?n WHERE { ?c a nco:PersonContact " \
+	"OPTIONAL { ?c nco:fullname ?n } FILTER (fn:starts-with (?c, 'urn:test:')) } " \
+	"ORDER BY DESC (?n) LIMIT 2"
+
+static TrackerDBCursor *
+query_continue (const gchar  *sparql,
+                const gchar  *continuation,
+                GError      **error)
+{
+	TrackerSparqlQuery *query;
+	TrackerDBCursor *cursor;
+
+	query = tracker_sparql_query_new (sparql);
+	cursor = tracker_sparql_query_execute_cursor_continued (query, continuation, FALSE, error);
+	g_object_unref (query);
+
+	return cursor;
+}
+
+static void
+test_keyset (TestInfo      *info,
+             gconstpointer  context)
+{
+	GHashTable *seen;
+	GError *error = NULL;
+	gchar *continuation = NULL, *last_name = NULL;
+	gint n_pages = 0;
+
+	test_data_manager_init ();
+
+	/* Ties on 'b' span page boundaries, c5 sorts last */
+	tracker_data_update_sparql ("INSERT { "
+	                            "<urn:test:c1> a nco:PersonContact ; nco:fullname 'b' . "
+	                            "<urn:test:c2> a nco:PersonContact ; nco:fullname 'a' . "
+	                            "<urn:test:c3> a nco:PersonContact ; nco:fullname 'b' . "
+	                            "<urn:test:c4> a nco:PersonContact ; nco:fullname 'c' . "
+	                            "<urn:test:c5> a nco:PersonContact . "
+	                            "<urn:test:c6> a nco:PersonContact ; nco:fullname 'b' . "
+	                            "<urn:test:c7> a nco:PersonContact ; nco:fullname 'd' }",
+	                            &error);
+	g_assert_no_error (error);
+
+	seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	while (TRUE) {
+		TrackerDBCursor *cursor;
+		gint n_rows = 0;
+
+		cursor = query_continue (PAGED_QUERY, continuation, &error);
+		g_assert_no_error (error);
+
+		while (tracker_db_cursor_iter_next (cursor, NULL, &error)) {
+			const gchar *name;
+
+			/* the ORDER BY key is not returned */
+			g_assert_cmpint (tracker_db_cursor_get_n_columns (cursor), ==, 2);
+
+			g_assert_false (g_hash_table_contains (seen, tracker_db_cursor_get_string (cursor, 0, NULL)));
+			g_hash_table_add (seen, g_strdup (tracker_db_cursor_get_string (cursor, 0, NULL)));
+
+			name = tracker_db_cursor_get_string (cursor, 1, NULL);
+			if (g_hash_table_size (seen) > 1) {
+				g_assert_cmpint (g_strcmp0 (name, last_name), <=, 0);
+			}
+
+			g_free (last_name);
+			last_name = g_strdup (name);
+			n_rows++;
+		}
+		g_assert_no_error (error);
+
+		if (n_rows > 0) {
+			g_free (continuation);
+			continuation = tracker_sparql_cursor_get_continuation (TRACKER_SPARQL_CURSOR (cursor));
+			g_assert (continuation != NULL);
+			n_pages++;
+		}
+
+		g_object_unref (cursor);
+
+		if (n_rows < 2) {
+			break;
+		}
+	}
+
+	g_assert_cmpint (g_hash_table_size (seen), ==, 7);
+	g_assert_cmpint (n_pages, ==, 4);
+	g_assert (last_name == NULL);
+
+	/* Continuations only apply to the query they come from */
+	g_assert (query_continue ("SELECT ?c WHERE { ?c a nco:PersonContact } ORDER BY ?c LIMIT 2", continuation, &error) == NULL);
+	g_assert_error (error, TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_PARSE);
+	g_clear_error (&error);
+
+	g_assert (query_continue (PAGED_QUERY, "garbage", &error) == NULL);
+	g_assert_error (error, TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_PARSE);
+	g_clear_error (&error);
+
+	g_hash_table_unref (seen);
+	g_free (continuation);
+
+	tracker_data_manager_shutdown ();
+}
+
+int
+main (int argc, char **argv)
+{
+	test_data_init (&argc, &argv);
+	test_data_add ("/libtracker-data/keyset", test_keyset);
+
+	return test_data_run ();
+}
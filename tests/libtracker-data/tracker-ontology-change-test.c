@@ -44,8 +44,19 @@ struct _ChangeInfo {
 	const gchar *update;
 	const gchar *test_name;
 	const gchar *ptr;
+	/* Expected composite and partial indexes of example:A */
+	const gchar *indexes;
 };
 
+#define COMPOSITE_1_2 "CREATE INDEX \"example:A_composite_example:single1_example:single2\" " \
+	"ON \"example:A\" (\"example:single1\", \"example:single2\")\n"
+#define COMPOSITE_2_1 "CREATE INDEX \"example:A_composite_example:single2_example:single1\" " \
+	"ON \"example:A\" (\"example:single2\", \"example:single1\")\n"
+#define PARTIAL_2 "CREATE INDEX \"example:A_partial_example:single2\" " \
+	"ON \"example:A\" (\"example:single2\") WHERE \"example:single2\" IS NOT NULL\n"
+#define PARTIAL_1_2 "CREATE INDEX \"example:A_partial_example:single1_example:single2\" " \
+	"ON \"example:A\" (\"example:single1\", \"example:single2\") WHERE \"example:single1\" IS NOT NULL\n"
+
 const TestInfo change_tests[] = {
 	{ "change/test-1", "change/data-1" },
 	{ "change/test-2", "change/data-2" },
@@ -62,7 +73,10 @@ const ChangeInfo changes[] = {
 	{ "99-example.ontology.v4", "99-example.queries.v4", NULL, NULL },
 	{ "99-example.ontology.v5", "99-example.queries.v5", "change/change-test-1", NULL },
 	{ "99-example.ontology.v6", "99-example.queries.v6", "change/change-test-2", NULL },
-	{ "99-example.ontology.v7", "99-example.queries.v7", "change/change-test-3", NULL },
+	{ "99-example.ontology.v7", "99-example.queries.v7", "change/change-test-3", NULL, "" },
+	{ "99-example.ontology.v8", NULL, NULL, NULL, COMPOSITE_1_2 PARTIAL_2 },
+	{ "99-example.ontology.v9", NULL, NULL, NULL, COMPOSITE_2_1 PARTIAL_2 },
+	{ "99-example.ontology.v10", NULL, NULL, NULL, PARTIAL_1_2 },
 	{ NULL }
 };
 
@@ -89,6 +103,41 @@ delete_db (gboolean del_journal)
 	g_free (db_location);
 }
 
+static void
+check_indexes (const gchar *expected)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GString *indexes;
+	GError *error = NULL;
+
+	iface = tracker_db_manager_get_db_interface ();
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "SELECT sql FROM sqlite_master "
+	                                              "WHERE type = 'index' AND tbl_name = 'example:A' AND "
+	                                              "(name GLOB '*_composite_*' OR name GLOB '*_partial_*') "
+	                                              "ORDER BY name");
+	g_assert_no_error (error);
+
+	cursor = tracker_db_statement_start_cursor (stmt, &error);
+	g_assert_no_error (error);
+
+	indexes = g_string_new ("");
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, &error)) {
+		g_string_append_printf (indexes, "%s\n", tracker_db_cursor_get_string (cursor, 0, NULL));
+	}
+
+	g_assert_no_error (error);
+	g_assert_cmpstr (indexes->str, ==, expected);
+
+	g_string_free (indexes, TRUE);
+	g_object_unref (cursor);
+	g_object_unref (stmt);
+}
+
 static void
 query_helper (const gchar *query_filename, const gchar *results_filename)
 {
@@ -212,7 +261,7 @@ test_ontology_change (void)
 		GFile *file1;
 		gchar *queries = NULL;
 		gchar *source = g_build_path (G_DIR_SEPARATOR_S, prefix, "change", "source", changes[i].ontology, NULL);
-		gchar *update = g_build_path (G_DIR_SEPARATOR_S, prefix, "change", "updates", changes[i].update, NULL);
+		gchar *update = NULL;
 		gchar *from, *to;
 
 		file1 = g_file_new_for_path (source);
@@ -234,7 +283,11 @@ test_ontology_change (void)
 
 		g_assert_no_error (error);
 
-		if (g_file_get_contents (update, &queries, NULL, NULL)) {
+		if (changes[i].update) {
+			update = g_build_path (G_DIR_SEPARATOR_S, prefix, "change", "updates", changes[i].update, NULL);
+		}
+
+		if (update && g_file_get_contents (update, &queries, NULL, NULL)) {
 			gchar *query = strtok (queries, "\n");
 			while (query) {
 
@@ -267,6 +320,10 @@ test_ontology_change (void)
 			g_free (results_filename);
 		}
 
+		if (changes[i].indexes) {
+			check_indexes (changes[i].indexes);
+		}
+
 		tracker_data_manager_shutdown ();
 	}
 
@@ -278,6 +335,9 @@ test_ontology_change (void)
 
 	g_assert_no_error (error);
 
+	/* The indexes of the last ontology, replayed from the journal */
+	check_indexes (PARTIAL_1_2);
+
 	for (i = 0; change_tests[i].test_name != NULL; i++) {
 		gchar *query_filename;
 		gchar *results_filename;
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Measures the SQL functions behind fn:lower-case, tracker:case-fold
+ * and tracker:unaccent, and the collation used for ORDER BY, over
+ * ASCII, Latin-1 and other texts.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libtracker-data/tracker-data.h>
+#include <libtracker-data/tracker-db-interface-sqlite.h>
+
+#define QUERY_REPEATS 3
+
+static gint n_rows = 1000000;
+
+static GOptionEntry entries[] = {
+	{ "rows", 'n', 0, G_OPTION_ARG_INT, &n_rows,
+	  "Number of rows to run the functions on (default: 1000000)", "N" },
+	{ NULL }
+};
+
+static const gchar *words[] = {
+	/* ASCII */
+	"Tracker", "desktop", "SEARCH", "Engine", "metadata", "Music",
+	/* Latin-1 */
+	"Ångström", "café", "GRÜN", "Señor", "Ærø", "façade",
+	/* Others */
+	"Straße", "Łódź", "Ελληνικά", "Русский",
+	NULL
+};
+
+static const gchar *queries[] = {
+	"SELECT COUNT(*) FROM %s WHERE SparqlLowerCase(s) = 'x'",
+	"SELECT COUNT(*) FROM %s WHERE SparqlCaseFold(s) = 'x'",
+	"SELECT COUNT(*) FROM %s WHERE SparqlUnaccent(s) = 'x'",
+	"SELECT COUNT(*) FROM (SELECT s FROM %s ORDER BY s COLLATE " TRACKER_COLLATION_NAME ")",
+	NULL
+};
+
+static void
+populate (TrackerDBInterface *iface,
+          const gchar        *table,
+          gint                first_word,
+          gint                last_word)
+{
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+	GString *str;
+	GRand *rand;
+	gint i, j;
+
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "CREATE TABLE %s (s TEXT)", table);
+	g_assert_no_error (error);
+
+	stmt = tracker_db_interface_create_statement (iface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_NONE,
+	                                              &error,
+	                                              "INSERT INTO %s (s) VALUES (?)",
+	                                              table);
+	g_assert_no_error (error);
+
+	rand = g_rand_new_with_seed (42);
+	str = g_string_new (NULL);
+
+	tracker_db_interface_start_transaction (iface);
+
+	for (i = 0; i < n_rows; i++) {
+		g_string_truncate (str, 0);
+
+		for (j = 0; j < 4; j++) {
+			if (j > 0) {
+				g_string_append_c (str, ' ');
+			}
+
+			g_string_append (str, words[g_rand_int_range (rand, first_word, last_word)]);
+		}
+
+		tracker_db_statement_bind_text (stmt, 0, str->str);
+		tracker_db_statement_execute (stmt, &error);
+		g_assert_no_error (error);
+	}
+
+	tracker_db_interface_end_db_transaction (iface, &error);
+	g_assert_no_error (error);
+
+	g_string_free (str, TRUE);
+	g_rand_free (rand);
+	g_object_unref (stmt);
+}
+
+static void
+run_queries (TrackerDBInterface *iface,
+             const gchar        *table)
+{
+	gint i, j;
+
+	g_print ("%s:\n", table);
+
+	for (i = 0; queries[i]; i++) {
+		gdouble best = G_MAXDOUBLE;
+		gchar *query;
+
+		query = g_strdup_printf (queries[i], table);
+
+		for (j = 0; j < QUERY_REPEATS; j++) {
+			TrackerDBStatement *stmt;
+			TrackerDBCursor *cursor;
+			GError *error = NULL;
+			GTimer *timer;
+
+			timer = g_timer_new ();
+
+			stmt = tracker_db_interface_create_statement (iface,
+			                                              TRACKER_DB_STATEMENT_CACHE_TYPE_NONE,
+			                                              &error, "%s", query);
+			g_assert_no_error (error);
+
+			cursor = tracker_db_statement_start_cursor (stmt, &error);
+			g_assert_no_error (error);
+
+			tracker_db_cursor_iter_next (cursor, NULL, &error);
+			g_assert_no_error (error);
+
+			best = MIN (best, g_timer_elapsed (timer, NULL));
+
+			g_object_unref (cursor);
+			g_object_unref (stmt);
+			g_timer_destroy (timer);
+		}
+
+		g_print ("  %-90s %.2fms\n", query, best * 1000);
+		g_free (query);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	GOptionContext *context;
+	TrackerDBInterface *iface;
+	GError *error = NULL;
+	gchar *dir, *filename;
+
+	context = g_option_context_new ("- Benchmark case and accent SQL functions");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_parse (context, &argc, &argv, NULL);
+	g_option_context_free (context);
+
+	dir = g_dir_make_tmp ("tracker-functions-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	filename = g_build_filename (dir, "benchmark.db", NULL);
+	iface = tracker_db_interface_sqlite_new (filename, &error);
+	g_assert_no_error (error);
+
+	populate (iface, "ascii", 0, 6);
+	populate (iface, "latin1", 0, 12);
+	populate (iface, "other", 0, 16);
+
+	run_queries (iface, "ascii");
+	run_queries (iface, "latin1");
+	run_queries (iface, "other");
+
+	g_object_unref (iface);
+
+	g_unlink (filename);
+	g_rmdir (dir);
+	g_free (filename);
+	g_free (dir);
+
+	return 0;
+}
@@ -101,15 +101,18 @@ const TestInfo tests[] = {
 	{ "functions/functions-xpath-7", "functions/data-1", FALSE },
 	{ "functions/functions-xpath-8", "functions/data-1", FALSE },
 	{ "functions/functions-xpath-9", "functions/data-1", FALSE },
+	{ "functions/functions-xpath-10", "functions/data-1", FALSE },
 	{ "graph/graph-1", "graph/data-1", FALSE },
 	{ "graph/graph-2", "graph/data-2", FALSE },
 	{ "graph/graph-3", "graph/data-3", FALSE },
 	{ "graph/graph-4", "graph/data-3", FALSE },
 	{ "graph/graph-4", "graph/data-4", FALSE },
 	{ "optional/q-opt-complex-1", "optional/complex-data-1", FALSE },
+	{ "optional/hoisted-optionals", "optional/hoisted-optionals", FALSE },
 	{ "optional/simple-optional-triple", "optional/simple-optional-triple", FALSE },
 	{ "regex/regex-query-001", "regex/regex-data-01", FALSE },
 	{ "regex/regex-query-002", "regex/regex-data-01", FALSE },
+	{ "regex/regex-query-003", "regex/regex-data-01", FALSE },
 	{ "sort/query-sort-1", "sort/data-sort-1", FALSE },
 	{ "sort/query-sort-2", "sort/data-sort-1", FALSE },
 	{ "sort/query-sort-3", "sort/data-sort-3", FALSE },
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Measures the latency of 1 to 3 character prefix queries, as sent
+ * by search-as-you-type UIs, with and without FTS prefix indexes.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libtracker-data/tracker-data.h>
+#include <libtracker-fts/tracker-fts-config.h>
+
+#define BATCH_SIZE       1000
+#define WORDS_PER_DOC    8
+#define QUERY_REPEATS    5
+
+static gint n_documents = 1000000;
+
+static GOptionEntry entries[] = {
+	{ "documents", 'n', 0, G_OPTION_ARG_INT, &n_documents,
+	  "Number of documents to index (default: 1000000)", "N" },
+	{ NULL }
+};
+
+static const gchar *prefixes[] = { "a", "ab", "abc", NULL };
+
+static void
+append_random_word (GString *str,
+                    GRand   *rand)
+{
+	gint i, len;
+
+	len = g_rand_int_range (rand, 3, 10);
+
+	for (i = 0; i < len; i++) {
+		/* Skew towards the first letters so prefixes do match */
+		g_string_append_c (str, 'a' + MIN (g_rand_int_range (rand, 0, 26),
+		                                   g_rand_int_range (rand, 0, 26)));
+	}
+}
+
+static void
+populate (void)
+{
+	GString *update;
+	GRand *rand;
+	GError *error = NULL;
+	gint i, j;
+
+	rand = g_rand_new_with_seed (42);
+	update = g_string_new (NULL);
+
+	for (i = 0; i < n_documents; i++) {
+		if (update->len == 0) {
+			g_string_append (update, "INSERT {");
+		}
+
+		g_string_append_printf (update, " <urn:doc:%d> a test:A ; test:p \"", i);
+
+		for (j = 0; j < WORDS_PER_DOC; j++) {
+			if (j > 0) {
+				g_string_append_c (update, ' ');
+			}
+
+			append_random_word (update, rand);
+		}
+
+		g_string_append (update, "\" .");
+
+		if ((i + 1) % BATCH_SIZE == 0 || i == n_documents - 1) {
+			g_string_append (update, " }");
+			tracker_data_update_sparql (update->str, &error);
+
+			if (error) {
+				g_error ("Could not insert documents: %s", error->message);
+			}
+
+			g_string_truncate (update, 0);
+		}
+	}
+
+	g_string_free (update, TRUE);
+	g_rand_free (rand);
+}
+
+static gdouble
+run_query (const gchar *prefix,
+           gint        *n_results)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	GTimer *timer;
+	gchar *query;
+	gdouble elapsed;
+
+	query = g_strdup_printf ("SELECT COUNT(?u) WHERE { ?u fts:match \"%s*\" }",
+	                         prefix);
+
+	timer = g_timer_new ();
+	cursor = tracker_data_query_sparql_cursor (query, &error);
+
+	if (error) {
+		g_error ("Could not run query '%s': %s", query, error->message);
+	}
+
+	tracker_db_cursor_iter_next (cursor, NULL, NULL);
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	*n_results = tracker_db_cursor_get_int (cursor, 0);
+
+	g_object_unref (cursor);
+	g_timer_destroy (timer);
+	g_free (query);
+
+	return elapsed;
+}
+
+static void
+benchmark (const gint *prefix_indexes,
+           gsize       n_prefix_indexes)
+{
+	TrackerFTSConfig *config;
+	GError *error = NULL;
+	const gchar *test_schemas[2] = { NULL, NULL };
+	gchar *ontology_dir, *str;
+	GTimer *timer;
+	gint i, j;
+
+	config = tracker_fts_config_new ();
+	tracker_fts_config_set_prefix_indexes (config, prefix_indexes, n_prefix_indexes);
+	str = tracker_fts_config_get_prefix_indexes (config);
+	g_object_unref (config);
+
+	g_print ("Prefix indexes: %s\n", str ? str : "none");
+	g_free (str);
+
+	ontology_dir = g_build_filename (TOP_SRCDIR, "tests", "libtracker-fts", "data", NULL);
+	test_schemas[0] = ontology_dir;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           test_schemas,
+	                           NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+
+	if (error) {
+		g_error ("Could not initialize data manager: %s", error->message);
+	}
+
+	timer = g_timer_new ();
+	populate ();
+	g_print ("  Indexed %d documents in %.2fs\n",
+	         n_documents, g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+
+	for (i = 0; prefixes[i]; i++) {
+		gdouble elapsed, best = G_MAXDOUBLE, total = 0;
+		gint n_results = 0;
+
+		for (j = 0; j < QUERY_REPEATS; j++) {
+			elapsed = run_query (prefixes[i], &n_results);
+			best = MIN (best, elapsed);
+			total += elapsed;
+		}
+
+		g_print ("  \"%s*\": %d matches, best %.2fms, average %.2fms\n",
+		         prefixes[i], n_results,
+		         best * 1000, total * 1000 / QUERY_REPEATS);
+	}
+
+	tracker_data_manager_shutdown ();
+	g_free (ontology_dir);
+}
+
+int
+main (int argc, char **argv)
+{
+	GOptionContext *context;
+	gchar *current_dir;
+	const gint prefix_indexes[] = { 2, 3 };
+
+	context = g_option_context_new ("- Benchmark FTS prefix queries");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_parse (context, &argc, &argv, NULL);
+	g_option_context_free (context);
+
+	current_dir = g_get_current_dir ();
+
+	g_setenv ("XDG_DATA_HOME", current_dir, TRUE);
+	g_setenv ("XDG_CACHE_HOME", current_dir, TRUE);
+	g_setenv ("TRACKER_DB_ONTOLOGIES_DIR", TOP_SRCDIR "/src/ontologies/", TRUE);
+	g_setenv ("TRACKER_FTS_STOP_WORDS", "0", TRUE);
+	g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+	g_free (current_dir);
+
+	benchmark (NULL, 0);
+	benchmark (prefix_indexes, G_N_ELEMENTS (prefix_indexes));
+
+	g_spawn_command_line_sync ("rm -R tracker/", NULL, NULL, NULL, NULL);
+
+	return 0;
+}
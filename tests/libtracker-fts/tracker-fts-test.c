@@ -33,6 +33,7 @@ typedef struct _TestInfo TestInfo;
 struct _TestInfo {
 	const gchar *test_name;
 	gint number_of_queries;
+	gboolean deferred;
 };
 
 const TestInfo tests[] = {
@@ -40,6 +41,10 @@ const TestInfo tests[] = {
 	{ "fts3ae", 1 },
 	{ "prefix/fts3prefix", 3 },
 	{ "limits/fts3limits", 4 },
+	{ "rank/fts3rank", 5 },
+	{ "snippet/fts3snippet", 3 },
+	{ "fts3aa", 2, TRUE },
+	{ "fts3ae", 1, TRUE },
 	{ NULL }
 };
 
@@ -75,6 +80,8 @@ test_sparql_query (gconstpointer test_data)
 
 	g_assert_no_error (error);
 
+	tracker_data_set_fts_deferred (test_info->deferred);
+
 	/* load data / perform updates */
 
 	update_filename = g_strconcat (test_prefix, "-data.rq", NULL);
@@ -87,6 +94,12 @@ test_sparql_query (gconstpointer test_data)
 	g_free (update_filename);
 	g_free (update);
 
+	if (test_info->deferred) {
+		/* FTS rows are only rebuilt here */
+		tracker_data_update_fts_queued (-1, &error);
+		g_assert_no_error (error);
+	}
+
 	/* perform queries */
 
 	for (i = 1; i <= test_info->number_of_queries; i++) {
@@ -165,6 +178,129 @@ test_sparql_query (gconstpointer test_data)
 	g_free (data_prefix);
 	g_free (test_prefix);
 
+	tracker_data_set_fts_deferred (FALSE);
+	tracker_data_manager_shutdown ();
+}
+
+static void
+test_merge (void)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	const gchar *test_schemas[2] = { NULL, NULL };
+	gchar *data_prefix, *update;
+	gint n_segments, n_levels, max_level_segments;
+	gint i, before;
+
+	data_prefix = g_build_path (G_DIR_SEPARATOR_S, TOP_SRCDIR, "tests", "libtracker-fts", "data", NULL);
+	test_schemas[0] = data_prefix;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           test_schemas,
+	                           NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	/* Each transaction adds a segment */
+	for (i = 0; i < 8; i++) {
+		update = g_strdup_printf ("INSERT { test:%d a test:A ; test:p \"merge test %d\" }", i, i);
+		tracker_data_update_sparql (update, &error);
+		g_assert_no_error (error);
+		g_free (update);
+	}
+
+	g_assert (tracker_data_get_fts_segment_stats (&n_segments, &n_levels, &max_level_segments));
+	g_assert_cmpint (max_level_segments, >=, 8);
+	before = n_segments;
+
+	while (tracker_data_fts_merge (16, 2, 1000, &error));
+	g_assert_no_error (error);
+
+	g_assert (tracker_data_get_fts_segment_stats (&n_segments, &n_levels, &max_level_segments));
+	g_assert_cmpint (n_segments, <, before);
+	g_assert_cmpint (max_level_segments, <, 2);
+
+	/* Merged index is still searchable */
+	cursor = tracker_data_query_sparql_cursor ("SELECT COUNT(?u) WHERE { ?u fts:match \"merge\" }", &error);
+	g_assert_no_error (error);
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_cmpint (tracker_db_cursor_get_int (cursor, 0), ==, 8);
+	g_object_unref (cursor);
+
+	g_free (data_prefix);
+
+	tracker_data_manager_shutdown ();
+}
+
+static gint
+count_matches (const gchar *match)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gchar *query;
+	gint count;
+
+	query = g_strdup_printf ("SELECT COUNT(?u) WHERE { ?u fts:match \"%s\" }", match);
+	cursor = tracker_data_query_sparql_cursor (query, &error);
+	g_assert_no_error (error);
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	count = tracker_db_cursor_get_int (cursor, 0);
+	g_object_unref (cursor);
+	g_free (query);
+
+	return count;
+}
+
+static void
+test_pretokenized (void)
+{
+	GError *error = NULL;
+	const gchar *test_schemas[2] = { NULL, NULL };
+	gchar *data_prefix, *update;
+	GString *text;
+	gint i;
+
+	data_prefix = g_build_path (G_DIR_SEPARATOR_S, TOP_SRCDIR, "tests", "libtracker-fts", "data", NULL);
+	test_schemas[0] = data_prefix;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           test_schemas,
+	                           NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	/* Big enough to be tokenized on a worker thread */
+	text = g_string_new ("beginning ");
+	for (i = 0; i < 1000; i++) {
+		g_string_append_printf (text, "filler%c ", 'a' + i % 26);
+	}
+	g_string_append (text, "ending");
+
+	update = g_strdup_printf ("INSERT { test:1 a test:A ; test:p \"%s\" }", text->str);
+	tracker_data_update_sparql (update, &error);
+	g_assert_no_error (error);
+	g_free (update);
+
+	g_assert_cmpint (count_matches ("beginning"), ==, 1);
+	g_assert_cmpint (count_matches ("ending"), ==, 1);
+	g_assert_cmpint (count_matches ("fillerz"), ==, 1);
+
+	/* Replacing the text must drop the old words */
+	g_string_overwrite (text, 0, "start    ");
+	update = g_strdup_printf ("INSERT OR REPLACE { test:1 test:p \"%s\" }", text->str);
+	tracker_data_update_sparql (update, &error);
+	g_assert_no_error (error);
+	g_free (update);
+
+	g_assert_cmpint (count_matches ("beginning"), ==, 0);
+	g_assert_cmpint (count_matches ("start"), ==, 1);
+	g_assert_cmpint (count_matches ("ending"), ==, 1);
+
+	g_string_free (text, TRUE);
+	g_free (data_prefix);
+
 	tracker_data_manager_shutdown ();
 }
 
@@ -191,11 +327,15 @@ main (int argc, char **argv)
 	for (i = 0; tests[i].test_name; i++) {
 		gchar *testpath;
 
-		testpath = g_strconcat ("/libtracker-fts/", tests[i].test_name, NULL);
+		testpath = g_strconcat ("/libtracker-fts/", tests[i].test_name,
+		                        tests[i].deferred ? "/deferred" : NULL, NULL);
 		g_test_add_data_func (testpath, &tests[i], test_sparql_query);
 		g_free (testpath);
 	}
 
+	g_test_add_func ("/libtracker-fts/merge", test_merge);
+	g_test_add_func ("/libtracker-fts/pretokenized", test_pretokenized);
+
 	/* run tests */
 	result = g_test_run ();
 
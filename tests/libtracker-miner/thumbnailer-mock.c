@@ -17,117 +17,264 @@
  * 02110-1301, USA.
  */
 
-#include <glib-object.h>
-#include <gobject/gvaluecollector.h>
+#include <gio/gio.h>
 
-#include "empty-gobject.h"
 #include "thumbnailer-mock.h"
 
+/* Minimal implementation of the thumbnailer spec services, running
+ * in its own thread so synchronous calls done from the test thread
+ * (e.g. GetSupported on initialization) don't deadlock.
+ */
+
+#define THUMBCACHE_SERVICE      "org.freedesktop.thumbnails.Cache1"
+#define THUMBCACHE_PATH         "/org/freedesktop/thumbnails/Cache1"
+
+#define THUMBMAN_SERVICE        "org.freedesktop.thumbnails.Thumbnailer1"
+#define THUMBMAN_PATH           "/org/freedesktop/thumbnails/Thumbnailer1"
+
+static const gchar introspection_xml[] =
+	"<node>"
+	"  <interface name='org.freedesktop.thumbnails.Cache1'>"
+	"    <method name='Delete'>"
+	"      <arg type='as' name='uris' direction='in' />"
+	"    </method>"
+	"    <method name='Move'>"
+	"      <arg type='as' name='from_uris' direction='in' />"
+	"      <arg type='as' name='to_uris' direction='in' />"
+	"    </method>"
+	"    <method name='Cleanup'>"
+	"      <arg type='s' name='uri_prefix' direction='in' />"
+	"    </method>"
+	"  </interface>"
+	"  <interface name='org.freedesktop.thumbnails.Thumbnailer1'>"
+	"    <method name='GetSupported'>"
+	"      <arg type='as' name='uri_schemes' direction='out' />"
+	"      <arg type='as' name='mime_types' direction='out' />"
+	"    </method>"
+	"  </interface>"
+	"</node>";
+
+static GMutex calls_lock;
 static GList *calls = NULL;
 
+static GThread *mock_thread = NULL;
+static GMainLoop *mock_loop = NULL;
+static GDBusConnection *mock_connection = NULL;
+
+static GMutex ready_lock;
+static GCond ready_cond;
+static gboolean ready = FALSE;
+
+static void
+dbus_mock_call_log_append (const gchar *method_name,
+                           GVariant    *parameters)
+{
+	gchar *args;
+
+	args = g_variant_print (parameters, FALSE);
+
+	g_mutex_lock (&calls_lock);
+	calls = g_list_append (calls, g_strdup_printf ("%s %s", method_name, args));
+	g_mutex_unlock (&calls_lock);
+
+	g_free (args);
+}
+
 void
-dbus_mock_call_log_reset ()
+dbus_mock_call_log_reset (void)
 {
-	if (calls) {
-		g_list_foreach (calls, (GFunc)g_free, NULL);
-		g_list_free (calls);
-		calls = NULL;
-	}
+	g_mutex_lock (&calls_lock);
+	g_list_free_full (calls, g_free);
+	calls = NULL;
+	g_mutex_unlock (&calls_lock);
 }
 
 GList *
-dbus_mock_call_log_get ()
+dbus_mock_call_log_get (void)
 {
-	return calls;
-}
+	GList *list;
+
+	/* All previously sent requests are guaranteed to
+	 * be logged once a round trip to the mock is done.
+	 */
+	thumbnailer_mock_sync ();
 
-#if 0
+	g_mutex_lock (&calls_lock);
+	list = calls;
+	g_mutex_unlock (&calls_lock);
+
+	return list;
+}
 
 static void
-dbus_mock_call_log_append (const gchar *function_name)
+handle_method_call (GDBusConnection       *connection,
+                    const gchar           *sender,
+                    const gchar           *object_path,
+                    const gchar           *interface_name,
+                    const gchar           *method_name,
+                    GVariant              *parameters,
+                    GDBusMethodInvocation *invocation,
+                    gpointer               user_data)
 {
-	calls = g_list_append (calls, g_strdup (function_name));
-}
+	if (g_strcmp0 (method_name, "GetSupported") == 0) {
+		const gchar *uri_schemes[] = { "file", "file", NULL };
+		const gchar *mime_types[] = { "mock/one", "mock/two", NULL };
 
+		g_dbus_method_invocation_return_value (invocation,
+		                                       g_variant_new ("(^as^as)",
+		                                                      uri_schemes,
+		                                                      mime_types));
+		return;
+	}
 
-/* Port to gdbus */
-/*
- * DBus overrides
- */
+	dbus_mock_call_log_append (method_name, parameters);
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static const GDBusInterfaceVTable interface_vtable = {
+	handle_method_call,
+	NULL,
+	NULL
+};
 
-DBusGConnection *
-dbus_g_bus_get (DBusBusType type, GError **error)
+static void
+request_name (GDBusConnection *connection,
+              const gchar     *name)
 {
-	return (DBusGConnection *) empty_object_new ();
+	GVariant *reply;
+	GError *error = NULL;
+
+	reply = g_dbus_connection_call_sync (connection,
+	                                     "org.freedesktop.DBus",
+	                                     "/org/freedesktop/DBus",
+	                                     "org.freedesktop.DBus",
+	                                     "RequestName",
+	                                     g_variant_new ("(su)", name, 0x4 /* DO_NOT_QUEUE */),
+	                                     G_VARIANT_TYPE ("(u)"),
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1,
+	                                     NULL,
+	                                     &error);
+	g_assert_no_error (error);
+	g_variant_unref (reply);
 }
 
-DBusGProxy *
-dbus_g_proxy_new_for_name (DBusGConnection *connection,
-                           const gchar *service,
-                           const gchar *path,
-                           const gchar *interface )
+static gpointer
+mock_thread_func (gpointer user_data)
 {
-	return (DBusGProxy *) empty_object_new ();
+	const gchar *bus_address = user_data;
+	GDBusNodeInfo *node_info;
+	GMainContext *context;
+	GError *error = NULL;
+
+	context = g_main_context_new ();
+	g_main_context_push_thread_default (context);
+
+	mock_connection = g_dbus_connection_new_for_address_sync (bus_address,
+	                                                          G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+	                                                          G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                                          NULL,
+	                                                          NULL,
+	                                                          &error);
+	g_assert_no_error (error);
+
+	node_info = g_dbus_node_info_new_for_xml (introspection_xml, &error);
+	g_assert_no_error (error);
+
+	g_dbus_connection_register_object (mock_connection,
+	                                   THUMBCACHE_PATH,
+	                                   node_info->interfaces[0],
+	                                   &interface_vtable,
+	                                   NULL, NULL,
+	                                   &error);
+	g_assert_no_error (error);
+
+	g_dbus_connection_register_object (mock_connection,
+	                                   THUMBMAN_PATH,
+	                                   node_info->interfaces[1],
+	                                   &interface_vtable,
+	                                   NULL, NULL,
+	                                   &error);
+	g_assert_no_error (error);
+
+	request_name (mock_connection, THUMBCACHE_SERVICE);
+	request_name (mock_connection, THUMBMAN_SERVICE);
+
+	mock_loop = g_main_loop_new (context, FALSE);
+
+	g_mutex_lock (&ready_lock);
+	ready = TRUE;
+	g_cond_signal (&ready_cond);
+	g_mutex_unlock (&ready_lock);
+
+	g_main_loop_run (mock_loop);
+
+	g_main_loop_unref (mock_loop);
+	g_object_unref (mock_connection);
+	g_dbus_node_info_unref (node_info);
+
+	g_main_context_pop_thread_default (context);
+	g_main_context_unref (context);
+
+	return NULL;
 }
 
-gboolean
-dbus_g_proxy_call (DBusGProxy *proxy,
-                   const gchar *function_name,
-                   GError  **error,
-                   GType first_arg_type, ...)
+void
+thumbnailer_mock_start (const gchar *bus_address)
 {
-	va_list args;
-	GType arg_type;
-	const gchar *supported_mimes[] = { "mock/one", "mock/two", NULL};
-	int     counter;
-
-	g_assert (g_strcmp0 (function_name, "GetSupported") == 0);
-
-	/*
-	  G_TYPE_INVALID,
-	  G_TYPE_STRV, &uri_schemes,
-	  G_TYPE_STRV, &mime_types,
-	  G_TYPE_INVALID);
-
-	  Set the mock values in the second parameter :)
-	*/
-
-	va_start (args, first_arg_type);
-	arg_type = va_arg (args, GType);
-
-	counter = 1;
-	while (arg_type != G_TYPE_INVALID) {
-
-		if (arg_type == G_TYPE_STRV && counter == 2) {
-			gchar *local_error = NULL;
-			GValue value = { 0, };
-			g_value_init (&value, arg_type);
-			g_value_set_boxed (&value, supported_mimes);
-			G_VALUE_LCOPY (&value,
-			               args, 0,
-			               &local_error);
-			g_free (local_error);
-			g_value_unset (&value);
-		} else {
-			gpointer *out_param;
-			out_param = va_arg (args, gpointer *);
-		}
-		arg_type = va_arg (args, GType);
-		counter += 1;
-	}
+	g_assert (mock_thread == NULL);
 
-	va_end (args);
-	return TRUE;
-}
+	mock_thread = g_thread_new ("thumbnailer-mock",
+	                            mock_thread_func,
+	                            (gpointer) bus_address);
 
+	g_mutex_lock (&ready_lock);
+	while (!ready) {
+		g_cond_wait (&ready_cond, &ready_lock);
+	}
+	g_mutex_unlock (&ready_lock);
+}
 
 void
-dbus_g_proxy_call_no_reply (DBusGProxy        *proxy,
-                            const char        *method,
-                            GType              first_arg_type,
-                            ...)
+thumbnailer_mock_stop (void)
 {
-	dbus_mock_call_log_append (method);
+	g_assert (mock_thread != NULL);
+
+	g_main_loop_quit (mock_loop);
+	g_thread_join (mock_thread);
+	mock_thread = NULL;
+	ready = FALSE;
+
+	dbus_mock_call_log_reset ();
 }
-#endif
 
+void
+thumbnailer_mock_sync (void)
+{
+	GDBusConnection *connection;
+	GVariant *reply;
+	GError *error = NULL;
+
+	/* Messages on a connection are delivered in order, so
+	 * once this call returns, the mock has processed every
+	 * request sent before through the same bus connection.
+	 */
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+
+	reply = g_dbus_connection_call_sync (connection,
+	                                     THUMBMAN_SERVICE,
+	                                     THUMBMAN_PATH,
+	                                     THUMBMAN_SERVICE,
+	                                     "GetSupported",
+	                                     NULL,
+	                                     NULL,
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1,
+	                                     NULL,
+	                                     &error);
+	g_assert_no_error (error);
+
+	g_variant_unref (reply);
+	g_object_unref (connection);
+}
@@ -24,6 +24,10 @@
 
 G_BEGIN_DECLS
 
+void    thumbnailer_mock_start   (const gchar *bus_address);
+void    thumbnailer_mock_stop    (void);
+void    thumbnailer_mock_sync    (void);
+
 void    dbus_mock_call_log_reset (void);
 GList * dbus_mock_call_log_get   (void);
 
@@ -18,139 +18,353 @@
  */
 
 #include <glib.h>
-#include <glib-object.h>
-#include <libtracker-miner/tracker-miner.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <libtracker-miner/tracker-thumbnailer.h>
+
 #include "thumbnailer-mock.h"
 
-#if 0
-/* port thumbnailer-mock.c to gdbus first */
+static void
+test_thumbnailer_init (void)
+{
+	TrackerThumbnailer *thumbnailer;
+
+	thumbnailer = tracker_thumbnailer_new ();
+	g_assert (thumbnailer != NULL);
+
+	g_object_unref (thumbnailer);
+}
+
+static void
+test_thumbnailer_send_empty (void)
+{
+	TrackerThumbnailer *thumbnailer;
+
+	dbus_mock_call_log_reset ();
+
+	thumbnailer = tracker_thumbnailer_new ();
+	tracker_thumbnailer_send (thumbnailer);
+
+	g_assert (dbus_mock_call_log_get () == NULL);
+
+	g_object_unref (thumbnailer);
+}
+
+static void
+test_thumbnailer_send_moves (void)
+{
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
+
+	thumbnailer = tracker_thumbnailer_new ();
+
+	/* Returns TRUE, but there is no dbus call */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://b.jpeg"));
+	g_assert (dbus_mock_call_log_get () == NULL);
+
+	/* Returns FALSE, unsupported mime */
+	g_assert (!tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "unsupported", "file://b.jpeg"));
+	g_assert (dbus_mock_call_log_get () == NULL);
+
+	tracker_thumbnailer_send (thumbnailer);
+
+	/* One call to "Move" method */
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==, "Move (['file://a.jpeg'], ['file://b.jpeg'])");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
+}
+
+static void
+test_thumbnailer_send_removes (void)
+{
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
+
+	thumbnailer = tracker_thumbnailer_new ();
+
+	/* Returns TRUE, but there is no dbus call */
+	g_assert (tracker_thumbnailer_remove_add (thumbnailer, "file://a.jpeg", "mock/one"));
+	g_assert (dbus_mock_call_log_get () == NULL);
+
+	/* Returns FALSE, unsupported mime */
+	g_assert (!tracker_thumbnailer_remove_add (thumbnailer, "file://a.jpeg", "unsupported"));
+	g_assert (dbus_mock_call_log_get () == NULL);
+
+	tracker_thumbnailer_send (thumbnailer);
+
+	/* One call to "Delete" method */
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==, "Delete (['file://a.jpeg'],)");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
+}
+
+static void
+test_thumbnailer_send_cleanup (void)
+{
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
+
+	thumbnailer = tracker_thumbnailer_new ();
+
+	/* Returns TRUE, and there is a dbus call */
+	g_assert (tracker_thumbnailer_cleanup (thumbnailer, "file://tri/lu/ri"));
+
+	/* One call to "Cleanup" method */
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==, "Cleanup ('file://tri/lu/ri',)");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
+}
 
 static void
-test_thumbnailer_init ()
+test_thumbnailer_coalesce_moves (void)
 {
-        g_assert (tracker_thumbnailer_init ());
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
 
-        tracker_thumbnailer_shutdown ();
+	thumbnailer = tracker_thumbnailer_new ();
+
+	/* a -> b -> c is sent as a single a -> c move */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://b.jpeg"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://b.jpeg", "mock/one", "file://c.jpeg"));
+
+	/* d -> e -> d cancels out */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://d.jpeg", "mock/one", "file://e.jpeg"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://e.jpeg", "mock/one", "file://d.jpeg"));
+
+	tracker_thumbnailer_send (thumbnailer);
+
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==, "Move (['file://a.jpeg'], ['file://c.jpeg'])");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
 }
 
 static void
-test_thumbnailer_send_empty () 
+test_thumbnailer_coalesce_removes (void)
 {
-        GList *dbus_calls = NULL;
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
 
-        dbus_mock_call_log_reset ();
+	dbus_mock_call_log_reset ();
 
-        tracker_thumbnailer_init ();
-        tracker_thumbnailer_send ();
+	thumbnailer = tracker_thumbnailer_new ();
 
-        dbus_calls = dbus_mock_call_log_get ();
-        g_assert (dbus_calls == NULL);
+	/* Removing a moved file removes the original thumbnail */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://b.jpeg"));
+	g_assert (tracker_thumbnailer_remove_add (thumbnailer, "file://b.jpeg", "mock/one"));
 
-        tracker_thumbnailer_shutdown ();
+	/* Duplicate removals are only sent once */
+	g_assert (tracker_thumbnailer_remove_add (thumbnailer, "file://a.jpeg", "mock/two"));
+
+	tracker_thumbnailer_send (thumbnailer);
+
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==, "Delete (['file://a.jpeg'],)");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
 }
 
 static void
-test_thumbnailer_send_moves ()
+test_thumbnailer_overwriting_moves (void)
 {
-        GList *dbus_calls = NULL;
-        
-        dbus_mock_call_log_reset ();
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
 
-        tracker_thumbnailer_init ();
-        /* Returns TRUE, but there is no dbus call */
-        g_assert (tracker_thumbnailer_move_add ("file://a.jpeg", "mock/one", "file://b.jpeg"));
-        g_assert (dbus_mock_call_log_get () == NULL);
+	thumbnailer = tracker_thumbnailer_new ();
 
-        /* Returns FALSE, unsupported mime */
-        g_assert (!tracker_thumbnailer_move_add ("file://a.jpeg", "unsupported", "file://b.jpeg"));
-        g_assert (dbus_mock_call_log_get () == NULL);
+	/* b overwrites the file moved to c before, so the
+	 * thumbnail of a goes away instead of being moved */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://c.jpeg"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://b.jpeg", "mock/one", "file://c.jpeg"));
 
-        tracker_thumbnailer_send ();
+	tracker_thumbnailer_send (thumbnailer);
 
-        /* One call to "move" method */
-        dbus_calls = dbus_mock_call_log_get ();
-        g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
-        g_assert_cmpstr (dbus_calls->data, ==, "Move");
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 2);
+	g_assert_cmpstr (dbus_calls->data, ==, "Delete (['file://a.jpeg'],)");
+	g_assert_cmpstr (dbus_calls->next->data, ==, "Move (['file://b.jpeg'], ['file://c.jpeg'])");
 
-        tracker_thumbnailer_shutdown ();
-        dbus_mock_call_log_reset ();
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
 }
 
 static void
-test_thumbnailer_send_removes ()
+test_thumbnailer_ordered_moves (void)
 {
-        GList *dbus_calls = NULL;
-        
-        dbus_mock_call_log_reset ();
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
 
+	dbus_mock_call_log_reset ();
 
-        tracker_thumbnailer_init ();
+	thumbnailer = tracker_thumbnailer_new ();
 
-        /* Returns TRUE, but there is no dbus call */
-        g_assert (tracker_thumbnailer_remove_add ("file://a.jpeg", "mock/one"));
-        g_assert (dbus_mock_call_log_get () == NULL);
+	/* a must be moved away before c takes its place */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://b.jpeg"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://c.jpeg", "mock/one", "file://a.jpeg"));
 
-        /* Returns FALSE, unsupported mime */
-        g_assert (!tracker_thumbnailer_remove_add ("file://a.jpeg", "unsupported"));
-        g_assert (dbus_mock_call_log_get () == NULL);
+	/* b -> d collapses into a -> d, still sent before c -> a */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://b.jpeg", "mock/one", "file://d.jpeg"));
 
-        tracker_thumbnailer_send ();
+	/* The removal goes between the moves */
+	g_assert (tracker_thumbnailer_remove_add (thumbnailer, "file://e.jpeg", "mock/one"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://f.jpeg", "mock/one", "file://e.jpeg"));
 
-        /* One call to "Delete" method */
-        dbus_calls = dbus_mock_call_log_get ();
-        g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
-        g_assert_cmpstr (dbus_calls->data, ==, "Delete");
+	tracker_thumbnailer_send (thumbnailer);
 
-        tracker_thumbnailer_shutdown ();
-        dbus_mock_call_log_reset ();
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 3);
+	g_assert_cmpstr (dbus_calls->data, ==,
+	                 "Move (['file://a.jpeg', 'file://c.jpeg'], "
+	                 "['file://d.jpeg', 'file://a.jpeg'])");
+	g_assert_cmpstr (dbus_calls->next->data, ==, "Delete (['file://e.jpeg'],)");
+	g_assert_cmpstr (dbus_calls->next->next->data, ==, "Move (['file://f.jpeg'], ['file://e.jpeg'])");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
 }
 
 static void
-test_thumbnailer_send_cleanup ()
+test_thumbnailer_chained_moves (void)
 {
-        GList *dbus_calls = NULL;
-        
-        dbus_mock_call_log_reset ();
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
+
+	thumbnailer = tracker_thumbnailer_new ();
 
-        tracker_thumbnailer_init ();
+	/* a -> b, b -> c can't become a -> c, the thumbnail of c
+	 * must be moved away before */
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://b.jpeg"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://c.jpeg", "mock/one", "file://d.jpeg"));
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://b.jpeg", "mock/one", "file://c.jpeg"));
 
-        /* Returns TRUE, and there is a dbus call */
-        g_assert (tracker_thumbnailer_cleanup ("file://tri/lu/ri"));
+	tracker_thumbnailer_send (thumbnailer);
 
-        /* One call to "Clean" method */
-        dbus_calls = dbus_mock_call_log_get ();
-        g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
-        g_assert_cmpstr (dbus_calls->data, ==, "Cleanup");
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==,
+	                 "Move (['file://a.jpeg', 'file://c.jpeg', 'file://b.jpeg'], "
+	                 "['file://b.jpeg', 'file://d.jpeg', 'file://c.jpeg'])");
 
-        tracker_thumbnailer_shutdown ();
-        dbus_mock_call_log_reset ();
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
 }
 
-#endif
+static void
+test_thumbnailer_persistent_queue (void)
+{
+	TrackerThumbnailer *thumbnailer;
+	GList *dbus_calls;
+
+	dbus_mock_call_log_reset ();
+
+	/* Pending requests are saved on finalization... */
+	thumbnailer = tracker_thumbnailer_new ();
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://a.jpeg", "mock/one", "file://b.jpeg"));
+	g_object_unref (thumbnailer);
+
+	g_assert (dbus_mock_call_log_get () == NULL);
+
+	/* ...and restored by the next thumbnailer */
+	thumbnailer = tracker_thumbnailer_new ();
+	g_assert (tracker_thumbnailer_move_add (thumbnailer, "file://b.jpeg", "mock/one", "file://c.jpeg"));
+	tracker_thumbnailer_send (thumbnailer);
+
+	dbus_calls = dbus_mock_call_log_get ();
+	g_assert_cmpint (g_list_length (dbus_calls), ==, 1);
+	g_assert_cmpstr (dbus_calls->data, ==, "Move (['file://a.jpeg'], ['file://c.jpeg'])");
+
+	g_object_unref (thumbnailer);
+	dbus_mock_call_log_reset ();
+
+	/* Nothing left once sent */
+	thumbnailer = tracker_thumbnailer_new ();
+	tracker_thumbnailer_send (thumbnailer);
+	g_assert (dbus_mock_call_log_get () == NULL);
+	g_object_unref (thumbnailer);
+}
 
 int
 main (int    argc,
       char **argv)
 {
+	GTestDBus *bus;
+	gchar *cache_dir, *tracker_cache_dir;
+	gint result;
+
 	g_test_init (&argc, &argv, NULL);
 
 	g_test_message ("Testing thumbnailer");
 
-#if 0
-/* port thumbnailer-mock.c to gdbus first */
+	/* Keep the persistent queue away from the user's cache */
+	cache_dir = g_dir_make_tmp ("tracker-thumbnailer-test-XXXXXX", NULL);
+	g_assert (cache_dir != NULL);
+	g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+	bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (bus);
+
+	thumbnailer_mock_start (g_test_dbus_get_bus_address (bus));
 
 	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/init",
 	                 test_thumbnailer_init);
 	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/send_empty",
 	                 test_thumbnailer_send_empty);
-        g_test_add_func ("/libtracker-minter/tracker-thumbnailer/send_moves",
-                         test_thumbnailer_send_moves);
-        g_test_add_func ("/libtracker-minter/tracker-thumbnailer/send_removes",
-                         test_thumbnailer_send_removes);
-        g_test_add_func ("/libtracker-minter/tracker-thumbnailer/send_cleanup",
-                         test_thumbnailer_send_cleanup);
-
-#endif
-
-	return g_test_run ();
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/send_moves",
+	                 test_thumbnailer_send_moves);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/send_removes",
+	                 test_thumbnailer_send_removes);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/send_cleanup",
+	                 test_thumbnailer_send_cleanup);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/coalesce_moves",
+	                 test_thumbnailer_coalesce_moves);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/coalesce_removes",
+	                 test_thumbnailer_coalesce_removes);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/overwriting_moves",
+	                 test_thumbnailer_overwriting_moves);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/ordered_moves",
+	                 test_thumbnailer_ordered_moves);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/chained_moves",
+	                 test_thumbnailer_chained_moves);
+	g_test_add_func ("/libtracker-miner/tracker-thumbnailer/persistent_queue",
+	                 test_thumbnailer_persistent_queue);
+
+	result = g_test_run ();
+
+	thumbnailer_mock_stop ();
+	g_test_dbus_down (bus);
+	g_object_unref (bus);
+
+	tracker_cache_dir = g_build_filename (cache_dir, "tracker", NULL);
+	g_rmdir (tracker_cache_dir);
+	g_rmdir (cache_dir);
+	g_free (tracker_cache_dir);
+	g_free (cache_dir);
+
+	return result;
 }
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <libtracker-extract/tracker-extract.h>
+
+#include "tracker-extract-test-module.h"
+
+G_MODULE_EXPORT gboolean
+tracker_extract_get_metadata (TrackerExtractInfo *info)
+{
+	TrackerSparqlBuilder *metadata;
+	gchar *basename;
+	gboolean fail;
+
+	basename = g_file_get_basename (tracker_extract_info_get_file (info));
+	fail = g_str_has_prefix (basename, TEST_MODULE_FAIL_PREFIX);
+	g_free (basename);
+
+	if (fail) {
+		return FALSE;
+	}
+
+	g_usleep (TEST_MODULE_SLEEP_MS * 1000);
+
+	metadata = tracker_extract_info_get_metadata_builder (info);
+	tracker_sparql_builder_predicate (metadata, "a");
+	tracker_sparql_builder_object (metadata, "nfo:Document");
+
+	return TRUE;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __TRACKER_EXTRACT_TEST_MODULE_H__
+#define __TRACKER_EXTRACT_TEST_MODULE_H__
+
+/* The test module handles this mimetype */
+#define TEST_MODULE_MIMETYPE "application/x-tracker-extract-test"
+
+/* Files whose name starts with this yield no metadata */
+#define TEST_MODULE_FAIL_PREFIX "fail"
+
+/* Time the module spends on every file it extracts */
+#define TEST_MODULE_SLEEP_MS 20
+
+#endif /* __TRACKER_EXTRACT_TEST_MODULE_H__ */
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026, agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <tracker-extract/tracker-extract.h>
+
+#include "tracker-extract-test-module.h"
+
+#define TEST_MODULE_NAME "libextract-test.so"
+
+typedef struct {
+	gchar *dir;
+	TrackerExtract *extract;
+} TestInfo;
+
+static gchar *
+create_file (const gchar *dir,
+             const gchar *name,
+             gsize        size)
+{
+	gchar *path, *contents, *uri;
+	GError *error = NULL;
+
+	path = g_build_filename (dir, name, NULL);
+	contents = g_strnfill (size, 'x');
+
+	g_file_set_contents (path, contents, size, &error);
+	g_assert_no_error (error);
+
+	uri = g_filename_to_uri (path, NULL, &error);
+	g_assert_no_error (error);
+
+	g_free (contents);
+	g_free (path);
+
+	return uri;
+}
+
+static void
+extract_file_cb (GObject      *object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+	GError **error = user_data;
+
+	g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error);
+	g_main_loop_quit (g_object_get_data (object, "test-loop"));
+}
+
+/* Runs the extraction of a file of the given size to completion, and
+ * returns the error it finished with, if any */
+static GError *
+extract_file (TestInfo     *info,
+              const gchar  *name,
+              gsize         size,
+              GCancellable *cancellable)
+{
+	GMainLoop *loop;
+	GError *error = NULL;
+	gchar *uri;
+
+	uri = create_file (info->dir, name, size);
+	loop = g_main_loop_new (NULL, FALSE);
+	g_object_set_data (G_OBJECT (info->extract), "test-loop", loop);
+
+	tracker_extract_file (info->extract, uri, TEST_MODULE_MIMETYPE,
+	                      "urn:test:graph", cancellable,
+	                      extract_file_cb, &error);
+	g_main_loop_run (loop);
+
+	g_object_set_data (G_OBJECT (info->extract), "test-loop", NULL);
+	g_main_loop_unref (loop);
+	g_free (uri);
+
+	return error;
+}
+
+static void
+test_statistics (TestInfo      *info,
+                 gconstpointer  context)
+{
+	GVariant *statistics, *dict, *histogram;
+	GCancellable *cancellable;
+	GVariantIter iter;
+	GError *error;
+	gint extracted, failed, cancelled, unhandled;
+	guint64 bytes_read;
+	gdouble wall_time, cpu_time;
+	gint64 peak_rss_delta;
+	guint limit, count, n_calls = 0, n_fast = 0;
+
+	/* Nothing extracted yet */
+	statistics = tracker_extract_get_statistics (info->extract, &unhandled);
+	g_assert_cmpuint (g_variant_n_children (statistics), ==, 0);
+	g_assert_cmpint (unhandled, ==, 0);
+	g_variant_unref (statistics);
+
+	error = extract_file (info, "first", 100, NULL);
+	g_assert_no_error (error);
+
+	error = extract_file (info, "second", 50, NULL);
+	g_assert_no_error (error);
+
+	error = extract_file (info, TEST_MODULE_FAIL_PREFIX, 10, NULL);
+	g_assert (error != NULL);
+	g_error_free (error);
+
+	/* Cancelled before the module gets to it */
+	cancellable = g_cancellable_new ();
+	g_cancellable_cancel (cancellable);
+	error = extract_file (info, "cancelled", 1000, cancellable);
+	g_assert (error != NULL);
+	g_error_free (error);
+	g_object_unref (cancellable);
+
+	statistics = tracker_extract_get_statistics (info->extract, &unhandled);
+	g_assert (g_variant_is_of_type (statistics, G_VARIANT_TYPE ("a{sa{sv}}")));
+	g_assert_cmpuint (g_variant_n_children (statistics), ==, 1);
+	g_assert_cmpint (unhandled, ==, 0);
+
+	dict = g_variant_lookup_value (statistics, TEST_MODULE_NAME, G_VARIANT_TYPE_VARDICT);
+	g_assert (dict != NULL);
+
+	g_assert (g_variant_lookup (dict, "extracted", "i", &extracted));
+	g_assert (g_variant_lookup (dict, "failed", "i", &failed));
+	g_assert (g_variant_lookup (dict, "cancelled", "i", &cancelled));
+	g_assert_cmpint (extracted, ==, 4);
+	g_assert_cmpint (failed, ==, 1);
+	g_assert_cmpint (cancelled, ==, 1);
+
+	/* Only files the module was called on are accounted */
+	g_assert (g_variant_lookup (dict, "bytes-read", "t", &bytes_read));
+	g_assert_cmpuint (bytes_read, ==, 100 + 50 + 10);
+
+	g_assert (g_variant_lookup (dict, "wall-time", "d", &wall_time));
+	g_assert (g_variant_lookup (dict, "cpu-time", "d", &cpu_time));
+	g_assert_cmpfloat (wall_time, >=, 2 * TEST_MODULE_SLEEP_MS / 1000.0);
+	g_assert_cmpfloat (cpu_time, >=, 0);
+	g_assert_cmpfloat (cpu_time, <, wall_time);
+
+	g_assert (g_variant_lookup (dict, "peak-rss-delta", "x", &peak_rss_delta));
+	g_assert_cmpint (peak_rss_delta, >=, 0);
+
+	g_assert (g_variant_lookup (dict, "latency-histogram", "@a(uu)", &histogram));
+	g_variant_iter_init (&iter, histogram);
+
+	while (g_variant_iter_next (&iter, "(uu)", &limit, &count)) {
+		n_calls += count;
+
+		if (limit <= TEST_MODULE_SLEEP_MS) {
+			n_fast += count;
+		}
+	}
+
+	/* Every module call falls in a bucket, the two sleeping
+	 * ones can't fall below the time they slept */
+	g_assert_cmpuint (n_calls, ==, 3);
+	g_assert_cmpuint (n_fast, <=, 1);
+
+	g_variant_unref (histogram);
+	g_variant_unref (dict);
+	g_variant_unref (statistics);
+}
+
+static void
+setup (TestInfo      *info,
+       gconstpointer  context)
+{
+	GError *error = NULL;
+	gchar *rule, *path;
+
+	info->dir = g_dir_make_tmp ("tracker-extract-test-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	rule = g_strdup_printf ("[ExtractorRule]\n"
+	                        "ModulePath=%s/" TEST_MODULE_NAME "\n"
+	                        "MimeTypes=" TEST_MODULE_MIMETYPE "\n",
+	                        TEST_MODULES_DIR);
+	path = g_build_filename (info->dir, "10-test.rule", NULL);
+	g_file_set_contents (path, rule, -1, &error);
+	g_assert_no_error (error);
+	g_free (path);
+	g_free (rule);
+
+	g_assert_true (g_setenv ("TRACKER_EXTRACTOR_RULES_DIR", info->dir, TRUE));
+
+	info->extract = tracker_extract_new (TRUE, NULL);
+	g_assert (info->extract != NULL);
+}
+
+static void
+teardown (TestInfo      *info,
+          gconstpointer  context)
+{
+	const gchar *name;
+	GDir *dir;
+
+	g_object_unref (info->extract);
+
+	dir = g_dir_open (info->dir, 0, NULL);
+
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		gchar *path;
+
+		path = g_build_filename (info->dir, name, NULL);
+		g_unlink (path);
+		g_free (path);
+	}
+
+	g_dir_close (dir);
+	g_rmdir (info->dir);
+	g_free (info->dir);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add ("/tracker-extract/statistics", TestInfo, NULL, setup, test_statistics, teardown);
+
+	return g_test_run ();
+}
@@ -183,6 +183,48 @@ test_tracker_sparql_query_iterate_largerow ()
 	query_and_compare_results ("SELECT nao:identifier(?r) WHERE {?r a nmm:Photo}");
 }
 
+/* Numeric columns are typed after how the store holds the value, the
+ * type the translator gives an expression is the one of its first
+ * operand */
+static void
+test_tracker_sparql_query_iterate_value_types (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+
+	tracker_sparql_connection_update (connection,
+	                                  "DELETE { <urn:testdata-types> a rdfs:Resource } "
+	                                  "INSERT { <urn:testdata-types> a nfo:FileDataObject ; nfo:fileSize 10 }",
+	                                  0, NULL, &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_sparql_connection_query (connection,
+	                                          "SELECT ?s (?s * 1.5 AS ?d) (?s + 1 AS ?i) ?t "
+	                                          "WHERE { <urn:testdata-types> nfo:fileSize ?s "
+	                                          "OPTIONAL { <urn:testdata-types> nie:title ?t } }",
+	                                          NULL, &error);
+	g_assert_no_error (error);
+
+	g_assert (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 0), ==, TRACKER_SPARQL_VALUE_TYPE_INTEGER);
+	g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 0), ==, 10);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 1), ==, TRACKER_SPARQL_VALUE_TYPE_DOUBLE);
+	g_assert_cmpfloat (tracker_sparql_cursor_get_double (cursor, 1), ==, 15.0);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 2), ==, TRACKER_SPARQL_VALUE_TYPE_INTEGER);
+	g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 2), ==, 11);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 3), ==, TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+
+	g_assert (!tracker_sparql_cursor_next (cursor, NULL, NULL));
+	g_object_unref (cursor);
+
+	tracker_sparql_connection_update (connection,
+	                                  "DELETE { <urn:testdata-types> a rdfs:Resource }",
+	                                  0, NULL, &error);
+	g_assert_no_error (error);
+}
+
 /* Runs an invalid query */
 static void
 test_tracker_sparql_query_iterate_error ()
@@ -597,6 +639,86 @@ test_tracker_sparql_update_async (void)
 	g_main_loop_unref (main_loop);
 }
 
+static gint
+query_cached_title (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint title = 0;
+
+	cursor = tracker_sparql_connection_query (connection,
+	                                          "SELECT ?t WHERE { <urn:testdata-cache> nie:title ?t }",
+	                                          NULL, &error);
+	g_assert_no_error (error);
+
+	if (tracker_sparql_cursor_next (cursor, NULL, NULL)) {
+		title = atoi (tracker_sparql_cursor_get_string (cursor, 0, NULL));
+	}
+
+	g_assert (!tracker_sparql_cursor_next (cursor, NULL, NULL));
+	g_object_unref (cursor);
+
+	return title;
+}
+
+static void
+cache_update_cb (GObject      *source_object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+	gboolean *done = user_data;
+	GError *error = NULL;
+
+	tracker_sparql_connection_update_finish (connection, result, &error);
+	g_assert_no_error (error);
+
+	*done = TRUE;
+}
+
+/* Runs the same query while updates changing its result commit. With
+ * query-cache-size set the store answers it from its cache, which must
+ * never return a result older than the last acknowledged update */
+static void
+test_tracker_sparql_query_cache_update (void)
+{
+	GError *error = NULL;
+	gint i;
+
+	tracker_sparql_connection_update (connection,
+	                                  "DELETE { <urn:testdata-cache> a rdfs:Resource } "
+	                                  "INSERT { <urn:testdata-cache> a nie:InformationElement ; nie:title \"0\" }",
+	                                  0, NULL, &error);
+	g_assert_no_error (error);
+
+	for (i = 1; i <= 50; i++) {
+		gboolean done = FALSE;
+		gchar *update;
+
+		update = g_strdup_printf ("DELETE { <urn:testdata-cache> nie:title ?t } "
+		                          "WHERE { <urn:testdata-cache> nie:title ?t } "
+		                          "INSERT { <urn:testdata-cache> nie:title \"%d\" }", i);
+
+		tracker_sparql_connection_update_async (connection, update, 0, NULL,
+		                                        cache_update_cb, &done);
+
+		while (!done) {
+			gint title = query_cached_title ();
+
+			g_assert (title == i - 1 || title == i);
+			g_main_context_iteration (NULL, FALSE);
+		}
+
+		g_assert_cmpint (query_cached_title (), ==, i);
+
+		g_free (update);
+	}
+
+	tracker_sparql_connection_update (connection,
+	                                  "DELETE { <urn:testdata-cache> a rdfs:Resource }",
+	                                  0, NULL, &error);
+	g_assert_no_error (error);
+}
+
 static void
 cancel_update_cb (GObject      *source_object,
                   GAsyncResult *result,
@@ -691,6 +813,7 @@ main (gint argc, gchar **argv)
 
 	g_test_add_func ("/steroids/tracker/tracker_sparql_query_iterate", test_tracker_sparql_query_iterate);
 	g_test_add_func ("/steroids/tracker/tracker_sparql_query_iterate_largerow", test_tracker_sparql_query_iterate_largerow);
+	g_test_add_func ("/steroids/tracker/tracker_sparql_query_iterate_value_types", test_tracker_sparql_query_iterate_value_types);
 	g_test_add_func ("/steroids/tracker/tracker_sparql_query_iterate_error", test_tracker_sparql_query_iterate_error);
 	g_test_add_func ("/steroids/tracker/tracker_sparql_query_iterate_empty", test_tracker_sparql_query_iterate_empty);
 	g_test_add_func ("/steroids/tracker/tracker_sparql_query_iterate_empty/subprocess", test_tracker_sparql_query_iterate_empty_subprocess);
@@ -709,6 +832,7 @@ main (gint argc, gchar **argv)
 	g_test_add_func ("/steroids/tracker/tracker_sparql_update_async_cancel", test_tracker_sparql_update_async_cancel);
 	g_test_add_func ("/steroids/tracker/tracker_sparql_update_blank_async", test_tracker_sparql_update_blank_async);
 	g_test_add_func ("/steroids/tracker/tracker_sparql_update_array_async", test_tracker_sparql_update_array_async);
+	g_test_add_func ("/steroids/tracker/tracker_sparql_query_cache_update", test_tracker_sparql_query_cache_update);
 
 	return g_test_run ();
 }